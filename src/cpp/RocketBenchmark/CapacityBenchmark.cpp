@@ -0,0 +1,166 @@
+#include "CapacityBenchmark.h"
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include "Server.h"
+#include "ServerWorld.h"
+#include "LoopbackHub.h"
+#include "LoopbackNetwork.h"
+#include "SimulatedClient.h"
+#include "CaptureNetwork.h"
+
+CapacityBenchmark::CapacityBenchmark(std::shared_ptr<Logger> logger, uint8_t features, const std::string& capturePath)
+	: m_logger(logger), m_simulationLogger(std::make_shared<Logger>()), m_features(features), m_capturePath(capturePath)
+{
+	// Per packet logs of servers and clients would dominate the measurement
+	m_simulationLogger->SetLogLevel(LogLevel::EXCEPTION);
+}
+
+int CapacityBenchmark::Run(int players, uint64_t ticks, CapacityResult& result)
+{
+	auto hub = std::make_shared<LoopbackHub>();
+
+	int rooms = (players + Server::MAX_PLAYERS - 1) / Server::MAX_PLAYERS;
+	std::vector<std::unique_ptr<Server>> servers;
+	for (int room = 0; room < rooms; room++)
+	{
+		std::shared_ptr<NetworkBase> network = std::make_shared<LoopbackNetwork>(m_simulationLogger, hub);
+		if (room == 0 && !m_capturePath.empty())
+		{
+			network = std::make_shared<CaptureNetwork>(m_simulationLogger, network, m_capturePath);
+		}
+		auto world = std::make_shared<ServerWorld>(1, Server::MAX_PLAYERS);
+		servers.push_back(std::make_unique<Server>(m_simulationLogger, network, world, 0));
+		if (servers.back()->Initialize(BASE_PORT + room) != 0)
+		{
+			return 1;
+		}
+	}
+
+	std::vector<std::unique_ptr<SimulatedClient>> clients;
+	for (int i = 0; i < players; i++)
+	{
+		clients.push_back(std::make_unique<SimulatedClient>(m_simulationLogger, hub, m_features));
+		if (clients.back()->Initialize(BASE_PORT + i / Server::MAX_PLAYERS) != 0)
+		{
+			return 1;
+		}
+	}
+
+	auto serveAll = [&servers]() {
+		for (auto& server : servers)
+		{
+			while (server->ProcessBatch() == 0)
+			{
+			}
+		}
+	};
+
+	// Handshake is not part of the measurement
+	uint64_t tick = 0;
+	for (; tick < HANDSHAKE_TICKS; tick++)
+	{
+		bool connected = std::all_of(clients.begin(), clients.end(),
+			[](const auto& client) { return client->IsConnected(); });
+		if (connected)
+		{
+			break;
+		}
+
+		for (auto& client : clients)
+		{
+			client->Update(tick);
+		}
+		serveAll();
+		for (auto& client : clients)
+		{
+			client->ReceiveReplies();
+		}
+	}
+
+	int connected = static_cast<int>(std::count_if(clients.begin(), clients.end(),
+		[](const auto& client) { return client->IsConnected(); }));
+	if (connected != players)
+	{
+		m_logger->Log(LogLevel::EXCEPTION, "Capacity: Clients failed to connect", { KV(players), KV(connected) });
+		return 1;
+	}
+
+	uint64_t bytesBefore = 0;
+	for (auto& client : clients)
+	{
+		bytesBefore += client->BytesSent() + client->BytesReceived();
+	}
+
+	std::vector<double> tickTimesUs;
+	tickTimesUs.reserve(ticks);
+	for (uint64_t i = 0; i < ticks; i++, tick++)
+	{
+		for (auto& client : clients)
+		{
+			client->Update(tick);
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		serveAll();
+		auto end = std::chrono::steady_clock::now();
+		tickTimesUs.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+
+		for (auto& client : clients)
+		{
+			client->ReceiveReplies();
+		}
+	}
+
+	uint64_t bytesAfter = 0;
+	for (auto& client : clients)
+	{
+		bytesAfter += client->BytesSent() + client->BytesReceived();
+	}
+
+	std::sort(tickTimesUs.begin(), tickTimesUs.end());
+	auto percentile = [&tickTimesUs](double fraction) {
+		size_t index = static_cast<size_t>(fraction * (tickTimesUs.size() - 1));
+		return tickTimesUs[index];
+	};
+
+	double seconds = static_cast<double>(ticks) / TICK_RATE;
+	double tickBudgetUs = 1e6 / TICK_RATE;
+
+	result.players = players;
+	result.rooms = rooms;
+	result.tickP50Us = percentile(0.50);
+	result.tickP99Us = percentile(0.99);
+	result.tickMaxUs = tickTimesUs.back();
+	result.bytesPerPlayerPerSecond = (bytesAfter - bytesBefore) / seconds / players;
+	result.sustainable = result.tickP99Us <= tickBudgetUs;
+	return 0;
+}
+
+int CapacityBenchmark::FindMaxPlayers(int maxPlayers, uint64_t ticks)
+{
+	int maxSustainablePlayers = 0;
+	for (int players = Server::MAX_PLAYERS; players <= maxPlayers; players *= 2)
+	{
+		CapacityResult result;
+		if (Run(players, ticks, result) != 0)
+		{
+			break;
+		}
+
+		m_logger->Log(
+			LogLevel::INFO,
+			"Capacity result",
+			{ KV(result.players), KV(result.rooms), KV(result.tickP50Us), KV(result.tickP99Us), KV(result.tickMaxUs),
+			  KV(result.bytesPerPlayerPerSecond), KV(result.sustainable) }
+		);
+
+		if (!result.sustainable)
+		{
+			break;
+		}
+		maxSustainablePlayers = players;
+	}
+
+	return maxSustainablePlayers;
+}
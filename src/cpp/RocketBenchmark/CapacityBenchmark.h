@@ -0,0 +1,46 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "Logger.h"
+
+struct CapacityResult
+{
+	int players = 0;
+	int rooms = 0;
+	double tickP50Us = 0;
+	double tickP99Us = 0;
+	double tickMaxUs = 0;
+	double bytesPerPlayerPerSecond = 0;
+	bool sustainable = false;
+};
+
+// Runs servers and simulated clients over the loopback transport in one
+// thread. Every tick all clients send their game state, then the servers
+// drain and answer them while being timed, then the clients read the replies.
+// Players are split into rooms of Server::MAX_PLAYERS, each with its own
+// Server, and all rooms share the one timed core. Clients request the given
+// features, and with a capture path the first room records its traffic.
+class CapacityBenchmark
+{
+private:
+	static constexpr int BASE_PORT = 3501;
+	static constexpr int HANDSHAKE_TICKS = 100;
+
+	std::shared_ptr<Logger> m_logger;
+	std::shared_ptr<Logger> m_simulationLogger;
+	uint8_t m_features = 0;
+	std::string m_capturePath;
+
+public:
+	static constexpr int TICK_RATE = 60;
+
+	CapacityBenchmark(std::shared_ptr<Logger> logger, uint8_t features = 0, const std::string& capturePath = "");
+
+	// Returns 0 on success and 1 if the clients could not connect
+	int Run(int players, uint64_t ticks, CapacityResult& result);
+
+	// Doubles the player count until a tick no longer fits into the tick
+	// budget at the 99th percentile and returns the largest count that did
+	int FindMaxPlayers(int maxPlayers, uint64_t ticks);
+};
@@ -0,0 +1,246 @@
+#include "SimulatedClient.h"
+#include "GamePacket.h"
+#include "NetworkUtilities.h"
+#include "Utils.h"
+#include "PathMtu.h"
+#include "PacketSchemas.h"
+#include "MessageBundle.h"
+
+// Replies only, so the queue never needs to hold more than a few ticks
+static constexpr size_t CLIENT_QUEUE_CAPACITY = 16;
+
+SimulatedClient::SimulatedClient(std::shared_ptr<Logger> logger, std::shared_ptr<LoopbackHub> hub, uint8_t requestedFeatures)
+	: m_logger(logger), m_network(logger, hub, CLIENT_QUEUE_CAPACITY), m_requestedFeatures(requestedFeatures)
+{
+	m_receivedBatch.reserve(NetworkBase::MAX_BATCH_SIZE);
+}
+
+int SimulatedClient::Initialize(int port)
+{
+	return m_network.Initialize("127.0.0.1", port, m_serverAddr);
+}
+
+void SimulatedClient::Send(NetworkPacket& networkPacket)
+{
+	networkPacket.CalculateCRC();
+	if (m_network.Send(networkPacket, m_serverAddr) == 0)
+	{
+		m_bytesSent += networkPacket.Size();
+	}
+}
+
+void SimulatedClient::SendConnectionRequest()
+{
+	m_clientSalt = Utils::GetRandomNumberUInt64();
+
+	PacketHandle networkPacket = m_network.AcquirePacket();
+	PacketSchemas::ConnectionRequest::Write(*networkPacket, m_clientSalt, m_requestedFeatures);
+
+	Send(*networkPacket);
+	m_connectionState = NetworkConnectionState::CONNECTING;
+	m_ticksSinceRequest = 0;
+}
+
+void SimulatedClient::SendGameState(uint64_t tick)
+{
+	m_localSequenceNumberLarge++;
+	uint16_t localSequenceNumberSmall = m_localSequenceNumberLarge % SEQUENCE_NUMBER_MAX;
+
+	uint32_t ackBits{};
+	NetworkUtilities::ComputeAckBits(m_receivedPackets, m_remoteSequenceNumberLarge, ackBits);
+
+	// Turn every now and then so that the keyboard state is not constant
+	PlayerState playerState{};
+	playerState.keyboard.up = 1;
+	playerState.keyboard.left = (tick / 30) % 2;
+
+	PacketHandle networkPacket = m_network.AcquirePacket();
+	GamePacket* gamePacket = static_cast<GamePacket*>(networkPacket.get());
+	PacketSchemas::InputFrame::Write(*gamePacket, m_connectionId, localSequenceNumberSmall,
+		PacketSchemas::SequenceDistance(localSequenceNumberSmall, m_remoteSequenceNumberSmall), PacketSchemas::MissingAckBits(ackBits));
+	gamePacket->SerializePlayerState(playerState);
+
+	// Pending probe acks go in the same datagram, as a real client sends them
+	if (m_pendingPacket != nullptr)
+	{
+		bool bundled = MessageBundle::Append(*m_pendingPacket, *gamePacket, PathMtu::MIN_DATAGRAM_SIZE);
+		Send(*m_pendingPacket);
+		m_pendingPacket.reset();
+		if (bundled)
+		{
+			return;
+		}
+	}
+
+	Send(*gamePacket);
+}
+
+void SimulatedClient::Update(uint64_t tick)
+{
+	if (m_denied)
+	{
+		return;
+	}
+
+	switch (m_connectionState)
+	{
+	case NetworkConnectionState::DISCONNECTED:
+		SendConnectionRequest();
+		break;
+	case NetworkConnectionState::CONNECTING:
+		if (++m_ticksSinceRequest >= RETRY_TICKS)
+		{
+			SendConnectionRequest();
+		}
+		break;
+	case NetworkConnectionState::CONNECTED:
+		SendGameState(tick);
+		break;
+	}
+}
+
+void SimulatedClient::HandlePacket(NetworkPacket& networkPacket)
+{
+	if (networkPacket.Size() < CRC32::CRC_SIZE || networkPacket.ReadAndValidateCRC())
+	{
+		m_logger->Log(LogLevel::WARNING, "SimulatedClient: Packet validation failed");
+		return;
+	}
+
+	MessageBundle::ForEach(networkPacket.Message(), [this](std::span<const uint8_t> message) {
+		return HandleMessage(message);
+	});
+}
+
+int SimulatedClient::HandleMessage(std::span<const uint8_t> message)
+{
+	NetworkPacketType packetType = static_cast<NetworkPacketType>(message[0]);
+	if (!PacketSchemas::ValidSize(packetType, message.size() + CRC32::CRC_SIZE))
+	{
+		m_logger->Log(LogLevel::WARNING, "SimulatedClient: Invalid packet size");
+		return 1;
+	}
+
+	switch (packetType)
+	{
+	case NetworkPacketType::CHALLENGE:
+	{
+		auto [clientSalt, serverSalt] = PacketView<PacketSchemas::Challenge>(message).Fields();
+		if (clientSalt != m_clientSalt)
+		{
+			return 0;
+		}
+		m_connectionSalt = clientSalt ^ serverSalt;
+
+		PacketHandle responsePacket = m_network.AcquirePacket();
+		PacketSchemas::ChallengeResponse::Write(*responsePacket, m_connectionSalt);
+		Send(*responsePacket);
+		break;
+	}
+	case NetworkPacketType::CONNECTION_ACCEPTED:
+	{
+		auto [playerID, features, connectionId] = PacketView<PacketSchemas::ConnectionAccepted>(message).Fields();
+		m_features = features;
+		m_connectionId = connectionId;
+		m_connectionState = NetworkConnectionState::CONNECTED;
+		break;
+	}
+	case NetworkPacketType::CONNECTION_DENIED:
+		m_denied = true;
+		break;
+	case NetworkPacketType::GAME_STATE:
+	{
+		PacketView<PacketSchemas::GameState> gameState(message);
+		std::span<const uint8_t> snapshot = gameState.Trailing();
+		HandleSnapshot(gameState.Fields(), std::span<const std::span<const uint8_t>>(&snapshot, 1));
+		break;
+	}
+	case NetworkPacketType::GAME_STATE_FRAGMENT:
+	{
+		SnapshotReassembly::FragmentView fragment(message);
+		if (std::get<0>(fragment.Fields()) != m_connectionId ||
+			m_reassembly.Add(fragment, std::chrono::steady_clock::now()) != 0)
+		{
+			return 0;
+		}
+		HandleSnapshot(m_reassembly.Fields(), m_reassembly.Fragments());
+		break;
+	}
+	case NetworkPacketType::MTU_PROBE:
+	{
+		uint64_t connectionSalt = 0;
+		size_t size = PathMtu::ReadProbe(message, connectionSalt);
+		if (connectionSalt != m_connectionSalt || size == 0)
+		{
+			return 0;
+		}
+
+		PacketHandle ackPacket = m_network.AcquirePacket();
+		PathMtu::WriteProbeAck(*ackPacket, m_connectionSalt, size);
+		if (m_pendingPacket == nullptr)
+		{
+			m_pendingPacket = std::move(ackPacket);
+		}
+		else if (!MessageBundle::Append(*m_pendingPacket, *ackPacket, PathMtu::MIN_DATAGRAM_SIZE))
+		{
+			Send(*ackPacket);
+		}
+		break;
+	}
+	default:
+		break;
+	}
+	return 0;
+}
+
+void SimulatedClient::HandleSnapshot(const PacketSchemas::GameState::Values& fields, std::span<const std::span<const uint8_t>> fragments)
+{
+	auto [connectionId, seqNum, ackDistance, missingAckBits, baselineDistance] = fields;
+	if (connectionId != m_connectionId)
+	{
+		return;
+	}
+	uint16_t baselineSeqNum = PacketSchemas::SequenceBefore(seqNum, baselineDistance);
+
+	// Snapshots whose baseline is gone are neither acknowledged nor decoded
+	const std::vector<PlayerState>* baseline = nullptr;
+	if (baselineSeqNum != seqNum)
+	{
+		baseline = m_snapshots.Find(baselineSeqNum);
+		if (baseline == nullptr)
+		{
+			return;
+		}
+	}
+
+	uint16_t diff = NetworkUtilities::SequenceNumberDiff(m_remoteSequenceNumberSmall, seqNum);
+	if (diff > 0 && diff < SEQUENCE_NUMBER_HALF)
+	{
+		m_remoteSequenceNumberLarge += diff;
+		m_remoteSequenceNumberSmall = seqNum;
+		m_receivedPackets.push_back(m_remoteSequenceNumberLarge);
+		if (m_receivedPackets.size() > MAX_RECEIVED_PACKETS_STORED)
+		{
+			m_receivedPackets.erase(m_receivedPackets.begin());
+		}
+	}
+
+	// Decoded like a real client would, the states are only kept as baselines
+	std::vector<PlayerState> playerStates = GamePacket::DeserializeSnapshotFragments(fragments, baseline != nullptr ? *baseline : std::vector<PlayerState>(),
+		(m_features & PacketSchemas::ENTROPY_CODED_SNAPSHOTS) != 0);
+	m_snapshots.Add(seqNum) = std::move(playerStates);
+}
+
+void SimulatedClient::ReceiveReplies()
+{
+	m_receivedBatch.clear();
+	while (m_network.ReceiveBatch(m_receivedBatch) == 0)
+	{
+		for (ReceivedPacket& receivedPacket : m_receivedBatch)
+		{
+			m_bytesReceived += receivedPacket.networkPacket->Size();
+			HandlePacket(*receivedPacket.networkPacket);
+		}
+		m_receivedBatch.clear();
+	}
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "Logger.h"
+#include "LoopbackNetwork.h"
+#include "NetworkConnectionState.h"
+#include "SnapshotHistory.h"
+#include "SnapshotReassembly.h"
+
+// Minimal game client driven one tick at a time. Performs the connection
+// handshake and then sends one game state per tick and acknowledges the
+// replies, which is the load a real client puts on the server.
+class SimulatedClient
+{
+private:
+	static constexpr int RETRY_TICKS = 30;
+	static constexpr size_t MAX_RECEIVED_PACKETS_STORED = 33;
+
+	std::shared_ptr<Logger> m_logger;
+	LoopbackNetwork m_network;
+	// Probe acks waiting to be bundled with the next game state, see MessageBundle
+	PacketHandle m_pendingPacket;
+	sockaddr_in m_serverAddr{};
+
+	NetworkConnectionState m_connectionState = NetworkConnectionState::DISCONNECTED;
+	bool m_denied = false;
+	int m_ticksSinceRequest = 0;
+
+	uint64_t m_clientSalt = 0;
+	uint64_t m_connectionSalt = 0;
+	uint16_t m_connectionId = 0;
+
+	// Features requested and the ones the server accepted, see PacketSchemas
+	uint8_t m_requestedFeatures = 0;
+	uint8_t m_features = 0;
+
+	uint64_t m_localSequenceNumberLarge = 0;
+	uint64_t m_remoteSequenceNumberLarge = 0;
+	uint16_t m_remoteSequenceNumberSmall = 0;
+	std::vector<uint64_t> m_receivedPackets;
+	std::vector<ReceivedPacket> m_receivedBatch;
+	SnapshotHistory m_snapshots;
+	SnapshotReassembly m_reassembly;
+
+	uint64_t m_bytesSent = 0;
+	uint64_t m_bytesReceived = 0;
+
+	void Send(NetworkPacket& networkPacket);
+	void SendConnectionRequest();
+	void SendGameState(uint64_t tick);
+	void HandlePacket(NetworkPacket& networkPacket);
+	int HandleMessage(std::span<const uint8_t> message);
+	void HandleSnapshot(const PacketSchemas::GameState::Values& fields, std::span<const std::span<const uint8_t>> fragments);
+
+public:
+	SimulatedClient(std::shared_ptr<Logger> logger, std::shared_ptr<LoopbackHub> hub, uint8_t requestedFeatures = 0);
+
+	int Initialize(int port);
+
+	// Sends what the client would send during one tick
+	void Update(uint64_t tick);
+
+	// Handles every reply the server has sent so far
+	void ReceiveReplies();
+
+	bool IsConnected() const { return m_connectionState == NetworkConnectionState::CONNECTED; }
+	bool IsDenied() const { return m_denied; }
+	uint64_t BytesSent() const { return m_bytesSent; }
+	uint64_t BytesReceived() const { return m_bytesReceived; }
+};
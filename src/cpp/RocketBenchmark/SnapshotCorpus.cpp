@@ -0,0 +1,102 @@
+#include "SnapshotCorpus.h"
+#include <fstream>
+#include <unordered_map>
+#include "CaptureRecord.h"
+#include "GamePacket.h"
+#include "PacketSchemas.h"
+#include "MessageBundle.h"
+#include "SnapshotHistory.h"
+
+SnapshotCorpus::SnapshotCorpus(std::shared_ptr<Logger> logger)
+	: m_logger(logger)
+{
+}
+
+int SnapshotCorpus::Load(const std::string& path)
+{
+	struct CapturedClient
+	{
+		uint8_t features = 0;
+		SnapshotHistory snapshots;
+	};
+
+	std::ifstream file(path, std::ios::binary);
+	CaptureFileHeader fileHeader;
+	if (!file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader)) ||
+		fileHeader.magic != CAPTURE_MAGIC || fileHeader.version != CAPTURE_VERSION)
+	{
+		m_logger->Log(LogLevel::EXCEPTION, "SnapshotCorpus: Failed to read capture file", { KVS(path) });
+		return 1;
+	}
+
+	std::unordered_map<uint64_t, CapturedClient> clients;
+	uint64_t missingBaselines = 0;
+
+	CaptureRecordHeader header;
+	std::vector<uint8_t> data;
+	while (file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+	{
+		data.resize(header.size);
+		if (!file.read(reinterpret_cast<char*>(data.data()), header.size))
+		{
+			m_logger->Log(LogLevel::WARNING, "SnapshotCorpus: Capture file is truncated");
+			break;
+		}
+
+		if (header.direction != CaptureDirection::SENT)
+		{
+			continue;
+		}
+
+		uint64_t clientKey = (static_cast<uint64_t>(header.address) << 16) | header.port;
+		if (data.size() < CRC32::CRC_SIZE)
+		{
+			continue;
+		}
+
+		// Snapshots may share a datagram with other replies, see MessageBundle
+		MessageBundle::ForEach(std::span<const uint8_t>(data).subspan(CRC32::CRC_SIZE), [&](std::span<const uint8_t> message) {
+			PacketView<PacketSchemas::ConnectionAccepted> connectionAccepted(message);
+			if (connectionAccepted.Valid())
+			{
+				CapturedClient& client = clients[clientKey];
+				client.features = std::get<1>(connectionAccepted.Fields());
+				client.snapshots.Clear();
+				return 0;
+			}
+
+			PacketView<PacketSchemas::GameState> gameState(message);
+			if (!gameState.Valid())
+			{
+				return 0;
+			}
+
+			CapturedClient& client = clients[clientKey];
+			auto [connectionId, seqNum, ackDistance, missingAckBits, baselineDistance] = gameState.Fields();
+			uint16_t baselineSeqNum = PacketSchemas::SequenceBefore(seqNum, baselineDistance);
+
+			CapturedSnapshot snapshot;
+			if (baselineSeqNum != seqNum)
+			{
+				const std::vector<PlayerState>* baseline = client.snapshots.Find(baselineSeqNum);
+				if (baseline == nullptr)
+				{
+					missingBaselines++;
+					return 0;
+				}
+				snapshot.baseline = *baseline;
+			}
+
+			snapshot.playerStates = GamePacket::DeserializeSnapshot(gameState.Trailing(), snapshot.baseline,
+				(client.features & PacketSchemas::ENTROPY_CODED_SNAPSHOTS) != 0);
+			client.snapshots.Add(seqNum) = snapshot.playerStates;
+			m_snapshots.push_back(std::move(snapshot));
+			return 0;
+		});
+	}
+
+	size_t snapshots = m_snapshots.size();
+	size_t clientCount = clients.size();
+	m_logger->Log(LogLevel::INFO, "SnapshotCorpus: Capture loaded", { KVS(path), KV(snapshots), KV(clientCount), KV(missingBaselines) });
+	return 0;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <vector>
+#include "Logger.h"
+#include "PlayerState.h"
+
+struct CapturedSnapshot
+{
+	std::vector<PlayerState> playerStates;
+	// Empty for a full snapshot
+	std::vector<PlayerState> baseline;
+};
+
+// Snapshots a server sent in a capture recorded with CAPTURE_FILE, decoded
+// against their baselines like the clients did. Every client address has its
+// own snapshot history, and the features accepted for it tell whether its
+// snapshots were entropy coded.
+class SnapshotCorpus
+{
+private:
+	std::shared_ptr<Logger> m_logger;
+	std::vector<CapturedSnapshot> m_snapshots;
+
+public:
+	SnapshotCorpus(std::shared_ptr<Logger> logger);
+
+	// Returns 0 on success and 1 if the capture could not be read
+	int Load(const std::string& path);
+
+	const std::vector<CapturedSnapshot>& Snapshots() const { return m_snapshots; }
+};
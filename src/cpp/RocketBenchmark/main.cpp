@@ -0,0 +1,502 @@
+#include <iostream>
+#include <cstring>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <ctime>
+#include <string>
+#include <cstdlib>
+#include <array>
+#include <fstream>
+#include <algorithm>
+#include "Logger.h"
+#include "Network.h"
+#include "UnixNetwork.h"
+#include "NetworkOptions.h"
+#include "CapacityBenchmark.h"
+#include "ReplayNetwork.h"
+#include "Server.h"
+#include "SnapshotCorpus.h"
+#include "GamePacket.h"
+
+// Measures how many datagrams per second the transport moves over loopback
+// and how much CPU time each datagram costs, with and without UDP offload,
+// and over a Unix domain socket.
+// With "capacity" as the first argument measures how many players a single
+// core can serve instead, see CapacityBenchmark. With "replay" replays a
+// capture recorded by the server with CAPTURE_FILE into a server. With
+// "model" trains SnapshotModel on the snapshots of a capture and with
+// "entropy" compares the size and CPU cost of plain and entropy coded ones.
+// With "crc" measures the packet checksums on the kernels this CPU selects.
+
+struct BenchmarkResult
+{
+	uint64_t sent = 0;
+	uint64_t received = 0;
+	double elapsedMs = 0;
+	double cpuNsPerPacket = 0;
+};
+
+static constexpr int RECEIVER_TIMER = 1;
+static constexpr uint64_t MAX_IN_FLIGHT = 512;
+
+std::shared_ptr<Logger> g_logger;
+
+// The sender keeps at most maxInFlight datagrams queued on the receiver
+static int RunBenchmark(NetworkBase& receiver, NetworkBase& sender, const std::string& server, int port, uint64_t maxInFlight, uint64_t packets, size_t packetSize, BenchmarkResult& result)
+{
+	sockaddr_in receiverAddr{};
+	sockaddr_in serverAddr{};
+	if (receiver.Initialize("", port, receiverAddr) != 0 ||
+		sender.Initialize(server, port, serverAddr) != 0)
+	{
+		return 1;
+	}
+
+	if (receiver.StartTimer(RECEIVER_TIMER, std::chrono::milliseconds(100)) != 0)
+	{
+		return 1;
+	}
+
+	std::atomic<uint64_t> received{};
+	std::atomic<bool> sending{ true };
+
+	std::thread receiverThread([&]() {
+		std::vector<int> expiredTimers;
+		std::vector<ReceivedPacket> receivedPackets;
+		receivedPackets.reserve(NetworkBase::MAX_BATCH_SIZE);
+		while (received.load() < packets)
+		{
+			expiredTimers.clear();
+			int waitResult = receiver.WaitForEvents(expiredTimers);
+
+			receivedPackets.clear();
+			int receiveResult = waitResult == 0 ? receiver.ReceiveBatch(receivedPackets) : -1;
+			if (receiveResult == 0)
+			{
+				received += receivedPackets.size();
+			}
+			else if (!expiredTimers.empty() && !sending.load())
+			{
+				// Sender is done and nothing arrived during a whole timer period
+				break;
+			}
+		}
+	});
+
+	auto start = std::chrono::steady_clock::now();
+	std::clock_t cpuStart = std::clock();
+
+	std::vector<OutgoingPacket> outgoingPackets;
+	outgoingPackets.reserve(NetworkBase::MAX_BATCH_SIZE);
+	uint64_t sent = 0;
+	while (sent < packets)
+	{
+		// Pace the sender so that the receive buffer does not overflow
+		uint64_t inFlight = sent - received.load();
+		if (inFlight >= maxInFlight)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+
+		size_t count = static_cast<size_t>(std::min<uint64_t>({ packets - sent, maxInFlight - inFlight, NetworkBase::MAX_BATCH_SIZE }));
+		for (size_t i = 0; i < count; i++)
+		{
+			OutgoingPacket outgoingPacket;
+			outgoingPacket.networkPacket = sender.AcquirePacket();
+			while (outgoingPacket.networkPacket->Size() < packetSize)
+			{
+				outgoingPacket.networkPacket->WriteInt8(static_cast<int8_t>(i));
+			}
+			// Sealed like the server does, so that the cost per packet includes the checksum
+			outgoingPacket.networkPacket->CalculateCRC();
+			outgoingPacket.clientAddr = serverAddr;
+			outgoingPackets.push_back(std::move(outgoingPacket));
+		}
+
+		sender.SendBatch(outgoingPackets);
+		outgoingPackets.clear();
+		sent += count;
+	}
+
+	sending = false;
+	receiverThread.join();
+
+	std::clock_t cpuEnd = std::clock();
+	auto end = std::chrono::steady_clock::now();
+
+	result.sent = sent;
+	result.received = received.load();
+	result.elapsedMs = std::chrono::duration<double, std::milli>(end - start).count();
+	double cpuNs = 1e9 * static_cast<double>(cpuEnd - cpuStart) / CLOCKS_PER_SEC;
+	result.cpuNsPerPacket = result.received > 0 ? cpuNs / result.received : 0;
+	return 0;
+}
+
+static int RunCapacity(int argc, char** argv)
+{
+	int maxPlayers = 4096;
+	uint64_t ticks = 600;
+	bool entropyCoded = false;
+	if (argc > 2)
+	{
+		maxPlayers = std::atoi(argv[2]);
+	}
+	if (argc > 3)
+	{
+		ticks = std::strtoull(argv[3], nullptr, 10);
+	}
+	if (argc > 4)
+	{
+		entropyCoded = std::atoi(argv[4]) != 0;
+	}
+
+	// Traffic of the first room of the last run, the input of the model and entropy modes
+	std::string capturePath;
+	const char* envCapture = std::getenv("CAPTURE_FILE");
+	if (envCapture)
+	{
+		capturePath = envCapture;
+	}
+
+	g_logger->Log(LogLevel::INFO, "Capacity benchmark starting", { KV(maxPlayers), KV(ticks), KV(entropyCoded) });
+
+	CapacityBenchmark benchmark(g_logger, entropyCoded ? PacketSchemas::ENTROPY_CODED_SNAPSHOTS : 0, capturePath);
+	int maxSustainablePlayers = benchmark.FindMaxPlayers(maxPlayers, ticks);
+
+	int tickRate = CapacityBenchmark::TICK_RATE;
+	g_logger->Log(LogLevel::INFO, "Maximum sustainable players per core", { KV(maxSustainablePlayers), KV(tickRate) });
+	return maxSustainablePlayers > 0 ? 0 : 1;
+}
+
+// Servers validate with the codec they were built with, so the replay needs the one of the capture
+template <typename Codec>
+static int ReplayCapture(const std::string& capturePath, double speed)
+{
+	// Per packet logs of the server would dominate the measurement
+	auto serverLogger = std::make_shared<Logger>();
+	serverLogger->SetLogLevel(LogLevel::WARNING);
+
+	std::atomic<bool> running{ true };
+	auto network = std::make_shared<ReplayNetwork>(serverLogger, capturePath, speed, running);
+	BasicServer<NetworkBase, Codec> server(serverLogger, network);
+	if (server.Initialize(3501) != 0)
+	{
+		return 1;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	std::clock_t cpuStart = std::clock();
+	int result = server.ExecuteGame(running);
+	std::clock_t cpuEnd = std::clock();
+	auto end = std::chrono::steady_clock::now();
+
+	uint64_t replayed = network->Replayed();
+	uint64_t replies = network->GetCounters().packetsSent;
+	double elapsedMs = std::chrono::duration<double, std::milli>(end - start).count();
+	double cpuNs = 1e9 * static_cast<double>(cpuEnd - cpuStart) / CLOCKS_PER_SEC;
+	double cpuNsPerDatagram = replayed > 0 ? cpuNs / replayed : 0;
+	g_logger->Log(LogLevel::INFO, "Replay result", { KVS(capturePath), KV(speed), KV(replayed), KV(replies), KV(elapsedMs), KV(cpuNsPerDatagram) });
+	return result;
+}
+
+static int RunReplay(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		g_logger->Log(LogLevel::EXCEPTION, "Usage: RocketBenchmark replay <capture file> [speed]");
+		return 1;
+	}
+
+	std::string capturePath = argv[2];
+	double speed = 1.0;
+	if (argc > 3)
+	{
+		speed = std::atof(argv[3]);
+	}
+
+	CodecId codec;
+	if (ReplayNetwork::ReadCodec(capturePath, codec) != 0)
+	{
+		g_logger->Log(LogLevel::EXCEPTION, "Failed to read capture file", { KVS(capturePath) });
+		return 1;
+	}
+
+	return codec == CodecId::CRC32C ? ReplayCapture<Crc32cCodec>(capturePath, speed) : ReplayCapture<Crc32Codec>(capturePath, speed);
+}
+
+// Counts the bits coded in every context of a SnapshotModel instead of coding them
+class ContextCounter
+{
+private:
+	std::vector<std::array<uint64_t, 2>>& m_counts;
+	const uint16_t* m_contexts;
+
+public:
+	ContextCounter(std::vector<std::array<uint64_t, 2>>& counts, const SnapshotModel& model)
+		: m_counts(counts), m_contexts(model.Contexts().data())
+	{
+	}
+
+	void EncodeBit(uint16_t& probability, uint32_t bit)
+	{
+		m_counts[&probability - m_contexts][bit]++;
+	}
+
+	void EncodeDirectBits(uint32_t, int)
+	{
+	}
+};
+
+static int RunModel(int argc, char** argv)
+{
+	if (argc < 4)
+	{
+		g_logger->Log(LogLevel::EXCEPTION, "Usage: RocketBenchmark model <capture file> <output file>");
+		return 1;
+	}
+
+	SnapshotCorpus corpus(g_logger);
+	if (corpus.Load(argv[2]) != 0)
+	{
+		return 1;
+	}
+
+	// Every snapshot starts from the initial probabilities, so the trained ones are the frequencies over all of them
+	std::vector<std::array<uint64_t, 2>> counts(SnapshotModel::CONTEXT_COUNT);
+	for (const CapturedSnapshot& snapshot : corpus.Snapshots())
+	{
+		std::array<const PlayerState*, 256> baselineStates{};
+		for (const PlayerState& playerState : snapshot.baseline)
+		{
+			baselineStates[playerState.playerID] = &playerState;
+		}
+
+		SnapshotModel model;
+		ContextCounter counter(counts, model);
+		uint8_t previousPlayerID = 0;
+		for (const PlayerState& playerState : snapshot.playerStates)
+		{
+			GamePacket::EncodeState(counter, model, playerState, baselineStates[playerState.playerID], previousPlayerID);
+			previousPlayerID = playerState.playerID;
+		}
+	}
+
+	std::string outputPath = argv[3];
+	std::ofstream output(outputPath);
+	if (!output)
+	{
+		g_logger->Log(LogLevel::EXCEPTION, "Failed to open output file", { KVS(outputPath) });
+		return 1;
+	}
+
+	// Smoothed by half an observation and kept away from certainty, unseen contexts stay at one half
+	output << "    static constexpr Probabilities TRAINED_PROBABILITIES = {" << std::endl;
+	for (size_t context = 0; context < SnapshotModel::CONTEXT_COUNT; context++)
+	{
+		uint64_t zeros = counts[context][0];
+		uint64_t total = zeros + counts[context][1];
+		uint64_t probability = (RangeCoder::PROBABILITY_ONE * (2 * zeros + 1) + total + 1) / (2 * (total + 1));
+		probability = std::clamp<uint64_t>(probability, 31, RangeCoder::PROBABILITY_ONE - 31);
+
+		output << (context % 16 == 0 ? "        " : " ") << probability << ",";
+		if (context % 16 == 15 || context + 1 == SnapshotModel::CONTEXT_COUNT)
+		{
+			output << std::endl;
+		}
+	}
+	output << "    };" << std::endl;
+
+	size_t contexts = SnapshotModel::CONTEXT_COUNT;
+	g_logger->Log(LogLevel::INFO, "Model trained, replace TRAINED_PROBABILITIES of SnapshotModel.h with the output", { KVS(outputPath), KV(contexts) });
+	return 0;
+}
+
+static int RunEntropy(int argc, char** argv)
+{
+	if (argc < 3)
+	{
+		g_logger->Log(LogLevel::EXCEPTION, "Usage: RocketBenchmark entropy <capture file>");
+		return 1;
+	}
+
+	SnapshotCorpus corpus(g_logger);
+	if (corpus.Load(argv[2]) != 0 || corpus.Snapshots().empty())
+	{
+		return 1;
+	}
+
+	for (bool entropyCoded : { false, true })
+	{
+		GamePacket gamePacket;
+		uint64_t bytes = 0;
+		uint64_t mismatches = 0;
+		std::chrono::nanoseconds encodeTime{};
+		std::chrono::nanoseconds decodeTime{};
+		for (const CapturedSnapshot& snapshot : corpus.Snapshots())
+		{
+			gamePacket.Clear();
+			auto start = std::chrono::steady_clock::now();
+			gamePacket.SerializeSnapshot(snapshot.playerStates, snapshot.baseline, NetworkPacket::MAX_DATAGRAM_SIZE, entropyCoded);
+			auto encoded = std::chrono::steady_clock::now();
+			std::vector<PlayerState> playerStates = GamePacket::DeserializeSnapshot(gamePacket.Bytes().subspan(CRC32::CRC_SIZE), snapshot.baseline, entropyCoded);
+			auto decoded = std::chrono::steady_clock::now();
+
+			encodeTime += encoded - start;
+			decodeTime += decoded - encoded;
+			bytes += gamePacket.Size() - CRC32::CRC_SIZE;
+
+			bool same = playerStates.size() == snapshot.playerStates.size();
+			for (size_t i = 0; same && i < playerStates.size(); i++)
+			{
+				same = playerStates[i].playerID == snapshot.playerStates[i].playerID &&
+					playerStates[i].pos.x.intValue == snapshot.playerStates[i].pos.x.intValue &&
+					playerStates[i].pos.y.intValue == snapshot.playerStates[i].pos.y.intValue &&
+					playerStates[i].rotation.intValue == snapshot.playerStates[i].rotation.intValue &&
+					playerStates[i].keyboard == snapshot.playerStates[i].keyboard;
+			}
+			mismatches += same ? 0 : 1;
+		}
+
+		double snapshots = static_cast<double>(corpus.Snapshots().size());
+		double bytesPerSnapshot = bytes / snapshots;
+		double encodeNsPerSnapshot = encodeTime.count() / snapshots;
+		double decodeNsPerSnapshot = decodeTime.count() / snapshots;
+		g_logger->Log(
+			LogLevel::INFO,
+			"Entropy result",
+			{ KV(entropyCoded), KV(bytesPerSnapshot), KV(encodeNsPerSnapshot), KV(decodeNsPerSnapshot), KV(mismatches) }
+		);
+	}
+	return 0;
+}
+
+static int RunCrc()
+{
+	constexpr uint64_t iterations = 1000000;
+	std::vector<uint8_t> data(NetworkPacket::MAX_DATAGRAM_SIZE);
+	for (size_t i = 0; i < data.size(); i++)
+	{
+		data[i] = static_cast<uint8_t>(i * 131);
+	}
+
+	// Tick messages, the handshake packets and a full datagram
+	for (size_t size : { static_cast<size_t>(32), static_cast<size_t>(200), PacketSchemas::CONNECTION_PACKET_SIZE, NetworkPacket::MAX_DATAGRAM_SIZE })
+	{
+		uint32_t checksum = 0;
+		auto start = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < iterations; i++)
+		{
+			checksum += CRC32::calculate(data.data(), size);
+		}
+		auto crc32End = std::chrono::steady_clock::now();
+		for (uint64_t i = 0; i < iterations; i++)
+		{
+			checksum += CRC32C::calculate(data.data(), size);
+		}
+		auto crc32cEnd = std::chrono::steady_clock::now();
+
+		double crc32NsPerPacket = std::chrono::duration<double, std::nano>(crc32End - start).count() / iterations;
+		double crc32cNsPerPacket = std::chrono::duration<double, std::nano>(crc32cEnd - crc32End).count() / iterations;
+		std::string crc32Kernel = CRC32::kernel();
+		std::string crc32cKernel = CRC32C::kernel();
+		g_logger->Log(
+			LogLevel::INFO,
+			"Checksum result",
+			{ KV(size), KVS(crc32Kernel), KV(crc32NsPerPacket), KVS(crc32cKernel), KV(crc32cNsPerPacket), KV(checksum) }
+		);
+	}
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	g_logger = std::make_shared<Logger>();
+	g_logger->SetLogLevel(LogLevel::INFO);
+
+	if (argc > 1 && std::strcmp(argv[1], "capacity") == 0)
+	{
+		return RunCapacity(argc, argv);
+	}
+	if (argc > 1 && std::strcmp(argv[1], "replay") == 0)
+	{
+		return RunReplay(argc, argv);
+	}
+	if (argc > 1 && std::strcmp(argv[1], "model") == 0)
+	{
+		return RunModel(argc, argv);
+	}
+	if (argc > 1 && std::strcmp(argv[1], "entropy") == 0)
+	{
+		return RunEntropy(argc, argv);
+	}
+	if (argc > 1 && std::strcmp(argv[1], "crc") == 0)
+	{
+		return RunCrc();
+	}
+
+	int port = 3601;
+	uint64_t packets = 1000000;
+	size_t packetSize = 200;
+	if (argc > 1)
+	{
+		packets = std::strtoull(argv[1], nullptr, 10);
+	}
+	if (argc > 2)
+	{
+		packetSize = std::max<size_t>(CRC32::CRC_SIZE, std::strtoul(argv[2], nullptr, 10));
+	}
+
+	g_logger->Log(LogLevel::INFO, "Rocket benchmark starting", { KV(packets), KV(packetSize) });
+
+	NetworkOptions plain;
+	NetworkOptions offload;
+	offload.udpGro = true;
+	offload.udpGso = true;
+
+	for (const NetworkOptions& options : { plain, offload })
+	{
+		Network receiver(g_logger, options);
+		Network sender(g_logger, options);
+		BenchmarkResult result;
+		if (RunBenchmark(receiver, sender, "127.0.0.1", port++, MAX_IN_FLIGHT, packets, packetSize, result) != 0)
+		{
+			g_logger->Log(LogLevel::EXCEPTION, "Benchmark failed to initialize network");
+			return 1;
+		}
+
+		bool offloadRequested = options.udpGro;
+		double packetsPerSecond = result.received / (result.elapsedMs / 1000.0);
+		g_logger->Log(
+			LogLevel::INFO,
+			"Benchmark result",
+			{ KV(offloadRequested), KV(result.sent), KV(result.received), KV(result.elapsedMs), KV(packetsPerSecond), KV(result.cpuNsPerPacket) }
+		);
+	}
+
+#ifndef _WIN32
+	{
+		// Sending to a full queue fails instead of dropping, so stay below its length
+		uint64_t maxInFlight = std::min<uint64_t>(MAX_IN_FLIGHT, std::max<size_t>(UnixNetwork::QueueLength(), 2) - 1);
+		std::string path = "@RocketBenchmark." + std::to_string(port);
+		UnixNetwork receiver(g_logger, path);
+		UnixNetwork sender(g_logger);
+		BenchmarkResult result;
+		if (RunBenchmark(receiver, sender, path, port++, maxInFlight, packets, packetSize, result) != 0)
+		{
+			g_logger->Log(LogLevel::EXCEPTION, "Benchmark failed to initialize Unix domain socket");
+			return 1;
+		}
+
+		double packetsPerSecond = result.received / (result.elapsedMs / 1000.0);
+		g_logger->Log(
+			LogLevel::INFO,
+			"Unix domain socket benchmark result",
+			{ KV(maxInFlight), KV(result.sent), KV(result.received), KV(result.elapsedMs), KV(packetsPerSecond), KV(result.cpuNsPerPacket) }
+		);
+	}
+#endif
+
+	return 0;
+}
@@ -5,49 +5,55 @@
 #include "Utils.h"
 #include "NetworkUtilities.h"
 #include "GamePacket.h"
+#include "PathMtu.h"
+#include "PacketSchemas.h"
+#include "MessageBundle.h"
+#include "UnixNetwork.h"
 
-Client::Client(std::shared_ptr<Logger> logger, std::unique_ptr<Network> network)
+template <typename Transport, typename Codec>
+BasicClient<Transport, Codec>::BasicClient(std::shared_ptr<Logger> logger, std::unique_ptr<Transport> network)
 	: m_logger(logger), m_network(std::move(network)) {
 }
 
-Client::~Client() {
+template <typename Transport, typename Codec>
+BasicClient<Transport, Codec>::~BasicClient() {
 }
 
-int Client::Initialize(std::string server, int port)
+template <typename Transport, typename Codec>
+int BasicClient<Transport, Codec>::Initialize(std::string server, int port)
 {
 	return m_network->Initialize(server, port, m_serverAddr);
 }
 
-int Client::EstablishConnection()
+template <typename Transport, typename Codec>
+int BasicClient<Transport, Codec>::SendPacket(NetworkPacket& networkPacket)
+{
+	Codec::Seal(networkPacket);
+	return m_network->Send(networkPacket, m_serverAddr);
+}
+
+template <typename Transport, typename Codec>
+int BasicClient<Transport, Codec>::EstablishConnection()
 {
     m_clientSalt = 0;
     m_serverSalt = 0;
     m_connectionSalt = 0;
     m_playerID = 0;
+    m_features = 0;
 
     uint64_t clientSalt = Utils::GetRandomNumberUInt64();
-    std::unique_ptr<NetworkPacket> networkPacket = std::make_unique<NetworkPacket>();
+    PacketHandle networkPacket = m_network->AcquirePacket();
 
     // TODO: Add clock synchronization
 
     m_connectionState = NetworkConnectionState::CONNECTING;
-    networkPacket->WriteInt8(static_cast<int8_t>(NetworkPacketType::CONNECTION_REQUEST));
-    networkPacket->WriteUInt64(clientSalt);
-
-    // Pad the packet to 1000 bytes
-    for (size_t i = 0; i < 1000
-        - sizeof(uint32_t) /* crc32 */
-        - sizeof(uint8_t) /* packet type */
-        - sizeof(uint64_t) /* client salt */; i++)
-    {
-        networkPacket->WriteInt8(0);
-    }
+    PacketSchemas::ConnectionRequest::Write(*networkPacket, clientSalt, PacketSchemas::ENTROPY_CODED_SNAPSHOTS);
 
     int result = 0;
 
     m_logger->Log(LogLevel::DEBUG, "EstablishConnection: Send connection request with client salt", { KV(clientSalt) });
 
-    if (m_network->Send(*networkPacket, m_serverAddr) != 0)
+    if (SendPacket(*networkPacket) != 0)
     {
         m_logger->Log(LogLevel::DEBUG, "EstablishConnection: Failed to send connection request");
         return 1;
@@ -59,7 +65,7 @@ int Client::EstablishConnection()
     std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 
     sockaddr_in clientAddr{};
-    std::unique_ptr<NetworkPacket> challengePacket = m_network->Receive(clientAddr, result);
+    PacketHandle challengePacket = m_network->Receive(clientAddr, result);
 
     if (result != 0)
     {
@@ -74,22 +80,22 @@ int Client::EstablishConnection()
         return 1;
     }
 
-    if (challengePacket->ReadAndValidateCRC())
+    if (Codec::Validate(*challengePacket))
     {
         m_connectionState = NetworkConnectionState::DISCONNECTED;
         m_logger->Log(LogLevel::WARNING, "EstablishConnection: Packet validation failed");
         return 1;
     }
 
-    if (challengePacket->ReadNetworkPacketType() != NetworkPacketType::CHALLENGE)
+    PacketView<PacketSchemas::Challenge> challenge(challengePacket->Message());
+    if (!challenge.Valid())
     {
         m_connectionState = NetworkConnectionState::DISCONNECTED;
         m_logger->Log(LogLevel::WARNING, "EstablishConnection: Invalid packet type");
         return 1;
     }
 
-    uint64_t receivedClientSalt = challengePacket->ReadUInt64();
-    uint64_t serverSalt = challengePacket->ReadUInt64();
+    auto [receivedClientSalt, serverSalt] = challenge.Fields();
     m_logger->Log(LogLevel::DEBUG, "EstablishConnection: Received challenge with client and server salt", { KV(receivedClientSalt), KV(serverSalt) });
 
     if (receivedClientSalt != clientSalt)
@@ -103,20 +109,11 @@ int Client::EstablishConnection()
     networkPacket->Clear();
 
     // Create a new packet with the connection salt
-    networkPacket->WriteInt8(static_cast<int8_t>(NetworkPacketType::CHALLENGE_RESPONSE));
-    networkPacket->WriteUInt64(connectionSalt);
-    // Pad the packet to 1000 bytes
-    for (size_t i = 0; i < 1000
-        - sizeof(uint32_t) /* crc32 */
-        - sizeof(uint8_t) /* packet type */
-        - sizeof(uint64_t) /* connection salt */; i++)
-    {
-        networkPacket->WriteInt8(0);
-    }
+    PacketSchemas::ChallengeResponse::Write(*networkPacket, connectionSalt);
 
     m_logger->Log(LogLevel::DEBUG, "EstablishConnection: Sending connection salt", { KV(connectionSalt) });
 
-    if (m_network->Send(*networkPacket, m_serverAddr) != 0)
+    if (SendPacket(*networkPacket) != 0)
     {
         m_connectionState = NetworkConnectionState::DISCONNECTED;
         m_logger->Log(LogLevel::DEBUG, "EstablishConnection: Failed to send challenge request");
@@ -128,7 +125,7 @@ int Client::EstablishConnection()
     // Sleep for a short period to allow the server to respond
     std::this_thread::sleep_for(std::chrono::milliseconds(1000));
 
-    std::unique_ptr<NetworkPacket> challengeResponsePacket = m_network->Receive(clientAddr, result);
+    PacketHandle challengeResponsePacket = m_network->Receive(clientAddr, result);
 
     if (result != 0)
     {
@@ -144,14 +141,15 @@ int Client::EstablishConnection()
         return 1;
     }
 
-    if (challengeResponsePacket->ReadAndValidateCRC())
+    if (Codec::Validate(*challengeResponsePacket))
     {
         m_connectionState = NetworkConnectionState::DISCONNECTED;
         m_logger->Log(LogLevel::WARNING, "EstablishConnection: Challenge packet validation failed");
         return 1;
     }
 
-    if (challengeResponsePacket->ReadNetworkPacketType() != NetworkPacketType::CONNECTION_ACCEPTED)
+    PacketView<PacketSchemas::ConnectionAccepted> connectionAccepted(challengeResponsePacket->Message());
+    if (!connectionAccepted.Valid())
     {
         m_connectionState = NetworkConnectionState::DISCONNECTED;
         m_logger->Log(LogLevel::WARNING, "EstablishConnection: Connection was not accepted");
@@ -162,13 +160,17 @@ int Client::EstablishConnection()
     m_clientSalt = clientSalt;
     m_serverSalt = serverSalt;
     m_connectionSalt = clientSalt ^ serverSalt;
-    m_playerID = challengeResponsePacket->ReadInt8();
-    m_logger->Log(LogLevel::INFO, "EstablishConnection: Connected");
+    auto [playerID, features, connectionId] = connectionAccepted.Fields();
+    m_playerID = static_cast<uint8_t>(playerID);
+    m_features = features;
+    m_connectionId = connectionId;
+    m_logger->Log(LogLevel::INFO, "EstablishConnection: Connected", { KV(m_features) });
 
     return 0;
 }
 
-int Client::SyncClock()
+template <typename Transport, typename Codec>
+int BasicClient<Transport, Codec>::SyncClock()
 {
     std::vector<int64_t> clockOffsets;
     std::vector<int64_t> roundTripTimes;
@@ -190,15 +192,13 @@ int Client::SyncClock()
 
         m_logger->Log(LogLevel::DEBUG, "SyncClock: Sending clock sync request");
         NetworkPacket networkPacket;
-        networkPacket.WriteInt8(static_cast<int8_t>(NetworkPacketType::CLOCK));
-        networkPacket.WriteInt64(m_connectionSalt);
 
         // Get current time
         auto sendNow = std::chrono::steady_clock::now();
         auto sendNowEpoch = std::chrono::duration_cast<std::chrono::milliseconds>(sendNow.time_since_epoch()).count();
-        networkPacket.WriteInt64(sendNowEpoch);
+        PacketSchemas::Clock::Write(networkPacket, m_connectionSalt, sendNowEpoch);
 
-        if (m_network->Send(networkPacket, m_serverAddr) != 0)
+        if (SendPacket(networkPacket) != 0)
         {
             m_connectionState = NetworkConnectionState::DISCONNECTED;
             m_logger->Log(LogLevel::DEBUG, "SyncClock: Failed to send clock sync packet");
@@ -213,7 +213,7 @@ int Client::SyncClock()
         {
             sockaddr_in clientAddr{};
             int result = 0;
-            std::unique_ptr<NetworkPacket> responsePacket = m_network->Receive(clientAddr, result);
+            PacketHandle responsePacket = m_network->Receive(clientAddr, result);
             if (result != 0)
             {
                 auto elapsed = std::chrono::steady_clock::now() - startTime;
@@ -229,18 +229,19 @@ int Client::SyncClock()
                 m_logger->Log(LogLevel::WARNING, "SyncClock: Received data from unknown address");
                 return 1;
             }
-            if (responsePacket->ReadAndValidateCRC())
+            if (Codec::Validate(*responsePacket))
             {
                 m_logger->Log(LogLevel::WARNING, "SyncClock: Packet validation failed");
                 return 1;
             }
-            if (responsePacket->ReadNetworkPacketType() != NetworkPacketType::CLOCK_RESPONSE)
+            PacketView<PacketSchemas::ClockResponse> clockResponse(responsePacket->Message());
+            if (!clockResponse.Valid())
             {
                 m_logger->Log(LogLevel::WARNING, "SyncClock: Invalid packet type");
                 return 1;
             }
 
-            auto receiveNow = std::chrono::steady_clock::now();
+            auto receiveNow = responsePacket->ReceiveTime();
             auto receiveNowEpoch = std::chrono::duration_cast<std::chrono::milliseconds>(receiveNow.time_since_epoch()).count();
 
             // Round trip time calculation
@@ -250,7 +251,7 @@ int Client::SyncClock()
             m_logger->Log(LogLevel::DEBUG, "SyncClock: Round trip time", { KV(roundTripTime) });
 
             // Read server time from the response packet
-            uint64_t serverTimeMs = responsePacket->ReadUInt64();
+            int64_t serverTimeMs = std::get<0>(clockResponse.Fields());
             auto serverClockOffset1 = static_cast<int64_t>(serverTimeMs) - sendNowEpoch - roundTripTime / 2;
             auto serverClockOffset2 = static_cast<int64_t>(serverTimeMs) - receiveNowEpoch - roundTripTime / 2;
 
@@ -275,36 +276,50 @@ int Client::SyncClock()
     return 1;
 }
 
-int Client::ExecuteGame(volatile std::sig_atomic_t& running)
+template <typename Transport, typename Codec>
+int BasicClient<Transport, Codec>::ExecuteGame(volatile std::sig_atomic_t& running)
 {
 	// Main loop
     const auto gameUpdateInterval = std::chrono::duration<double>(1.0 / 60.0); // 1/60 second
-    auto gameUpdateTime = std::chrono::steady_clock::now();
 
     int idleTime = 0;
-    auto idle = std::chrono::steady_clock::now();
+    bool dataReceived = false;
     // TODO: Add timer to send stats to server every 10 seconds
 
+    if (m_network->StartTimer(GAME_UPDATE_TIMER, std::chrono::duration_cast<std::chrono::nanoseconds>(gameUpdateInterval)) != 0 ||
+        m_network->StartTimer(IDLE_TIMER, std::chrono::seconds(5)) != 0)
+    {
+        m_logger->Log(LogLevel::EXCEPTION, "Failed to start timers");
+        return 1;
+    }
+
 	while (running)
 	{
 		sockaddr_in serverAddr{};
 		int result = 0;
 
-        auto current = std::chrono::steady_clock::now();
-        auto elapsed = current - gameUpdateTime;
-        if (elapsed >= gameUpdateInterval)
+        m_expiredTimers.clear();
+        int waitResult = m_network->WaitForEvents(m_expiredTimers);
+        if (waitResult == 1)
         {
-            SendGameState();
-            gameUpdateTime = current;
+            m_logger->Log(LogLevel::DEBUG, "Failed to wait for events");
+            continue;
         }
 
-		std::unique_ptr<NetworkPacket> networkPacket = m_network->Receive(serverAddr, result);
-		if (result == -1)
-		{
-            auto now = std::chrono::steady_clock::now();
-            if (std::chrono::duration_cast<std::chrono::milliseconds>(now - idle).count() >= 5000 /* 5 seconds */)
+        for (int timerId : m_expiredTimers)
+        {
+            if (timerId == GAME_UPDATE_TIMER)
             {
-                idle = now;
+                SendGameState();
+            }
+            else if (timerId == IDLE_TIMER)
+            {
+                if (dataReceived)
+                {
+                    dataReceived = false;
+                    continue;
+                }
+
                 m_logger->Log(LogLevel::DEBUG, "Waiting for data");
                 idleTime++;
                 if (idleTime > 20)
@@ -313,7 +328,17 @@ int Client::ExecuteGame(volatile std::sig_atomic_t& running)
                     running = 0;
                 }
             }
+        }
+
+        if (waitResult == -1)
+        {
+            // Woken up by a timer only
+            continue;
+        }
 
+		PacketHandle networkPacket = m_network->Receive(serverAddr, result);
+		if (result == -1)
+		{
 			continue;
 		}
 
@@ -336,49 +361,112 @@ int Client::ExecuteGame(volatile std::sig_atomic_t& running)
 			continue;
 		}
 
-		if (networkPacket->ReadAndValidateCRC())
+		if (Codec::Validate(*networkPacket))
 		{
 			m_logger->Log(LogLevel::WARNING, "Invalid packet");
 			continue;
 		}
 
         idleTime = 0;
-        NetworkPacketType packetType = networkPacket->ReadNetworkPacketType();
-        auto packetTypeInt = static_cast<int>(packetType);
-        m_logger->Log(LogLevel::DEBUG, "Received packet type", { KV(packetTypeInt) });
+        dataReceived = true;
+
+        // Every message of a bundle is handled in this one receive
+        ReceivedMessage message;
+        message.receiveTime = networkPacket->ReceiveTime();
+        MessageBundle::ForEach(networkPacket->Message(), [&](std::span<const uint8_t> bytes) {
+            message.bytes = bytes;
+            NetworkPacketType packetType = static_cast<NetworkPacketType>(bytes[0]);
+            auto packetTypeInt = static_cast<int>(packetType);
+            m_logger->Log(LogLevel::DEBUG, "Received packet type", { KV(packetTypeInt) });
+
+            size_t messageSize = bytes.size() + CRC32::CRC_SIZE;
+            if (!PacketSchemas::ValidSize(packetType, messageSize))
+            {
+                m_logger->Log(LogLevel::WARNING, "Received invalid packet size", { KV(packetTypeInt), KV(messageSize) });
+                return 1;
+            }
 
-		switch (packetType)
-		{
-		case NetworkPacketType::GAME_STATE:
-			m_logger->Log(LogLevel::DEBUG, "Game state packet received");
-            HandleGameState(std::move(networkPacket));
-			break;
-		case NetworkPacketType::DISCONNECT:
-            m_logger->Log(LogLevel::INFO, "Received disconnected packet from server");
-            running = false;
-			break;
-		default:
-			m_logger->Log(LogLevel::WARNING, "Unknown packet type");
-			break;
-		}
+            switch (packetType)
+            {
+            case NetworkPacketType::GAME_STATE:
+                m_logger->Log(LogLevel::DEBUG, "Game state packet received");
+                return HandleGameState(message);
+            case NetworkPacketType::GAME_STATE_FRAGMENT:
+                return HandleGameStateFragment(message);
+            case NetworkPacketType::MTU_PROBE:
+                return HandleMtuProbe(message);
+            case NetworkPacketType::DISCONNECT:
+                m_logger->Log(LogLevel::INFO, "Received disconnected packet from server");
+                running = false;
+                return 0;
+            default:
+                m_logger->Log(LogLevel::WARNING, "Unknown packet type");
+                return 0;
+            }
+        });
 	}
 
 	return 0;
 }
 
-int Client::HandleGameState(std::unique_ptr<NetworkPacket> networkPacket)
+template <typename Transport, typename Codec>
+int BasicClient<Transport, Codec>::HandleGameState(const ReceivedMessage& message)
 {
-    GamePacket* gamePacket = static_cast<GamePacket*>(networkPacket.get());
-    int64_t connectionSalt = gamePacket->ReadUInt64();
-    if (m_connectionSalt != connectionSalt)
+    PacketView<PacketSchemas::GameState> gameState(message.bytes);
+    std::span<const uint8_t> snapshot = gameState.Trailing();
+    return HandleSnapshot(gameState.Fields(), std::span<const std::span<const uint8_t>>(&snapshot, 1), message.receiveTime);
+}
+
+template <typename Transport, typename Codec>
+int BasicClient<Transport, Codec>::HandleGameStateFragment(const ReceivedMessage& message)
+{
+    SnapshotReassembly::FragmentView fragment(message.bytes);
+    uint16_t connectionId = std::get<0>(fragment.Fields());
+    if (m_connectionId != connectionId)
     {
-        m_logger->Log(LogLevel::WARNING, "HandleGameState: Incorrect salt", { KV(m_connectionSalt), KV(connectionSalt)});
+        m_logger->Log(LogLevel::WARNING, "HandleGameStateFragment: Incorrect connection id", { KV(m_connectionId), KV(connectionId) });
         return 0;
     }
 
-    uint16_t seqNum = gamePacket->ReadInt16();
-    uint16_t ack = gamePacket->ReadInt16();
-    uint32_t ackBits = gamePacket->ReadInt32();
+    int result = m_reassembly.Add(fragment, message.receiveTime);
+    if (result == 1)
+    {
+        m_logger->Log(LogLevel::WARNING, "HandleGameStateFragment: Invalid fragment");
+        return 0;
+    }
+    if (result == -1)
+    {
+        return 0;
+    }
+    return HandleSnapshot(m_reassembly.Fields(), m_reassembly.Fragments(), message.receiveTime);
+}
+
+template <typename Transport, typename Codec>
+int BasicClient<Transport, Codec>::HandleSnapshot(const PacketSchemas::GameState::Values& fields, std::span<const std::span<const uint8_t>> fragments,
+    std::chrono::steady_clock::time_point receiveTime)
+{
+    auto [connectionId, seqNum, ackDistance, missingAckBits, baselineDistance] = fields;
+    if (m_connectionId != connectionId)
+    {
+        m_logger->Log(LogLevel::WARNING, "HandleGameState: Incorrect connection id", { KV(m_connectionId), KV(connectionId)});
+        return 0;
+    }
+    uint16_t ack = PacketSchemas::SequenceBefore(seqNum, ackDistance);
+    uint32_t ackBits = PacketSchemas::MissingAckBits(missingAckBits);
+    uint16_t baselineSeqNum = PacketSchemas::SequenceBefore(seqNum, baselineDistance);
+
+    // Snapshots are delta encoded against one this client acknowledged, unless the baseline is the snapshot itself.
+    // Without it the snapshot cannot be decoded and is neither acknowledged nor used.
+    const std::vector<PlayerState>* baseline = nullptr;
+    if (baselineSeqNum != seqNum)
+    {
+        baseline = m_snapshots.Find(baselineSeqNum);
+        if (baseline == nullptr)
+        {
+            m_logger->Log(LogLevel::WARNING, "HandleGameState: Missing baseline", { KV(seqNum), KV(baselineSeqNum) });
+            return 0;
+        }
+    }
 
     uint16_t diff = NetworkUtilities::SequenceNumberDiff(m_remoteSequenceNumberSmall, seqNum);
 
@@ -404,7 +492,7 @@ int Client::HandleGameState(std::unique_ptr<NetworkPacket> networkPacket)
     diff = NetworkUtilities::SequenceNumberDiff(m_localSequenceNumberSmall, ack);
     auto localSequenceNumberLarge = m_localSequenceNumberLarge - diff;
 
-    NetworkUtilities::VerifyAck(m_sendPackets, localSequenceNumberLarge, ackBits);
+    NetworkUtilities::VerifyAck(m_sendPackets, localSequenceNumberLarge, ackBits, receiveTime);
 
     // Clear all acknowledged packets away from send packets
     const size_t packetsToKeep = MAX_SEND_PACKETS_STORED; // Keep the last 33 packets
@@ -480,18 +568,55 @@ int Client::HandleGameState(std::unique_ptr<NetworkPacket> networkPacket)
     m_logger->Log(LogLevel::DEBUG, "HandleGameState", { KV(m_remoteSequenceNumberLarge), KV(m_remoteSequenceNumberSmall), KV(sendPacketsRemaining), KV(receivedPacketsRemaining) });
 
     // Parse the player states from the server
-    std::vector<PlayerState> playerStates = gamePacket->DeserializePlayerStates();
+    std::vector<PlayerState> playerStates = GamePacket::DeserializeSnapshotFragments(fragments, baseline != nullptr ? *baseline : std::vector<PlayerState>(),
+        (m_features & PacketSchemas::ENTROPY_CODED_SNAPSHOTS) != 0);
+    m_snapshots.Add(seqNum) = playerStates;
     IncomingStates.push(playerStates);
 
     return 1;
 }
 
-void Client::SendGameState()
+template <typename Transport, typename Codec>
+int BasicClient<Transport, Codec>::HandleMtuProbe(const ReceivedMessage& message)
+{
+    uint64_t connectionSalt = 0;
+    size_t size = PathMtu::ReadProbe(message.bytes, connectionSalt);
+    if (m_connectionSalt != connectionSalt || size == 0)
+    {
+        m_logger->Log(LogLevel::DEBUG, "HandleMtuProbe: Ignoring probe", { KV(size) });
+        return 0;
+    }
+
+    // Acknowledge the size so that the server can send snapshots up to it, the acks of all probes go with the next input frame
+    PacketHandle ackPacket = m_network->AcquirePacket();
+    PathMtu::WriteProbeAck(*ackPacket, m_connectionSalt, size);
+    if (m_pendingPacket == nullptr)
+    {
+        m_pendingPacket = std::move(ackPacket);
+        return 0;
+    }
+
+    if (!MessageBundle::Append(*m_pendingPacket, *ackPacket, PathMtu::MIN_DATAGRAM_SIZE) &&
+        SendPacket(*ackPacket) != 0)
+    {
+        m_logger->Log(LogLevel::WARNING, "HandleMtuProbe: Failed to send probe ack");
+        return 1;
+    }
+    return 0;
+}
+
+template <typename Transport, typename Codec>
+void BasicClient<Transport, Codec>::SendGameState()
 {
     std::optional<PlayerState> playerStateOptional = OutgoingState.pop();
     if (!playerStateOptional.has_value())
     {
         m_logger->Log(LogLevel::DEBUG, "SendGameState: No player state to send");
+        if (m_pendingPacket != nullptr)
+        {
+            SendPacket(*m_pendingPacket);
+            m_pendingPacket.reset();
+        }
         return;
     }
 
@@ -504,16 +629,25 @@ void Client::SendGameState()
     NetworkUtilities::ComputeAckBits(m_receivedPackets, m_remoteSequenceNumberSmall, ackBits);
 
     GamePacket sendNetworkPacket;
-    sendNetworkPacket.WriteInt8(static_cast<int8_t>(NetworkPacketType::INPUT_FRAME));
-    sendNetworkPacket.WriteInt64(m_connectionSalt);
-    sendNetworkPacket.WriteInt16(m_localSequenceNumberSmall);
-    sendNetworkPacket.WriteInt16(m_remoteSequenceNumberSmall);
-    sendNetworkPacket.WriteInt32(ackBits);
+    PacketSchemas::InputFrame::Write(sendNetworkPacket, m_connectionId, m_localSequenceNumberSmall,
+        PacketSchemas::SequenceDistance(m_localSequenceNumberSmall, m_remoteSequenceNumberSmall), PacketSchemas::MissingAckBits(ackBits));
 
     // Serialize input frame
     sendNetworkPacket.SerializePlayerState(playerState);
 
-    m_network->Send(sendNetworkPacket, m_serverAddr);
+    // Bundled with the pending messages when they fit, otherwise both are sent
+    bool bundled = false;
+    if (m_pendingPacket != nullptr)
+    {
+        bundled = MessageBundle::Append(*m_pendingPacket, sendNetworkPacket, PathMtu::MIN_DATAGRAM_SIZE);
+        SendPacket(*m_pendingPacket);
+        m_pendingPacket.reset();
+    }
+
+    if (!bundled)
+    {
+        SendPacket(sendNetworkPacket);
+    }
 
     PacketInfo pi;
     pi.seqNum = m_localSequenceNumberLarge;
@@ -525,7 +659,8 @@ void Client::SendGameState()
     m_logger->Log(LogLevel::DEBUG, "SendGameState", { KV(m_localSequenceNumberLarge), KV(m_localSequenceNumberSmall) });
 }
 
-void Client::ClientSidePrediction(const PlayerState& playerState, const uint64_t seqNum)
+template <typename Transport, typename Codec>
+void BasicClient<Transport, Codec>::ClientSidePrediction(const PlayerState& playerState, const uint64_t seqNum)
 {
     if (m_gameStateSnapshot.empty())
     {
@@ -548,6 +683,8 @@ void Client::ClientSidePrediction(const PlayerState& playerState, const uint64_t
             PlayerState newPlayerState = PhysicsEngine::SimulatePlayer(
                 previousPlayerState, playerState.keyboard,
                 (float)playerState.deltaTime /* Use local deltaTime */);
+            // Predicted on the values a snapshot carries, see GamePacket
+            GamePacket::QuantizePlayerState(newPlayerState);
             snapshot.players.push_back(newPlayerState);
         }
         else
@@ -556,6 +693,7 @@ void Client::ClientSidePrediction(const PlayerState& playerState, const uint64_t
             PlayerState newPlayerState = PhysicsEngine::SimulatePlayer(
                 previousPlayerState, previousPlayerState.keyboard,
                 (float)playerState.deltaTime /* Use local deltaTime */);
+            GamePacket::QuantizePlayerState(newPlayerState);
             snapshot.players.push_back(newPlayerState);
         }
     }
@@ -566,7 +704,8 @@ void Client::ClientSidePrediction(const PlayerState& playerState, const uint64_t
     IncomingStates.push(snapshot.players);
 }
 
-void Client::ApplyAuthoritativeState(const GameStateSnapshot& serverState, const uint64_t seqNum)
+template <typename Transport, typename Codec>
+void BasicClient<Transport, Codec>::ApplyAuthoritativeState(const GameStateSnapshot& serverState, const uint64_t seqNum)
 {
     // Find the state in history
     auto it = std::find_if(m_gameStateSnapshot.begin(), m_gameStateSnapshot.end(),
@@ -607,7 +746,8 @@ void Client::ApplyAuthoritativeState(const GameStateSnapshot& serverState, const
     }
 }
 
-void Client::RollbackAndReplay(const GameStateSnapshot& serverState)
+template <typename Transport, typename Codec>
+void BasicClient<Transport, Codec>::RollbackAndReplay(const GameStateSnapshot& serverState)
 {
     // Remove all states after the authoritative tick
     std::vector<GameStateSnapshot> previousClientSideSnapshots;
@@ -645,6 +785,7 @@ void Client::RollbackAndReplay(const GameStateSnapshot& serverState)
         PlayerState newPlayerState = PhysicsEngine::SimulatePlayer(
             playerState, playerState.keyboard, 
             (float)serverState.deltaTime /* Use server deltaTime */);
+        GamePacket::QuantizePlayerState(newPlayerState);
         previousState.players.push_back(newPlayerState);
     }
 
@@ -675,6 +816,7 @@ void Client::RollbackAndReplay(const GameStateSnapshot& serverState)
                 PlayerState newPlayerState = PhysicsEngine::SimulatePlayer(
                     *it, playerState.keyboard,
                     (float)previousClientSideSnapshot.deltaTime /* Use local deltaTime */);
+                GamePacket::QuantizePlayerState(newPlayerState);
                 replayStateSnapshot.players.push_back(newPlayerState);
             }
         }
@@ -688,7 +830,8 @@ void Client::RollbackAndReplay(const GameStateSnapshot& serverState)
 }
 
 
-int Client::QuitGame()
+template <typename Transport, typename Codec>
+int BasicClient<Transport, Codec>::QuitGame()
 {
 	m_logger->Log(LogLevel::DEBUG, "Game is stopping");
 
@@ -698,10 +841,17 @@ int Client::QuitGame()
         for (size_t i = 0; i < 10; i++)
         {
             NetworkPacket sendNetworkPacket;
-            sendNetworkPacket.WriteInt8(static_cast<int8_t>(NetworkPacketType::DISCONNECT));
-            sendNetworkPacket.WriteInt64(m_connectionSalt);
-            m_network->Send(sendNetworkPacket, m_serverAddr);
+            PacketSchemas::Disconnect::Write(sendNetworkPacket, m_connectionSalt);
+            SendPacket(sendNetworkPacket);
         }
 	}
 	return 0;
 }
+
+// Any NetworkBase through virtual calls, and the transports main picks without decorators, with either codec
+template class BasicClient<NetworkBase>;
+template class BasicClient<Network>;
+template class BasicClient<UnixNetwork>;
+template class BasicClient<NetworkBase, Crc32cCodec>;
+template class BasicClient<Network, Crc32cCodec>;
+template class BasicClient<UnixNetwork, Crc32cCodec>;
@@ -8,17 +8,29 @@
 #include "NetworkQueue.h"
 #include "PhysicsEngine.h"
 #include "GameStateSnapshot.h"
-
-class Client
+#include "PacketCodec.h"
+#include "ReceivedMessage.h"
+#include "SnapshotReassembly.h"
+
+// Game client. Transport and Codec work as in BasicServer, Client.cpp
+// instantiates the transports that are used.
+template <typename Transport, typename Codec = Crc32Codec>
+class BasicClient
 {
 private:
 	std::shared_ptr<Logger> m_logger;
-	std::unique_ptr<Network> m_network;
+	std::unique_ptr<Transport> m_network;
+    // Messages waiting to be bundled with the next input frame, see MessageBundle
+    PacketHandle m_pendingPacket;
 
     uint64_t m_clientSalt = 0;
     uint64_t m_serverSalt = 0;
     uint64_t m_connectionSalt = 0;
+    // Sent in place of the salt every tick, see BasicServer::FindPlayer
+    uint16_t m_connectionId = 0;
     uint8_t m_playerID = 0;
+    // Features the server accepted, see PacketSchemas
+    uint8_t m_features = 0;
     NetworkConnectionState m_connectionState = NetworkConnectionState::DISCONNECTED;
     struct sockaddr_in m_serverAddr {};
 
@@ -35,6 +47,11 @@ private:
     uint64_t m_remoteSequenceNumberLarge = 0;
     uint16_t m_remoteSequenceNumberSmall = 0;
 
+    // Decoded snapshots, the baselines of the delta encoded ones
+    SnapshotHistory m_snapshots;
+    // Snapshots which came in fragments, until all of them arrived
+    SnapshotReassembly m_reassembly;
+
     uint64_t m_roundTripTimeMs = 0;
 
     int64_t m_serverClockOffset = 0; // Offset to synchronize the server clock
@@ -42,9 +59,16 @@ private:
     const int MAX_SEND_PACKETS_STORED = 33; // Maximum number of packets to store for sending
     const int MAX_RECEIVED_PACKETS_STORED = 33; // Maximum number of packets to store for received packets
 
+    static constexpr int GAME_UPDATE_TIMER = 1;
+    static constexpr int IDLE_TIMER = 2;
+    std::vector<int> m_expiredTimers;
+
+    // Seals the packet with Codec and sends it to the server
+    int SendPacket(NetworkPacket& networkPacket);
+
 public:
-	Client(std::shared_ptr<Logger> logger, std::unique_ptr<Network> network);
-	~Client();
+	BasicClient(std::shared_ptr<Logger> logger, std::unique_ptr<Transport> network);
+	~BasicClient();
 
     NetworkQueue<PlayerState, 256> OutgoingState;
     NetworkQueue<std::vector<PlayerState>, 256> IncomingStates;
@@ -56,7 +80,12 @@ public:
 	int ExecuteGame(volatile std::sig_atomic_t& running);
 
     void SendGameState();
-    int HandleGameState(std::unique_ptr<NetworkPacket> networkPacket);
+    int HandleGameState(const ReceivedMessage& message);
+    int HandleGameStateFragment(const ReceivedMessage& message);
+    // Handles a snapshot which came in one message or was reassembled from fragments
+    int HandleSnapshot(const PacketSchemas::GameState::Values& fields, std::span<const std::span<const uint8_t>> fragments,
+        std::chrono::steady_clock::time_point receiveTime);
+    int HandleMtuProbe(const ReceivedMessage& message);
     NetworkConnectionState GetConnectionState() const { return m_connectionState; }
     uint64_t GetRoundTripTimeMs() const { return m_roundTripTimeMs; }
 
@@ -66,3 +95,6 @@ public:
 
 	int QuitGame();
 };
+
+// Client on any NetworkBase
+using Client = BasicClient<NetworkBase>;
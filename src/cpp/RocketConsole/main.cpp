@@ -5,6 +5,8 @@
 #include <csignal>
 #include "Client.h"
 #include "NetworkQueue.h"
+#include "ImpairedNetwork.h"
+#include "UnixNetwork.h"
 
 static std::string GetEnvVariable(const char* varName) {
 	std::string result;
@@ -28,7 +30,6 @@ static std::string GetEnvVariable(const char* varName) {
 
 // Global variables for cleanup
 std::shared_ptr<Logger> g_logger;
-std::unique_ptr<Client> g_client;
 
 volatile std::sig_atomic_t g_running = 1;
 
@@ -42,6 +43,51 @@ static void SignalHandler(int signal)
 	}
 }
 
+// Connects to the server and plays until stopped. Without decorators the
+// transport type is known at compile time, see BasicClient.
+template <typename Codec, typename Transport>
+static int RunClient(std::unique_ptr<Transport> network, const std::string& server, int udpPort)
+{
+	auto client = std::make_unique<BasicClient<Transport, Codec>>(g_logger, std::move(network));
+
+	if (client->Initialize(server, udpPort) != 0)
+	{
+		g_logger->Log(LogLevel::WARNING, "Failed to initialize network");
+		return 1;
+	}
+
+	while (client->EstablishConnection() != 0)
+	{
+		if (g_running == 0) break;
+
+		g_logger->Log(LogLevel::WARNING, "Failed to establish connection");
+		std::this_thread::sleep_for(std::chrono::seconds(3));
+	}
+
+    while (client->SyncClock() != 0)
+    {
+        if (g_running == 0) break;
+
+        g_logger->Log(LogLevel::WARNING, "Failed to sync clock");
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+    }
+
+	if (g_running)
+	{
+		g_logger->Log(LogLevel::INFO, "Connection established");
+
+		if (client->ExecuteGame(g_running) != 0)
+		{
+			g_logger->Log(LogLevel::EXCEPTION, "Game stopped unexpectedly");
+			return 1;
+		}
+
+		client->QuitGame();
+	}
+
+	return 0;
+}
+
 int main(int argc, char** argv)
 {
 	// Register the signal handler for SIGINT and SIGTERM
@@ -78,44 +124,59 @@ int main(int argc, char** argv)
 		udpPort = std::atoi(argv[2]);
 	}
 
-	g_logger->Log(LogLevel::INFO, "UDP Server", { KVS(server), KV(udpPort) });
-
-	std::unique_ptr<Network> network = std::make_unique<Network>(g_logger);
-	g_client = std::make_unique<Client>(g_logger, std::move(network));
-
-	if (g_client->Initialize(server, udpPort) != 0)
+	// A server on this host can be reached over its Unix domain socket instead of UDP
+	std::string unixSocketPath = GetEnvVariable("UNIX_SOCKET");
+	if (!unixSocketPath.empty())
 	{
-		g_logger->Log(LogLevel::WARNING, "Failed to initialize network");
-		return 1;
+		server = unixSocketPath;
+		g_logger->Log(LogLevel::INFO, "Unix domain socket", { KVS(server) });
 	}
-
-	while (g_client->EstablishConnection() != 0)
+	else
 	{
-		if (g_running == 0) break;
-
-		g_logger->Log(LogLevel::WARNING, "Failed to establish connection");
-		std::this_thread::sleep_for(std::chrono::seconds(3));
+		g_logger->Log(LogLevel::INFO, "UDP Server", { KVS(server), KV(udpPort) });
 	}
 
-    while (g_client->SyncClock() != 0)
-    {
-        if (g_running == 0) break;
+	// Has to match the checksum the server was started with, see Crc32cCodec
+	bool crc32c = GetEnvVariable("PACKET_CHECKSUM") == "crc32c";
+	auto runClient = [&](auto network) {
+		if (crc32c)
+		{
+			return RunClient<Crc32cCodec>(std::move(network), server, udpPort);
+		}
+		return RunClient<Crc32Codec>(std::move(network), server, udpPort);
+	};
 
-        g_logger->Log(LogLevel::WARNING, "Failed to sync clock");
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-    }
+	// Simulated latency, jitter, loss, duplication, reordering and bandwidth cap
+	ImpairmentOptions impairment;
+	impairment.LoadFromEnvironment();
 
-	if (g_running)
+	int result = 0;
+	if (impairment.IsEnabled())
 	{
-		g_logger->Log(LogLevel::INFO, "Connection established");
-
-		if (g_client->ExecuteGame(g_running) != 0)
+		std::shared_ptr<NetworkBase> transport;
+		if (!unixSocketPath.empty())
 		{
-			g_logger->Log(LogLevel::EXCEPTION, "Game stopped unexpectedly");
-			return 1;
+			transport = std::make_shared<UnixNetwork>(g_logger);
+		}
+		else
+		{
+			transport = std::make_shared<Network>(g_logger);
 		}
+		std::unique_ptr<NetworkBase> network = std::make_unique<ImpairedNetwork>(g_logger, transport, impairment);
+		result = runClient(std::move(network));
+	}
+	else if (!unixSocketPath.empty())
+	{
+		result = runClient(std::make_unique<UnixNetwork>(g_logger));
+	}
+	else
+	{
+		result = runClient(std::make_unique<Network>(g_logger));
+	}
 
-		g_client->QuitGame();
+	if (result != 0)
+	{
+		return 1;
 	}
 
 #if _DEBUG
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cassert>
+#include <span>
+
+// Reads values written by BitWriter from a span of received bytes, a byte at
+// a time as the bits are needed. Bits past the end read as zero and mark the
+// reader overrun. The padding of the last byte is left unread.
+class BitReader
+{
+private:
+    std::span<const uint8_t> m_bytes;
+    size_t m_offset = 0;
+    uint64_t m_scratch = 0;
+    int m_scratchBits = 0;
+    bool m_overrun = false;
+
+public:
+    explicit BitReader(std::span<const uint8_t> bytes) : m_bytes(bytes)
+    {
+    }
+
+    inline uint32_t ReadBits(int bits)
+    {
+        assert(bits > 0 && bits <= 32);
+        while (m_scratchBits < bits)
+        {
+            uint8_t byte = 0;
+            if (m_offset < m_bytes.size())
+            {
+                byte = m_bytes[m_offset++];
+            }
+            else
+            {
+                m_overrun = true;
+            }
+            m_scratch = (m_scratch << 8) | byte;
+            m_scratchBits += 8;
+        }
+        m_scratchBits -= bits;
+        return static_cast<uint32_t>((m_scratch >> m_scratchBits) & ((uint64_t(1) << bits) - 1));
+    }
+
+    inline bool Overrun() const
+    {
+        return m_overrun;
+    }
+};
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <cassert>
+#include "NetworkPacket.h"
+
+// Appends values of 1 to 32 bits to a packet, most significant bit first.
+// Bits are collected in a scratch word and written out a byte at a time,
+// Flush writes the last partial byte padded with zeros.
+// https://gafferongames.com/post/reading_and_writing_packets/
+class BitWriter
+{
+private:
+    NetworkPacket& m_packet;
+    uint64_t m_scratch = 0;
+    int m_scratchBits = 0;
+
+public:
+    explicit BitWriter(NetworkPacket& networkPacket) : m_packet(networkPacket)
+    {
+    }
+
+    inline void WriteBits(uint32_t value, int bits)
+    {
+        assert(bits > 0 && bits <= 32);
+        m_scratch = (m_scratch << bits) | (value & ((uint64_t(1) << bits) - 1));
+        m_scratchBits += bits;
+        while (m_scratchBits >= 8)
+        {
+            m_scratchBits -= 8;
+            m_packet.WriteInt8(static_cast<int8_t>(m_scratch >> m_scratchBits));
+        }
+    }
+
+    // Bits written but not yet appended to the packet
+    inline int PendingBits() const
+    {
+        return m_scratchBits;
+    }
+
+    inline void Flush()
+    {
+        if (m_scratchBits > 0)
+        {
+            m_packet.WriteInt8(static_cast<int8_t>(m_scratch << (8 - m_scratchBits)));
+            m_scratchBits = 0;
+        }
+    }
+};
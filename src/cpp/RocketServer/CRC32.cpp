@@ -1,29 +1,271 @@
+#include <array>
+#include <cstring>
 #include "CRC32.h"
 
+#if defined(__x86_64__) || defined(_M_X64)
+#define CRC32_X64 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define CRC32_TARGET(features)
+#else
+#include <cpuid.h>
+#define CRC32_TARGET(features) __attribute__((target(features)))
+#endif
+#endif
+
 // Standard CRC32 polynomial
 constexpr uint32_t CRC32_POLY = 0xEDB88320U;
+// Castagnoli polynomial of CRC32C
+constexpr uint32_t CRC32C_POLY = 0x82F63B78U;
 
-uint32_t CRC32::table[256];
-bool CRC32::table_initialized = false;
+// Table k maps a byte to its CRC followed by k zero bytes, so that
+// slicing-by-8 looks up the eight bytes of a word independently
+using SlicingTables = std::array<std::array<uint32_t, 256>, 8>;
 
-void CRC32::generate_table()
+static constexpr SlicingTables MakeSlicingTables(uint32_t polynomial)
 {
+	SlicingTables tables{};
 	for (uint32_t i = 0; i < 256; ++i) {
 		uint32_t c = i;
 		for (size_t j = 0; j < 8; ++j) {
-			if (c & 1)
-				c = CRC32_POLY ^ (c >> 1);
-			else
-				c >>= 1;
+			c = (c & 1) ? polynomial ^ (c >> 1) : c >> 1;
+		}
+		tables[0][i] = c;
+	}
+	for (size_t k = 1; k < tables.size(); ++k) {
+		for (size_t i = 0; i < 256; ++i) {
+			tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
 		}
-		table[i] = c;
 	}
-	table_initialized = true;
+	return tables;
+}
+
+static constexpr SlicingTables CRC32_TABLES = MakeSlicingTables(CRC32_POLY);
+static constexpr SlicingTables CRC32C_TABLES = MakeSlicingTables(CRC32C_POLY);
+static_assert(CRC32_TABLES[0][1] == 0x77073096U, "CRC32 table");
+static_assert(CRC32C_TABLES[0][1] == 0xF26B8303U, "CRC32C table");
+
+static inline uint32_t LoadLittleEndian32(const uint8_t* data)
+{
+	return static_cast<uint32_t>(data[0]) | (static_cast<uint32_t>(data[1]) << 8) |
+		(static_cast<uint32_t>(data[2]) << 16) | (static_cast<uint32_t>(data[3]) << 24);
+}
+
+template <const SlicingTables& tables>
+static uint32_t UpdateSlicing8(uint32_t crc, const uint8_t* data, size_t length)
+{
+	while (length >= 8) {
+		uint32_t low = LoadLittleEndian32(data) ^ crc;
+		uint32_t high = LoadLittleEndian32(data + 4);
+		crc = tables[7][low & 0xFF] ^ tables[6][(low >> 8) & 0xFF] ^
+			tables[5][(low >> 16) & 0xFF] ^ tables[4][low >> 24] ^
+			tables[3][high & 0xFF] ^ tables[2][(high >> 8) & 0xFF] ^
+			tables[1][(high >> 16) & 0xFF] ^ tables[0][high >> 24];
+		data += 8;
+		length -= 8;
+	}
+	for (size_t i = 0; i < length; ++i) {
+		crc = tables[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return crc;
+}
+
+using UpdateFunction = uint32_t (*)(uint32_t crc, const uint8_t* data, size_t length);
+
+struct Kernel
+{
+	UpdateFunction update;
+	const char* name;
+};
+
+#if CRC32_X64
+// Shorter runs are faster without the folding set up and reduction
+constexpr size_t CLMUL_MIN_LENGTH = 64;
+
+// Powers of x modulo the polynomial, bit reflected and shifted left by one,
+// and the Barrett constant and polynomial of the final reduction
+struct FoldConstants
+{
+	uint64_t k1, k2, k3, k4, k5;
+	uint64_t mu, polynomial;
+};
+
+static constexpr FoldConstants CRC32_FOLD{ 0x0154442BD4, 0x01C6E41596, 0x01751997D0, 0x00CCAA009E, 0x0163CD6124, 0x01F7011641, 0x01DB710641 };
+static constexpr FoldConstants CRC32C_FOLD{ 0x00740EEF02, 0x009E4ADDF8, 0x00F20C0DFE, 0x014CD00BD6, 0x00DD45AAB8, 0x00DEA713F1, 0x0105EC76F1 };
+
+// Folds four 128 bit lanes of the data 64 bytes at a time with carry-less
+// multiplies by powers of x modulo the polynomial, then folds the lanes into
+// one and Barrett reduces it to the CRC, as in Intel's "Fast CRC Computation
+// for Generic Polynomials Using PCLMULQDQ Instruction". length is a multiple
+// of 16 and at least 64.
+template <const FoldConstants& constants>
+CRC32_TARGET("pclmul,sse4.1")
+static uint32_t FoldClmul(uint32_t crc, const uint8_t* data, size_t length)
+{
+	const __m128i k1k2 = _mm_set_epi64x(constants.k2, constants.k1);
+	const __m128i k3k4 = _mm_set_epi64x(constants.k4, constants.k3);
+	const __m128i k5k0 = _mm_set_epi64x(0, constants.k5);
+	const __m128i poly = _mm_set_epi64x(constants.mu, constants.polynomial);
+	const __m128i mask32 = _mm_setr_epi32(~0, 0, ~0, 0);
+
+	__m128i x1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+	__m128i x2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16));
+	__m128i x3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32));
+	__m128i x4 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48));
+	x1 = _mm_xor_si128(x1, _mm_cvtsi32_si128(static_cast<int>(crc)));
+	data += 64;
+	length -= 64;
+
+	while (length >= 64) {
+		__m128i x5 = _mm_clmulepi64_si128(x1, k1k2, 0x00);
+		__m128i x6 = _mm_clmulepi64_si128(x2, k1k2, 0x00);
+		__m128i x7 = _mm_clmulepi64_si128(x3, k1k2, 0x00);
+		__m128i x8 = _mm_clmulepi64_si128(x4, k1k2, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k1k2, 0x11);
+		x2 = _mm_clmulepi64_si128(x2, k1k2, 0x11);
+		x3 = _mm_clmulepi64_si128(x3, k1k2, 0x11);
+		x4 = _mm_clmulepi64_si128(x4, k1k2, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, x5), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data)));
+		x2 = _mm_xor_si128(_mm_xor_si128(x2, x6), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16)));
+		x3 = _mm_xor_si128(_mm_xor_si128(x3, x7), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 32)));
+		x4 = _mm_xor_si128(_mm_xor_si128(x4, x8), _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 48)));
+		data += 64;
+		length -= 64;
+	}
+
+	// Four lanes into one
+	for (__m128i lane : { x2, x3, x4 }) {
+		__m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, lane), x5);
+	}
+
+	while (length >= 16) {
+		__m128i x5 = _mm_clmulepi64_si128(x1, k3k4, 0x00);
+		x1 = _mm_clmulepi64_si128(x1, k3k4, 0x11);
+		x1 = _mm_xor_si128(_mm_xor_si128(x1, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data))), x5);
+		data += 16;
+		length -= 16;
+	}
+
+	// 128 bits to 64
+	__m128i folded = _mm_clmulepi64_si128(x1, k3k4, 0x10);
+	x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), folded);
+	__m128i high = _mm_srli_si128(x1, 4);
+	x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5k0, 0x00);
+	x1 = _mm_xor_si128(x1, high);
+
+	// Barrett reduction to 32 bits
+	__m128i quotient = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), poly, 0x10);
+	__m128i product = _mm_clmulepi64_si128(_mm_and_si128(quotient, mask32), poly, 0x00);
+	x1 = _mm_xor_si128(x1, product);
+	return static_cast<uint32_t>(_mm_extract_epi32(x1, 1));
+}
+
+CRC32_TARGET("pclmul,sse4.1")
+static uint32_t UpdateClmul(uint32_t crc, const uint8_t* data, size_t length)
+{
+	if (length >= CLMUL_MIN_LENGTH) {
+		size_t folded = length & ~static_cast<size_t>(15);
+		crc = FoldClmul<CRC32_FOLD>(crc, data, folded);
+		data += folded;
+		length -= folded;
+	}
+	return UpdateSlicing8<CRC32_TABLES>(crc, data, length);
+}
+
+// The CRC32 instruction has a latency of three cycles for eight bytes, so
+// long runs are folded as well and only what is left goes through it
+template <bool fold>
+CRC32_TARGET("pclmul,sse4.2")
+static uint32_t UpdateSse42(uint32_t crc, const uint8_t* data, size_t length)
+{
+	if (fold && length >= CLMUL_MIN_LENGTH) {
+		size_t folded = length & ~static_cast<size_t>(15);
+		crc = FoldClmul<CRC32C_FOLD>(crc, data, folded);
+		data += folded;
+		length -= folded;
+	}
+
+	uint64_t crc64 = crc;
+	while (length >= 8) {
+		uint64_t word;
+		std::memcpy(&word, data, sizeof(word));
+		crc64 = _mm_crc32_u64(crc64, word);
+		data += 8;
+		length -= 8;
+	}
+	crc = static_cast<uint32_t>(crc64);
+	for (size_t i = 0; i < length; ++i) {
+		crc = _mm_crc32_u8(crc, data[i]);
+	}
+	return crc;
+}
+#endif
+
+struct CpuFeatures
+{
+	bool pclmul = false;
+	bool sse41 = false;
+	bool sse42 = false;
+};
+
+static CpuFeatures DetectCpuFeatures()
+{
+	CpuFeatures features;
+#if CRC32_X64
+#ifdef _MSC_VER
+	int registers[4] = {};
+	__cpuid(registers, 1);
+	unsigned int ecx = static_cast<unsigned int>(registers[2]);
+#else
+	unsigned int eax = 0, ebx = 0, ecx = 0, edx = 0;
+	if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+		return features;
+	}
+#endif
+	features.pclmul = (ecx & (1u << 1)) != 0;
+	features.sse41 = (ecx & (1u << 19)) != 0;
+	features.sse42 = (ecx & (1u << 20)) != 0;
+#endif
+	return features;
+}
+
+// Picked with CPUID the first time a CRC is computed
+static const Kernel& Crc32Kernel()
+{
+	static const Kernel kernel = []() {
+#if CRC32_X64
+		CpuFeatures features = DetectCpuFeatures();
+		if (features.pclmul && features.sse41) {
+			return Kernel{ UpdateClmul, "pclmul" };
+		}
+#endif
+		return Kernel{ UpdateSlicing8<CRC32_TABLES>, "slicing-by-8" };
+	}();
+	return kernel;
+}
+
+static const Kernel& Crc32cKernel()
+{
+	static const Kernel kernel = []() {
+#if CRC32_X64
+		CpuFeatures features = DetectCpuFeatures();
+		if (features.sse42 && features.pclmul) {
+			return Kernel{ UpdateSse42<true>, "sse4.2+pclmul" };
+		}
+		if (features.sse42) {
+			return Kernel{ UpdateSse42<false>, "sse4.2" };
+		}
+#endif
+		return Kernel{ UpdateSlicing8<CRC32C_TABLES>, "slicing-by-8" };
+	}();
+	return kernel;
 }
 
 CRC32::CRC32()
 {
-	if (!table_initialized) generate_table();
 	reset();
 }
 
@@ -34,9 +276,7 @@ void CRC32::reset()
 
 void CRC32::update(const uint8_t* data, size_t length)
 {
-	for (size_t i = 0; i < length; ++i) {
-		crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
-	}
+	crc = Crc32Kernel().update(crc, data, length);
 }
 
 uint32_t CRC32::value() const
@@ -50,3 +290,40 @@ uint32_t CRC32::calculate(const uint8_t* data, size_t length)
 	c.update(data, length);
 	return c.value();
 }
+
+const char* CRC32::kernel()
+{
+	return Crc32Kernel().name;
+}
+
+CRC32C::CRC32C()
+{
+	reset();
+}
+
+void CRC32C::reset()
+{
+	crc = 0xFFFFFFFFU;
+}
+
+void CRC32C::update(const uint8_t* data, size_t length)
+{
+	crc = Crc32cKernel().update(crc, data, length);
+}
+
+uint32_t CRC32C::value() const
+{
+	return crc ^ 0xFFFFFFFFU;
+}
+
+uint32_t CRC32C::calculate(const uint8_t* data, size_t length)
+{
+	CRC32C c;
+	c.update(data, length);
+	return c.value();
+}
+
+const char* CRC32C::kernel()
+{
+	return Crc32cKernel().name;
+}
@@ -2,6 +2,9 @@
 #include <cstdint>
 #include <cstddef>
 
+// Reflected CRC32 with the IEEE polynomial of Ethernet and zlib. update runs
+// the fastest kernel the CPU supports, picked once with CPUID: carry-less
+// multiply folding with PCLMULQDQ for long runs, slicing-by-8 otherwise.
 class CRC32
 {
 public:
@@ -12,9 +15,24 @@ public:
     void update(const uint8_t* data, size_t length);
     uint32_t value() const;
     static uint32_t calculate(const uint8_t* data, size_t length);
+    // Name of the kernel update runs on this CPU
+    static const char* kernel();
+private:
+    uint32_t crc;
+};
+
+// CRC32C with the Castagnoli polynomial, which SSE4.2 computes in hardware.
+// Falls back to slicing-by-8 on CPUs without it.
+class CRC32C
+{
+public:
+    CRC32C();
+    void reset();
+    void update(const uint8_t* data, size_t length);
+    uint32_t value() const;
+    static uint32_t calculate(const uint8_t* data, size_t length);
+    // Name of the kernel update runs on this CPU
+    static const char* kernel();
 private:
     uint32_t crc;
-    static uint32_t table[256];
-    static void generate_table();
-    static bool table_initialized;
 };
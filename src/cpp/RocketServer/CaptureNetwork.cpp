@@ -0,0 +1,117 @@
+#include "CaptureNetwork.h"
+#include <algorithm>
+
+CaptureNetwork::CaptureNetwork(std::shared_ptr<Logger> logger, std::shared_ptr<NetworkBase> network, const std::string& path, CodecId codec)
+	: m_logger(logger), m_network(network), m_path(path), m_codec(codec), m_writeBuffer(WRITE_BUFFER_SIZE)
+{
+	// Large buffer so that capturing does not add a write syscall per datagram
+	m_file.rdbuf()->pubsetbuf(m_writeBuffer.data(), m_writeBuffer.size());
+}
+
+CaptureNetwork::~CaptureNetwork()
+{
+	if (m_file.is_open())
+	{
+		m_file.close();
+		m_logger->Log(LogLevel::INFO, "CaptureNetwork: Capture closed", { KVS(m_path), KV(m_records) });
+	}
+}
+
+void CaptureNetwork::Write(CaptureDirection direction, std::chrono::steady_clock::time_point time, const sockaddr_in& addr, NetworkPacket& networkPacket)
+{
+	// Kernel timestamps of datagrams queued before the capture started are clamped to its start
+	auto elapsed = std::max(time, m_start) - m_start;
+
+	CaptureRecordHeader header;
+	header.timestampNs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	header.direction = direction;
+	header.port = addr.sin_port;
+	header.address = addr.sin_addr.s_addr;
+	header.size = static_cast<uint16_t>(networkPacket.Size());
+
+	m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	m_file.write(reinterpret_cast<const char*>(networkPacket.Data()), header.size);
+	m_records++;
+}
+
+int CaptureNetwork::Initialize(std::string server, int port, sockaddr_in& addr)
+{
+	m_file.open(m_path, std::ios::binary | std::ios::trunc);
+	if (!m_file.is_open())
+	{
+		m_logger->Log(LogLevel::EXCEPTION, "Initialize: Failed to open capture file", { KVS(m_path) });
+		return 1;
+	}
+
+	CaptureFileHeader header;
+	header.codec = m_codec;
+	m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	m_start = std::chrono::steady_clock::now();
+
+	m_logger->Log(LogLevel::INFO, "Initialize: Capturing traffic", { KVS(m_path) });
+	return m_network->Initialize(server, port, addr);
+}
+
+int CaptureNetwork::Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
+{
+	int result = m_network->Send(networkPacket, clientAddr);
+	if (result == 0)
+	{
+		// Recorded after sending so that the bytes include the CRC
+		Write(CaptureDirection::SENT, std::chrono::steady_clock::now(), clientAddr, networkPacket);
+	}
+	return result;
+}
+
+int CaptureNetwork::SendBatch(std::vector<OutgoingPacket>& outgoingPackets)
+{
+	// Written before the wrapped network takes the packets
+	auto now = std::chrono::steady_clock::now();
+	for (OutgoingPacket& outgoingPacket : outgoingPackets)
+	{
+		Write(CaptureDirection::SENT, now, outgoingPacket.clientAddr, *outgoingPacket.networkPacket);
+	}
+	return m_network->SendBatch(outgoingPackets);
+}
+
+PacketHandle CaptureNetwork::Receive(sockaddr_in& clientAddr, int& result)
+{
+	PacketHandle networkPacket = m_network->Receive(clientAddr, result);
+	if (result == 0)
+	{
+		Write(CaptureDirection::RECEIVED, networkPacket->ReceiveTime(), clientAddr, *networkPacket);
+	}
+	return networkPacket;
+}
+
+int CaptureNetwork::ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets)
+{
+	size_t first = receivedPackets.size();
+	int result = m_network->ReceiveBatch(receivedPackets);
+	for (size_t i = first; i < receivedPackets.size(); i++)
+	{
+		ReceivedPacket& receivedPacket = receivedPackets[i];
+		Write(CaptureDirection::RECEIVED, receivedPacket.networkPacket->ReceiveTime(), receivedPacket.clientAddr, *receivedPacket.networkPacket);
+	}
+	return result;
+}
+
+int CaptureNetwork::StartTimer(int timerId, std::chrono::nanoseconds interval)
+{
+	return m_network->StartTimer(timerId, interval);
+}
+
+int CaptureNetwork::WaitForEvents(std::vector<int>& expiredTimers)
+{
+	return m_network->WaitForEvents(expiredTimers);
+}
+
+NetworkCounters CaptureNetwork::GetCounters()
+{
+	return m_network->GetCounters();
+}
+
+void CaptureNetwork::ReleasePeer(const sockaddr_in& clientAddr)
+{
+	m_network->ReleasePeer(clientAddr);
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include "NetworkBase.h"
+#include "Logger.h"
+#include "CaptureRecord.h"
+
+// Decorator which appends every datagram received and successfully sent by
+// the wrapped network to a capture file, see CaptureRecord.h. Batches are
+// written before they are sent, since the wrapped network may take their
+// packets, so a failed batched send is recorded as well. The capture can be
+// fed back into a server with ReplayNetwork.
+class CaptureNetwork : public NetworkBase
+{
+private:
+	static constexpr size_t WRITE_BUFFER_SIZE = 1 << 20;
+
+	std::shared_ptr<Logger> m_logger;
+	std::shared_ptr<NetworkBase> m_network;
+	std::string m_path;
+	CodecId m_codec;
+
+	std::vector<char> m_writeBuffer;
+	std::ofstream m_file;
+	std::chrono::steady_clock::time_point m_start{};
+	uint64_t m_records = 0;
+
+	void Write(CaptureDirection direction, std::chrono::steady_clock::time_point time, const sockaddr_in& addr, NetworkPacket& networkPacket);
+
+public:
+	// The codec of the server is recorded in the file header for the replay
+	CaptureNetwork(std::shared_ptr<Logger> logger, std::shared_ptr<NetworkBase> network, const std::string& path, CodecId codec = CodecId::CRC32);
+	~CaptureNetwork();
+
+	int Initialize(std::string server, int port, sockaddr_in& addr) override;
+	int Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr) override;
+	int SendBatch(std::vector<OutgoingPacket>& outgoingPackets) override;
+	PacketHandle Receive(sockaddr_in& clientAddr, int& result) override;
+	int ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets) override;
+	int StartTimer(int timerId, std::chrono::nanoseconds interval) override;
+	int WaitForEvents(std::vector<int>& expiredTimers) override;
+	NetworkCounters GetCounters() override;
+	void ReleasePeer(const sockaddr_in& clientAddr) override;
+};
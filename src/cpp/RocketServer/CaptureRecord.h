@@ -0,0 +1,37 @@
+#pragma once
+#include <cstdint>
+#include "PacketCodec.h"
+
+// Capture files start with CaptureFileHeader followed by one record per
+// datagram: CaptureRecordHeader and then size bytes of the datagram exactly
+// as it was on the wire. Fields are in host byte order except address and
+// port, which are kept in network byte order as in sockaddr_in.
+
+static constexpr uint32_t CAPTURE_MAGIC = 0x50414352; // "RCAP"
+static constexpr uint16_t CAPTURE_VERSION = 1;
+
+enum class CaptureDirection : uint8_t {
+    RECEIVED = 0,
+    SENT = 1
+};
+
+#pragma pack(push, 1)
+struct CaptureFileHeader
+{
+    uint32_t magic = CAPTURE_MAGIC;
+    uint16_t version = CAPTURE_VERSION;
+    // Codec of the server which wrote the capture, older captures left it 0 which is CRC32
+    CodecId codec = CodecId::CRC32;
+};
+
+struct CaptureRecordHeader
+{
+    // Nanoseconds since the capture started, the kernel receive time for received datagrams
+    uint64_t timestampNs = 0;
+    CaptureDirection direction = CaptureDirection::RECEIVED;
+    uint8_t reserved = 0;
+    uint16_t port = 0;
+    uint32_t address = 0;
+    uint16_t size = 0;
+};
+#pragma pack(pop)
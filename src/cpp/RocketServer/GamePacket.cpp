@@ -1,40 +1,301 @@
+#include <cmath>
+#include <algorithm>
 #include "GamePacket.h"
+#include "PhysicsEngine.h"
+#include "BitWriter.h"
+#include "BitReader.h"
+
+uint32_t GamePacket::QuantizeRange(float value, float max, int bits)
+{
+    // Out of range and NaN values are clamped to the nearest bound
+    uint32_t steps = (1u << bits) - 1;
+    if (!(value > 0.0f))
+    {
+        return 0;
+    }
+    if (!(value < max))
+    {
+        return steps;
+    }
+    return static_cast<uint32_t>(std::lround(value / max * steps));
+}
+
+float GamePacket::DequantizeRange(uint32_t quantized, float max, int bits)
+{
+    uint32_t steps = (1u << bits) - 1;
+    return max * (static_cast<float>(quantized) / steps);
+}
+
+uint32_t GamePacket::QuantizeSigned(float value, float max, int bits)
+{
+    // Symmetric around zero so that a resting value stays exactly zero
+    int32_t steps = (1 << (bits - 1)) - 1;
+    float normalized = std::isnan(value) ? 0.0f : std::clamp(value / max, -1.0f, 1.0f);
+    return static_cast<uint32_t>(std::lround(normalized * steps) + steps);
+}
+
+float GamePacket::DequantizeSigned(uint32_t quantized, float max, int bits)
+{
+    int32_t steps = (1 << (bits - 1)) - 1;
+    return max * (static_cast<float>(static_cast<int32_t>(quantized) - steps) / steps);
+}
+
+uint32_t GamePacket::QuantizeAngle(float angle, int bits)
+{
+    // Wraps around, a full turn is the same angle as none
+    uint32_t turns = 1u << bits;
+    if (!std::isfinite(angle))
+    {
+        return 0;
+    }
+    float fraction = std::fmod(angle, PhysicsEngine::FULL_ROTATION) / PhysicsEngine::FULL_ROTATION;
+    return static_cast<uint32_t>(std::lround(fraction * turns)) & (turns - 1);
+}
+
+float GamePacket::DequantizeAngle(uint32_t quantized, int bits)
+{
+    uint32_t turns = 1u << bits;
+    return PhysicsEngine::FULL_ROTATION * (static_cast<float>(quantized) / turns);
+}
+
+GamePacket::QuantizedFields GamePacket::Quantize(const PlayerState& playerState)
+{
+    QuantizedFields fields{};
+    fields[POSITION_X] = QuantizeRange(playerState.pos.x.floatValue, PhysicsEngine::WORLD_WIDTH, POSITION_BITS);
+    fields[POSITION_Y] = QuantizeRange(playerState.pos.y.floatValue, PhysicsEngine::WORLD_HEIGHT, POSITION_BITS);
+    fields[VELOCITY_X] = QuantizeSigned(playerState.vel.x.floatValue, PhysicsEngine::MAX_SPEED, VELOCITY_BITS);
+    fields[VELOCITY_Y] = QuantizeSigned(playerState.vel.y.floatValue, PhysicsEngine::MAX_SPEED, VELOCITY_BITS);
+    fields[ROTATION] = QuantizeAngle(playerState.rotation.floatValue, ROTATION_BITS);
+    fields[HEALTH] = QuantizeRange(playerState.health.floatValue, MAX_HEALTH, HEALTH_BITS);
+    fields[KEYBOARD] = playerState.keyboard.ToByte();
+    return fields;
+}
+
+void GamePacket::Dequantize(const QuantizedFields& fields, PlayerState& playerState)
+{
+    playerState.pos.x.floatValue = DequantizeRange(fields[POSITION_X], PhysicsEngine::WORLD_WIDTH, POSITION_BITS);
+    playerState.pos.y.floatValue = DequantizeRange(fields[POSITION_Y], PhysicsEngine::WORLD_HEIGHT, POSITION_BITS);
+    playerState.vel.x.floatValue = DequantizeSigned(fields[VELOCITY_X], PhysicsEngine::MAX_SPEED, VELOCITY_BITS);
+    playerState.vel.y.floatValue = DequantizeSigned(fields[VELOCITY_Y], PhysicsEngine::MAX_SPEED, VELOCITY_BITS);
+    playerState.speed.floatValue = std::sqrt(playerState.vel.x.floatValue * playerState.vel.x.floatValue + playerState.vel.y.floatValue * playerState.vel.y.floatValue);
+    playerState.rotation.floatValue = DequantizeAngle(fields[ROTATION], ROTATION_BITS);
+    playerState.health.floatValue = DequantizeRange(fields[HEALTH], MAX_HEALTH, HEALTH_BITS);
+    playerState.keyboard.ReadFromByte(static_cast<uint8_t>(fields[KEYBOARD]));
+}
+
+void GamePacket::QuantizePlayerState(PlayerState& playerState)
+{
+    Dequantize(Quantize(playerState), playerState);
+}
 
 void GamePacket::SerializePlayerState(const PlayerState& playerState)
 {
-    WriteInt8(playerState.playerID);
-    WriteInt32(playerState.pos.x.intValue);
-    WriteInt32(playerState.pos.y.intValue);
-    WriteInt32(playerState.vel.x.intValue);
-    WriteInt32(playerState.vel.y.intValue);
-    WriteInt32(playerState.speed.intValue);
-    WriteInt32(playerState.rotation.intValue);
-    WriteInt32(playerState.health.intValue);
-    WriteInt8(playerState.keyboard.ToByte());
+    BitWriter writer(*this);
+    writer.WriteBits(playerState.playerID, PLAYER_ID_BITS);
+    QuantizedFields fields = Quantize(playerState);
+    for (int field = 0; field < FIELD_COUNT; field++)
+    {
+        writer.WriteBits(fields[field], FIELD_BITS[field]);
+    }
+    writer.Flush();
+}
+
+PlayerState GamePacket::DeserializePlayerState(std::span<const uint8_t> bytes)
+{
+    BitReader reader(bytes);
+    PlayerState playerState{};
+    playerState.playerID = static_cast<uint8_t>(reader.ReadBits(PLAYER_ID_BITS));
+    QuantizedFields fields{};
+    for (int field = 0; field < FIELD_COUNT; field++)
+    {
+        fields[field] = reader.ReadBits(FIELD_BITS[field]);
+    }
+    Dequantize(fields, playerState);
+    return playerState;
 }
 
-std::vector<PlayerState> GamePacket::DeserializePlayerStates()
+uint32_t GamePacket::ChangedMask(const QuantizedFields& fields, const QuantizedFields& baselineFields)
 {
+    uint32_t changedMask = 0;
+    for (int field = 0; field < FIELD_COUNT; field++)
+    {
+        if (fields[field] != baselineFields[field])
+        {
+            changedMask |= 1u << field;
+        }
+    }
+    return changedMask;
+}
+
+GamePacket::BaselineStates GamePacket::FindBaselineStates(const std::vector<PlayerState>& baseline)
+{
+    BaselineStates baselineStates{};
+    for (const PlayerState& playerState : baseline)
+    {
+        baselineStates[playerState.playerID] = &playerState;
+    }
+    return baselineStates;
+}
+
+size_t GamePacket::SerializeSnapshot(std::span<const PlayerState> playerStates, const std::vector<PlayerState>& baseline, size_t maxSize, bool entropyCoded)
+{
+    BaselineStates baselineStates = FindBaselineStates(baseline);
+
+    // Count is written once known
+    size_t countOffset = Size();
+    WriteInt8(0);
+
+    size_t count = entropyCoded ?
+        SerializeCodedStates(playerStates, baselineStates, maxSize) :
+        SerializeStates(playerStates, baselineStates, maxSize);
+
+    Data()[countOffset] = static_cast<uint8_t>(count);
+    return count;
+}
+
+size_t GamePacket::SerializeStates(std::span<const PlayerState> playerStates, const BaselineStates& baselineStates, size_t maxSize)
+{
+    const PlayerState defaultState{};
+    BitWriter writer(*this);
+    size_t count = 0;
+    for (const PlayerState& playerState : playerStates)
+    {
+        size_t worstCaseSize = Size() + (writer.PendingBits() + PLAYER_STATE_DELTA_BITS + 7) / 8;
+        if (count == UINT8_MAX || worstCaseSize > maxSize)
+        {
+            break;
+        }
+
+        const PlayerState* baselineState = baselineStates[playerState.playerID];
+        QuantizedFields fields = Quantize(playerState);
+        QuantizedFields baselineFields = Quantize(baselineState != nullptr ? *baselineState : defaultState);
+        uint32_t changedMask = ChangedMask(fields, baselineFields);
+
+        writer.WriteBits(playerState.playerID, PLAYER_ID_BITS);
+        writer.WriteBits(changedMask, FIELD_COUNT);
+        for (int field = 0; field < FIELD_COUNT; field++)
+        {
+            if (changedMask & (1u << field))
+            {
+                writer.WriteBits(fields[field], FIELD_BITS[field]);
+            }
+        }
+        count++;
+    }
+    writer.Flush();
+    return count;
+}
+
+size_t GamePacket::SerializeCodedStates(std::span<const PlayerState> playerStates, const BaselineStates& baselineStates, size_t maxSize)
+{
+    // Coded sizes have no useful worst case, a state which does not fit is undone instead
+    RangeEncoder encoder(*this);
+    SnapshotModel model;
+    uint8_t previousPlayerID = 0;
+    size_t count = 0;
+    for (const PlayerState& playerState : playerStates)
+    {
+        if (count == UINT8_MAX)
+        {
+            break;
+        }
+
+        RangeEncoder::Checkpoint checkpoint = encoder.Save();
+        EncodeState(encoder, model, playerState, baselineStates[playerState.playerID], previousPlayerID);
+        if (Size() + encoder.PendingBytes() > maxSize)
+        {
+            encoder.Restore(checkpoint);
+            break;
+        }
+
+        previousPlayerID = playerState.playerID;
+        count++;
+    }
+    encoder.Flush();
+    return count;
+}
+
+std::vector<PlayerState> GamePacket::DeserializeSnapshot(std::span<const uint8_t> bytes, const std::vector<PlayerState>& baseline, bool entropyCoded)
+{
+    BaselineStates baselineStates = FindBaselineStates(baseline);
+    const PlayerState defaultState{};
+
     std::vector<PlayerState> playerStates;
-    auto players = ReadInt8();
-    for (int i = 0; i < players; ++i) {
-        PlayerState playerState = DeserializePlayerState();
+    if (bytes.empty())
+    {
+        return playerStates;
+    }
+
+    size_t count = bytes[0];
+    playerStates.reserve(count);
+
+    if (entropyCoded)
+    {
+        // Zeros are read past the end, a truncated snapshot cannot be told apart
+        RangeDecoder decoder(bytes.subspan(1));
+        SnapshotModel model;
+        uint8_t previousPlayerID = 0;
+        for (size_t i = 0; i < count; i++)
+        {
+            uint8_t playerID = model.DecodePlayerId(decoder, previousPlayerID);
+            const PlayerState* baselineState = baselineStates[playerID];
+            QuantizedFields fields = Quantize(baselineState != nullptr ? *baselineState : defaultState);
+
+            uint32_t changedMask = model.DecodeChangedMask(decoder);
+            for (int field = 0; field < FIELD_COUNT; field++)
+            {
+                if (changedMask & (1u << field))
+                {
+                    fields[field] = model.DecodeField(decoder, field, FIELD_BITS[field], fields[field]);
+                }
+            }
+
+            PlayerState playerState{};
+            playerState.playerID = playerID;
+            Dequantize(fields, playerState);
+            playerStates.push_back(playerState);
+            previousPlayerID = playerID;
+        }
+        return playerStates;
+    }
+
+    BitReader reader(bytes.subspan(1));
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t playerID = static_cast<uint8_t>(reader.ReadBits(PLAYER_ID_BITS));
+        const PlayerState* baselineState = baselineStates[playerID];
+        QuantizedFields fields = Quantize(baselineState != nullptr ? *baselineState : defaultState);
+
+        uint32_t changedMask = reader.ReadBits(FIELD_COUNT);
+        for (int field = 0; field < FIELD_COUNT; field++)
+        {
+            if (changedMask & (1u << field))
+            {
+                fields[field] = reader.ReadBits(FIELD_BITS[field]);
+            }
+        }
+
+        // Truncated snapshots keep the states read completely
+        if (reader.Overrun())
+        {
+            break;
+        }
+
+        PlayerState playerState{};
+        playerState.playerID = playerID;
+        Dequantize(fields, playerState);
         playerStates.push_back(playerState);
     }
     return playerStates;
 }
 
-inline PlayerState GamePacket::DeserializePlayerState()
+std::vector<PlayerState> GamePacket::DeserializeSnapshotFragments(std::span<const std::span<const uint8_t>> fragments, const std::vector<PlayerState>& baseline, bool entropyCoded)
 {
-    PlayerState playerState{};
-    playerState.playerID = ReadInt8();
-    playerState.pos.x.intValue = ReadInt32();
-    playerState.pos.y.intValue = ReadInt32();
-    playerState.vel.x.intValue = ReadInt32();
-    playerState.vel.y.intValue = ReadInt32();
-    playerState.speed.intValue = ReadInt32();
-    playerState.rotation.intValue = ReadInt32();
-    playerState.health.intValue = ReadInt32();
-    playerState.keyboard.ReadFromByte(ReadInt8());
-    return playerState;
+    std::vector<PlayerState> playerStates;
+    for (std::span<const uint8_t> fragment : fragments)
+    {
+        std::vector<PlayerState> fragmentStates = DeserializeSnapshot(fragment, baseline, entropyCoded);
+        playerStates.insert(playerStates.end(), fragmentStates.begin(), fragmentStates.end());
+    }
+    return playerStates;
 }
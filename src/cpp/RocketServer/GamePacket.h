@@ -1,16 +1,107 @@
 #pragma once
+#include <array>
 #include "NetworkPacket.h"
 #include "Keyboard.h"
 #include "PlayerState.h"
+#include "SnapshotModel.h"
 
+// Player states are bit-packed with every value quantized to the range the
+// simulation keeps it in: positions within the world, velocities within
+// the maximum speed, the rotation as a fraction of a full turn. Speed is
+// not sent but derived from the velocity. Dequantized values depend only
+// on the transmitted integers, so QuantizePlayerState gives the sender the
+// exact values the receiver simulates on.
+//
+// Snapshots are delta encoded against a baseline snapshot the receiver
+// already has. Every state carries a mask of the fields which changed since
+// the state of the same player in the baseline and only those fields, or
+// the fields which differ from a default state when the player is not in it.
+// Entropy coded snapshots code the same symbols with SnapshotModel and a
+// range coder instead of writing them as plain bits.
 class GamePacket :
     public NetworkPacket
 {
 private:
+    // Positions in steps of about 1/8, velocities of about 1/16 and rotations of about 1/650 of a radian
+    static constexpr int PLAYER_ID_BITS = 8;
+    static constexpr int POSITION_BITS = 14;
+    static constexpr int VELOCITY_BITS = 14;
+    static constexpr int ROTATION_BITS = 12;
+    static constexpr int HEALTH_BITS = 7;
+    static constexpr int KEYBOARD_BITS = 5;
+
+    // Quantized fields in wire order
+    enum Field { POSITION_X, POSITION_Y, VELOCITY_X, VELOCITY_Y, ROTATION, HEALTH, KEYBOARD, FIELD_COUNT };
+    static constexpr int FIELD_BITS[FIELD_COUNT] = { POSITION_BITS, POSITION_BITS, VELOCITY_BITS, VELOCITY_BITS, ROTATION_BITS, HEALTH_BITS, KEYBOARD_BITS };
+    using QuantizedFields = std::array<uint32_t, FIELD_COUNT>;
+
+    static constexpr int PLAYER_STATE_BITS = PLAYER_ID_BITS + 2 * POSITION_BITS + 2 * VELOCITY_BITS + ROTATION_BITS + HEALTH_BITS + KEYBOARD_BITS;
+    // A state of a snapshot with every field changed
+    static constexpr int PLAYER_STATE_DELTA_BITS = PLAYER_STATE_BITS + FIELD_COUNT;
+
+    static_assert(FIELD_COUNT == SnapshotModel::FIELD_COUNT, "Model has a context per field");
+    static_assert(POSITION_BITS <= SnapshotModel::MAX_FIELD_BITS && VELOCITY_BITS <= SnapshotModel::MAX_FIELD_BITS, "Model codes the bit length of every field");
+
+    using BaselineStates = std::array<const PlayerState*, 256>;
+
+    static uint32_t QuantizeRange(float value, float max, int bits);
+    static float DequantizeRange(uint32_t quantized, float max, int bits);
+    static uint32_t QuantizeSigned(float value, float max, int bits);
+    static float DequantizeSigned(uint32_t quantized, float max, int bits);
+    static uint32_t QuantizeAngle(float angle, int bits);
+    static float DequantizeAngle(uint32_t quantized, int bits);
+    static QuantizedFields Quantize(const PlayerState& playerState);
+    static void Dequantize(const QuantizedFields& fields, PlayerState& playerState);
+    static uint32_t ChangedMask(const QuantizedFields& fields, const QuantizedFields& baselineFields);
+
+    // Baseline states by player id, players not in it are compared against a default state
+    static BaselineStates FindBaselineStates(const std::vector<PlayerState>& baseline);
+
+    size_t SerializeStates(std::span<const PlayerState> playerStates, const BaselineStates& baselineStates, size_t maxSize);
+    size_t SerializeCodedStates(std::span<const PlayerState> playerStates, const BaselineStates& baselineStates, size_t maxSize);
 
 public:
+    static constexpr float MAX_HEALTH = 100.0f;
+
+    // Bytes written by SerializePlayerState
+    static constexpr size_t PLAYER_STATE_SIZE = (PLAYER_STATE_BITS + 7) / 8;
+
+    // Rounds the state to the values a receiver of it deserializes
+    static void QuantizePlayerState(PlayerState& playerState);
+
     void SerializePlayerState(const PlayerState& playerState);
-    std::vector<PlayerState> DeserializePlayerStates();
-    inline PlayerState DeserializePlayerState();
+    // Reads a state from the received bytes written by SerializePlayerState
+    static PlayerState DeserializePlayerState(std::span<const uint8_t> bytes);
+
+    // Writes the count and as many of the states as fit into a packet of
+    // maxSize bytes, delta encoded against baseline, which is empty for a
+    // full snapshot. Returns the number of states written.
+    size_t SerializeSnapshot(std::span<const PlayerState> playerStates, const std::vector<PlayerState>& baseline, size_t maxSize, bool entropyCoded = false);
+    // Reads the received bytes written by SerializeSnapshot against the same
+    // baseline, a truncated snapshot gives the states read completely
+    static std::vector<PlayerState> DeserializeSnapshot(std::span<const uint8_t> bytes, const std::vector<PlayerState>& baseline, bool entropyCoded = false);
+    // Reads a snapshot sent in fragments, each one written by SerializeSnapshot
+    // with the states which did not fit the fragments before it
+    static std::vector<PlayerState> DeserializeSnapshotFragments(std::span<const std::span<const uint8_t>> fragments, const std::vector<PlayerState>& baseline, bool entropyCoded = false);
+
+    // Codes the state of an entropy coded snapshot against its state in the
+    // baseline, nullptr when it has none. Also drives the model training.
+    template <typename Encoder>
+    static void EncodeState(Encoder& encoder, SnapshotModel& model, const PlayerState& playerState, const PlayerState* baselineState, uint8_t previousPlayerID)
+    {
+        QuantizedFields fields = Quantize(playerState);
+        QuantizedFields baselineFields = Quantize(baselineState != nullptr ? *baselineState : PlayerState{});
+        uint32_t changedMask = ChangedMask(fields, baselineFields);
+
+        model.EncodePlayerId(encoder, playerState.playerID, previousPlayerID);
+        model.EncodeChangedMask(encoder, changedMask);
+        for (int field = 0; field < FIELD_COUNT; field++)
+        {
+            if (changedMask & (1u << field))
+            {
+                model.EncodeField(encoder, field, FIELD_BITS[field], fields[field], baselineFields[field]);
+            }
+        }
+    }
 };
 
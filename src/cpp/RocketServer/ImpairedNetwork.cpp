@@ -0,0 +1,321 @@
+#include "ImpairedNetwork.h"
+#include <algorithm>
+#include <cstring>
+
+ImpairedNetwork::ImpairedNetwork(std::shared_ptr<Logger> logger, std::shared_ptr<NetworkBase> network, const ImpairmentOptions& options)
+	: m_logger(logger), m_network(network), m_options(options), m_random(options.seed)
+{
+	m_receiveBatch.reserve(MAX_BATCH_SIZE);
+	m_sendBatch.reserve(MAX_BATCH_SIZE);
+}
+
+ImpairedNetwork::~ImpairedNetwork()
+{
+	m_logger->Log(LogLevel::INFO, "ImpairedNetwork: Impairment statistics", { KV(m_dropped), KV(m_duplicated), KV(m_reordered) });
+}
+
+bool ImpairedNetwork::IsLater(const DelayedPacket& a, const DelayedPacket& b)
+{
+	// Min heap on the due time, datagrams due at the same time keep their order
+	return a.due > b.due || (a.due == b.due && a.order > b.order);
+}
+
+bool ImpairedNetwork::HasDelay() const
+{
+	return m_options.latencyMs > 0 || m_options.jitterMs > 0 || m_options.bandwidthBytesPerSecond > 0;
+}
+
+double ImpairedNetwork::NextProbability()
+{
+	return std::uniform_real_distribution<double>(0.0, 1.0)(m_random);
+}
+
+int ImpairedNetwork::Impair(Link& link, size_t size, std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point& due)
+{
+	if (m_options.lossRate > 0 && NextProbability() < m_options.lossRate)
+	{
+		m_dropped++;
+		return 0;
+	}
+
+	due = now;
+	if (m_options.reorderRate > 0 && NextProbability() < m_options.reorderRate)
+	{
+		m_reordered++;
+	}
+	else if (m_options.latencyMs > 0 || m_options.jitterMs > 0)
+	{
+		double delayMs = m_options.latencyMs + m_options.jitterMs * (2.0 * NextProbability() - 1.0);
+		due += std::chrono::microseconds(static_cast<int64_t>(std::max(0.0, delayMs) * 1000.0));
+	}
+
+	if (m_options.bandwidthBytesPerSecond > 0)
+	{
+		// Datagrams queue behind each other on the capped link
+		auto start = std::max(due, link.freeAt);
+		if (start - due > MAX_QUEUE_DELAY)
+		{
+			m_dropped++;
+			return 0;
+		}
+
+		auto transmitTime = std::chrono::nanoseconds(static_cast<int64_t>(size * 1e9 / m_options.bandwidthBytesPerSecond));
+		link.freeAt = start + transmitTime;
+		due = link.freeAt;
+	}
+
+	if (m_options.duplicateRate > 0 && NextProbability() < m_options.duplicateRate)
+	{
+		m_duplicated++;
+		return 2;
+	}
+	return 1;
+}
+
+void ImpairedNetwork::Schedule(Link& link, std::chrono::steady_clock::time_point due, const sockaddr_in& addr, PacketHandle networkPacket)
+{
+	DelayedPacket delayedPacket;
+	delayedPacket.due = due;
+	delayedPacket.order = m_order++;
+	delayedPacket.addr = addr;
+	delayedPacket.networkPacket = std::move(networkPacket);
+	link.delayed.push_back(std::move(delayedPacket));
+	std::push_heap(link.delayed.begin(), link.delayed.end(), IsLater);
+}
+
+PacketHandle ImpairedNetwork::Copy(NetworkPacket& networkPacket)
+{
+	PacketHandle copy = AcquirePacket();
+	copy->Resize(networkPacket.Size());
+	std::memcpy(copy->Data(), networkPacket.Data(), networkPacket.Size());
+	copy->SetReceiveTime(networkPacket.ReceiveTime());
+	return copy;
+}
+
+void ImpairedNetwork::PullIncoming()
+{
+	m_receiveBatch.clear();
+	while (m_network->ReceiveBatch(m_receiveBatch) == 0)
+	{
+		auto now = std::chrono::steady_clock::now();
+		for (ReceivedPacket& receivedPacket : m_receiveBatch)
+		{
+			std::chrono::steady_clock::time_point due;
+			int copies = Impair(m_incoming, receivedPacket.networkPacket->Size(), now, due);
+			if (copies == 0)
+			{
+				continue;
+			}
+
+			if (copies == 2)
+			{
+				Schedule(m_incoming, due, receivedPacket.clientAddr, Copy(*receivedPacket.networkPacket));
+			}
+			Schedule(m_incoming, due, receivedPacket.clientAddr, std::move(receivedPacket.networkPacket));
+		}
+		m_receiveBatch.clear();
+	}
+}
+
+void ImpairedNetwork::ReleaseDue()
+{
+	auto now = std::chrono::steady_clock::now();
+
+	while (!m_outgoing.delayed.empty() && m_outgoing.delayed.front().due <= now)
+	{
+		std::pop_heap(m_outgoing.delayed.begin(), m_outgoing.delayed.end(), IsLater);
+		DelayedPacket& delayedPacket = m_outgoing.delayed.back();
+		m_network->Send(*delayedPacket.networkPacket, delayedPacket.addr);
+		m_outgoing.delayed.pop_back();
+	}
+
+	while (!m_incoming.delayed.empty() && m_incoming.delayed.front().due <= now)
+	{
+		std::pop_heap(m_incoming.delayed.begin(), m_incoming.delayed.end(), IsLater);
+		DelayedPacket& delayedPacket = m_incoming.delayed.back();
+
+		// The datagram arrives when the simulated link delivers it
+		ReceivedPacket receivedPacket;
+		receivedPacket.networkPacket = std::move(delayedPacket.networkPacket);
+		receivedPacket.networkPacket->SetReceiveTime(std::max(delayedPacket.due, receivedPacket.networkPacket->ReceiveTime()));
+		receivedPacket.clientAddr = delayedPacket.addr;
+		m_readyPackets.push_back(std::move(receivedPacket));
+		m_incoming.delayed.pop_back();
+	}
+}
+
+int ImpairedNetwork::Initialize(std::string server, int port, sockaddr_in& addr)
+{
+	if (m_network->Initialize(server, port, addr) != 0)
+	{
+		return 1;
+	}
+
+	m_logger->Log(
+		LogLevel::INFO,
+		"Initialize: Network impairment enabled",
+		{ KV(m_options.latencyMs), KV(m_options.jitterMs), KV(m_options.lossRate), KV(m_options.duplicateRate),
+		  KV(m_options.reorderRate), KV(m_options.bandwidthBytesPerSecond), KV(m_options.seed) }
+	);
+
+	if (HasDelay())
+	{
+		// Wakes WaitForEvents up to release delayed datagrams on time
+		return m_network->StartTimer(IMPAIRMENT_TIMER, IMPAIRMENT_TIMER_INTERVAL);
+	}
+	return 0;
+}
+
+int ImpairedNetwork::Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
+{
+	ReleaseDue();
+
+	auto now = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point due;
+	int copies = Impair(m_outgoing, networkPacket.Size(), now, due);
+
+	// Lost datagrams look sent to the caller just like with UDP
+	int result = 0;
+	for (int i = 0; i < copies; i++)
+	{
+		if (due <= now)
+		{
+			result |= m_network->Send(networkPacket, clientAddr);
+		}
+		else
+		{
+			Schedule(m_outgoing, due, clientAddr, Copy(networkPacket));
+		}
+	}
+	return result;
+}
+
+int ImpairedNetwork::SendBatch(std::vector<OutgoingPacket>& outgoingPackets)
+{
+	ReleaseDue();
+
+	auto now = std::chrono::steady_clock::now();
+	m_sendBatch.clear();
+	m_sendSources.clear();
+	for (size_t i = 0; i < outgoingPackets.size(); i++)
+	{
+		OutgoingPacket& outgoingPacket = outgoingPackets[i];
+		outgoingPacket.result = 0;
+
+		std::chrono::steady_clock::time_point due;
+		int copies = Impair(m_outgoing, outgoingPacket.networkPacket->Size(), now, due);
+		for (int copy = 0; copy < copies; copy++)
+		{
+			if (due > now)
+			{
+				Schedule(m_outgoing, due, outgoingPacket.clientAddr, Copy(*outgoingPacket.networkPacket));
+				continue;
+			}
+
+			// Datagrams due now still go out as one batch of the wrapped network
+			OutgoingPacket immediatePacket;
+			immediatePacket.networkPacket = Copy(*outgoingPacket.networkPacket);
+			immediatePacket.clientAddr = outgoingPacket.clientAddr;
+			m_sendBatch.push_back(std::move(immediatePacket));
+			m_sendSources.push_back(i);
+		}
+	}
+
+	if (m_sendBatch.empty())
+	{
+		return 0;
+	}
+
+	int result = m_network->SendBatch(m_sendBatch);
+	for (size_t i = 0; i < m_sendBatch.size(); i++)
+	{
+		outgoingPackets[m_sendSources[i]].result |= m_sendBatch[i].result;
+	}
+	m_sendBatch.clear();
+	return result;
+}
+
+PacketHandle ImpairedNetwork::Receive(sockaddr_in& clientAddr, int& result)
+{
+	PullIncoming();
+	ReleaseDue();
+
+	if (m_readyPackets.empty())
+	{
+		result = -1;
+		return nullptr;
+	}
+
+	ReceivedPacket receivedPacket = std::move(m_readyPackets.front());
+	m_readyPackets.pop_front();
+	clientAddr = receivedPacket.clientAddr;
+	result = 0;
+	return std::move(receivedPacket.networkPacket);
+}
+
+int ImpairedNetwork::ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets)
+{
+	PullIncoming();
+	ReleaseDue();
+
+	if (m_readyPackets.empty())
+	{
+		return -1;
+	}
+
+	for (size_t i = 0; i < MAX_BATCH_SIZE && !m_readyPackets.empty(); i++)
+	{
+		receivedPackets.push_back(std::move(m_readyPackets.front()));
+		m_readyPackets.pop_front();
+	}
+	return 0;
+}
+
+int ImpairedNetwork::StartTimer(int timerId, std::chrono::nanoseconds interval)
+{
+	return m_network->StartTimer(timerId, interval);
+}
+
+int ImpairedNetwork::WaitForEvents(std::vector<int>& expiredTimers)
+{
+	while (true)
+	{
+		ReleaseDue();
+		if (!m_readyPackets.empty())
+		{
+			return 0;
+		}
+
+		size_t previousTimers = expiredTimers.size();
+		int result = m_network->WaitForEvents(expiredTimers);
+		if (result == 1)
+		{
+			return 1;
+		}
+
+		expiredTimers.erase(
+			std::remove(expiredTimers.begin() + previousTimers, expiredTimers.end(), IMPAIRMENT_TIMER),
+			expiredTimers.end()
+		);
+		if (result == 0)
+		{
+			// Datagrams arrived, into the delay line until they are due
+			PullIncoming();
+		}
+		if (expiredTimers.size() > previousTimers)
+		{
+			ReleaseDue();
+			return m_readyPackets.empty() ? -1 : 0;
+		}
+	}
+}
+
+NetworkCounters ImpairedNetwork::GetCounters()
+{
+	return m_network->GetCounters();
+}
+
+void ImpairedNetwork::ReleasePeer(const sockaddr_in& clientAddr)
+{
+	m_network->ReleasePeer(clientAddr);
+}
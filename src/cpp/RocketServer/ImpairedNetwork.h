@@ -0,0 +1,86 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <random>
+#include <chrono>
+#include "NetworkBase.h"
+#include "Logger.h"
+#include "ImpairmentOptions.h"
+
+// Decorator which runs every datagram of the wrapped network through a
+// simulated bad link: loss, duplication, latency with jitter, reordering and
+// a bandwidth cap, all drawn from a seeded generator. Delayed datagrams are
+// held in a delay line per direction and released from WaitForEvents and
+// the receive and send calls, which a short internal timer keeps running.
+class ImpairedNetwork : public NetworkBase
+{
+private:
+	// Negative timer ids are reserved for decorators
+	static constexpr int IMPAIRMENT_TIMER = -1;
+	static constexpr std::chrono::milliseconds IMPAIRMENT_TIMER_INTERVAL{ 1 };
+
+	// Datagrams which would wait longer than this for the capped link are dropped
+	static constexpr std::chrono::milliseconds MAX_QUEUE_DELAY{ 250 };
+
+	struct DelayedPacket
+	{
+		std::chrono::steady_clock::time_point due{};
+		uint64_t order = 0;
+		sockaddr_in addr{};
+		PacketHandle networkPacket;
+	};
+
+	// Delay line of one direction, a min heap on the due time
+	struct Link
+	{
+		std::vector<DelayedPacket> delayed;
+		std::chrono::steady_clock::time_point freeAt{};
+	};
+
+	std::shared_ptr<Logger> m_logger;
+	std::shared_ptr<NetworkBase> m_network;
+	ImpairmentOptions m_options;
+	std::mt19937_64 m_random;
+
+	Link m_outgoing;
+	Link m_incoming;
+	uint64_t m_order = 0;
+
+	std::deque<ReceivedPacket> m_readyPackets;
+	std::vector<ReceivedPacket> m_receiveBatch;
+	std::vector<OutgoingPacket> m_sendBatch;
+	std::vector<size_t> m_sendSources;
+
+	uint64_t m_dropped = 0;
+	uint64_t m_duplicated = 0;
+	uint64_t m_reordered = 0;
+
+	static bool IsLater(const DelayedPacket& a, const DelayedPacket& b);
+	bool HasDelay() const;
+	double NextProbability();
+
+	// Decides the fate of one datagram and returns how many copies to deliver
+	// and when. Returns 0 when the datagram is lost.
+	int Impair(Link& link, size_t size, std::chrono::steady_clock::time_point now, std::chrono::steady_clock::time_point& due);
+	void Schedule(Link& link, std::chrono::steady_clock::time_point due, const sockaddr_in& addr, PacketHandle networkPacket);
+	PacketHandle Copy(NetworkPacket& networkPacket);
+
+	void PullIncoming();
+	void ReleaseDue();
+
+public:
+	ImpairedNetwork(std::shared_ptr<Logger> logger, std::shared_ptr<NetworkBase> network, const ImpairmentOptions& options);
+	~ImpairedNetwork();
+
+	int Initialize(std::string server, int port, sockaddr_in& addr) override;
+	int Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr) override;
+	int SendBatch(std::vector<OutgoingPacket>& outgoingPackets) override;
+	PacketHandle Receive(sockaddr_in& clientAddr, int& result) override;
+	int ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets) override;
+	int StartTimer(int timerId, std::chrono::nanoseconds interval) override;
+	int WaitForEvents(std::vector<int>& expiredTimers) override;
+	NetworkCounters GetCounters() override;
+	void ReleasePeer(const sockaddr_in& clientAddr) override;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <cstdlib>
+
+// Network conditions simulated by ImpairedNetwork. Every option applies to
+// each direction separately, so latency adds twice to the round trip time.
+struct ImpairmentOptions
+{
+    // One way delay and the maximum random deviation from it in milliseconds
+    int latencyMs = 0;
+    int jitterMs = 0;
+
+    // Probabilities between 0 and 1 per datagram
+    double lossRate = 0;
+    double duplicateRate = 0;
+
+    // Reordered datagrams skip the latency and overtake the ones in flight
+    double reorderRate = 0;
+
+    // Link capacity in bytes per second, 0 is unlimited
+    int64_t bandwidthBytesPerSecond = 0;
+
+    // Same seed and same traffic give the same impairments
+    uint64_t seed = 1;
+
+    bool IsEnabled() const
+    {
+        return latencyMs > 0 || jitterMs > 0 || lossRate > 0 || duplicateRate > 0 ||
+            reorderRate > 0 || bandwidthBytesPerSecond > 0;
+    }
+
+    // Reads IMPAIR_LATENCY_MS, IMPAIR_JITTER_MS, IMPAIR_LOSS, IMPAIR_DUPLICATE,
+    // IMPAIR_REORDER, IMPAIR_BANDWIDTH and IMPAIR_SEED when they are set
+    void LoadFromEnvironment()
+    {
+        if (const char* value = std::getenv("IMPAIR_LATENCY_MS")) latencyMs = std::atoi(value);
+        if (const char* value = std::getenv("IMPAIR_JITTER_MS")) jitterMs = std::atoi(value);
+        if (const char* value = std::getenv("IMPAIR_LOSS")) lossRate = std::atof(value);
+        if (const char* value = std::getenv("IMPAIR_DUPLICATE")) duplicateRate = std::atof(value);
+        if (const char* value = std::getenv("IMPAIR_REORDER")) reorderRate = std::atof(value);
+        if (const char* value = std::getenv("IMPAIR_BANDWIDTH")) bandwidthBytesPerSecond = std::atoll(value);
+        if (const char* value = std::getenv("IMPAIR_SEED")) seed = std::strtoull(value, nullptr, 10);
+    }
+};
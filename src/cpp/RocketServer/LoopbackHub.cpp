@@ -0,0 +1,147 @@
+#include "LoopbackHub.h"
+#include <cstring>
+#include <algorithm>
+
+LoopbackQueue::LoopbackQueue(size_t capacity)
+{
+	size_t slots = 2;
+	while (slots < capacity)
+	{
+		slots *= 2;
+	}
+
+	m_slots = std::make_unique<Slot[]>(slots);
+	m_mask = slots - 1;
+	for (size_t i = 0; i < slots; i++)
+	{
+		m_slots[i].sequence.store(i, std::memory_order_relaxed);
+	}
+}
+
+bool LoopbackQueue::Push(const sockaddr_in& from, const uint8_t* data, size_t size)
+{
+	size_t position = m_enqueuePosition.load(std::memory_order_relaxed);
+	Slot* slot = nullptr;
+	while (true)
+	{
+		slot = &m_slots[position & m_mask];
+		size_t sequence = slot->sequence.load(std::memory_order_acquire);
+		intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+		if (difference == 0)
+		{
+			if (m_enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			// Consumer has not freed this slot yet
+			m_drops.fetch_add(1, std::memory_order_relaxed);
+			return false;
+		}
+		else
+		{
+			position = m_enqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	slot->from = from;
+	slot->size = std::min(size, MAX_DATAGRAM_SIZE);
+	std::memcpy(slot->data, data, slot->size);
+	slot->sequence.store(position + 1, std::memory_order_release);
+	return true;
+}
+
+bool LoopbackQueue::Pop(sockaddr_in& from, uint8_t* data, size_t& size)
+{
+	size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+	Slot& slot = m_slots[position & m_mask];
+	if (slot.sequence.load(std::memory_order_acquire) != position + 1)
+	{
+		return false;
+	}
+
+	from = slot.from;
+	size = slot.size;
+	std::memcpy(data, slot.data, slot.size);
+
+	// Single consumer, so the slot is handed back to the producers one lap ahead
+	m_dequeuePosition.store(position + 1, std::memory_order_relaxed);
+	slot.sequence.store(position + m_mask + 1, std::memory_order_release);
+	return true;
+}
+
+bool LoopbackQueue::Empty() const
+{
+	size_t position = m_dequeuePosition.load(std::memory_order_relaxed);
+	return m_slots[position & m_mask].sequence.load(std::memory_order_acquire) != position + 1;
+}
+
+uint64_t LoopbackQueue::Drops() const
+{
+	return m_drops.load(std::memory_order_relaxed);
+}
+
+LoopbackHub::LoopbackHub()
+	: m_ports(std::make_unique<std::atomic<LoopbackQueue*>[]>(PORT_COUNT))
+{
+	for (int i = 0; i < PORT_COUNT; i++)
+	{
+		m_ports[i].store(nullptr, std::memory_order_relaxed);
+	}
+}
+
+LoopbackQueue* LoopbackHub::Bind(int& port, size_t capacity)
+{
+	std::lock_guard<std::mutex> lock(m_queuesMutex);
+
+	if (port == 0)
+	{
+		for (int i = EPHEMERAL_PORT_START; i < PORT_COUNT; i++)
+		{
+			int candidate = m_nextEphemeralPort++;
+			if (m_nextEphemeralPort == PORT_COUNT)
+			{
+				m_nextEphemeralPort = EPHEMERAL_PORT_START;
+			}
+
+			if (m_ports[candidate].load(std::memory_order_relaxed) == nullptr)
+			{
+				port = candidate;
+				break;
+			}
+		}
+	}
+
+	if (port <= 0 || port >= PORT_COUNT || m_ports[port].load(std::memory_order_relaxed) != nullptr)
+	{
+		return nullptr;
+	}
+
+	m_queues.push_back(std::make_unique<LoopbackQueue>(capacity));
+	LoopbackQueue* queue = m_queues.back().get();
+	m_ports[port].store(queue, std::memory_order_release);
+	return queue;
+}
+
+void LoopbackHub::Unbind(int port)
+{
+	if (port > 0 && port < PORT_COUNT)
+	{
+		m_ports[port].store(nullptr, std::memory_order_release);
+	}
+}
+
+int LoopbackHub::Deliver(const sockaddr_in& from, const sockaddr_in& to, const uint8_t* data, size_t size)
+{
+	LoopbackQueue* queue = m_ports[ntohs(to.sin_port)].load(std::memory_order_acquire);
+	if (queue == nullptr)
+	{
+		return 1;
+	}
+
+	// A full queue drops the datagram like an overflowing socket buffer
+	queue->Push(from, data, size);
+	return 0;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#ifdef _WIN32
+#include <winsock2.h>
+#else
+#include <netinet/in.h>
+#endif
+#include "NetworkPacket.h"
+
+// Bounded multi-producer single-consumer datagram queue. Every slot carries
+// a sequence number so that producers claim slots with a single CAS and the
+// consumer never blocks them (Vyukov's bounded queue).
+class LoopbackQueue
+{
+public:
+	// Larger datagrams are truncated just like a socket receive buffer would
+	static constexpr size_t MAX_DATAGRAM_SIZE = NetworkPacket::MAX_DATAGRAM_SIZE;
+
+private:
+	struct alignas(64) Slot
+	{
+		std::atomic<size_t> sequence{};
+		sockaddr_in from{};
+		size_t size = 0;
+		uint8_t data[MAX_DATAGRAM_SIZE]{};
+	};
+
+	std::unique_ptr<Slot[]> m_slots;
+	size_t m_mask = 0;
+
+	alignas(64) std::atomic<size_t> m_enqueuePosition{};
+	alignas(64) std::atomic<size_t> m_dequeuePosition{};
+	alignas(64) std::atomic<uint64_t> m_drops{};
+
+public:
+	// Capacity is rounded up to a power of two
+	explicit LoopbackQueue(size_t capacity);
+
+	// Any thread: returns false and counts a drop if the queue is full
+	bool Push(const sockaddr_in& from, const uint8_t* data, size_t size);
+
+	// Owner thread: copies the oldest datagram into data, returns false if empty
+	bool Pop(sockaddr_in& from, uint8_t* data, size_t& size);
+
+	bool Empty() const;
+	uint64_t Drops() const;
+};
+
+// Switchboard which routes datagrams between loopback networks by port.
+// Binding is rare and takes a lock, delivering is lock free. Queues are owned
+// by the hub so that a sender racing with an unbind never touches freed memory.
+class LoopbackHub
+{
+private:
+	static constexpr int PORT_COUNT = 65536;
+	static constexpr int EPHEMERAL_PORT_START = 49152;
+
+	std::unique_ptr<std::atomic<LoopbackQueue*>[]> m_ports;
+
+	std::mutex m_queuesMutex;
+	int m_nextEphemeralPort = EPHEMERAL_PORT_START;
+	std::vector<std::unique_ptr<LoopbackQueue>> m_queues;
+
+public:
+	LoopbackHub();
+
+	// Binds a new queue to port, or to a free ephemeral port when port is 0.
+	// Returns nullptr if the port is already in use.
+	LoopbackQueue* Bind(int& port, size_t capacity);
+	void Unbind(int port);
+
+	// Returns 0 when the datagram was queued or dropped on a full queue and
+	// 1 when nothing is bound to the destination port
+	int Deliver(const sockaddr_in& from, const sockaddr_in& to, const uint8_t* data, size_t size);
+};
@@ -0,0 +1,194 @@
+#include "LoopbackNetwork.h"
+#include <thread>
+#include <algorithm>
+#include "NetworkUtilities.h"
+
+LoopbackNetwork::LoopbackNetwork(std::shared_ptr<Logger> logger, std::shared_ptr<LoopbackHub> hub, size_t queueCapacity)
+	: m_logger(logger), m_hub(hub), m_queueCapacity(queueCapacity)
+{
+}
+
+LoopbackNetwork::~LoopbackNetwork()
+{
+	if (m_queue != nullptr)
+	{
+		m_hub->Unbind(m_port);
+	}
+}
+
+int LoopbackNetwork::Initialize(std::string server, int port, sockaddr_in& addr)
+{
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+
+	int localPort = 0;
+	if (server.empty())
+	{
+		// Server
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		localPort = port;
+	}
+	else
+	{
+		// Client
+		if (inet_pton(AF_INET, server.c_str(), &addr.sin_addr) != 1)
+		{
+			m_logger->Log(LogLevel::EXCEPTION, "Initialize: Failed to convert address", { KVS(server) });
+			return 1;
+		}
+	}
+
+	m_queue = m_hub->Bind(localPort, m_queueCapacity);
+	if (m_queue == nullptr)
+	{
+		m_logger->Log(LogLevel::EXCEPTION, "Initialize: Loopback port already in use", { KV(port) });
+		return 1;
+	}
+
+	m_port = localPort;
+	m_localAddr.sin_family = AF_INET;
+	m_localAddr.sin_port = htons(localPort);
+	m_localAddr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	m_logger->Log(LogLevel::INFO, "Initialize: Loopback bound", { KV(localPort) });
+	return 0;
+}
+
+int LoopbackNetwork::Deliver(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
+{
+	if (m_hub->Deliver(m_localAddr, clientAddr, networkPacket.Data(), networkPacket.Size()) != 0)
+	{
+		std::string address = NetworkUtilities::AddressToString(clientAddr);
+		m_logger->Log(LogLevel::EXCEPTION, "Send: No loopback network bound", { KVS(address) });
+		return 1;
+	}
+	return 0;
+}
+
+int LoopbackNetwork::Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
+{
+	if (Deliver(networkPacket, clientAddr) != 0)
+	{
+		m_counters.sendFailures++;
+		return 1;
+	}
+	m_counters.packetsSent++;
+	return 0;
+}
+
+int LoopbackNetwork::SendBatch(std::vector<OutgoingPacket>& outgoingPackets)
+{
+	int failures = 0;
+	for (OutgoingPacket& outgoingPacket : outgoingPackets)
+	{
+		outgoingPacket.result = Send(*outgoingPacket.networkPacket, outgoingPacket.clientAddr);
+		if (outgoingPacket.result != 0)
+		{
+			failures++;
+		}
+	}
+	return failures == 0 ? 0 : 1;
+}
+
+bool LoopbackNetwork::ReadDatagram(ReceivedPacket& receivedPacket)
+{
+	if (m_queue->Empty())
+	{
+		return false;
+	}
+
+	PacketHandle networkPacket = AcquirePacket();
+
+	size_t size = 0;
+	if (!m_queue->Pop(receivedPacket.clientAddr, networkPacket->Buffer().data(), size))
+	{
+		return false;
+	}
+
+	networkPacket->Resize(size);
+	networkPacket->SetReceiveTime(std::chrono::steady_clock::now());
+	receivedPacket.networkPacket = std::move(networkPacket);
+	m_counters.packetsReceived++;
+	return true;
+}
+
+PacketHandle LoopbackNetwork::Receive(sockaddr_in& clientAddr, int& result)
+{
+	ReceivedPacket receivedPacket;
+	if (m_queue == nullptr || !ReadDatagram(receivedPacket))
+	{
+		result = -1;
+		return nullptr;
+	}
+
+	clientAddr = receivedPacket.clientAddr;
+	result = 0;
+	return std::move(receivedPacket.networkPacket);
+}
+
+int LoopbackNetwork::ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets)
+{
+	if (m_queue == nullptr)
+	{
+		return -1;
+	}
+
+	size_t received = 0;
+	ReceivedPacket receivedPacket;
+	while (received < MAX_BATCH_SIZE && ReadDatagram(receivedPacket))
+	{
+		receivedPackets.push_back(std::move(receivedPacket));
+		received++;
+	}
+
+	return received == 0 ? -1 : 0;
+}
+
+int LoopbackNetwork::StartTimer(int timerId, std::chrono::nanoseconds interval)
+{
+	LoopbackTimer timer;
+	timer.timerId = timerId;
+	timer.interval = interval;
+	timer.deadline = std::chrono::steady_clock::now() + interval;
+	m_timers.push_back(timer);
+	return 0;
+}
+
+int LoopbackNetwork::WaitForEvents(std::vector<int>& expiredTimers)
+{
+	while (true)
+	{
+		auto now = std::chrono::steady_clock::now();
+		auto wakeUp = now + POLL_INTERVAL;
+		for (LoopbackTimer& timer : m_timers)
+		{
+			if (timer.deadline <= now)
+			{
+				// Missed expirations are reported once like a timerfd read
+				expiredTimers.push_back(timer.timerId);
+				while (timer.deadline <= now)
+				{
+					timer.deadline += timer.interval;
+				}
+			}
+			wakeUp = std::min(wakeUp, timer.deadline);
+		}
+
+		bool readable = m_queue != nullptr && !m_queue->Empty();
+		if (!expiredTimers.empty() || readable)
+		{
+			return readable ? 0 : -1;
+		}
+
+		std::this_thread::sleep_until(wakeUp);
+	}
+}
+
+NetworkCounters LoopbackNetwork::GetCounters()
+{
+	if (m_queue != nullptr)
+	{
+		m_counters.kernelDrops = m_queue->Drops();
+	}
+	return m_counters;
+}
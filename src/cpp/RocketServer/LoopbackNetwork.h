@@ -0,0 +1,57 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include "NetworkBase.h"
+#include "Logger.h"
+#include "LoopbackHub.h"
+
+// In-memory transport which exchanges datagrams with other loopback networks
+// of the same hub through lock-free queues instead of sockets. Lets a server
+// and many clients run in one process for capacity measurements and tests.
+class LoopbackNetwork final : public NetworkBase
+{
+private:
+	// Longest sleep in WaitForEvents while polling the queue for datagrams
+	static constexpr std::chrono::microseconds POLL_INTERVAL{ 100 };
+
+	struct LoopbackTimer
+	{
+		int timerId{};
+		std::chrono::nanoseconds interval{};
+		std::chrono::steady_clock::time_point deadline{};
+	};
+
+	std::shared_ptr<Logger> m_logger;
+	std::shared_ptr<LoopbackHub> m_hub;
+	size_t m_queueCapacity;
+
+	LoopbackQueue* m_queue = nullptr;
+	int m_port = 0;
+	sockaddr_in m_localAddr{};
+
+	std::vector<LoopbackTimer> m_timers;
+
+	int Deliver(NetworkPacket& networkPacket, sockaddr_in& clientAddr);
+	bool ReadDatagram(ReceivedPacket& receivedPacket);
+
+public:
+	static constexpr size_t DEFAULT_QUEUE_CAPACITY = 1024;
+
+	LoopbackNetwork(std::shared_ptr<Logger> logger, std::shared_ptr<LoopbackHub> hub, size_t queueCapacity = DEFAULT_QUEUE_CAPACITY);
+	~LoopbackNetwork();
+
+	// Servers bind port, clients bind an ephemeral port and get the server address
+	int Initialize(std::string server, int port, sockaddr_in& addr) override;
+	int Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr) override;
+	int SendBatch(std::vector<OutgoingPacket>& outgoingPackets) override;
+	PacketHandle Receive(sockaddr_in& clientAddr, int& result) override;
+	int ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets) override;
+	int StartTimer(int timerId, std::chrono::nanoseconds interval) override;
+	int WaitForEvents(std::vector<int>& expiredTimers) override;
+	NetworkCounters GetCounters() override;
+
+	// Address other loopback networks use to reach this one
+	sockaddr_in LocalAddress() const { return m_localAddr; }
+};
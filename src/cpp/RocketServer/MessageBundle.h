@@ -0,0 +1,160 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <span>
+#include "NetworkPacket.h"
+#include "PacketSchemas.h"
+
+// Several messages in one datagram, so that the messages sent to one address
+// in a tick share the CRC, the UDP and IP headers and the system call. A
+// bundle is the CRC and the BUNDLE type followed by the messages, each one
+// its big-endian uint16_t length and then the message as it would follow the
+// CRC of a datagram of its own, its type and its fields. Messages stay
+// contiguous so that PacketView reads them in place either way.
+//
+// Only the messages of connected players are bundled. The handshake keeps a
+// datagram of its own so that its padding still stops the server replies from
+// being larger than the requests, and MTU probes must be the size they probe.
+class MessageBundle
+{
+private:
+    static inline size_t LoadLength(const uint8_t* data)
+    {
+        return (static_cast<size_t>(data[0]) << 8) | data[1];
+    }
+
+    static inline void StoreLength(uint8_t* data, size_t length)
+    {
+        data[0] = static_cast<uint8_t>(length >> 8);
+        data[1] = static_cast<uint8_t>(length);
+    }
+
+    // Whether the messages following the bundle type are framed correctly
+    static inline bool ValidFraming(std::span<const uint8_t> messages)
+    {
+        size_t offset = 0;
+        while (offset < messages.size())
+        {
+            if (messages.size() - offset < LENGTH_SIZE)
+            {
+                return false;
+            }
+
+            size_t length = LoadLength(messages.data() + offset);
+            offset += LENGTH_SIZE;
+            if (length == 0 || length > messages.size() - offset ||
+                !Bundleable(static_cast<NetworkPacketType>(messages[offset])))
+            {
+                return false;
+            }
+            offset += length;
+        }
+        return !messages.empty();
+    }
+
+public:
+    static constexpr size_t LENGTH_SIZE = sizeof(uint16_t);
+
+    static constexpr bool Bundleable(NetworkPacketType type)
+    {
+        switch (type)
+        {
+        case NetworkPacketType::GAME_STATE:
+        case NetworkPacketType::GAME_STATE_FRAGMENT:
+        case NetworkPacketType::INPUT_FRAME:
+        case NetworkPacketType::DISCONNECT:
+        case NetworkPacketType::CLOCK:
+        case NetworkPacketType::CLOCK_RESPONSE:
+        case NetworkPacketType::MTU_PROBE_ACK:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    // Appends the message of a datagram to another datagram, which becomes a
+    // bundle unless it is one already. Returns false and leaves the datagram
+    // unchanged when either message is never bundled or the bundle would be
+    // larger than maxSize.
+    static inline bool Append(NetworkPacket& datagram, NetworkPacket& single, size_t maxSize)
+    {
+        std::span<const uint8_t> message = single.Message();
+        std::span<const uint8_t> first = datagram.Message();
+        if (message.empty() || first.empty() || !Bundleable(static_cast<NetworkPacketType>(message[0])))
+        {
+            return false;
+        }
+
+        bool bundled = static_cast<NetworkPacketType>(first[0]) == NetworkPacketType::BUNDLE;
+        if (!bundled && !Bundleable(static_cast<NetworkPacketType>(first[0])))
+        {
+            return false;
+        }
+
+        size_t size = datagram.Size() + LENGTH_SIZE + message.size();
+        if (!bundled)
+        {
+            size += sizeof(NetworkPacketType) + LENGTH_SIZE;
+        }
+        if (size > maxSize || size > NetworkPacket::MAX_DATAGRAM_SIZE)
+        {
+            return false;
+        }
+
+        if (!bundled)
+        {
+            // The message moves behind the bundle type and its own length
+            size_t firstSize = first.size();
+            datagram.Append(sizeof(NetworkPacketType) + LENGTH_SIZE);
+            uint8_t* data = datagram.Data() + CRC32::CRC_SIZE;
+            std::memmove(data + sizeof(NetworkPacketType) + LENGTH_SIZE, data, firstSize);
+            data[0] = static_cast<uint8_t>(NetworkPacketType::BUNDLE);
+            StoreLength(data + sizeof(NetworkPacketType), firstSize);
+        }
+
+        std::span<uint8_t> bytes = datagram.Append(LENGTH_SIZE + message.size());
+        StoreLength(bytes.data(), message.size());
+        std::memcpy(bytes.data() + LENGTH_SIZE, message.data(), message.size());
+        return true;
+    }
+
+    // Calls handler with every message of a received datagram, given the
+    // bytes following its CRC: the message of a plain datagram or each one of
+    // a bundle in order. A malformed bundle is dropped as a whole before any
+    // of its messages is handled. Returns 1 when the datagram is malformed or
+    // a handler failed and 0 otherwise.
+    template <typename Handler>
+    static inline int ForEach(std::span<const uint8_t> message, Handler&& handler)
+    {
+        if (message.empty())
+        {
+            return 1;
+        }
+
+        if (static_cast<NetworkPacketType>(message[0]) != NetworkPacketType::BUNDLE)
+        {
+            return handler(message) != 0 ? 1 : 0;
+        }
+
+        std::span<const uint8_t> messages = message.subspan(sizeof(NetworkPacketType));
+        if (!ValidFraming(messages))
+        {
+            return 1;
+        }
+
+        int result = 0;
+        size_t offset = 0;
+        while (offset < messages.size())
+        {
+            size_t length = LoadLength(messages.data() + offset);
+            offset += LENGTH_SIZE;
+            if (handler(messages.subspan(offset, length)) != 0)
+            {
+                result = 1;
+            }
+            offset += length;
+        }
+        return result;
+    }
+};
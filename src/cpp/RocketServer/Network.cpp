@@ -4,15 +4,24 @@
 #include "Network.h"
 #include "NetworkPacketType.h"
 #include "Utils.h"
+#include "NetworkUtilities.h"
 
 #ifdef _WIN32
 #define SOCKET_TIMEOUT WSAEWOULDBLOCK
 #else
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/timerfd.h>
 #include <errno.h>
 #include <cstring>
 #include <cerrno>
+#include <netinet/udp.h>
+#include <sys/ioctl.h>
+#include <linux/sockios.h>
+#include <linux/sock_diag.h>
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
 // https://en.wikipedia.org/wiki/Errno.h
 #define SOCKET_ERROR -1
 #define SOCKET_TIMEOUT EAGAIN // 11
@@ -71,8 +80,41 @@ static std::string GetNetworkErrorMessage(int errorCode)
 }
 #endif
 
-Network::Network(std::shared_ptr<Logger> logger) : m_logger(logger), m_socket(0)
+#if _DEBUG
+static std::string BufferToString(const uint8_t* data, size_t size)
 {
+	// Comma separated values of the buffer
+	std::string bufferString;
+	for (size_t i = 0; i < size; i++)
+	{
+		bufferString += std::to_string(data[i]);
+		if (i != size - 1)
+		{
+			bufferString += ",";
+		}
+	}
+	return bufferString;
+}
+#endif
+
+Network::Network(std::shared_ptr<Logger> logger, bool reusePort)
+	: Network(logger, NetworkOptions{ reusePort })
+{
+}
+
+Network::Network(std::shared_ptr<Logger> logger, NetworkOptions options) : m_logger(logger), m_socket(0), m_options(options)
+{
+#ifndef _WIN32
+	// Point every message of the receive ring to its own address, the
+	// buffers are pooled packets attached before every recvmmsg call
+	for (size_t i = 0; i < MAX_BATCH_SIZE; i++)
+	{
+		m_receiveMessages[i].msg_hdr.msg_iov = &m_receiveIovecs[i];
+		m_receiveMessages[i].msg_hdr.msg_iovlen = 1;
+		m_receiveMessages[i].msg_hdr.msg_name = &m_receiveAddresses[i];
+		m_receiveMessages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+	}
+#endif
 }
 
 Network::~Network()
@@ -82,6 +124,14 @@ Network::~Network()
 	closesocket(m_socket);
 	WSACleanup();
 #else
+	for (NetworkTimer& timer : m_timers)
+	{
+		close(timer.fd);
+	}
+	if (m_epoll != -1)
+	{
+		close(m_epoll);
+	}
 	close(m_socket);
 #endif
 }
@@ -145,6 +195,44 @@ int Network::Initialize(std::string server, int port, sockaddr_in& addr)
         // Server
         addr.sin_addr.s_addr = htonl(INADDR_ANY);
 
+#ifndef _WIN32
+        if (m_options.reusePort)
+        {
+            // Multiple sockets share the port and the kernel hashes every client to one of them
+            int reusePort = 1;
+            if (setsockopt(m_socket, SOL_SOCKET, SO_REUSEPORT, &reusePort, sizeof(reusePort)) == -1)
+            {
+                auto errorCode = GetNetworkLastError();
+                std::string errorMsg = GetNetworkErrorMessage(errorCode);
+                m_logger->Log(
+                    LogLevel::EXCEPTION,
+                    "Initialize: Failed to set SO_REUSEPORT",
+                    { KV(errorCode), KVS(errorMsg) }
+                );
+                return 1;
+            }
+        }
+#endif
+
+        // Datagrams above the path MTU are dropped instead of fragmented so that MTU probes measure the path
+#ifdef _WIN32
+        DWORD dontFragment = TRUE;
+        if (setsockopt(m_socket, IPPROTO_IP, IP_DONTFRAGMENT, (const char*)&dontFragment, sizeof(dontFragment)) != 0)
+#else
+        // Probe mode sets DF but ignores the cached path MTU, so larger probes still leave the host
+        int mtuDiscover = IP_PMTUDISC_PROBE;
+        if (setsockopt(m_socket, IPPROTO_IP, IP_MTU_DISCOVER, &mtuDiscover, sizeof(mtuDiscover)) == -1)
+#endif
+        {
+            auto errorCode = GetNetworkLastError();
+            std::string errorMsg = GetNetworkErrorMessage(errorCode);
+            m_logger->Log(
+                LogLevel::WARNING,
+                "Initialize: Failed to set don't fragment",
+                { KV(errorCode), KVS(errorMsg) }
+            );
+        }
+
         m_logger->Log(LogLevel::INFO, "Initialize: Binding on port", { KV(port) });
         if (bind(m_socket, (sockaddr*)&addr, sizeof(addr)) < 0)
         {
@@ -164,22 +252,98 @@ int Network::Initialize(std::string server, int port, sockaddr_in& addr)
             return 1;
         }
     }
+
+	ConfigureBuffers();
+
+#ifndef _WIN32
+	// Kernel stamps every datagram when it is queued so latency math does not include scheduling delay
+	int timestamps = 1;
+	if (setsockopt(m_socket, SOL_SOCKET, SO_TIMESTAMPNS, &timestamps, sizeof(timestamps)) == -1)
+	{
+		auto errorCode = GetNetworkLastError();
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::WARNING,
+			"Initialize: Failed to enable receive timestamps",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+	}
+
+	// Every received datagram carries the number of datagrams dropped so far
+	int dropCounter = 1;
+	if (setsockopt(m_socket, SOL_SOCKET, SO_RXQ_OVFL, &dropCounter, sizeof(dropCounter)) == -1)
+	{
+		auto errorCode = GetNetworkLastError();
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::WARNING,
+			"Initialize: Failed to enable drop counter",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+	}
+
+	EnableOffload();
+
+	// Wait for datagrams and timers with epoll instead of spinning on the socket
+	m_epoll = epoll_create1(EPOLL_CLOEXEC);
+	if (m_epoll == -1)
+	{
+		auto errorCode = GetNetworkLastError();
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"Initialize: Failed to create epoll",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+		return 1;
+	}
+
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.fd = m_socket;
+	if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_socket, &event) == -1)
+	{
+		auto errorCode = GetNetworkLastError();
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"Initialize: Failed to register socket to epoll",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+		return 1;
+	}
+#endif
 	return 0;
 }
 
-std::unique_ptr<NetworkPacket> Network::Receive(sockaddr_in& clientAddr, int& result)
+PacketHandle Network::Receive(sockaddr_in& clientAddr, int& result)
 {
-    const int len = 1024;
-    std::vector<uint8_t> data(len);
+    const int len = RECEIVE_BUFFER_SIZE;
+    PacketHandle networkPacket = AcquirePacket();
+    networkPacket->Resize(len);
 
+#ifdef _WIN32
 	socklen_t addrLen = sizeof(clientAddr);
 	int n = recvfrom(
 		m_socket,
-		reinterpret_cast<char*>(data.data()),
+		reinterpret_cast<char*>(networkPacket->Data()),
         len,
 		0,
 		reinterpret_cast<sockaddr*>(&clientAddr),
 		&addrLen);
+#else
+	// recvmsg instead of recvfrom to get the receive timestamp
+	iovec iov{ networkPacket->Data(), static_cast<size_t>(len) };
+	alignas(cmsghdr) uint8_t control[CONTROL_SIZE]{};
+	msghdr message{};
+	message.msg_name = &clientAddr;
+	message.msg_namelen = sizeof(clientAddr);
+	message.msg_iov = &iov;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+	int n = recvmsg(m_socket, &message, 0);
+#endif
 
 	if (n == SOCKET_ERROR)
 	{
@@ -208,19 +372,18 @@ std::unique_ptr<NetworkPacket> Network::Receive(sockaddr_in& clientAddr, int& re
 	}
 
     // Resize to actual received size
-    data.resize(n);
+    networkPacket->Resize(n);
+	m_counters.packetsReceived++;
+#ifdef _WIN32
+	networkPacket->SetReceiveTime(std::chrono::steady_clock::now());
+#else
+	networkPacket->SetReceiveTime(NetworkUtilities::GetReceiveTime(message));
+	NetworkUtilities::GetDropCount(message, m_counters.kernelDrops);
+#endif
 
 	// Log the received buffer as comma separated values as string
 #if _DEBUG
-	std::string bufferString;
-	for (size_t i = 0; i < n; i++)
-	{
-		bufferString += std::to_string(data[i]);
-		if (i != n - 1)
-		{
-			bufferString += ",";
-		}
-	}
+	std::string bufferString = BufferToString(networkPacket->Data(), n);
 	m_logger->Log(
 		LogLevel::DEBUG,
 		"Receive: Received bytes",
@@ -228,27 +391,415 @@ std::unique_ptr<NetworkPacket> Network::Receive(sockaddr_in& clientAddr, int& re
 	);
 #endif
 
-	return std::make_unique<NetworkPacket>(data);
+	return networkPacket;
 }
 
-int Network::Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
+int Network::ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets)
 {
-	networkPacket.CalculateCRC();
+#ifdef _WIN32
+	// No recvmmsg on Windows so drain the socket one datagram at a time
+	for (size_t i = 0; i < MAX_BATCH_SIZE; i++)
+	{
+		int result = 0;
+		ReceivedPacket receivedPacket;
+		receivedPacket.networkPacket = Receive(receivedPacket.clientAddr, result);
+		if (result != 0)
+		{
+			// Report timeout or failure only if nothing was received
+			return i == 0 ? result : 0;
+		}
+		receivedPackets.push_back(std::move(receivedPacket));
+	}
+	return 0;
+#else
+	if (m_groEnabled)
+	{
+		return ReceiveCoalescedBatch(receivedPackets);
+	}
 
-	auto size = networkPacket.Size();
-	auto data = networkPacket.ToBytes();
+	for (size_t i = 0; i < MAX_BATCH_SIZE; i++)
+	{
+		// Slots consumed by the previous call get a fresh packet from the pool
+		if (!m_receiveSlots[i])
+		{
+			m_receiveSlots[i] = AcquirePacket();
+			std::span<uint8_t> buffer = m_receiveSlots[i]->Buffer();
+			m_receiveIovecs[i].iov_base = buffer.data();
+			m_receiveIovecs[i].iov_len = buffer.size();
+		}
+
+		// Kernel overwrites the address and control lengths on every call
+		m_receiveMessages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		m_receiveMessages[i].msg_hdr.msg_control = m_receiveControl[i];
+		m_receiveMessages[i].msg_hdr.msg_controllen = sizeof(m_receiveControl[i]);
+		m_receiveMessages[i].msg_len = 0;
+	}
+
+	int n = recvmmsg(m_socket, m_receiveMessages, MAX_BATCH_SIZE, 0, nullptr);
+	if (n == SOCKET_ERROR)
+	{
+		auto errorCode = GetNetworkLastError();
+		if (errorCode == SOCKET_TIMEOUT)
+		{
+			// Timeout, no data received
+			return -1;
+		}
+
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"ReceiveBatch: Failed",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+		return 1;
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		auto size = m_receiveMessages[i].msg_len;
+		if (size == 0)
+		{
+			m_logger->Log(LogLevel::WARNING, "ReceiveBatch: No data received");
+			continue;
+		}
 
 #if _DEBUG
-	// Log the send buffer as comma separated values as string
-	std::string bufferString;
-	for (size_t i = 0; i < data.size(); i++)
+		std::string bufferString = BufferToString(m_receiveSlots[i]->Data(), size);
+		m_logger->Log(
+			LogLevel::DEBUG,
+			"ReceiveBatch: Received bytes",
+			{ KV(size), KVS(bufferString) }
+		);
+#endif
+
+		// Hand the slot over without copying, the datagram is already in it
+		ReceivedPacket receivedPacket;
+		receivedPacket.networkPacket = std::move(m_receiveSlots[i]);
+		receivedPacket.networkPacket->Resize(size);
+		receivedPacket.networkPacket->SetReceiveTime(NetworkUtilities::GetReceiveTime(m_receiveMessages[i].msg_hdr));
+		NetworkUtilities::GetDropCount(m_receiveMessages[i].msg_hdr, m_counters.kernelDrops);
+		m_counters.packetsReceived++;
+		receivedPacket.clientAddr = m_receiveAddresses[i];
+		receivedPackets.push_back(std::move(receivedPacket));
+	}
+	return 0;
+#endif
+}
+
+#ifndef _WIN32
+void Network::EnableOffload()
+{
+	if (m_options.udpGro)
 	{
-		bufferString += std::to_string(data[i]);
-		if (i != data.size() - 1)
+		int enable = 1;
+		if (setsockopt(m_socket, SOL_UDP, UDP_GRO, &enable, sizeof(enable)) == 0)
 		{
-			bufferString += ",";
+			m_groEnabled = true;
+
+			// Point every coalesced receive message to its own large buffer, address and control data
+			m_groBuffers.resize(GRO_BATCH_SIZE * GRO_BUFFER_SIZE);
+			for (size_t i = 0; i < GRO_BATCH_SIZE; i++)
+			{
+				m_groIovecs[i].iov_base = m_groBuffers.data() + i * GRO_BUFFER_SIZE;
+				m_groIovecs[i].iov_len = GRO_BUFFER_SIZE;
+				m_groMessages[i].msg_hdr.msg_iov = &m_groIovecs[i];
+				m_groMessages[i].msg_hdr.msg_iovlen = 1;
+				m_groMessages[i].msg_hdr.msg_name = &m_receiveAddresses[i];
+			}
 		}
+		else
+		{
+			auto errorCode = GetNetworkLastError();
+			std::string errorMsg = GetNetworkErrorMessage(errorCode);
+			m_logger->Log(
+				LogLevel::WARNING,
+				"Initialize: UDP_GRO is not supported",
+				{ KV(errorCode), KVS(errorMsg) }
+			);
+		}
+	}
+
+	if (m_options.udpGso)
+	{
+		// Kernels without GSO reject the socket option
+		int segmentSize = 0;
+		socklen_t optionLength = sizeof(segmentSize);
+		if (getsockopt(m_socket, SOL_UDP, UDP_SEGMENT, &segmentSize, &optionLength) == 0)
+		{
+			m_gsoEnabled = true;
+		}
+		else
+		{
+			auto errorCode = GetNetworkLastError();
+			std::string errorMsg = GetNetworkErrorMessage(errorCode);
+			m_logger->Log(
+				LogLevel::WARNING,
+				"Initialize: UDP_SEGMENT is not supported",
+				{ KV(errorCode), KVS(errorMsg) }
+			);
+		}
+	}
+
+	if (m_options.udpGro || m_options.udpGso)
+	{
+		m_logger->Log(LogLevel::INFO, "Initialize: UDP offload", { KV(m_groEnabled), KV(m_gsoEnabled) });
+	}
+}
+
+int Network::ReceiveCoalescedBatch(std::vector<ReceivedPacket>& receivedPackets)
+{
+	for (size_t i = 0; i < GRO_BATCH_SIZE; i++)
+	{
+		// Kernel overwrites the address and control lengths on every call
+		m_groMessages[i].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+		m_groMessages[i].msg_hdr.msg_control = m_groControl[i];
+		m_groMessages[i].msg_hdr.msg_controllen = sizeof(m_groControl[i]);
+		m_groMessages[i].msg_len = 0;
 	}
+
+	int n = recvmmsg(m_socket, m_groMessages, GRO_BATCH_SIZE, 0, nullptr);
+	if (n == SOCKET_ERROR)
+	{
+		auto errorCode = GetNetworkLastError();
+		if (errorCode == SOCKET_TIMEOUT)
+		{
+			// Timeout, no data received
+			return -1;
+		}
+
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"ReceiveBatch: Failed",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+		return 1;
+	}
+
+	for (int i = 0; i < n; i++)
+	{
+		msghdr& message = m_groMessages[i].msg_hdr;
+		size_t size = m_groMessages[i].msg_len;
+		// Without the control message the buffer holds a single datagram
+		size_t segmentSize = NetworkUtilities::GetSegmentSize(message, size);
+		bool truncated = (message.msg_flags & MSG_TRUNC) != 0;
+		if (truncated)
+		{
+			m_logger->Log(LogLevel::WARNING, "ReceiveBatch: Coalesced datagrams truncated", { KV(size) });
+		}
+
+		size_t segments = NetworkUtilities::SegmentCount(size, segmentSize, truncated);
+		if (segments == 0)
+		{
+			m_logger->Log(LogLevel::WARNING, "ReceiveBatch: No data received");
+			continue;
+		}
+
+		// All segments of a coalesced buffer share the timestamp of the buffer
+		auto receiveTime = NetworkUtilities::GetReceiveTime(message);
+		NetworkUtilities::GetDropCount(message, m_counters.kernelDrops);
+
+		// Split the buffer back into the datagrams the peer sent
+		const uint8_t* buffer = static_cast<const uint8_t*>(m_groIovecs[i].iov_base);
+		for (size_t segment = 0; segment < segments; segment++)
+		{
+			size_t offset = segment * segmentSize;
+			size_t length = std::min(segmentSize, size - offset);
+			if (length > RECEIVE_BUFFER_SIZE)
+			{
+				m_logger->Log(LogLevel::WARNING, "ReceiveBatch: Datagram too large", { KV(length) });
+				continue;
+			}
+
+			ReceivedPacket receivedPacket;
+			receivedPacket.networkPacket = AcquirePacket();
+			receivedPacket.networkPacket->Resize(length);
+			std::memcpy(receivedPacket.networkPacket->Data(), buffer + offset, length);
+			receivedPacket.networkPacket->SetReceiveTime(receiveTime);
+			m_counters.packetsReceived++;
+			receivedPacket.clientAddr = m_receiveAddresses[i];
+			receivedPackets.push_back(std::move(receivedPacket));
+		}
+	}
+	return 0;
+}
+
+bool Network::CanAppendSegment(size_t message, const OutgoingPacket& outgoingPacket, const OutgoingPacket& firstPacket)
+{
+	// Segments of one message share the destination and only the last one may be shorter
+	const SendSegments& segments = m_sendSegments[message];
+	size_t size = outgoingPacket.networkPacket->Size();
+	return
+		!segments.closed &&
+		size <= segments.segmentSize &&
+		segments.count < GSO_MAX_SEGMENTS &&
+		segments.bytes + size <= GSO_MAX_BYTES &&
+		NetworkUtilities::IsSameAddress(outgoingPacket.clientAddr, firstPacket.clientAddr);
+}
+#endif
+
+bool Network::IsGroEnabled() const
+{
+	return m_groEnabled;
+}
+
+bool Network::IsGsoEnabled() const
+{
+	return m_gsoEnabled;
+}
+
+int Network::StartTimer(int timerId, std::chrono::nanoseconds interval)
+{
+	NetworkTimer timer;
+	timer.timerId = timerId;
+	timer.interval = interval;
+	timer.deadline = std::chrono::steady_clock::now() + interval;
+
+#ifndef _WIN32
+	timer.fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timer.fd == -1)
+	{
+		auto errorCode = GetNetworkLastError();
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"StartTimer: Failed to create timer",
+			{ KV(timerId), KV(errorCode), KVS(errorMsg) }
+		);
+		return 1;
+	}
+
+	auto seconds = std::chrono::duration_cast<std::chrono::seconds>(interval);
+	itimerspec spec{};
+	spec.it_interval.tv_sec = seconds.count();
+	spec.it_interval.tv_nsec = (interval - seconds).count();
+	spec.it_value = spec.it_interval;
+
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.fd = timer.fd;
+	if (timerfd_settime(timer.fd, 0, &spec, nullptr) == -1 ||
+		epoll_ctl(m_epoll, EPOLL_CTL_ADD, timer.fd, &event) == -1)
+	{
+		auto errorCode = GetNetworkLastError();
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"StartTimer: Failed to arm timer",
+			{ KV(timerId), KV(errorCode), KVS(errorMsg) }
+		);
+		close(timer.fd);
+		return 1;
+	}
+#endif
+
+	m_timers.push_back(timer);
+	return 0;
+}
+
+int Network::WaitForEvents(std::vector<int>& expiredTimers)
+{
+#ifdef _WIN32
+	// No epoll or timerfd on Windows so select until the nearest timer deadline
+	timeval timeout{};
+	timeval* timeoutPtr = nullptr;
+	if (!m_timers.empty())
+	{
+		auto deadline = std::min_element(m_timers.begin(), m_timers.end(),
+			[](const NetworkTimer& a, const NetworkTimer& b) { return a.deadline < b.deadline; })->deadline;
+		auto wait = std::max(
+			std::chrono::duration_cast<std::chrono::microseconds>(deadline - std::chrono::steady_clock::now()),
+			std::chrono::microseconds(0));
+		timeout.tv_sec = static_cast<long>(wait.count() / 1000000);
+		timeout.tv_usec = static_cast<long>(wait.count() % 1000000);
+		timeoutPtr = &timeout;
+	}
+
+	fd_set readSet;
+	FD_ZERO(&readSet);
+	FD_SET(m_socket, &readSet);
+	if (select(0, &readSet, nullptr, nullptr, timeoutPtr) == SOCKET_ERROR)
+	{
+		auto errorCode = GetNetworkLastError();
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"WaitForEvents: Failed",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+		return 1;
+	}
+
+	auto now = std::chrono::steady_clock::now();
+	for (NetworkTimer& timer : m_timers)
+	{
+		if (now >= timer.deadline)
+		{
+			expiredTimers.push_back(timer.timerId);
+			timer.deadline += timer.interval;
+			if (timer.deadline <= now)
+			{
+				// Fell behind by more than one interval so skip the missed expirations
+				timer.deadline = now + timer.interval;
+			}
+		}
+	}
+	return FD_ISSET(m_socket, &readSet) ? 0 : -1;
+#else
+	int n = epoll_wait(m_epoll, m_events, MAX_EVENTS, -1);
+	if (n == -1)
+	{
+		auto errorCode = GetNetworkLastError();
+		if (errorCode == EINTR)
+		{
+			// Interrupted by a signal, let the caller check if it is still running
+			return -1;
+		}
+
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"WaitForEvents: Failed",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+		return 1;
+	}
+
+	bool readable = false;
+	for (int i = 0; i < n; i++)
+	{
+		if (m_events[i].data.fd == m_socket)
+		{
+			// Datagrams are picked up by the caller with Receive or ReceiveBatch
+			readable = true;
+			continue;
+		}
+
+		for (NetworkTimer& timer : m_timers)
+		{
+			if (timer.fd == m_events[i].data.fd)
+			{
+				uint64_t expirations = 0;
+				if (read(timer.fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+				{
+					expiredTimers.push_back(timer.timerId);
+				}
+				break;
+			}
+		}
+	}
+	return readable ? 0 : -1;
+#endif
+}
+
+int Network::Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
+{
+	auto size = networkPacket.Size();
+	auto data = networkPacket.Data();
+
+#if _DEBUG
+	// Log the send buffer as comma separated values as string
+	std::string bufferString = BufferToString(data, size);
 	m_logger->Log(
 		LogLevel::DEBUG,
 		"Send: Sending bytes",
@@ -256,7 +807,7 @@ int Network::Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
 	);
 #endif
 
-	if (sendto(m_socket, (char*)data.data(), (int)size, 0, (sockaddr*)&clientAddr, sizeof(clientAddr)) != size)
+	if (sendto(m_socket, (char*)data, (int)size, 0, (sockaddr*)&clientAddr, sizeof(clientAddr)) != size)
 	{
 		auto errorCode = GetNetworkLastError();
 		std::string errorMsg = GetNetworkErrorMessage(errorCode);
@@ -265,7 +816,220 @@ int Network::Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
 			"Send: Failed",
 			{ KV(errorCode), KVS(errorMsg) }
 		);
+		m_counters.sendFailures++;
 		return 1;
 	}
+	m_counters.packetsSent++;
 	return 0;
 }
+
+int Network::SendBatch(std::vector<OutgoingPacket>& outgoingPackets)
+{
+	int failures = 0;
+
+#ifdef _WIN32
+	// No sendmmsg on Windows so send one datagram at a time
+	for (OutgoingPacket& outgoingPacket : outgoingPackets)
+	{
+		outgoingPacket.result = Send(*outgoingPacket.networkPacket, outgoingPacket.clientAddr);
+		if (outgoingPacket.result != 0)
+		{
+			failures++;
+		}
+	}
+#else
+	size_t offset = 0;
+	while (offset < outgoingPackets.size())
+	{
+		size_t count = std::min(outgoingPackets.size() - offset, MAX_BATCH_SIZE);
+		size_t messages = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			OutgoingPacket& outgoingPacket = outgoingPackets[offset + i];
+			outgoingPacket.result = 0;
+
+			auto size = outgoingPacket.networkPacket->Size();
+#if _DEBUG
+			std::string bufferString = BufferToString(outgoingPacket.networkPacket->Data(), size);
+			m_logger->Log(
+				LogLevel::DEBUG,
+				"SendBatch: Sending bytes",
+				{ KV(size), KVS(bufferString) }
+			);
+#endif
+
+			std::span<uint8_t> bytes = outgoingPacket.networkPacket->Bytes();
+			m_sendIovecs[i].iov_base = bytes.data();
+			m_sendIovecs[i].iov_len = bytes.size();
+
+			// Consecutive packets to the same client ride in one GSO message
+			if (m_gsoEnabled && messages > 0)
+			{
+				SendSegments& segments = m_sendSegments[messages - 1];
+				const OutgoingPacket& firstPacket = outgoingPackets[offset + i - segments.count];
+				if (CanAppendSegment(messages - 1, outgoingPacket, firstPacket))
+				{
+					segments.closed = size < segments.segmentSize;
+					segments.count++;
+					segments.bytes += size;
+					m_sendMessages[messages - 1].msg_hdr.msg_iovlen++;
+					continue;
+				}
+			}
+
+			m_sendSegments[messages] = { 1, size, size, false };
+			m_sendMessages[messages].msg_hdr.msg_iov = &m_sendIovecs[i];
+			m_sendMessages[messages].msg_hdr.msg_iovlen = 1;
+			m_sendMessages[messages].msg_hdr.msg_name = &outgoingPacket.clientAddr;
+			m_sendMessages[messages].msg_hdr.msg_namelen = sizeof(sockaddr_in);
+			m_sendMessages[messages].msg_hdr.msg_control = nullptr;
+			m_sendMessages[messages].msg_hdr.msg_controllen = 0;
+			m_sendMessages[messages].msg_len = 0;
+			messages++;
+		}
+
+		for (size_t i = 0; i < messages; i++)
+		{
+			if (m_sendSegments[i].count == 1)
+			{
+				continue;
+			}
+
+			// Kernel splits the message into datagrams of the segment size
+			msghdr& message = m_sendMessages[i].msg_hdr;
+			message.msg_control = m_sendControl[i];
+			message.msg_controllen = sizeof(m_sendControl[i]);
+			cmsghdr* cmsg = CMSG_FIRSTHDR(&message);
+			cmsg->cmsg_level = SOL_UDP;
+			cmsg->cmsg_type = UDP_SEGMENT;
+			cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+			uint16_t segmentSize = static_cast<uint16_t>(m_sendSegments[i].segmentSize);
+			std::memcpy(CMSG_DATA(cmsg), &segmentSize, sizeof(segmentSize));
+		}
+
+		int n = sendmmsg(m_socket, m_sendMessages, messages, 0);
+		if (n == SOCKET_ERROR)
+		{
+			auto errorCode = GetNetworkLastError();
+			if (errorCode == EIO && m_sendSegments[0].count > 1)
+			{
+				// Device cannot checksum the segments so fall back to plain datagrams
+				m_logger->Log(LogLevel::WARNING, "SendBatch: UDP_SEGMENT failed, disabling GSO");
+				m_gsoEnabled = false;
+				continue;
+			}
+
+			// sendmmsg stops at the first failing message so report it and skip past it
+			std::string errorMsg = GetNetworkErrorMessage(errorCode);
+			std::string address = NetworkUtilities::AddressToString(outgoingPackets[offset].clientAddr);
+			m_logger->Log(
+				LogLevel::EXCEPTION,
+				"SendBatch: Failed",
+				{ KV(errorCode), KVS(errorMsg), KVS(address) }
+			);
+			for (size_t i = 0; i < m_sendSegments[0].count; i++)
+			{
+				outgoingPackets[offset + i].result = 1;
+				failures++;
+			}
+			offset += m_sendSegments[0].count;
+			continue;
+		}
+
+		for (int i = 0; i < n; i++)
+		{
+			const SendSegments& segments = m_sendSegments[i];
+			if (m_sendMessages[i].msg_len != segments.bytes)
+			{
+				auto size = segments.bytes;
+				auto sent = m_sendMessages[i].msg_len;
+				std::string address = NetworkUtilities::AddressToString(outgoingPackets[offset].clientAddr);
+				m_logger->Log(
+					LogLevel::EXCEPTION,
+					"SendBatch: Partial send",
+					{ KV(size), KV(sent), KVS(address) }
+				);
+				for (size_t j = 0; j < segments.count; j++)
+				{
+					outgoingPackets[offset + j].result = 1;
+					failures++;
+				}
+			}
+			offset += segments.count;
+		}
+	}
+
+	// Windows counts in Send
+	m_counters.packetsSent += outgoingPackets.size() - failures;
+	m_counters.sendFailures += failures;
+#endif
+
+	return failures == 0 ? 0 : 1;
+}
+
+void Network::ConfigureBuffers()
+{
+	if (m_options.receiveBufferSize > 0 &&
+		setsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, (const char*)&m_options.receiveBufferSize, sizeof(m_options.receiveBufferSize)) != 0)
+	{
+		auto errorCode = GetNetworkLastError();
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::WARNING,
+			"Initialize: Failed to set receive buffer size",
+			{ KV(m_options.receiveBufferSize), KV(errorCode), KVS(errorMsg) }
+		);
+	}
+
+	if (m_options.sendBufferSize > 0 &&
+		setsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, (const char*)&m_options.sendBufferSize, sizeof(m_options.sendBufferSize)) != 0)
+	{
+		auto errorCode = GetNetworkLastError();
+		std::string errorMsg = GetNetworkErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::WARNING,
+			"Initialize: Failed to set send buffer size",
+			{ KV(m_options.sendBufferSize), KV(errorCode), KVS(errorMsg) }
+		);
+	}
+
+	// Kernel may clamp or double the requested sizes so read back what was granted
+	socklen_t optionLength = sizeof(m_counters.receiveBufferSize);
+	getsockopt(m_socket, SOL_SOCKET, SO_RCVBUF, (char*)&m_counters.receiveBufferSize, &optionLength);
+	optionLength = sizeof(m_counters.sendBufferSize);
+	getsockopt(m_socket, SOL_SOCKET, SO_SNDBUF, (char*)&m_counters.sendBufferSize, &optionLength);
+
+	int receiveBufferSize = m_counters.receiveBufferSize;
+	int sendBufferSize = m_counters.sendBufferSize;
+	m_logger->Log(LogLevel::INFO, "Initialize: Socket buffers", { KV(receiveBufferSize), KV(sendBufferSize) });
+}
+
+NetworkCounters Network::GetCounters()
+{
+#ifdef _WIN32
+	u_long available = 0;
+	if (ioctlsocket(m_socket, FIONREAD, &available) == 0)
+	{
+		m_counters.receiveQueueBytes = static_cast<int>(available);
+	}
+#else
+	// SIOCINQ only reports the next datagram on UDP so the whole queue is read from SO_MEMINFO
+	uint32_t memoryInfo[SK_MEMINFO_VARS]{};
+	socklen_t optionLength = sizeof(memoryInfo);
+	int queued = 0;
+	if (getsockopt(m_socket, SOL_SOCKET, SO_MEMINFO, memoryInfo, &optionLength) == 0)
+	{
+		m_counters.receiveQueueBytes = static_cast<int>(memoryInfo[SK_MEMINFO_RMEM_ALLOC]);
+	}
+	else if (ioctl(m_socket, SIOCINQ, &queued) == 0)
+	{
+		m_counters.receiveQueueBytes = queued;
+	}
+
+	if (ioctl(m_socket, SIOCOUTQ, &queued) == 0)
+	{
+		m_counters.sendQueueBytes = queued;
+	}
+#endif
+	return m_counters;
+}
\ No newline at end of file
@@ -4,22 +4,102 @@
 #include <memory>
 #include "NetworkBase.h"
 #include "Logger.h"
+#include "NetworkOptions.h"
 
 #ifdef _WIN32
 #else
+#include <sys/uio.h>
+#include <sys/epoll.h>
 typedef int SOCKET;
 #endif
 
-class Network : public NetworkBase
+class Network final : public NetworkBase
 {
 private:
+	static constexpr int RECEIVE_BUFFER_SIZE = NetworkPacket::MAX_DATAGRAM_SIZE;
+	static constexpr int MAX_EVENTS = 16;
+
+	// Coalesced receive buffers hold up to 64 KB worth of segments each
+	static constexpr size_t GRO_BATCH_SIZE = 8;
+	static constexpr size_t GRO_BUFFER_SIZE = 65535;
+
+#ifndef _WIN32
+	// Ancillary data of every received datagram: timestamp and drop counter
+	static constexpr size_t CONTROL_SIZE = CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(uint32_t));
+#endif
+
+	// Kernel limits for one UDP_SEGMENT send
+	static constexpr size_t GSO_MAX_SEGMENTS = 64;
+	static constexpr size_t GSO_MAX_BYTES = 65000;
+
+	struct NetworkTimer
+	{
+		int timerId{};
+		std::chrono::nanoseconds interval{};
+		std::chrono::steady_clock::time_point deadline{};
+		int fd = -1;
+	};
+
 	SOCKET m_socket{};
 	std::shared_ptr<Logger> m_logger;
+	NetworkOptions m_options;
+	bool m_groEnabled = false;
+	bool m_gsoEnabled = false;
+	std::vector<NetworkTimer> m_timers;
+
+	void ConfigureBuffers();
+
+#ifndef _WIN32
+	int m_epoll = -1;
+	epoll_event m_events[MAX_EVENTS]{};
+
+	// Pooled packets and addresses filled in place by recvmmsg
+	PacketHandle m_receiveSlots[MAX_BATCH_SIZE];
+	sockaddr_in m_receiveAddresses[MAX_BATCH_SIZE]{};
+	iovec m_receiveIovecs[MAX_BATCH_SIZE]{};
+	mmsghdr m_receiveMessages[MAX_BATCH_SIZE]{};
+	alignas(cmsghdr) uint8_t m_receiveControl[MAX_BATCH_SIZE][CONTROL_SIZE]{};
+
+	// Scatter list handed to sendmmsg
+	iovec m_sendIovecs[MAX_BATCH_SIZE]{};
+	mmsghdr m_sendMessages[MAX_BATCH_SIZE]{};
+
+	// Outgoing packets carried by every message, more than one when segmented with GSO
+	struct SendSegments
+	{
+		size_t count = 0;
+		size_t bytes = 0;
+		size_t segmentSize = 0;
+		bool closed = false;
+	};
+	SendSegments m_sendSegments[MAX_BATCH_SIZE]{};
+	alignas(cmsghdr) uint8_t m_sendControl[MAX_BATCH_SIZE][CMSG_SPACE(sizeof(uint16_t))]{};
+
+	// Large buffers for coalesced datagrams, allocated only when GRO is enabled
+	std::vector<uint8_t> m_groBuffers;
+	iovec m_groIovecs[GRO_BATCH_SIZE]{};
+	mmsghdr m_groMessages[GRO_BATCH_SIZE]{};
+	alignas(cmsghdr) uint8_t m_groControl[GRO_BATCH_SIZE][CMSG_SPACE(sizeof(int)) + CONTROL_SIZE]{};
+
+	void EnableOffload();
+	int ReceiveCoalescedBatch(std::vector<ReceivedPacket>& receivedPackets);
+	bool CanAppendSegment(size_t message, const OutgoingPacket& outgoingPacket, const OutgoingPacket& firstPacket);
+#endif
 
 public:
-    Network(std::shared_ptr<Logger> logger);
+    Network(std::shared_ptr<Logger> logger, bool reusePort = false);
+    Network(std::shared_ptr<Logger> logger, NetworkOptions options);
 	~Network();
     int Initialize(std::string server, int port, sockaddr_in& addr) override;
 	int Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr) override;
-	std::unique_ptr<NetworkPacket> Receive(sockaddr_in& clientAddr, int& result) override;
+	int SendBatch(std::vector<OutgoingPacket>& outgoingPackets) override;
+	PacketHandle Receive(sockaddr_in& clientAddr, int& result) override;
+	int ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets) override;
+	int StartTimer(int timerId, std::chrono::nanoseconds interval) override;
+	int WaitForEvents(std::vector<int>& expiredTimers) override;
+	NetworkCounters GetCounters() override;
+
+	// Offloads which the kernel accepted during Initialize
+	bool IsGroEnabled() const;
+	bool IsGsoEnabled() const;
 };
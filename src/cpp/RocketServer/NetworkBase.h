@@ -1,14 +1,66 @@
 #pragma once
 #include <string>
 #include <iostream>
+#include <vector>
+#include <chrono>
 #include "NetworkPacket.h"
 #include "NetworkConnectionState.h"
+#include "ReceivedPacket.h"
+#include "OutgoingPacket.h"
+#include "PacketPool.h"
+#include "NetworkCounters.h"
 
 class NetworkBase
 {
-private:
+protected:
+	// Base class members outlive the packets held by the derived transports
+	PacketPool m_packetPool;
+
+	NetworkCounters m_counters;
+
 public:
+	// Maximum number of datagrams drained by a single ReceiveBatch call
+	static constexpr size_t MAX_BATCH_SIZE = 64;
+
 	virtual int Initialize(std::string server, int port, sockaddr_in& addr) = 0;
+	// Sends the bytes as they are, callers seal packets with their codec first, see PacketCodec.h
 	virtual int Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr) = 0;
-	virtual std::unique_ptr<NetworkPacket> Receive(sockaddr_in& clientAddr, int& result) = 0;
+	virtual PacketHandle Receive(sockaddr_in& clientAddr, int& result) = 0;
+
+	// Returns a recycled packet which goes back to this network's pool when released
+	PacketHandle AcquirePacket()
+	{
+		return m_packetPool.Acquire();
+	}
+
+	// Appends up to MAX_BATCH_SIZE received packets to receivedPackets, or more
+	// when the transport splits coalesced GRO buffers back into datagrams.
+	// Returns -1 when no data is available, 0 on success and 1 on failure.
+	virtual int ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets) = 0;
+
+	// Sends every packet to its own address and stores the outcome in its result.
+	// Returns 0 if all packets were sent and 1 if any of them failed. Transports
+	// may take the packets, callers only read the results afterwards.
+	virtual int SendBatch(std::vector<OutgoingPacket>& outgoingPackets) = 0;
+
+	// Arms a periodic timer which WaitForEvents reports by its id
+	virtual int StartTimer(int timerId, std::chrono::nanoseconds interval) = 0;
+
+	// Blocks until a datagram arrives or a timer expires and appends the ids
+	// of the expired timers to expiredTimers. Returns 0 when datagrams are
+	// waiting, -1 when only timers expired and 1 on failure.
+	virtual int WaitForEvents(std::vector<int>& expiredTimers) = 0;
+
+	// Called when the player at clientAddr is gone, or when a datagram from an
+	// address without a player was rejected, transports that map peers to
+	// addresses release the mapping here
+	virtual void ReleasePeer(const sockaddr_in&)
+	{
+	}
+
+	// Returns the cumulative counters, transports sample their queue depths here
+	virtual NetworkCounters GetCounters()
+	{
+		return m_counters;
+	}
 };
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+// Transport statistics used to size socket buffers under real load
+struct NetworkCounters
+{
+    uint64_t packetsReceived = 0;
+    uint64_t packetsSent = 0;
+    uint64_t sendFailures = 0;
+
+    // Datagrams the kernel dropped because the receive buffer was full (SO_RXQ_OVFL)
+    uint64_t kernelDrops = 0;
+
+    // Bytes waiting in the socket queues when the counters were sampled (SIOCINQ, SIOCOUTQ)
+    int receiveQueueBytes = 0;
+    int sendQueueBytes = 0;
+
+    // Effective socket buffer sizes granted by the kernel
+    int receiveBufferSize = 0;
+    int sendBufferSize = 0;
+};
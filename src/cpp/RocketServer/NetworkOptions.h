@@ -0,0 +1,18 @@
+#pragma once
+
+// Socket features requested from the kernel when the network is initialized
+struct NetworkOptions
+{
+    // Share the port between several sockets (Linux only)
+    bool reusePort = false;
+
+    // Receive coalesced datagrams with UDP_GRO (Linux only)
+    bool udpGro = false;
+
+    // Send trains of equally sized datagrams with UDP_SEGMENT (Linux only)
+    bool udpGso = false;
+
+    // SO_RCVBUF and SO_SNDBUF in bytes, 0 keeps the kernel default
+    int receiveBufferSize = 0;
+    int sendBufferSize = 0;
+};
@@ -11,97 +11,137 @@
 #include "NetworkUtilities.h"
 
 NetworkPacket::NetworkPacket()
-	: m_offset(0)
 {
 	Clear();
 }
 
-NetworkPacket::NetworkPacket(std::vector<uint8_t>& data)
-	: m_buffer(data), m_offset(0)
+NetworkPacket::NetworkPacket(const std::vector<uint8_t>& data)
 {
+	Resize(data.size());
+	std::memcpy(m_buffer, data.data(), m_size);
 }
 
 size_t NetworkPacket::Size()
 {
-	return m_buffer.size();
+	return m_size;
+}
+
+uint8_t* NetworkPacket::Data()
+{
+	return m_buffer;
+}
+
+std::span<uint8_t> NetworkPacket::Bytes()
+{
+	return std::span<uint8_t>(m_buffer, m_size);
+}
+
+std::span<const uint8_t> NetworkPacket::Message()
+{
+	if (m_size <= CRC32::CRC_SIZE)
+	{
+		return {};
+	}
+	return std::span<const uint8_t>(m_buffer + CRC32::CRC_SIZE, m_size - CRC32::CRC_SIZE);
+}
+
+std::span<uint8_t> NetworkPacket::Buffer()
+{
+	return std::span<uint8_t>(m_buffer, PACKET_CAPACITY);
+}
+
+std::span<uint8_t> NetworkPacket::Append(size_t size)
+{
+	if (m_size + size > PACKET_CAPACITY)
+	{
+		m_overrun = true;
+		return {};
+	}
+	std::span<uint8_t> bytes(m_buffer + m_size, size);
+	m_size += size;
+	return bytes;
 }
 
 void NetworkPacket::Clear()
 {
-	m_buffer.clear();
-    m_buffer.reserve(1024);
+	m_size = 0;
 	WriteInt32(0); // Placeholder for CRC32
 	m_offset = 0;
+	m_overrun = false;
+	m_receiveTime = {};
+}
+
+void NetworkPacket::Resize(size_t size)
+{
+	// Datagrams larger than the capacity are truncated like by the kernel
+	m_overrun = size > PACKET_CAPACITY;
+	m_size = m_overrun ? PACKET_CAPACITY : size;
+	m_offset = 0;
+}
+
+bool NetworkPacket::Overrun() const
+{
+	return m_overrun;
+}
+
+std::chrono::steady_clock::time_point NetworkPacket::ReceiveTime()
+{
+	return m_receiveTime;
+}
+
+void NetworkPacket::SetReceiveTime(std::chrono::steady_clock::time_point receiveTime)
+{
+	m_receiveTime = receiveTime;
 }
 
 void NetworkPacket::WriteInt8(int8_t value)
 {
-	m_buffer.insert(m_buffer.end(), value);
+	WriteValue(value);
 }
 
 void NetworkPacket::WriteInt16(int16_t value)
 {
-    int16_t net = htons(value);
-    uint8_t* p = reinterpret_cast<uint8_t*>(&net);
-    m_buffer.insert(m_buffer.end(), p, p + sizeof(int16_t));
+	WriteValue<int16_t>(htons(value));
 }
 
 void NetworkPacket::WriteInt32(int32_t value)
 {
-	int32_t net = htonl(value);
-	uint8_t* p = reinterpret_cast<uint8_t*>(&net);
-	m_buffer.insert(m_buffer.end(), p, p + sizeof(int32_t));
+	WriteValue<int32_t>(htonl(value));
 }
 
 void NetworkPacket::WriteInt64(int64_t value)
 {
-	int64_t net = htonll(value);
-	uint8_t* p = reinterpret_cast<uint8_t*>(&net);
-	m_buffer.insert(m_buffer.end(), p, p + sizeof(int64_t));
+	WriteValue<int64_t>(htonll(value));
 }
 
 void NetworkPacket::WriteUInt64(uint64_t value)
 {
-    uint64_t net = htonll(value);
-    uint8_t* p = reinterpret_cast<uint8_t*>(&net);
-    m_buffer.insert(m_buffer.end(), p, p + sizeof(uint64_t));
+	WriteValue<uint64_t>(htonll(value));
 }
 
 void NetworkPacket::WriteKeyboard(const Keyboard& keyboard)
 {
-	uint8_t k = NetworkUtilities::PackKeyboard(keyboard);
-	m_buffer.push_back(k);
+	WriteValue<uint8_t>(NetworkUtilities::PackKeyboard(keyboard));
 }
 
 int8_t NetworkPacket::ReadInt8()
 {
-	int8_t value = m_buffer[m_offset];
-	m_offset += sizeof(int8_t);
-	return value;
+	return ReadValue<int8_t>();
 }
 
 int16_t NetworkPacket::ReadInt16()
 {
-    int16_t net = 0;
-    std::memcpy(&net, m_buffer.data() + m_offset, sizeof(int16_t));
-    m_offset += sizeof(int16_t);
-    return ntohs(net);
+	return ntohs(ReadValue<int16_t>());
 }
 
 int32_t NetworkPacket::ReadInt32()
 {
-    int32_t net = 0;
-    std::memcpy(&net, m_buffer.data() + m_offset, sizeof(int32_t));
-    m_offset += sizeof(int32_t);
-    return ntohl(net);
+	return ntohl(ReadValue<int32_t>());
 }
 
 uint64_t NetworkPacket::ReadUInt64()
 {
-    uint64_t net = 0;
-	std::memcpy(&net, m_buffer.data() + m_offset, sizeof(uint64_t));
-	m_offset += sizeof(uint64_t);
-	return ntohll(net);
+	return ntohll(ReadValue<uint64_t>());
 }
 
 float NetworkPacket::ReadInt32ToFloat()
@@ -111,12 +151,13 @@ float NetworkPacket::ReadInt32ToFloat()
 
 std::vector<uint8_t> NetworkPacket::ToBytes()
 {
-	return m_buffer;
+	return std::vector<uint8_t>(m_buffer, m_buffer + m_size);
 }
 
 NetworkPacket NetworkPacket::FromBytes(const std::vector<uint8_t>& data)
 {
-	m_buffer = data;
+	Resize(data.size());
+	std::memcpy(m_buffer, data.data(), m_size);
 	return *this;
 }
 
@@ -126,15 +167,16 @@ NetworkPacketType NetworkPacket::ReadNetworkPacketType()
 	return static_cast<NetworkPacketType>(networkPacketType);
 }
 
+template <typename Checksum>
 int NetworkPacket::ReadAndValidateCRC()
 {
 	// CRC32 check
+	if (m_size < CRC32::CRC_SIZE)
+	{
+		return 1;
+	}
 	uint32_t received_crc = ReadInt32();
-	m_crc.reset();
-	uint8_t magic = PROTOCOL_MAGIC_NUMBER;
-	m_crc.update(&magic, 1);
-	m_crc.update(m_buffer.data() + CRC32::CRC_SIZE, m_buffer.size() - CRC32::CRC_SIZE);
-	uint32_t calc_crc = m_crc.value();
+	uint32_t calc_crc = ComputeCRC<Checksum>();
 	if (received_crc != calc_crc)
 	{
 		return 1;
@@ -142,12 +184,24 @@ int NetworkPacket::ReadAndValidateCRC()
 	return 0;
 }
 
-void NetworkPacket::CalculateCRC()
+template <typename Checksum>
+uint32_t NetworkPacket::ComputeCRC()
 {
-	m_crc.reset();
+	Checksum crc;
 	uint8_t magic = PROTOCOL_MAGIC_NUMBER;
-	m_crc.update(&magic, 1);
-	m_crc.update(m_buffer.data() + CRC32::CRC_SIZE, m_buffer.size() - CRC32::CRC_SIZE);
-	uint32_t crc = htonl(m_crc.value());
-	std::memcpy(m_buffer.data(), &crc, sizeof(crc));
-}
\ No newline at end of file
+	crc.update(&magic, 1);
+	crc.update(m_buffer + CRC32::CRC_SIZE, m_size - CRC32::CRC_SIZE);
+	return crc.value();
+}
+
+template <typename Checksum>
+void NetworkPacket::CalculateCRC()
+{
+	uint32_t crc = htonl(ComputeCRC<Checksum>());
+	std::memcpy(m_buffer, &crc, sizeof(crc));
+}
+
+template int NetworkPacket::ReadAndValidateCRC<CRC32>();
+template int NetworkPacket::ReadAndValidateCRC<CRC32C>();
+template void NetworkPacket::CalculateCRC<CRC32>();
+template void NetworkPacket::CalculateCRC<CRC32C>();
\ No newline at end of file
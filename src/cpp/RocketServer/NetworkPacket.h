@@ -1,7 +1,10 @@
 #pragma once
 #include <cstdint>
 #include <vector>
+#include <span>
+#include <cstring>
 #include <stdexcept>
+#include <chrono>
 #ifdef _WIN32
 #include <winsock2.h>
 #include <ws2tcpip.h>
@@ -16,23 +19,84 @@
 #include "NetworkPacketType.h"
 #include "Keyboard.h"
 
+// Datagram bytes in an inline buffer of the largest datagram size, so that a
+// packet lives on the stack or in a pool without touching the heap. Writes
+// append at the end and reads advance a cursor. A write past the capacity or
+// a read past the end is dropped, reads then return zero, and the packet is
+// marked overrun until it is cleared or resized.
 class NetworkPacket {
 protected:
     static constexpr uint8_t PROTOCOL_MAGIC_NUMBER = 0xFE;
+    static constexpr size_t PACKET_CAPACITY = 1472;
 
-    std::vector<uint8_t> m_buffer;
-    CRC32 m_crc;
-    size_t m_offset;
+    alignas(8) uint8_t m_buffer[PACKET_CAPACITY];
+    size_t m_size = 0;
+    size_t m_offset = 0;
+    bool m_overrun = false;
+    std::chrono::steady_clock::time_point m_receiveTime{};
+
+    template <typename Checksum>
+    uint32_t ComputeCRC();
+
+    template <typename T>
+    inline void WriteValue(T value)
+    {
+        if (m_size + sizeof(T) > PACKET_CAPACITY) [[unlikely]]
+        {
+            m_overrun = true;
+            return;
+        }
+        std::memcpy(m_buffer + m_size, &value, sizeof(T));
+        m_size += sizeof(T);
+    }
+
+    template <typename T>
+    inline T ReadValue()
+    {
+        T value{};
+        if (m_offset + sizeof(T) > m_size) [[unlikely]]
+        {
+            m_overrun = true;
+            m_offset = m_size;
+            return value;
+        }
+        std::memcpy(&value, m_buffer + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return value;
+    }
 
 public:
+    // Largest UDP payload which fits a 1500 byte Ethernet MTU without IP fragmentation
+    static constexpr size_t MAX_DATAGRAM_SIZE = PACKET_CAPACITY;
+
     NetworkPacket();
-    NetworkPacket(std::vector<uint8_t>& data);
-    virtual std::vector<uint8_t> ToBytes();
-    virtual NetworkPacket FromBytes(const std::vector<uint8_t>& data);
-    virtual int ReadAndValidateCRC();
+    NetworkPacket(const std::vector<uint8_t>& data);
+    virtual ~NetworkPacket() = default;
+    std::vector<uint8_t> ToBytes();
+    NetworkPacket FromBytes(const std::vector<uint8_t>& data);
+    // Checksum is CRC32 or CRC32C, see PacketCodec.h
+    template <typename Checksum = CRC32>
+    int ReadAndValidateCRC();
 
     size_t Size();
+    uint8_t* Data();
+    // Bytes written or received, what the transport sends
+    std::span<uint8_t> Bytes();
+    // Bytes following the CRC, the type and the fields of the message, empty for a datagram without any
+    std::span<const uint8_t> Message();
+    // Whole capacity, what the transport receives into before calling Resize
+    std::span<uint8_t> Buffer();
+    // Appends size bytes to fill in place, empty when they do not fit
+    std::span<uint8_t> Append(size_t size);
     void Clear();
+    // Sets the payload size for writing received bytes into Data() and rewinds reading
+    void Resize(size_t size);
+    // Whether a read or write went past the end since Clear or Resize
+    bool Overrun() const;
+    // Time when the kernel queued the datagram, or when it was read if the kernel gave no timestamp
+    std::chrono::steady_clock::time_point ReceiveTime();
+    void SetReceiveTime(std::chrono::steady_clock::time_point receiveTime);
+    template <typename Checksum = CRC32>
     void CalculateCRC();
     void WriteInt8(int8_t value);
     void WriteInt16(int16_t value);
@@ -12,6 +12,7 @@ enum class NetworkPacketType : int8_t {
 	
     GAME_STATE = 10,
     INPUT_FRAME = 11,
+    GAME_STATE_FRAGMENT = 12,
 
 	DISCONNECT = 20,
 
@@ -19,5 +20,10 @@ enum class NetworkPacketType : int8_t {
 	RESUME = 31,
 
     CLOCK = 40,
-    CLOCK_RESPONSE = 41
+    CLOCK_RESPONSE = 41,
+
+    MTU_PROBE = 50,
+    MTU_PROBE_ACK = 51,
+
+    BUNDLE = 60
 };
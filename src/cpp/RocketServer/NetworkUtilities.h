@@ -2,10 +2,18 @@
 #include <cstdint>
 #include <vector>
 #include <chrono>
+#include <cstring>
 #include <assert.h>
 #include "Player.h"
 #include "PacketInfo.h"
 
+#ifndef _WIN32
+#include <netinet/udp.h>
+#ifndef UDP_GRO
+#define UDP_GRO 104
+#endif
+#endif
+
 constexpr auto SEQUENCE_NUMBER_MAX = 65535;
 constexpr auto SEQUENCE_NUMBER_HALF = 32768;
 
@@ -77,7 +85,7 @@ public:
         }
     }
 
-    static inline void VerifyAck(std::vector<PacketInfo>& data, const uint64_t& ack, uint32_t& ackBits)
+    static inline void VerifyAck(std::vector<PacketInfo>& data, const uint64_t& ack, uint32_t& ackBits, const std::chrono::steady_clock::time_point& receiveTicks)
     {
         if (data.size() == 0)
         {
@@ -101,7 +109,7 @@ public:
                 {
                     // First acknowledgement time of the packet is relevant
                     data[idx].acknowledged = isAck;
-                    data[idx].receiveTicks = std::chrono::steady_clock::now();
+                    data[idx].receiveTicks = receiveTicks;
                     data[idx].roundTripTime = data[idx].receiveTicks - data[idx].sendTicks;
                 }
             }
@@ -117,6 +125,81 @@ public:
             left.sin_port == right.sin_port);
     }
 
+#ifndef _WIN32
+    // Converts the SO_TIMESTAMPNS control message of a received datagram to
+    // steady clock. The kernel stamps with the realtime clock, so the age of the
+    // datagram is measured on that clock and subtracted from the current time.
+    static inline std::chrono::steady_clock::time_point GetReceiveTime(msghdr& message)
+    {
+        auto now = std::chrono::steady_clock::now();
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+        {
+            if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPNS)
+            {
+                continue;
+            }
+
+            timespec timestamp{};
+            std::memcpy(&timestamp, CMSG_DATA(cmsg), sizeof(timestamp));
+            auto kernelTime = std::chrono::system_clock::time_point(
+                std::chrono::duration_cast<std::chrono::system_clock::duration>(
+                    std::chrono::seconds(timestamp.tv_sec) + std::chrono::nanoseconds(timestamp.tv_nsec)));
+            auto age = std::chrono::system_clock::now() - kernelTime;
+            if (age > std::chrono::system_clock::duration::zero())
+            {
+                return now - std::chrono::duration_cast<std::chrono::steady_clock::duration>(age);
+            }
+            break;
+        }
+        return now;
+    }
+
+    // Reads the SO_RXQ_OVFL control message which carries the cumulative
+    // number of datagrams the socket dropped. Kernel omits it while zero.
+    static inline void GetDropCount(msghdr& message, uint64_t& kernelDrops)
+    {
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+        {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SO_RXQ_OVFL)
+            {
+                uint32_t dropCount = 0;
+                std::memcpy(&dropCount, CMSG_DATA(cmsg), sizeof(dropCount));
+                kernelDrops = dropCount;
+                return;
+            }
+        }
+    }
+
+    // Reads the UDP_GRO control message which carries the size of the
+    // segments of a coalesced buffer. Without it the buffer holds a single
+    // datagram of size bytes.
+    static inline size_t GetSegmentSize(msghdr& message, size_t size)
+    {
+        for (cmsghdr* cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+        {
+            if (cmsg->cmsg_level == SOL_UDP && cmsg->cmsg_type == UDP_GRO)
+            {
+                int segmentSize = 0;
+                std::memcpy(&segmentSize, CMSG_DATA(cmsg), sizeof(segmentSize));
+                return static_cast<size_t>(segmentSize);
+            }
+        }
+        return size;
+    }
+#endif
+
+    // Number of datagrams in a coalesced buffer of size bytes, all of
+    // segmentSize except a shorter last one. The last segment of a truncated
+    // buffer was cut off, so it is left out.
+    static inline size_t SegmentCount(size_t size, size_t segmentSize, bool truncated)
+    {
+        if (segmentSize == 0)
+        {
+            return 0;
+        }
+        return truncated ? size / segmentSize : (size + segmentSize - 1) / segmentSize;
+    }
+
     static std::string AddressToString(const sockaddr_in& addr)
     {
         char buf[INET_ADDRSTRLEN];
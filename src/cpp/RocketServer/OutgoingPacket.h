@@ -0,0 +1,11 @@
+#pragma once
+#include <memory>
+#include "NetworkPacket.h"
+#include "PacketPool.h"
+
+struct OutgoingPacket
+{
+    PacketHandle networkPacket;
+    sockaddr_in clientAddr{};
+    int result = 0;
+};
@@ -0,0 +1,46 @@
+#pragma once
+#include "NetworkPacket.h"
+
+// Codec policies of BasicServer and BasicClient. Validate reads past the
+// integrity check of a received packet and returns 0 when it is intact, Seal
+// writes the integrity check of a packet about to be sent. Transports send
+// packets as they are.
+
+// Identifies the codec in files which outlive the process, see CaptureFileHeader
+enum class CodecId : uint16_t {
+    CRC32 = 0,
+    CRC32C = 1
+};
+
+// CRC32 of the protocol magic number and the payload in the first four bytes
+struct Crc32Codec
+{
+    static constexpr CodecId ID = CodecId::CRC32;
+
+    static inline int Validate(NetworkPacket& networkPacket)
+    {
+        return networkPacket.ReadAndValidateCRC<CRC32>();
+    }
+
+    static inline void Seal(NetworkPacket& networkPacket)
+    {
+        networkPacket.CalculateCRC<CRC32>();
+    }
+};
+
+// Same layout with CRC32C, which CPUs with SSE4.2 compute in hardware. It is
+// a protocol variant, servers and clients only talk to the ones built with it.
+struct Crc32cCodec
+{
+    static constexpr CodecId ID = CodecId::CRC32C;
+
+    static inline int Validate(NetworkPacket& networkPacket)
+    {
+        return networkPacket.ReadAndValidateCRC<CRC32C>();
+    }
+
+    static inline void Seal(NetworkPacket& networkPacket)
+    {
+        networkPacket.CalculateCRC<CRC32C>();
+    }
+};
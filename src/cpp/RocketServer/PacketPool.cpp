@@ -0,0 +1,62 @@
+#include "PacketPool.h"
+#include "GamePacket.h"
+
+void PacketDeleter::operator()(NetworkPacket* networkPacket) const
+{
+	if (pool != nullptr)
+	{
+		pool->Release(networkPacket);
+	}
+	else
+	{
+		delete networkPacket;
+	}
+}
+
+PacketPool::PacketPool(size_t capacity)
+	: m_capacity(capacity)
+{
+	// Packets are game packets so that handlers can read them as either type
+	m_freePackets.reserve(capacity);
+	for (size_t i = 0; i < capacity; i++)
+	{
+		m_freePackets.push_back(new GamePacket());
+	}
+}
+
+PacketPool::~PacketPool()
+{
+	for (NetworkPacket* networkPacket : m_freePackets)
+	{
+		delete networkPacket;
+	}
+}
+
+PacketHandle PacketPool::Acquire()
+{
+	if (m_freePackets.empty())
+	{
+		return PacketHandle(new GamePacket(), PacketDeleter(this));
+	}
+
+	NetworkPacket* networkPacket = m_freePackets.back();
+	m_freePackets.pop_back();
+	return PacketHandle(networkPacket, PacketDeleter(this));
+}
+
+void PacketPool::Release(NetworkPacket* networkPacket)
+{
+	if (m_freePackets.size() >= m_capacity)
+	{
+		delete networkPacket;
+		return;
+	}
+
+	networkPacket->Clear();
+	m_freePackets.push_back(networkPacket);
+}
+
+size_t PacketPool::Available() const
+{
+	return m_freePackets.size();
+}
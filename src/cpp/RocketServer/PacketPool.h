@@ -0,0 +1,49 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include "NetworkPacket.h"
+
+class PacketPool;
+
+// Deleter which hands pooled packets back to their pool. Packets created
+// with std::make_unique have no pool and are deleted as usual.
+struct PacketDeleter
+{
+	PacketPool* pool = nullptr;
+
+	PacketDeleter() = default;
+	PacketDeleter(PacketPool* packetPool) : pool(packetPool) {}
+
+	template<typename T>
+	PacketDeleter(std::default_delete<T>) {}
+
+	void operator()(NetworkPacket* networkPacket) const;
+};
+
+using PacketHandle = std::unique_ptr<NetworkPacket, PacketDeleter>;
+
+// Free list of preallocated packets. Packet buffers are inline, so that
+// steady state receive, dispatch and send do not touch the heap.
+// Not thread safe, every network owns its own pool.
+class PacketPool
+{
+private:
+	std::vector<NetworkPacket*> m_freePackets;
+	size_t m_capacity;
+
+public:
+	static constexpr size_t DEFAULT_CAPACITY = 256;
+
+	PacketPool(size_t capacity = DEFAULT_CAPACITY);
+	~PacketPool();
+
+	PacketPool(const PacketPool&) = delete;
+	PacketPool& operator=(const PacketPool&) = delete;
+
+	// Returns a cleared packet, allocating a new one only if the pool is empty
+	PacketHandle Acquire();
+	void Release(NetworkPacket* networkPacket);
+
+	size_t Available() const;
+};
@@ -0,0 +1,211 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <tuple>
+#include <type_traits>
+#include "NetworkPacket.h"
+#include "NetworkPacketType.h"
+
+// Bytes following the fields of a packet, between MinBytes and
+// MaxBytes, written and read by the caller. Packets never exceed the largest
+// datagram size whatever MaxBytes is.
+template <size_t MinBytes, size_t MaxBytes>
+struct TrailingBytes
+{
+    static constexpr bool PADDED = false;
+    static constexpr size_t MinSize(size_t headerSize) { return headerSize + MinBytes; }
+    static constexpr size_t MaxSize(size_t headerSize) { return headerSize + MaxBytes < NetworkPacket::MAX_DATAGRAM_SIZE ? headerSize + MaxBytes : NetworkPacket::MAX_DATAGRAM_SIZE; }
+};
+
+using NoTrailingBytes = TrailingBytes<0, 0>;
+
+// Zero padding which Write appends up to exactly Size bytes
+template <size_t Size>
+struct PaddedTo
+{
+    static constexpr bool PADDED = true;
+    static constexpr size_t MinSize(size_t) { return Size; }
+    static constexpr size_t MaxSize(size_t) { return Size; }
+};
+
+// Unsigned integer field of type T in as few bytes as its value needs, seven
+// bits a byte with the least significant first and the high bit set on every
+// byte but the last. Values below 128 take a single byte.
+template <typename T>
+struct VarUInt
+{
+    static_assert(std::is_unsigned_v<T>, "Variable-length fields are unsigned");
+};
+
+// Encoding of a field of a schema, a big-endian integer unless specialized
+template <typename Field>
+struct FieldTraits
+{
+    static_assert(std::is_integral_v<Field>, "Fields are integers");
+
+    using Value = Field;
+    static constexpr size_t MIN_SIZE = sizeof(Field);
+    static constexpr size_t MAX_SIZE = sizeof(Field);
+
+    static constexpr size_t Size(Value)
+    {
+        return sizeof(Field);
+    }
+
+    static inline void Store(uint8_t* data, size_t& offset, Value value)
+    {
+        auto bits = static_cast<std::make_unsigned_t<Field>>(value);
+        for (size_t i = 0; i < sizeof(Field); i++)
+        {
+            data[offset + i] = static_cast<uint8_t>(bits >> (8 * (sizeof(Field) - 1 - i)));
+        }
+        offset += sizeof(Field);
+    }
+
+    static inline Value Load(const uint8_t* data, size_t& offset)
+    {
+        std::make_unsigned_t<Field> bits = 0;
+        for (size_t i = 0; i < sizeof(Field); i++)
+        {
+            bits = static_cast<std::make_unsigned_t<Field>>((bits << 8) | data[offset + i]);
+        }
+        offset += sizeof(Field);
+        return static_cast<Value>(bits);
+    }
+
+    // Moves offset past the field, false when the field does not end within size bytes
+    static inline bool Skip(const uint8_t*, size_t size, size_t& offset)
+    {
+        offset += sizeof(Field);
+        return offset <= size;
+    }
+};
+
+template <typename T>
+struct FieldTraits<VarUInt<T>>
+{
+    using Value = T;
+    static constexpr size_t MIN_SIZE = 1;
+    static constexpr size_t MAX_SIZE = (8 * sizeof(T) + 6) / 7;
+
+    static constexpr size_t Size(Value value)
+    {
+        size_t size = 1;
+        while (value >= 0x80)
+        {
+            value = static_cast<Value>(value >> 7);
+            size++;
+        }
+        return size;
+    }
+
+    static inline void Store(uint8_t* data, size_t& offset, Value value)
+    {
+        while (value >= 0x80)
+        {
+            data[offset++] = static_cast<uint8_t>(value | 0x80);
+            value = static_cast<Value>(value >> 7);
+        }
+        data[offset++] = static_cast<uint8_t>(value);
+    }
+
+    // The field was checked by Skip
+    static inline Value Load(const uint8_t* data, size_t& offset)
+    {
+        Value value = 0;
+        for (size_t shift = 0; ; shift += 7)
+        {
+            uint8_t byte = data[offset++];
+            value = static_cast<Value>(value | (static_cast<Value>(byte & 0x7F) << shift));
+            if ((byte & 0x80) == 0)
+            {
+                return value;
+            }
+        }
+    }
+
+    // Rejects fields longer than MAX_SIZE and last bytes with bits past the range of T
+    static inline bool Skip(const uint8_t* data, size_t size, size_t& offset)
+    {
+        for (size_t i = 0; i < MAX_SIZE && offset < size; i++)
+        {
+            uint8_t byte = data[offset++];
+            if ((byte & 0x80) == 0)
+            {
+                size_t bitsLeft = 8 * sizeof(T) - 7 * i;
+                return bitsLeft >= 7 || (byte >> bitsLeft) == 0;
+            }
+        }
+        return false;
+    }
+};
+
+// Layout of a packet type: the CRC, the type, the Fields in order and then
+// the Trailing bytes. Fields are big-endian integers or VarUInt. Write
+// encodes all fields against a single bounds check of the packet and
+// PacketView decodes them from received bytes. HEADER_SIZE and
+// MAX_HEADER_SIZE are the CRC, the type and the fields at their shortest and
+// longest, MIN_SIZE and MAX_SIZE the sizes a valid datagram of the type has.
+template <NetworkPacketType Type, typename Trailing, typename... Fields>
+struct PacketSchema
+{
+    using Values = std::tuple<typename FieldTraits<Fields>::Value...>;
+
+    static constexpr NetworkPacketType TYPE = Type;
+    static constexpr size_t HEADER_SIZE = CRC32::CRC_SIZE + sizeof(NetworkPacketType) + (FieldTraits<Fields>::MIN_SIZE + ... + 0);
+    static constexpr size_t MAX_HEADER_SIZE = CRC32::CRC_SIZE + sizeof(NetworkPacketType) + (FieldTraits<Fields>::MAX_SIZE + ... + 0);
+    static constexpr size_t MIN_SIZE = Trailing::MinSize(HEADER_SIZE);
+    static constexpr size_t MAX_SIZE = Trailing::MaxSize(MAX_HEADER_SIZE);
+
+    static_assert(MIN_SIZE >= HEADER_SIZE && MIN_SIZE <= MAX_SIZE, "Padding leaves room for the fields");
+
+    static constexpr bool ValidSize(size_t size)
+    {
+        return size >= MIN_SIZE && size <= MAX_SIZE;
+    }
+
+    // Whether a datagram whose header takes headerSize bytes may have the size
+    static constexpr bool ValidSize(size_t size, size_t headerSize)
+    {
+        return size >= Trailing::MinSize(headerSize) && size <= Trailing::MaxSize(headerSize);
+    }
+
+    // Appends the type and the fields, and the padding of padded packets, to a cleared packet
+    static void Write(NetworkPacket& networkPacket, typename FieldTraits<Fields>::Value... values)
+    {
+        std::span<uint8_t> bytes = networkPacket.Append(sizeof(NetworkPacketType) + (FieldTraits<Fields>::Size(values) + ... + 0));
+        if (bytes.empty())
+        {
+            return;
+        }
+
+        bytes[0] = static_cast<uint8_t>(Type);
+        [[maybe_unused]] size_t offset = sizeof(NetworkPacketType);
+        (FieldTraits<Fields>::Store(bytes.data(), offset, values), ...);
+
+        if constexpr (Trailing::PADDED)
+        {
+            if (networkPacket.Size() < MIN_SIZE)
+            {
+                std::span<uint8_t> padding = networkPacket.Append(MIN_SIZE - networkPacket.Size());
+                std::memset(padding.data(), 0, padding.size());
+            }
+        }
+    }
+
+    // Sets size to the bytes the fields take at the start of fields, false when they run past its end
+    static bool MeasureFields(std::span<const uint8_t> fields, size_t& size)
+    {
+        size = 0;
+        return (FieldTraits<Fields>::Skip(fields.data(), fields.size(), size) && ...);
+    }
+
+    // Decodes the fields starting at data, measured by MeasureFields
+    static Values LoadFields(const uint8_t* data)
+    {
+        // Elements of a braced list are evaluated in order
+        size_t offset = 0;
+        return Values{ FieldTraits<Fields>::Load(data, offset)... };
+    }
+};
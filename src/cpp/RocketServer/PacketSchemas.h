@@ -0,0 +1,103 @@
+#pragma once
+#include <array>
+#include "PacketSchema.h"
+#include "PacketView.h"
+#include "GamePacket.h"
+
+// Wire layout of every packet type. Each type has one layout and is only
+// sent in one direction, clients send INPUT_FRAME and the server GAME_STATE.
+class PacketSchemas
+{
+private:
+    struct SizeLimits
+    {
+        size_t minSize = 0;
+        size_t maxSize = 0;
+    };
+
+    template <typename... Schemas>
+    static constexpr std::array<SizeLimits, 256> MakeSizeLimits()
+    {
+        std::array<SizeLimits, 256> sizeLimits{};
+        ((sizeLimits[static_cast<uint8_t>(Schemas::TYPE)] = SizeLimits{ Schemas::MIN_SIZE, Schemas::MAX_SIZE }), ...);
+        return sizeLimits;
+    }
+
+public:
+    // Connection requests and responses are padded so that the replies of the server are never larger
+    static constexpr size_t CONNECTION_PACKET_SIZE = 1000;
+
+    // Optional features, clients request them and the server accepts those it supports
+    static constexpr uint8_t ENTROPY_CODED_SNAPSHOTS = 1 << 0;
+
+    // Client salt, requested features
+    using ConnectionRequest = PacketSchema<NetworkPacketType::CONNECTION_REQUEST, PaddedTo<CONNECTION_PACKET_SIZE>, uint64_t, uint8_t>;
+    using ConnectionDenied = PacketSchema<NetworkPacketType::CONNECTION_DENIED, NoTrailingBytes>;
+    // Client salt, server salt
+    using Challenge = PacketSchema<NetworkPacketType::CHALLENGE, NoTrailingBytes, uint64_t, uint64_t>;
+    // Connection salt
+    using ChallengeResponse = PacketSchema<NetworkPacketType::CHALLENGE_RESPONSE, PaddedTo<CONNECTION_PACKET_SIZE>, uint64_t>;
+    // Player id, accepted features, connection id
+    using ConnectionAccepted = PacketSchema<NetworkPacketType::CONNECTION_ACCEPTED, NoTrailingBytes, int64_t, uint8_t, uint16_t>;
+
+    // The messages sent every tick carry the connection id the server
+    // assigned instead of the connection salt, and the ack and baseline as
+    // their distance back from the sequence number and the ack bits inverted,
+    // see SequenceDistance and MissingAckBits. While packets arrive in order
+    // each of those takes a single byte.
+
+    // Connection id, sequence number, ack distance, missing ack bits, baseline distance, then the snapshot
+    using GameState = PacketSchema<NetworkPacketType::GAME_STATE, TrailingBytes<sizeof(uint8_t), NetworkPacket::MAX_DATAGRAM_SIZE>,
+        uint16_t, uint16_t, VarUInt<uint16_t>, VarUInt<uint32_t>, VarUInt<uint16_t>>;
+    // Game state fields, fragment index, fragment count, then the player states which follow those of the fragments before
+    using GameStateFragment = PacketSchema<NetworkPacketType::GAME_STATE_FRAGMENT, TrailingBytes<sizeof(uint8_t), NetworkPacket::MAX_DATAGRAM_SIZE>,
+        uint16_t, uint16_t, VarUInt<uint16_t>, VarUInt<uint32_t>, VarUInt<uint16_t>, uint8_t, uint8_t>;
+    // Connection id, sequence number, ack distance, missing ack bits, then the player state
+    using InputFrame = PacketSchema<NetworkPacketType::INPUT_FRAME, TrailingBytes<GamePacket::PLAYER_STATE_SIZE, GamePacket::PLAYER_STATE_SIZE>,
+        uint16_t, uint16_t, VarUInt<uint16_t>, VarUInt<uint32_t>>;
+
+    // Connection salt
+    using Disconnect = PacketSchema<NetworkPacketType::DISCONNECT, NoTrailingBytes, uint64_t>;
+
+    // Connection salt, client time in milliseconds
+    using Clock = PacketSchema<NetworkPacketType::CLOCK, NoTrailingBytes, uint64_t, int64_t>;
+    // Server time in milliseconds
+    using ClockResponse = PacketSchema<NetworkPacketType::CLOCK_RESPONSE, NoTrailingBytes, int64_t>;
+
+    // Connection salt, probe size, then zero padding up to the probe size
+    using MtuProbe = PacketSchema<NetworkPacketType::MTU_PROBE, TrailingBytes<0, NetworkPacket::MAX_DATAGRAM_SIZE>, uint64_t, uint16_t>;
+    // Connection salt, probe size
+    using MtuProbeAck = PacketSchema<NetworkPacketType::MTU_PROBE_ACK, NoTrailingBytes, uint64_t, uint16_t>;
+
+    // Messages, each one preceded by its uint16_t length, see MessageBundle
+    using Bundle = PacketSchema<NetworkPacketType::BUNDLE, TrailingBytes<sizeof(uint16_t) + sizeof(NetworkPacketType), NetworkPacket::MAX_DATAGRAM_SIZE>>;
+
+    // Sequence numbers and ack bits to and from the fields of the messages sent every tick
+    static constexpr uint16_t SequenceDistance(uint16_t seqNum, uint16_t earlier)
+    {
+        return static_cast<uint16_t>(seqNum - earlier);
+    }
+
+    static constexpr uint16_t SequenceBefore(uint16_t seqNum, uint16_t distance)
+    {
+        return static_cast<uint16_t>(seqNum - distance);
+    }
+
+    // Its own inverse
+    static constexpr uint32_t MissingAckBits(uint32_t ackBits)
+    {
+        return ~ackBits;
+    }
+
+    // Whether a datagram of the type may have the size, the size includes the CRC
+    static inline bool ValidSize(NetworkPacketType type, size_t size)
+    {
+        // Types without a layout have no valid size
+        static constexpr std::array<SizeLimits, 256> sizeLimits = MakeSizeLimits<
+            ConnectionRequest, ConnectionDenied, Challenge, ChallengeResponse, ConnectionAccepted,
+            GameState, GameStateFragment, InputFrame, Disconnect, Clock, ClockResponse, MtuProbe, MtuProbeAck, Bundle>();
+
+        const SizeLimits& limits = sizeLimits[static_cast<uint8_t>(type)];
+        return size >= limits.minSize && size <= limits.maxSize && limits.maxSize > 0;
+    }
+};
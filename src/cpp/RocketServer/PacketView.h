@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include "PacketSchema.h"
+
+// Read-only view of a received message laid out by Schema. A message is the
+// type and what follows it, either the datagram after its CRC or one message
+// of a bundle, see MessageBundle. The type, the length and the extent of
+// variable-length fields are validated once when the view is made, after
+// which the fields are decoded straight from the received bytes without
+// further bounds checks and the trailing bytes are handed out in place. A
+// message of another type or an invalid size gives an empty view whose
+// fields read as zero.
+template <typename Schema>
+class PacketView
+{
+private:
+    static constexpr size_t FIELDS_OFFSET = sizeof(NetworkPacketType);
+
+    std::span<const uint8_t> m_bytes;
+    size_t m_trailingOffset = 0;
+
+public:
+    // Bytes of the message, starting with the type
+    explicit PacketView(std::span<const uint8_t> bytes)
+    {
+        // Sizes of the schema include the CRC which the message goes without
+        size_t fieldsSize = 0;
+        if (Schema::ValidSize(bytes.size() + CRC32::CRC_SIZE) &&
+            static_cast<NetworkPacketType>(bytes[0]) == Schema::TYPE &&
+            Schema::MeasureFields(bytes.subspan(FIELDS_OFFSET), fieldsSize) &&
+            Schema::ValidSize(bytes.size() + CRC32::CRC_SIZE, CRC32::CRC_SIZE + FIELDS_OFFSET + fieldsSize))
+        {
+            m_bytes = bytes;
+            m_trailingOffset = FIELDS_OFFSET + fieldsSize;
+        }
+    }
+
+    inline bool Valid() const
+    {
+        return !m_bytes.empty();
+    }
+
+    // Fields following the type
+    inline typename Schema::Values Fields() const
+    {
+        if (!Valid())
+        {
+            return typename Schema::Values{};
+        }
+        return Schema::LoadFields(m_bytes.data() + FIELDS_OFFSET);
+    }
+
+    // Bytes following the fields, empty for an invalid view
+    inline std::span<const uint8_t> Trailing() const
+    {
+        if (!Valid())
+        {
+            return {};
+        }
+        return m_bytes.subspan(m_trailingOffset);
+    }
+};
@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include "NetworkPacket.h"
+#include "PacketSchemas.h"
+
+// Path MTU discovery. Once a client is connected the server sends MTU_PROBE
+// datagrams padded to every candidate size with the don't fragment bit set.
+// The client answers each probe which arrived complete with MTU_PROBE_ACK,
+// and the largest acknowledged size becomes the byte budget of the snapshots
+// sent to it. Until then the budget is the payload every IPv4 path carries.
+//
+// See PacketSchemas::MtuProbe and PacketSchemas::MtuProbeAck for the layouts.
+class PathMtu
+{
+public:
+    // 576 byte minimum reassembly size minus 60 byte IP and 8 byte UDP headers
+    static constexpr size_t MIN_DATAGRAM_SIZE = 508;
+
+    // Probed in every round, the largest one fills an Ethernet frame
+    static constexpr size_t PROBE_SIZES[] = { 1000, 1200, 1400, NetworkPacket::MAX_DATAGRAM_SIZE };
+
+    // Probes are lost like any datagram, so unanswered sizes are probed again on later rounds
+    static constexpr int MAX_PROBE_ROUNDS = 3;
+
+    static inline void WriteProbe(NetworkPacket& networkPacket, uint64_t connectionSalt, size_t size)
+    {
+        PacketSchemas::MtuProbe::Write(networkPacket, connectionSalt, static_cast<uint16_t>(size));
+        if (networkPacket.Size() < size)
+        {
+            std::span<uint8_t> padding = networkPacket.Append(size - networkPacket.Size());
+            std::memset(padding.data(), 0, padding.size());
+        }
+    }
+
+    static inline void WriteProbeAck(NetworkPacket& networkPacket, uint64_t connectionSalt, size_t size)
+    {
+        PacketSchemas::MtuProbeAck::Write(networkPacket, connectionSalt, static_cast<uint16_t>(size));
+    }
+
+    // Reads a received probe, which is never bundled so the message is the
+    // whole datagram after the CRC. Returns 0 when the probe was truncated on
+    // the way, which must not count as the path carrying it.
+    static inline size_t ReadProbe(std::span<const uint8_t> message, uint64_t& connectionSalt)
+    {
+        auto [salt, size] = PacketView<PacketSchemas::MtuProbe>(message).Fields();
+        connectionSalt = salt;
+        return size == message.size() + CRC32::CRC_SIZE ? size : 0;
+    }
+};
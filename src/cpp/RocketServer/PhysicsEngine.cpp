@@ -51,11 +51,11 @@ void PhysicsEngine::ApplyInput(PlayerState& player, const Keyboard& input, float
     // Normalize rotation to [0, 2?)
     while (player.rotation.floatValue < 0.0f)
     {
-        player.rotation.floatValue += 2.0f * 3.14159f;
+        player.rotation.floatValue += FULL_ROTATION;
     }
-    while (player.rotation.floatValue >= 2.0f * 3.14159f)
+    while (player.rotation.floatValue >= FULL_ROTATION)
     {
-        player.rotation.floatValue -= 2.0f * 3.14159f;
+        player.rotation.floatValue -= FULL_ROTATION;
     }
     
     // Thrust
@@ -97,10 +97,7 @@ void PhysicsEngine::ApplyPhysics(PlayerState& player, float deltaTime)
         player.vel.y.floatValue * player.vel.y.floatValue
     );
     
-    // Simple screen wrapping (adjust bounds as needed)
-    const float WORLD_WIDTH = 1920.0f;
-    const float WORLD_HEIGHT = 1080.0f;
-    
+    // Simple screen wrapping
     if (player.pos.x.floatValue < 0.0f)
     {
         player.pos.x.floatValue = WORLD_WIDTH;
@@ -8,11 +8,16 @@ class PhysicsEngine
 private:
     // Physics constants
     static constexpr float ACCELERATION = 100.0f;
-    static constexpr float MAX_SPEED = 500.0f;
     static constexpr float ROTATION_SPEED = 3.14159f;
     static constexpr float FRICTION = 0.95f;
     
 public:
+    // Bounds of the simulated values, GamePacket quantizes within them
+    static constexpr float MAX_SPEED = 500.0f;
+    static constexpr float WORLD_WIDTH = 1920.0f;
+    static constexpr float WORLD_HEIGHT = 1080.0f;
+    static constexpr float FULL_ROTATION = 2.0f * 3.14159f;
+
     // Pure function - no side effects, thread-safe
     static PlayerState SimulatePlayer(const PlayerState& state, const Keyboard& input, float deltaTime);
     
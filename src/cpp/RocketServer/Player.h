@@ -13,12 +13,16 @@
 #include "NetworkConnectionState.h"
 #include "GamePacket.h"
 #include "PacketInfo.h"
+#include "PathMtu.h"
+#include "SnapshotHistory.h"
 
 struct Player : PlayerState
 {
 	uint64_t ClientSalt = 0;
 	uint64_t ServerSalt = 0;
 	uint64_t ConnectionSalt = 0;
+	// Assigned by the server and sent in place of the salt every tick, see BasicServer::FindPlayer
+	uint16_t ConnectionId = 0;
     // TODO: Add signing key to encrypt payload but not headers
 	sockaddr_in Address{};
 	NetworkConnectionState ConnectionState = NetworkConnectionState::DISCONNECTED;
@@ -27,6 +31,13 @@ struct Player : PlayerState
 	int Messages = 0;
 	int64_t Ticks = 0;
 
+    // Features requested by the client and supported by the server, see PacketSchemas
+    uint8_t Features = 0;
+
+    // Largest datagram acknowledged by the client, the byte budget of its snapshots
+    size_t Mtu = PathMtu::MIN_DATAGRAM_SIZE;
+    int MtuProbeRounds = 0;
+
     int64_t serverClockOffset = 0;
 
     std::vector<PacketInfo> sendPackets{};
@@ -37,4 +48,8 @@ struct Player : PlayerState
 
     uint64_t remoteSequenceNumberLarge = 0;
     uint16_t remoteSequenceNumberSmall = 0;
+
+    // Snapshots sent to the client and the newest one it acknowledged, 0 until it acknowledges one
+    SnapshotHistory snapshots{};
+    uint64_t baselineSequenceNumber = 0;
 };
\ No newline at end of file
@@ -0,0 +1,232 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include "NetworkPacket.h"
+
+// Adaptive binary range coder as used by LZMA. Every bit is coded with the
+// probability of it being zero, out of PROBABILITY_ONE, which moves towards
+// the coded bit by 1/32 of the distance each time. Direct bits are coded
+// with a probability of one half and cost exactly one bit.
+//
+// The coder works on a single datagram. The leading byte, which is always
+// zero, is not written and trailing zero bytes are trimmed, the decoder reads
+// zeros past the end instead.
+// https://github.com/jljusten/LZMA-SDK/blob/master/DOC/lzma-specification.txt
+class RangeCoder
+{
+public:
+    static constexpr int PROBABILITY_BITS = 11;
+    static constexpr uint16_t PROBABILITY_ONE = 1 << PROBABILITY_BITS;
+    static constexpr uint16_t PROBABILITY_HALF = PROBABILITY_ONE / 2;
+    static constexpr int MOVE_BITS = 5;
+    static constexpr uint32_t TOP = 1u << 24;
+};
+
+// Appends the coded bits to a packet
+class RangeEncoder
+{
+private:
+    NetworkPacket& m_packet;
+    size_t m_start = 0;
+    uint64_t m_low = 0;
+    uint32_t m_range = 0xFFFFFFFF;
+    uint8_t m_cache = 0;
+    uint64_t m_cacheSize = 1;
+    bool m_leadingByte = true;
+
+    inline void ShiftLow()
+    {
+        // Bytes are held back while a carry may still propagate into them
+        if (static_cast<uint32_t>(m_low) < 0xFF000000 || (m_low >> 32) != 0)
+        {
+            uint8_t carry = static_cast<uint8_t>(m_low >> 32);
+            uint8_t byte = m_cache;
+            do
+            {
+                if (!m_leadingByte)
+                {
+                    m_packet.WriteInt8(static_cast<int8_t>(byte + carry));
+                }
+                m_leadingByte = false;
+                byte = 0xFF;
+            } while (--m_cacheSize != 0);
+            m_cache = static_cast<uint8_t>(m_low >> 24);
+        }
+        m_cacheSize++;
+        m_low = (m_low & 0x00FFFFFF) << 8;
+    }
+
+    inline void Normalize()
+    {
+        while (m_range < RangeCoder::TOP)
+        {
+            m_range <<= 8;
+            ShiftLow();
+        }
+    }
+
+public:
+    // State to go back to when the bits coded since do not fit
+    struct Checkpoint
+    {
+        size_t size = 0;
+        uint64_t low = 0;
+        uint32_t range = 0;
+        uint8_t cache = 0;
+        uint64_t cacheSize = 0;
+        bool leadingByte = false;
+    };
+
+    explicit RangeEncoder(NetworkPacket& networkPacket) : m_packet(networkPacket), m_start(networkPacket.Size())
+    {
+    }
+
+    inline void EncodeBit(uint16_t& probability, uint32_t bit)
+    {
+        uint32_t bound = (m_range >> RangeCoder::PROBABILITY_BITS) * probability;
+        if (bit == 0)
+        {
+            m_range = bound;
+            probability += (RangeCoder::PROBABILITY_ONE - probability) >> RangeCoder::MOVE_BITS;
+        }
+        else
+        {
+            m_low += bound;
+            m_range -= bound;
+            probability -= probability >> RangeCoder::MOVE_BITS;
+        }
+        Normalize();
+    }
+
+    // Most significant bit first
+    inline void EncodeDirectBits(uint32_t value, int bits)
+    {
+        for (int i = bits - 1; i >= 0; i--)
+        {
+            m_range >>= 1;
+            if ((value >> i) & 1)
+            {
+                m_low += m_range;
+            }
+            Normalize();
+        }
+    }
+
+    // Bytes which Flush appends at most
+    inline size_t PendingBytes() const
+    {
+        return static_cast<size_t>(m_cacheSize) + 4;
+    }
+
+    inline Checkpoint Save() const
+    {
+        return Checkpoint{ m_packet.Size(), m_low, m_range, m_cache, m_cacheSize, m_leadingByte };
+    }
+
+    // Carries never reach bytes already written, so only the packet size is restored
+    inline void Restore(const Checkpoint& checkpoint)
+    {
+        m_packet.Resize(checkpoint.size);
+        m_low = checkpoint.low;
+        m_range = checkpoint.range;
+        m_cache = checkpoint.cache;
+        m_cacheSize = checkpoint.cacheSize;
+        m_leadingByte = checkpoint.leadingByte;
+    }
+
+    inline void Flush()
+    {
+        // Any value within the range decodes the same, the one with the most trailing zero bits needs the fewest bytes
+        for (int bits = 32; bits > 0; bits--)
+        {
+            uint64_t mask = (uint64_t(1) << bits) - 1;
+            uint64_t value = (m_low + mask) & ~mask;
+            if (value < m_low + m_range)
+            {
+                m_low = value;
+                break;
+            }
+        }
+
+        for (int i = 0; i < 5; i++)
+        {
+            ShiftLow();
+        }
+
+        size_t size = m_packet.Size();
+        while (size > m_start && m_packet.Data()[size - 1] == 0)
+        {
+            size--;
+        }
+        m_packet.Resize(size);
+    }
+};
+
+// Decodes bits from received bytes written by RangeEncoder
+class RangeDecoder
+{
+private:
+    std::span<const uint8_t> m_bytes;
+    size_t m_offset = 0;
+    uint32_t m_code = 0;
+    uint32_t m_range = 0xFFFFFFFF;
+
+    inline uint8_t NextByte()
+    {
+        return m_offset < m_bytes.size() ? m_bytes[m_offset++] : 0;
+    }
+
+    inline void Normalize()
+    {
+        while (m_range < RangeCoder::TOP)
+        {
+            m_range <<= 8;
+            m_code = (m_code << 8) | NextByte();
+        }
+    }
+
+public:
+    explicit RangeDecoder(std::span<const uint8_t> bytes) : m_bytes(bytes)
+    {
+        // The leading zero byte was not written
+        for (int i = 0; i < 4; i++)
+        {
+            m_code = (m_code << 8) | NextByte();
+        }
+    }
+
+    inline uint32_t DecodeBit(uint16_t& probability)
+    {
+        uint32_t bound = (m_range >> RangeCoder::PROBABILITY_BITS) * probability;
+        uint32_t bit;
+        if (m_code < bound)
+        {
+            m_range = bound;
+            probability += (RangeCoder::PROBABILITY_ONE - probability) >> RangeCoder::MOVE_BITS;
+            bit = 0;
+        }
+        else
+        {
+            m_code -= bound;
+            m_range -= bound;
+            probability -= probability >> RangeCoder::MOVE_BITS;
+            bit = 1;
+        }
+        Normalize();
+        return bit;
+    }
+
+    inline uint32_t DecodeDirectBits(int bits)
+    {
+        uint32_t value = 0;
+        for (int i = 0; i < bits; i++)
+        {
+            m_range >>= 1;
+            uint32_t bit = m_code >= m_range ? 1 : 0;
+            m_code -= m_range & (0 - bit);
+            value = (value << 1) | bit;
+            Normalize();
+        }
+        return value;
+    }
+};
@@ -0,0 +1,12 @@
+#pragma once
+#include <cstdint>
+#include <span>
+#include <chrono>
+
+// One message of a received datagram, see MessageBundle
+struct ReceivedMessage
+{
+    // Type and fields, valid as long as the datagram is
+    std::span<const uint8_t> bytes;
+    std::chrono::steady_clock::time_point receiveTime{};
+};
@@ -0,0 +1,10 @@
+#pragma once
+#include <memory>
+#include "NetworkPacket.h"
+#include "PacketPool.h"
+
+struct ReceivedPacket
+{
+    PacketHandle networkPacket;
+    sockaddr_in clientAddr{};
+};
@@ -0,0 +1,341 @@
+#include "ReplayNetwork.h"
+#include "MessageBundle.h"
+#include <thread>
+#include <cstring>
+#include <algorithm>
+
+ReplayNetwork::ReplayNetwork(std::shared_ptr<Logger> logger, const std::string& path, double speed, std::atomic<bool>& running)
+	: m_logger(logger), m_path(path), m_speed(speed), m_running(running)
+{
+}
+
+uint64_t ReplayNetwork::ReadSalt(const uint8_t* message)
+{
+	uint64_t salt = 0;
+	for (size_t i = 0; i < sizeof(uint64_t); i++)
+	{
+		salt = (salt << 8) | message[SALT_OFFSET + i];
+	}
+	return salt;
+}
+
+void ReplayNetwork::WriteSalt(uint8_t* message, uint64_t salt)
+{
+	for (size_t i = 0; i < sizeof(uint64_t); i++)
+	{
+		message[SALT_OFFSET + i] = static_cast<uint8_t>(salt >> (56 - 8 * i));
+	}
+}
+
+bool ReplayNetwork::CarriesSalt(std::span<const uint8_t> message)
+{
+	if (message.size() < SALT_OFFSET + sizeof(uint64_t))
+	{
+		return false;
+	}
+
+	switch (static_cast<NetworkPacketType>(message[0]))
+	{
+	case NetworkPacketType::CHALLENGE_RESPONSE:
+	case NetworkPacketType::CLOCK:
+	case NetworkPacketType::DISCONNECT:
+	case NetworkPacketType::MTU_PROBE_ACK:
+		return true;
+	default:
+		return false;
+	}
+}
+
+bool ReplayNetwork::AwaitsChallenge(std::span<const uint8_t> datagram) const
+{
+	if (datagram.size() < CRC32::CRC_SIZE)
+	{
+		return false;
+	}
+
+	bool awaits = false;
+	MessageBundle::ForEach(datagram.subspan(CRC32::CRC_SIZE), [&](std::span<const uint8_t> message) {
+		awaits = awaits || (CarriesSalt(message) && m_pendingSalts.count(ReadSalt(message.data())) > 0);
+		return 0;
+	});
+	return awaits;
+}
+
+bool ReplayNetwork::ReadFileHeader(std::istream& file, CaptureFileHeader& fileHeader)
+{
+	return file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader)) &&
+		fileHeader.magic == CAPTURE_MAGIC && fileHeader.version == CAPTURE_VERSION &&
+		(fileHeader.codec == CodecId::CRC32 || fileHeader.codec == CodecId::CRC32C);
+}
+
+int ReplayNetwork::ReadCodec(const std::string& path, CodecId& codec)
+{
+	std::ifstream file(path, std::ios::binary);
+	CaptureFileHeader fileHeader;
+	if (!ReadFileHeader(file, fileHeader))
+	{
+		return 1;
+	}
+
+	codec = fileHeader.codec;
+	return 0;
+}
+
+int ReplayNetwork::ScanChallenges()
+{
+	// Challenges sent in the capture give the captured connection salt of every client salt
+	std::ifstream file(m_path, std::ios::binary);
+	CaptureFileHeader fileHeader;
+	if (!ReadFileHeader(file, fileHeader))
+	{
+		return 1;
+	}
+	m_codec = fileHeader.codec;
+
+	CaptureRecordHeader header;
+	std::vector<uint8_t> data;
+	while (file.read(reinterpret_cast<char*>(&header), sizeof(header)))
+	{
+		data.resize(header.size);
+		if (!file.read(reinterpret_cast<char*>(data.data()), header.size))
+		{
+			break;
+		}
+
+		if (header.direction == CaptureDirection::SENT &&
+			header.size >= CRC32::CRC_SIZE + SALT_OFFSET + 2 * sizeof(uint64_t) &&
+			static_cast<NetworkPacketType>(data[CRC32::CRC_SIZE]) == NetworkPacketType::CHALLENGE)
+		{
+			uint64_t clientSalt = ReadSalt(data.data() + CRC32::CRC_SIZE);
+			uint64_t serverSalt = ReadSalt(data.data() + CRC32::CRC_SIZE + sizeof(uint64_t));
+			m_capturedSalts[clientSalt] = clientSalt ^ serverSalt;
+			m_pendingSalts.insert(clientSalt ^ serverSalt);
+		}
+	}
+	return 0;
+}
+
+void ReplayNetwork::ReadNextRecord()
+{
+	m_hasRecord = false;
+	while (m_file.read(reinterpret_cast<char*>(&m_record), sizeof(m_record)))
+	{
+		m_recordData.resize(m_record.size);
+		if (!m_file.read(reinterpret_cast<char*>(m_recordData.data()), m_record.size))
+		{
+			m_logger->Log(LogLevel::WARNING, "ReplayNetwork: Capture file is truncated");
+			return;
+		}
+
+		if (m_record.direction == CaptureDirection::RECEIVED)
+		{
+			m_hasRecord = true;
+			return;
+		}
+	}
+}
+
+std::chrono::steady_clock::time_point ReplayNetwork::RecordDue() const
+{
+	if (m_speed <= 0)
+	{
+		return m_start;
+	}
+	return m_start + std::chrono::nanoseconds(static_cast<int64_t>(m_record.timestampNs / m_speed));
+}
+
+template <typename Checksum>
+void ReplayNetwork::TranslateSalt(NetworkPacket& networkPacket)
+{
+	bool translated = false;
+	bool valid = false;
+
+	MessageBundle::ForEach(networkPacket.Message(), [&](std::span<const uint8_t> message) {
+		if (!CarriesSalt(message))
+		{
+			return 0;
+		}
+
+		auto translation = m_saltTranslation.find(ReadSalt(message.data()));
+		if (translation != m_saltTranslation.end())
+		{
+			// Only datagrams which were valid in the capture get a valid CRC again
+			if (!translated)
+			{
+				valid = networkPacket.ReadAndValidateCRC<Checksum>() == 0;
+				translated = true;
+			}
+			WriteSalt(networkPacket.Data() + (message.data() - networkPacket.Data()), translation->second);
+		}
+		return 0;
+	});
+
+	if (translated)
+	{
+		if (valid)
+		{
+			networkPacket.CalculateCRC<Checksum>();
+		}
+		networkPacket.Resize(networkPacket.Size());
+	}
+}
+
+bool ReplayNetwork::ReadDatagram(ReceivedPacket& receivedPacket, bool first)
+{
+	if (!m_hasRecord || RecordDue() > std::chrono::steady_clock::now())
+	{
+		return false;
+	}
+
+	// Without the challenge of the server the salt cannot be translated yet
+	if (!first && AwaitsChallenge(m_recordData))
+	{
+		return false;
+	}
+
+	receivedPacket.networkPacket = AcquirePacket();
+	receivedPacket.networkPacket->Resize(m_recordData.size());
+	std::memcpy(receivedPacket.networkPacket->Data(), m_recordData.data(), m_recordData.size());
+	receivedPacket.networkPacket->SetReceiveTime(RecordDue());
+	if (m_codec == CodecId::CRC32C)
+	{
+		TranslateSalt<CRC32C>(*receivedPacket.networkPacket);
+	}
+	else
+	{
+		TranslateSalt<CRC32>(*receivedPacket.networkPacket);
+	}
+
+	receivedPacket.clientAddr = {};
+	receivedPacket.clientAddr.sin_family = AF_INET;
+	receivedPacket.clientAddr.sin_port = m_record.port;
+	receivedPacket.clientAddr.sin_addr.s_addr = m_record.address;
+
+	m_replayed++;
+	m_counters.packetsReceived++;
+	ReadNextRecord();
+	return true;
+}
+
+int ReplayNetwork::Initialize([[maybe_unused]] std::string server, int port, sockaddr_in& addr)
+{
+	if (ScanChallenges() != 0)
+	{
+		m_logger->Log(LogLevel::EXCEPTION, "Initialize: Failed to read capture file", { KVS(m_path) });
+		return 1;
+	}
+
+	m_file.open(m_path, std::ios::binary);
+	CaptureFileHeader fileHeader;
+	m_file.read(reinterpret_cast<char*>(&fileHeader), sizeof(fileHeader));
+	ReadNextRecord();
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+	m_start = std::chrono::steady_clock::now();
+	m_logger->Log(LogLevel::INFO, "Initialize: Replaying capture", { KVS(m_path), KV(m_speed) });
+	return 0;
+}
+
+int ReplayNetwork::Send(NetworkPacket& networkPacket, [[maybe_unused]] sockaddr_in& clientAddr)
+{
+	// Pair the challenge with the captured one to translate the salts of the client
+	PacketView<PacketSchemas::Challenge> challenge(networkPacket.Message());
+	if (challenge.Valid())
+	{
+		auto [clientSalt, serverSalt] = challenge.Fields();
+		auto capturedSalt = m_capturedSalts.find(clientSalt);
+		if (capturedSalt != m_capturedSalts.end())
+		{
+			m_saltTranslation[capturedSalt->second] = clientSalt ^ serverSalt;
+			m_pendingSalts.erase(capturedSalt->second);
+		}
+	}
+
+	m_counters.packetsSent++;
+	return 0;
+}
+
+int ReplayNetwork::SendBatch(std::vector<OutgoingPacket>& outgoingPackets)
+{
+	for (OutgoingPacket& outgoingPacket : outgoingPackets)
+	{
+		outgoingPacket.result = Send(*outgoingPacket.networkPacket, outgoingPacket.clientAddr);
+	}
+	return 0;
+}
+
+PacketHandle ReplayNetwork::Receive(sockaddr_in& clientAddr, int& result)
+{
+	ReceivedPacket receivedPacket;
+	if (!ReadDatagram(receivedPacket, true))
+	{
+		result = -1;
+		return nullptr;
+	}
+
+	clientAddr = receivedPacket.clientAddr;
+	result = 0;
+	return std::move(receivedPacket.networkPacket);
+}
+
+int ReplayNetwork::ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets)
+{
+	size_t received = 0;
+	ReceivedPacket receivedPacket;
+	while (received < MAX_BATCH_SIZE && ReadDatagram(receivedPacket, received == 0))
+	{
+		receivedPackets.push_back(std::move(receivedPacket));
+		received++;
+	}
+
+	return received == 0 ? -1 : 0;
+}
+
+int ReplayNetwork::StartTimer(int timerId, std::chrono::nanoseconds interval)
+{
+	ReplayTimer timer;
+	timer.timerId = timerId;
+	timer.interval = interval;
+	timer.deadline = std::chrono::steady_clock::now() + interval;
+	m_timers.push_back(timer);
+	return 0;
+}
+
+int ReplayNetwork::WaitForEvents(std::vector<int>& expiredTimers)
+{
+	while (true)
+	{
+		if (!m_hasRecord)
+		{
+			m_logger->Log(LogLevel::INFO, "ReplayNetwork: Capture replayed", { KV(m_replayed) });
+			m_running = false;
+			return -1;
+		}
+
+		auto now = std::chrono::steady_clock::now();
+		auto recordDue = RecordDue();
+		auto wakeUp = recordDue;
+		for (ReplayTimer& timer : m_timers)
+		{
+			if (timer.deadline <= now)
+			{
+				expiredTimers.push_back(timer.timerId);
+				while (timer.deadline <= now)
+				{
+					timer.deadline += timer.interval;
+				}
+			}
+			wakeUp = std::min(wakeUp, timer.deadline);
+		}
+
+		if (!expiredTimers.empty() || recordDue <= now)
+		{
+			return recordDue <= now ? 0 : -1;
+		}
+
+		std::this_thread::sleep_until(wakeUp);
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <vector>
+#include <fstream>
+#include <chrono>
+#include <atomic>
+#include <unordered_map>
+#include <unordered_set>
+#include "NetworkBase.h"
+#include "Logger.h"
+#include "CaptureRecord.h"
+
+// Transport which feeds the received datagrams of a capture file to a server
+// at their original pace, or faster by speed, and discards everything the
+// server sends. Clears running once the capture is exhausted so that
+// Server::ExecuteGame returns.
+//
+// The server picks new random salts during the replay, so the captured
+// connection salts would no longer match. The challenges found in the
+// capture are paired with the ones the server sends now by client salt, and
+// the salts of replayed messages are rewritten to the new ones, each message
+// of a bundle on its own. A datagram whose challenge the server has not sent
+// yet ends the batch, so that the server handles the preceding connection
+// request first. Input frames carry the connection id instead, which the
+// server gives out in the same order during the replay. CRCs are checked and
+// rewritten with the codec recorded in the capture, the server has to be
+// built with the same one.
+class ReplayNetwork : public NetworkBase
+{
+private:
+	// Offset of the connection salt in handshake and control messages, after the type
+	static constexpr size_t SALT_OFFSET = sizeof(int8_t);
+
+	struct ReplayTimer
+	{
+		int timerId{};
+		std::chrono::nanoseconds interval{};
+		std::chrono::steady_clock::time_point deadline{};
+	};
+
+	std::shared_ptr<Logger> m_logger;
+	std::string m_path;
+	double m_speed;
+	std::atomic<bool>& m_running;
+
+	std::ifstream m_file;
+	CodecId m_codec = CodecId::CRC32;
+	std::chrono::steady_clock::time_point m_start{};
+
+	// Next received datagram of the capture, valid while m_hasRecord is set
+	bool m_hasRecord = false;
+	CaptureRecordHeader m_record{};
+	std::vector<uint8_t> m_recordData;
+
+	// Client salt to the connection salt in the capture and during the replay
+	std::unordered_map<uint64_t, uint64_t> m_capturedSalts;
+	std::unordered_map<uint64_t, uint64_t> m_saltTranslation;
+	// Captured connection salts whose challenge the server has not sent yet
+	std::unordered_set<uint64_t> m_pendingSalts;
+
+	std::vector<ReplayTimer> m_timers;
+	uint64_t m_replayed = 0;
+
+	static uint64_t ReadSalt(const uint8_t* message);
+	static void WriteSalt(uint8_t* message, uint64_t salt);
+	static bool CarriesSalt(std::span<const uint8_t> message);
+	// Whether a message of the datagram carries a salt whose challenge the server has not sent yet
+	bool AwaitsChallenge(std::span<const uint8_t> datagram) const;
+
+	static bool ReadFileHeader(std::istream& file, CaptureFileHeader& fileHeader);
+	int ScanChallenges();
+	void ReadNextRecord();
+	std::chrono::steady_clock::time_point RecordDue() const;
+	template <typename Checksum>
+	void TranslateSalt(NetworkPacket& networkPacket);
+	bool ReadDatagram(ReceivedPacket& receivedPacket, bool first);
+
+public:
+	// A speed of 0 replays as fast as the server can take it
+	ReplayNetwork(std::shared_ptr<Logger> logger, const std::string& path, double speed, std::atomic<bool>& running);
+
+	// Codec of the server which wrote the capture, returns 1 if the file is not a capture
+	static int ReadCodec(const std::string& path, CodecId& codec);
+
+	int Initialize(std::string server, int port, sockaddr_in& addr) override;
+	int Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr) override;
+	int SendBatch(std::vector<OutgoingPacket>& outgoingPackets) override;
+	PacketHandle Receive(sockaddr_in& clientAddr, int& result) override;
+	int ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets) override;
+	int StartTimer(int timerId, std::chrono::nanoseconds interval) override;
+	int WaitForEvents(std::vector<int>& expiredTimers) override;
+
+	uint64_t Replayed() const { return m_replayed; }
+};
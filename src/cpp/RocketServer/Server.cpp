@@ -2,131 +2,263 @@
 #include "NetworkPacketType.h"
 #include "Utils.h"
 #include "NetworkUtilities.h"
+#include "Network.h"
+#include "UringNetwork.h"
+#include "UnixNetwork.h"
+#include "MessageBundle.h"
+#include "SnapshotReassembly.h"
+
+template <typename Transport, typename Codec>
+BasicServer<Transport, Codec>::BasicServer(std::shared_ptr<Logger> logger, std::shared_ptr<Transport> network)
+	: BasicServer(logger, network, std::make_shared<ServerWorld>(1, MAX_PLAYERS), 0) {
+}
 
-Server::Server(std::shared_ptr<Logger> logger, std::shared_ptr<NetworkBase> network)
-	: m_logger(logger), m_network(network) {
+template <typename Transport, typename Codec>
+BasicServer<Transport, Codec>::BasicServer(std::shared_ptr<Logger> logger, std::shared_ptr<Transport> network, std::shared_ptr<ServerWorld> world, int shardId)
+	: m_logger(logger), m_network(network), m_world(world), m_shardId(shardId) {
+	m_receivedPackets.reserve(NetworkBase::MAX_BATCH_SIZE);
+	m_outgoingPackets.reserve(NetworkBase::MAX_BATCH_SIZE);
+	m_playerIndex.fill(-1);
 }
 
-Server::~Server() {
+template <typename Transport, typename Codec>
+BasicServer<Transport, Codec>::~BasicServer() {
 }
 
-int Server::Initialize(int port)
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::Initialize(int port)
 {
     sockaddr_in addr{};
 	return m_network->Initialize("" /* server*/, port, addr);
 }
 
-int Server::ExecuteGame(volatile std::sig_atomic_t& running)
+template <typename Transport, typename Codec>
+void BasicServer<Transport, Codec>::SetFeatures(uint8_t features)
+{
+	m_features = features & SUPPORTED_FEATURES;
+}
+
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::ExecuteGame(std::atomic<bool>& running)
 {
 	int idleTime = 0;
-	auto idle = std::chrono::steady_clock::now();
+	uint64_t receivedBatches = m_world->ReceivedBatches();
+
+	if (m_network->StartTimer(HOUSEKEEPING_TIMER, std::chrono::seconds(5)) != 0)
+	{
+		m_logger->Log(LogLevel::EXCEPTION, "Failed to start housekeeping timer");
+		return 1;
+	}
+
 	m_logger->Log(LogLevel::INFO, "Server is running");
 	while (running)
 	{
-		sockaddr_in clientAddr{};
-		int result = 0;
-
-		std::unique_ptr<NetworkPacket> networkPacket = m_network->Receive(clientAddr, result);
+		m_expiredTimers.clear();
+		int waitResult = m_network->WaitForEvents(m_expiredTimers);
+		if (waitResult == 1)
+		{
+			m_logger->Log(LogLevel::DEBUG, "Failed to wait for events");
+			continue;
+		}
 
-		if (result == -1)
+		for (int timerId : m_expiredTimers)
 		{
-			auto now = std::chrono::steady_clock::now();
-			if (std::chrono::duration_cast<std::chrono::milliseconds>(now - idle).count() >= 5000 /* 5 seconds */)
+			if (timerId != HOUSEKEEPING_TIMER)
 			{
-				idle = now;
-				m_logger->Log(LogLevel::DEBUG, "Waiting for data");
-				idleTime++;
-				if (idleTime > 20)
-				{
-					m_logger->Log(LogLevel::INFO, "No data received for a while, exiting");
-					running = 0;
-				}
+				continue;
 			}
 
-			continue;
+			LogNetworkCounters();
+			ProbePathMtu();
+
+			// Server is idle only when none of the shards received data
+			uint64_t currentReceivedBatches = m_world->ReceivedBatches();
+			if (currentReceivedBatches != receivedBatches)
+			{
+				receivedBatches = currentReceivedBatches;
+				idleTime = 0;
+				continue;
+			}
+
+			m_logger->Log(LogLevel::DEBUG, "Waiting for data");
+			idleTime++;
+			if (idleTime > 20)
+			{
+				m_logger->Log(LogLevel::INFO, "No data received for a while, exiting");
+				running = false;
+			}
 		}
 
-		if (result != 0)
+		// A wakeup by a timer only would cost a receive call which finds nothing
+		if (waitResult == 0)
 		{
-			m_logger->Log(LogLevel::DEBUG, "Failed to receive data");
-			continue;
+			ProcessBatch();
 		}
+	}
 
-		idleTime = 0;
-		std::string address = NetworkUtilities::AddressToString(clientAddr);
-		size_t size = networkPacket->Size();
+	return 0;
+}
 
-		m_logger->Log(LogLevel::DEBUG, "Received bytes from client", { KV(size), KVS(address) });
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::ProcessBatch()
+{
+	m_receivedPackets.clear();
+	int result = m_network->ReceiveBatch(m_receivedPackets);
 
-		if (size < CRC32::CRC_SIZE)
-		{
-			m_logger->Log(LogLevel::WARNING, "Received too small packet", { KV(size) });
-			continue;
-		}
+	if (result == -1)
+	{
+		// Woken up by a timer only
+		return -1;
+	}
 
-		if (networkPacket->ReadAndValidateCRC())
-		{
-			m_logger->Log(LogLevel::WARNING, "Packet validation failed");
-			continue;
-		}
+	if (result != 0)
+	{
+		m_logger->Log(LogLevel::DEBUG, "Failed to receive data");
+		return 1;
+	}
 
-		NetworkPacketType packetType = networkPacket->ReadNetworkPacketType();
-		auto packetTypeInt = static_cast<int>(packetType);
-		m_logger->Log(LogLevel::DEBUG, "Received packet type", { KV(packetTypeInt) });
+	m_world->AddReceivedBatch(m_shardId);
 
-		switch (packetType)
+	if (m_world->ShardCount() > 1)
+	{
+		// Players owned by other shards, read once for every reply of the batch
+		m_otherPlayerStates.clear();
+		m_world->CollectPlayerStates(m_shardId, m_otherPlayerStates);
+	}
+
+	// Dispatch the whole batch in one pass
+	for (ReceivedPacket& receivedPacket : m_receivedPackets)
+	{
+		if (HandlePacket(std::move(receivedPacket.networkPacket), receivedPacket.clientAddr) != 0 &&
+			!HasPlayer(receivedPacket.clientAddr))
 		{
-		case NetworkPacketType::CONNECTION_REQUEST:
-			if (size != 1000)
-			{
-				m_logger->Log(LogLevel::WARNING, "Received invalid packet size for connection request", { KV(size) });
-				continue;
-			}
+			// Strangers sending rejected datagrams keep no peer mapping in the transport
+			m_network->ReleasePeer(receivedPacket.clientAddr);
+		}
+	}
 
-			if (HandleConnectionRequest(std::move(networkPacket), clientAddr) != 0)
-			{
-				continue;
-			}
-		    break;
-		case NetworkPacketType::CHALLENGE_RESPONSE:
-			if (size != 1000)
-			{
-				m_logger->Log(LogLevel::WARNING, "Received invalid packet size for challenge", { KV(size) });
-				continue;
-			}
+	FlushOutgoingPackets();
 
-			if (HandleChallengeResponse(std::move(networkPacket), clientAddr) != 0)
-			{
-				continue;
-			}
-			break;
-        case NetworkPacketType::CLOCK:
-            if (HandleClockSync(std::move(networkPacket), clientAddr) != 0)
-            {
-                continue;
-            }
-            break;
-		case NetworkPacketType::GAME_STATE:
-            if (HandleGameState(std::move(networkPacket), clientAddr) != 0)
-            {
-                continue;
-            }
-			break;
-		case NetworkPacketType::DISCONNECT:
-            if (HandleDisconnect(std::move(networkPacket), clientAddr) != 0)
-            {
-                continue;
-            }
-		    break;
-		default:
-			break;
-		}
+	if (m_world->ShardCount() > 1)
+	{
+		// Make the players of this shard visible to the other shards
+		m_world->Publish(m_shardId, m_players);
 	}
 
 	return 0;
 }
 
-int Server::HandleConnectionRequest(std::unique_ptr<NetworkPacket> networkPacket, sockaddr_in& clientAddr)
+template <typename Transport, typename Codec>
+constexpr std::array<typename BasicServer<Transport, Codec>::PacketHandler, 256> BasicServer<Transport, Codec>::MakePacketHandlers()
+{
+	std::array<PacketHandler, 256> packetHandlers{};
+	packetHandlers[static_cast<uint8_t>(NetworkPacketType::CONNECTION_REQUEST)] = &BasicServer::HandleConnectionRequest;
+	packetHandlers[static_cast<uint8_t>(NetworkPacketType::CHALLENGE_RESPONSE)] = &BasicServer::HandleChallengeResponse;
+	packetHandlers[static_cast<uint8_t>(NetworkPacketType::CLOCK)] = &BasicServer::HandleClockSync;
+	packetHandlers[static_cast<uint8_t>(NetworkPacketType::INPUT_FRAME)] = &BasicServer::HandleGameState;
+	packetHandlers[static_cast<uint8_t>(NetworkPacketType::DISCONNECT)] = &BasicServer::HandleDisconnect;
+	packetHandlers[static_cast<uint8_t>(NetworkPacketType::MTU_PROBE_ACK)] = &BasicServer::HandleMtuProbeAck;
+	return packetHandlers;
+}
+
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::HandlePacket(PacketHandle networkPacket, sockaddr_in& clientAddr)
+{
+	std::string address = NetworkUtilities::AddressToString(clientAddr);
+	size_t size = networkPacket->Size();
+
+	m_logger->Log(LogLevel::DEBUG, "Received bytes from client", { KV(size), KVS(address) });
+
+	if (size < CRC32::CRC_SIZE)
+	{
+		m_logger->Log(LogLevel::WARNING, "Received too small packet", { KV(size) });
+		return 1;
+	}
+
+	if (Codec::Validate(*networkPacket))
+	{
+		m_logger->Log(LogLevel::WARNING, "Packet validation failed");
+		return 1;
+	}
+
+	// The CRC covers every message of a bundle, the datagram is kept until all of them are handled
+	ReceivedMessage message;
+	message.receiveTime = networkPacket->ReceiveTime();
+	return MessageBundle::ForEach(networkPacket->Message(), [&](std::span<const uint8_t> bytes) {
+		message.bytes = bytes;
+		return HandleMessage(message, clientAddr);
+	});
+}
+
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::HandleMessage(const ReceivedMessage& message, sockaddr_in& clientAddr)
+{
+	NetworkPacketType packetType = static_cast<NetworkPacketType>(message.bytes[0]);
+	auto packetTypeInt = static_cast<int>(packetType);
+	m_logger->Log(LogLevel::DEBUG, "Received packet type", { KV(packetTypeInt) });
+
+	static constexpr std::array<PacketHandler, 256> packetHandlers = MakePacketHandlers();
+	PacketHandler packetHandler = packetHandlers[static_cast<uint8_t>(packetType)];
+	if (packetHandler == nullptr)
+	{
+		// Ignored, the other messages of a bundle are still handled
+		return 1;
+	}
+
+	size_t size = message.bytes.size() + CRC32::CRC_SIZE;
+	if (!PacketSchemas::ValidSize(packetType, size))
+	{
+		m_logger->Log(LogLevel::WARNING, "Received invalid packet size", { KV(packetTypeInt), KV(size) });
+		return 1;
+	}
+
+	return (this->*packetHandler)(message, clientAddr);
+}
+
+template <typename Transport, typename Codec>
+Player* BasicServer<Transport, Codec>::FindPlayer(uint16_t connectionId, const sockaddr_in& clientAddr)
+{
+	// Connection ids are not secret, only the address which completed the handshake may use one
+	int16_t index = m_playerIndex[connectionId & 0xFF];
+	if (index < 0)
+	{
+		return nullptr;
+	}
+
+	Player& player = m_players[index];
+	if (player.ConnectionId != connectionId ||
+		player.ConnectionState != NetworkConnectionState::CONNECTED ||
+		!NetworkUtilities::IsSameAddress(player.Address, clientAddr))
+	{
+		return nullptr;
+	}
+	return &player;
+}
+
+template <typename Transport, typename Codec>
+bool BasicServer<Transport, Codec>::HasPlayer(const sockaddr_in& clientAddr) const
+{
+	return std::any_of(m_players.begin(), m_players.end(),
+		[&clientAddr](const Player& p) { return NetworkUtilities::IsSameAddress(p.Address, clientAddr); });
+}
+
+template <typename Transport, typename Codec>
+void BasicServer<Transport, Codec>::IndexPlayers()
+{
+	m_playerIndex.fill(-1);
+	for (size_t i = 0; i < m_players.size(); i++)
+	{
+		// A client which repeated its connection request has a second entry, the first one is the one accepted
+		int16_t& index = m_playerIndex[m_players[i].ConnectionId & 0xFF];
+		if (index < 0)
+		{
+			index = static_cast<int16_t>(i);
+		}
+	}
+}
+
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::HandleConnectionRequest(const ReceivedMessage& message, sockaddr_in& clientAddr)
 {
 	// Check if the client is already connected
 	int playerID = 0;
@@ -141,31 +273,20 @@ int Server::HandleConnectionRequest(std::unique_ptr<NetworkPacket> networkPacket
 
 	if (playerID == 0)
 	{
-		// Find a free player ID
-		for (int i = 1; i < MAX_PLAYERS; i++)
-		{
-			bool found = true;
-			for (const Player& player : m_players) {
-				if (player.playerID == i) {
-					found = false;
-					playerID = i;
-					break;
-				}
-			}
-
-			if (found) {
-				break;
-			}
-		}
+		playerID = m_world->AcquirePlayerID();
 	}
 
 	if (playerID == 0)
 	{
-		// This is the first player
-		playerID = 1;
+		m_logger->Log(LogLevel::WARNING, "HandleConnectionRequest: Server is full");
+
+		PacketHandle deniedPacket = m_network->AcquirePacket();
+		PacketSchemas::ConnectionDenied::Write(*deniedPacket);
+		SendPacket(*deniedPacket, clientAddr);
+		return 1;
 	}
 
-    uint64_t clientSalt = networkPacket->ReadUInt64();
+    auto [clientSalt, requestedFeatures] = PacketView<PacketSchemas::ConnectionRequest>(message.bytes).Fields();
     uint64_t serverSalt = Utils::GetRandomNumberUInt64();
     m_logger->Log(LogLevel::DEBUG, "HandleConnectionRequest: Received connection request with client salt", { KV(clientSalt) });
 
@@ -177,6 +298,8 @@ int Server::HandleConnectionRequest(std::unique_ptr<NetworkPacket> networkPacket
 	player.ServerSalt = serverSalt;
 	player.ConnectionSalt = player.ClientSalt ^ player.ServerSalt;
 	player.playerID = playerID;
+	player.ConnectionId = static_cast<uint16_t>((m_connectionGeneration++ << 8) | playerID);
+	player.Features = requestedFeatures & m_features;
 	player.Address = clientAddr;
 	player.Created = std::chrono::steady_clock::now();
     player.pos.x.floatValue = 200.0f;
@@ -185,17 +308,16 @@ int Server::HandleConnectionRequest(std::unique_ptr<NetworkPacket> networkPacket
 
 
 	m_players.push_back(player);
+	IndexPlayers();
 
 	m_logger->Log(LogLevel::DEBUG, "HandleConnectionRequest: Player challenge", { KV(playerID) });
 
-	networkPacket->Clear();
-	networkPacket->WriteInt8(static_cast<int8_t>(NetworkPacketType::CHALLENGE));
-	networkPacket->WriteUInt64(clientSalt);
-	networkPacket->WriteUInt64(serverSalt);
+	PacketHandle challengePacket = m_network->AcquirePacket();
+	PacketSchemas::Challenge::Write(*challengePacket, clientSalt, serverSalt);
 
     m_logger->Log(LogLevel::INFO, "HandleConnectionRequest: Sending challenge", { KV(clientSalt), KV(serverSalt) });
 
-	if (m_network->Send(*networkPacket, clientAddr) != 0)
+	if (SendPacket(*challengePacket, clientAddr) != 0)
 	{
 		m_logger->Log(LogLevel::DEBUG, "HandleConnectionRequest: Failed to send challenge");
 		return 1;
@@ -203,15 +325,16 @@ int Server::HandleConnectionRequest(std::unique_ptr<NetworkPacket> networkPacket
 	return 0;
 }
 
-int Server::HandleChallengeResponse(std::unique_ptr<NetworkPacket> networkPacket, sockaddr_in& clientAddr)
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::HandleChallengeResponse(const ReceivedMessage& message, sockaddr_in& clientAddr)
 {
-	int64_t salt = networkPacket->ReadUInt64();
+	auto [salt] = PacketView<PacketSchemas::ChallengeResponse>(message.bytes).Fields();
 
 	for (Player& player : m_players)
 	{
 		if (NetworkUtilities::IsSameAddress(player.Address, clientAddr))
 		{
-			networkPacket->Clear();
+			PacketHandle networkPacket = m_network->AcquirePacket();
 
 			if (player.ConnectionSalt == salt)
 			{
@@ -221,14 +344,16 @@ int Server::HandleChallengeResponse(std::unique_ptr<NetworkPacket> networkPacket
 
                 // TODO: Add clock synchronization
 
-				networkPacket->WriteInt8(static_cast<int8_t>(NetworkPacketType::CONNECTION_ACCEPTED));
-				networkPacket->WriteInt64(player.playerID);
+				PacketSchemas::ConnectionAccepted::Write(*networkPacket, player.playerID, player.Features, player.ConnectionId);
 
-				if (m_network->Send(*networkPacket, clientAddr) != 0)
+				if (SendPacket(*networkPacket, clientAddr) != 0)
 				{
 					m_logger->Log(LogLevel::WARNING, "HandleChallengeRequest: Failed to send connection accepted");
 					return 1;
 				}
+
+				// Snapshots stay within the minimum datagram size until the client acknowledges larger probes
+				SendMtuProbes(player);
 			}
 			else
 			{
@@ -241,12 +366,16 @@ int Server::HandleChallengeResponse(std::unique_ptr<NetworkPacket> networkPacket
 					});
 
 				if (it != m_players.end()) {
+					m_world->ReleasePlayerID(it->playerID);
 					m_players.erase(it);
+					IndexPlayers();
 				}
 
-				networkPacket->WriteInt8(static_cast<int8_t>(NetworkPacketType::CONNECTION_DENIED));
+				PacketSchemas::ConnectionDenied::Write(*networkPacket);
 
-				if (m_network->Send(*networkPacket, clientAddr) != 0)
+				int sendResult = SendPacket(*networkPacket, clientAddr);
+				m_network->ReleasePeer(clientAddr);
+				if (sendResult != 0)
 				{
 					m_logger->Log(LogLevel::WARNING, "HandleChallengeRequest: Failed to send connection not accepted");
 					return 1;
@@ -260,12 +389,13 @@ int Server::HandleChallengeResponse(std::unique_ptr<NetworkPacket> networkPacket
 	return 1;
 }
 
-int Server::HandleClockSync(std::unique_ptr<NetworkPacket> networkPacket, sockaddr_in& clientAddr)
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::HandleClockSync(const ReceivedMessage& message, sockaddr_in& clientAddr)
 {
-    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    // Kernel receive time keeps socket queueing and scheduling delay out of the offset
+    auto now = std::chrono::duration_cast<std::chrono::milliseconds>(message.receiveTime.time_since_epoch()).count();
 
-    int64_t connectionSalt = networkPacket->ReadUInt64();
-    int64_t clientTime = networkPacket->ReadUInt64();
+    auto [connectionSalt, clientTime] = PacketView<PacketSchemas::Clock>(message.bytes).Fields();
     for (Player& player : m_players)
     {
         if (player.ConnectionSalt == connectionSalt &&
@@ -274,15 +404,10 @@ int Server::HandleClockSync(std::unique_ptr<NetworkPacket> networkPacket, sockad
             player.serverClockOffset = now - clientTime;
             m_logger->Log(LogLevel::INFO, "HandleClockSync: Clock synchronized", { KV(player.serverClockOffset) });
 
-            // Send clock sync response
-            NetworkPacket responsePacket;
-            responsePacket.WriteInt8(static_cast<int8_t>(NetworkPacketType::CLOCK_RESPONSE));
-            responsePacket.WriteInt64(now);
-            if (m_network->Send(responsePacket, player.Address) != 0)
-            {
-                m_logger->Log(LogLevel::WARNING, "HandleClockSync: Failed to send clock sync response");
-                return 1;
-            }
+            // Sent together with the other replies of this batch, bundled with them when they fit
+            PacketHandle responsePacket = m_network->AcquirePacket();
+            PacketSchemas::ClockResponse::Write(*responsePacket, now);
+            QueueOutgoing(std::move(responsePacket), player.Address, player.Mtu);
             return 0;
         }
     }
@@ -290,115 +415,207 @@ int Server::HandleClockSync(std::unique_ptr<NetworkPacket> networkPacket, sockad
     return 1;
 }
 
-int Server::HandleGameState(std::unique_ptr<NetworkPacket> networkPacket, sockaddr_in& clientAddr)
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::HandleGameState(const ReceivedMessage& message, sockaddr_in& clientAddr)
 {
-    int64_t connectionSalt = networkPacket->ReadUInt64();
+    PacketView<PacketSchemas::InputFrame> inputFrame(message.bytes);
+    auto [connectionId, seqNum, ackDistance, missingAckBits] = inputFrame.Fields();
+    uint16_t ack = PacketSchemas::SequenceBefore(seqNum, ackDistance);
+    uint32_t ackBits = PacketSchemas::MissingAckBits(missingAckBits);
 
-    for (Player& player : m_players)
+    Player* found = FindPlayer(connectionId, clientAddr);
+    if (found == nullptr)
     {
-        if (player.ConnectionSalt == connectionSalt &&
-            NetworkUtilities::IsSameAddress(player.Address, clientAddr))
-        {
-            GamePacket* gamePacket = static_cast<GamePacket*>(networkPacket.get());
+        m_logger->Log(LogLevel::WARNING, "HandleGameState: Player not found");
+        return 1;
+    }
+    Player& player = *found;
 
-            uint16_t seqNum = gamePacket->ReadInt16();
-            uint16_t ack = gamePacket->ReadInt16();
-            uint32_t ackBits = gamePacket->ReadInt32();
+    uint16_t diff = NetworkUtilities::SequenceNumberDiff(player.remoteSequenceNumberSmall, seqNum);
+    if (diff > 0)
+    {
+        player.remoteSequenceNumberLarge += diff;
+        player.remoteSequenceNumberSmall = seqNum;
 
-            uint16_t diff = NetworkUtilities::SequenceNumberDiff(player.remoteSequenceNumberSmall, seqNum);
-            if (diff > 0)
-            {
-                player.remoteSequenceNumberLarge += diff;
-                player.remoteSequenceNumberSmall = seqNum;
+        // TODO: This or NetworkUtilities::StoreAcks(...)
+        player.receivedPackets.push_back(player.remoteSequenceNumberLarge);
+    }
+    else if (diff < 0)
+    {
+        // TODO: Add stats about out-of-order received packets
+        m_logger->Log(LogLevel::WARNING, "HandleGameState out-of-order packets");
+    }
+    else if (diff == 0)
+    {
+        // TODO: Add stats about duplicate received packets or replayed packet
+        m_logger->Log(LogLevel::WARNING, "HandleGameState duplicate packets");
+    }
 
-                // TODO: This or NetworkUtilities::StoreAcks(...)
-                player.receivedPackets.push_back(player.remoteSequenceNumberLarge);
-            }
-            else if (diff < 0)
-            {
-                // TODO: Add stats about out-of-order received packets
-                m_logger->Log(LogLevel::WARNING, "HandleGameState out-of-order packets");
-            }
-            else if (diff == 0)
-            {
-                // TODO: Add stats about duplicate received packets or replayed packet
-                m_logger->Log(LogLevel::WARNING, "HandleGameState duplicate packets");
-            }
+    diff = NetworkUtilities::SequenceNumberDiff(player.localSequenceNumberSmall, ack);
+    auto localSequenceNumberLarge = player.localSequenceNumberLarge - diff;
 
-            diff = NetworkUtilities::SequenceNumberDiff(player.localSequenceNumberSmall, ack);
-            auto localSequenceNumberLarge = player.localSequenceNumberLarge - diff;
-
-            NetworkUtilities::VerifyAck(player.sendPackets, localSequenceNumberLarge, ackBits);
-
-            // Clear all acknowledged packets away from send packets
-            player.sendPackets.erase(
-                std::remove_if(
-                    player.sendPackets.begin(),
-                    player.sendPackets.end(),
-                    [this](const PacketInfo& pi) {
-                        // Remove if acknowledged
-                        return pi.acknowledged;
-                    }
-                ),
-                player.sendPackets.end()
-            );
-
-            // Keep only 60 received packets
-            if (player.receivedPackets.size() > 60)
-            {
-                player.receivedPackets.erase(
-                    player.receivedPackets.begin(),
-                    player.receivedPackets.begin() + (player.receivedPackets.size() - 60)
-                );
+    NetworkUtilities::VerifyAck(player.sendPackets, localSequenceNumberLarge, ackBits, message.receiveTime);
+
+    // The newest snapshot the client acknowledged becomes the baseline of the next ones
+    for (const PacketInfo& pi : player.sendPackets)
+    {
+        if (pi.acknowledged && pi.seqNum > player.baselineSequenceNumber)
+        {
+            player.baselineSequenceNumber = pi.seqNum;
+        }
+    }
+
+    // Clear all acknowledged packets away from send packets
+    player.sendPackets.erase(
+        std::remove_if(
+            player.sendPackets.begin(),
+            player.sendPackets.end(),
+            [this](const PacketInfo& pi) {
+                // Remove if acknowledged
+                return pi.acknowledged;
             }
+        ),
+        player.sendPackets.end()
+    );
 
-            auto sendPacketsRemaining = player.sendPackets.size();
-            auto receivedPacketsRemaining = player.receivedPackets.size();
-            m_logger->Log(LogLevel::DEBUG, "HandleGameState", { KV(player.remoteSequenceNumberLarge), KV(player.remoteSequenceNumberSmall), KV(sendPacketsRemaining), KV(receivedPacketsRemaining)  });
+    // Keep only 60 received packets
+    if (player.receivedPackets.size() > 60)
+    {
+        player.receivedPackets.erase(
+            player.receivedPackets.begin(),
+            player.receivedPackets.begin() + (player.receivedPackets.size() - 60)
+        );
+    }
 
-            ackBits = 0;
-            NetworkUtilities::ComputeAckBits(player.receivedPackets, player.remoteSequenceNumberLarge, ackBits);
+    auto sendPacketsRemaining = player.sendPackets.size();
+    auto receivedPacketsRemaining = player.receivedPackets.size();
+    m_logger->Log(LogLevel::DEBUG, "HandleGameState", { KV(player.remoteSequenceNumberLarge), KV(player.remoteSequenceNumberSmall), KV(sendPacketsRemaining), KV(receivedPacketsRemaining)  });
 
-            player.localSequenceNumberLarge++;
-            player.localSequenceNumberSmall = player.localSequenceNumberLarge % SEQUENCE_NUMBER_MAX;
+    ackBits = 0;
+    NetworkUtilities::ComputeAckBits(player.receivedPackets, player.remoteSequenceNumberLarge, ackBits);
 
-            PlayerState playerState = gamePacket->DeserializePlayerState();
-            player.keyboard = playerState.keyboard;
+    player.localSequenceNumberLarge++;
+    player.localSequenceNumberSmall = player.localSequenceNumberLarge % SEQUENCE_NUMBER_MAX;
 
-            GamePacket sendNetworkPacket;
-            sendNetworkPacket.WriteInt8(static_cast<int8_t>(NetworkPacketType::GAME_STATE));
-            sendNetworkPacket.WriteInt64(player.ConnectionSalt);
-            sendNetworkPacket.WriteInt16(player.localSequenceNumberSmall);
-            sendNetworkPacket.WriteInt16(player.remoteSequenceNumberSmall);
-            sendNetworkPacket.WriteInt32(ackBits);
+    PlayerState playerState = GamePacket::DeserializePlayerState(inputFrame.Trailing());
+    player.keyboard = playerState.keyboard;
 
-            // Serialize player states
-            sendNetworkPacket.WriteInt8(static_cast<int8_t>(m_players.size()));
-            for (const Player& p : m_players)
-            {
-                sendNetworkPacket.SerializePlayerState(p);
-            }
+    // Pooled packets are always game packets
+    PacketHandle sendPacketHandle = m_network->AcquirePacket();
+    GamePacket* sendNetworkPacket = static_cast<GamePacket*>(sendPacketHandle.get());
+
+    // Delta encode against the acknowledged baseline while it is kept, a baseline equal to the sequence number is a full snapshot
+    const std::vector<PlayerState>* baseline = nullptr;
+    uint16_t baselineSequenceNumberSmall = player.localSequenceNumberSmall;
+    if (player.baselineSequenceNumber > 0)
+    {
+        baseline = player.snapshots.Find(player.baselineSequenceNumber % SEQUENCE_NUMBER_MAX);
+        if (baseline != nullptr)
+        {
+            baselineSequenceNumberSmall = player.baselineSequenceNumber % SEQUENCE_NUMBER_MAX;
+        }
+    }
+    PacketSchemas::GameState::Write(*sendNetworkPacket, player.ConnectionId, player.localSequenceNumberSmall,
+        PacketSchemas::SequenceDistance(player.localSequenceNumberSmall, player.remoteSequenceNumberSmall),
+        PacketSchemas::MissingAckBits(ackBits),
+        PacketSchemas::SequenceDistance(player.localSequenceNumberSmall, baselineSequenceNumberSmall));
+
+    // Its own state first, then the other players of this shard and of the other shards
+    m_snapshotPlayerStates.clear();
+    m_snapshotPlayerStates.push_back(player);
+    for (const Player& p : m_players)
+    {
+        if (&p != &player)
+        {
+            m_snapshotPlayerStates.push_back(p);
+        }
+    }
+    m_snapshotPlayerStates.insert(m_snapshotPlayerStates.end(), m_otherPlayerStates.begin(), m_otherPlayerStates.end());
+
+    // Serialize as many player states as fit the path MTU of the client
+    bool entropyCoded = (player.Features & PacketSchemas::ENTROPY_CODED_SNAPSHOTS) != 0;
+    const std::vector<PlayerState> noBaseline;
+    const std::vector<PlayerState>& baselineStates = baseline != nullptr ? *baseline : noBaseline;
+    size_t serialized = sendNetworkPacket->SerializeSnapshot(m_snapshotPlayerStates, baselineStates, player.Mtu, entropyCoded);
+    if (serialized < m_snapshotPlayerStates.size())
+    {
+        // Too large for one datagram, sent in fragments instead. Only these snapshots are serialized twice.
+        sendPacketHandle.reset();
+        serialized = QueueSnapshotFragments(player, ackBits, baselineSequenceNumberSmall, baselineStates, entropyCoded);
+    }
+    else
+    {
+        // Sent together with the other replies of this batch, bundled with them when they fit
+        QueueOutgoing(std::move(sendPacketHandle), player.Address, player.Mtu);
+    }
 
-            m_network->Send(sendNetworkPacket, player.Address);
+    // Kept as the client decodes them, the baseline of later snapshots
+    std::vector<PlayerState>& snapshot = player.snapshots.Add(player.localSequenceNumberSmall);
+    snapshot.assign(m_snapshotPlayerStates.begin(), m_snapshotPlayerStates.begin() + serialized);
+    for (PlayerState& p : snapshot)
+    {
+        GamePacket::QuantizePlayerState(p);
+    }
 
-            PacketInfo pi;
-            pi.seqNum = player.localSequenceNumberLarge;
-            pi.sendTicks = std::chrono::steady_clock::now();
-            player.sendPackets.push_back(pi);
+    PacketInfo pi;
+    pi.seqNum = player.localSequenceNumberLarge;
+    pi.sendTicks = std::chrono::steady_clock::now();
+    player.sendPackets.push_back(pi);
 
-            m_logger->Log(LogLevel::DEBUG, "SendGameState", { KV(player.localSequenceNumberLarge), KV(player.localSequenceNumberSmall) });
+    m_logger->Log(LogLevel::DEBUG, "SendGameState", { KV(player.localSequenceNumberLarge), KV(player.localSequenceNumberSmall) });
 
-            return 0;
+    return 0;
+}
+
+template <typename Transport, typename Codec>
+size_t BasicServer<Transport, Codec>::QueueSnapshotFragments(const Player& player, uint32_t ackBits, uint16_t baselineSequenceNumberSmall,
+    const std::vector<PlayerState>& baseline, bool entropyCoded)
+{
+    std::array<PacketHandle, SnapshotReassembly::MAX_FRAGMENTS> fragments;
+    size_t fragmentCount = 0;
+    size_t countOffset = 0;
+    std::span<const PlayerState> remaining = m_snapshotPlayerStates;
+    while (!remaining.empty() && fragmentCount < fragments.size())
+    {
+        // Pooled packets are always game packets
+        PacketHandle fragmentHandle = m_network->AcquirePacket();
+        GamePacket* fragment = static_cast<GamePacket*>(fragmentHandle.get());
+
+        // The fragment count, the last field, is written once known
+        PacketSchemas::GameStateFragment::Write(*fragment, player.ConnectionId, player.localSequenceNumberSmall,
+            PacketSchemas::SequenceDistance(player.localSequenceNumberSmall, player.remoteSequenceNumberSmall),
+            PacketSchemas::MissingAckBits(ackBits),
+            PacketSchemas::SequenceDistance(player.localSequenceNumberSmall, baselineSequenceNumberSmall),
+            static_cast<uint8_t>(fragmentCount), 0);
+        countOffset = fragment->Size() - sizeof(uint8_t);
+        size_t serialized = fragment->SerializeSnapshot(remaining, baseline, player.Mtu, entropyCoded);
+        if (serialized == 0)
+        {
+            break;
         }
+
+        remaining = remaining.subspan(serialized);
+        fragments[fragmentCount++] = std::move(fragmentHandle);
     }
 
-    m_logger->Log(LogLevel::WARNING, "HandleGameState: Player not found");
-    return 1;
+    if (!remaining.empty())
+    {
+        size_t truncated = remaining.size();
+        m_logger->Log(LogLevel::WARNING, "QueueSnapshotFragments: Snapshot truncated", { KV(player.playerID), KV(truncated) });
+    }
+
+    for (size_t i = 0; i < fragmentCount; i++)
+    {
+        fragments[i]->Data()[countOffset] = static_cast<uint8_t>(fragmentCount);
+        QueueOutgoing(std::move(fragments[i]), player.Address, player.Mtu);
+    }
+    return m_snapshotPlayerStates.size() - remaining.size();
 }
 
-int Server::HandleDisconnect(std::unique_ptr<NetworkPacket> networkPacket, sockaddr_in& clientAddr)
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::HandleDisconnect(const ReceivedMessage& message, sockaddr_in& clientAddr)
 {
-    int64_t connectionSalt = networkPacket->ReadUInt64();
+    uint64_t connectionSalt = std::get<0>(PacketView<PacketSchemas::Disconnect>(message.bytes).Fields());
 
     auto it = std::remove_if(m_players.begin(), m_players.end(),
         [connectionSalt, &clientAddr](const Player& p) {
@@ -412,15 +629,157 @@ int Server::HandleDisconnect(std::unique_ptr<NetworkPacket> networkPacket, socka
         auto playerID = it->playerID;
         m_logger->Log(LogLevel::INFO, "HandleDisconnect: Player disconnected", { KV(playerID) });
 
+        m_world->ReleasePlayerID(playerID);
         m_players.erase(it, m_players.end());
+        IndexPlayers();
 
         // TODO: Notify other players
     }
 
+    // Also drops the peers of repeated disconnects that arrive after the player is gone
+    if (!HasPlayer(clientAddr))
+    {
+        m_network->ReleasePeer(clientAddr);
+    }
+
     return 1;
 }
 
-int Server::QuitGame()
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::HandleMtuProbeAck(const ReceivedMessage& message, sockaddr_in& clientAddr)
+{
+    auto [connectionSalt, size] = PacketView<PacketSchemas::MtuProbeAck>(message.bytes).Fields();
+
+    for (Player& player : m_players)
+    {
+        if (player.ConnectionSalt == connectionSalt &&
+            NetworkUtilities::IsSameAddress(player.Address, clientAddr))
+        {
+            // Probes arrive in any order, only a larger acknowledged size raises the budget
+            if (size > player.Mtu && size <= NetworkPacket::MAX_DATAGRAM_SIZE)
+            {
+                player.Mtu = size;
+                m_logger->Log(LogLevel::DEBUG, "HandleMtuProbeAck: Path MTU raised", { KV(player.playerID), KV(player.Mtu) });
+            }
+            return 0;
+        }
+    }
+
+    m_logger->Log(LogLevel::WARNING, "HandleMtuProbeAck: Player not found");
+    return 1;
+}
+
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::SendPacket(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
+{
+	Codec::Seal(networkPacket);
+	return m_network->Send(networkPacket, clientAddr);
+}
+
+template <typename Transport, typename Codec>
+void BasicServer<Transport, Codec>::QueueOutgoing(PacketHandle networkPacket, const sockaddr_in& clientAddr, size_t maxSize)
+{
+	// Replies to one client of a batch follow each other, so only the last one queued for the address is tried
+	for (auto it = m_outgoingPackets.rbegin(); it != m_outgoingPackets.rend(); ++it)
+	{
+		if (NetworkUtilities::IsSameAddress(it->clientAddr, clientAddr))
+		{
+			if (MessageBundle::Append(*it->networkPacket, *networkPacket, maxSize))
+			{
+				return;
+			}
+			break;
+		}
+	}
+
+	OutgoingPacket outgoingPacket;
+	outgoingPacket.networkPacket = std::move(networkPacket);
+	outgoingPacket.clientAddr = clientAddr;
+	m_outgoingPackets.push_back(std::move(outgoingPacket));
+}
+
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::SendMtuProbes(Player& player)
+{
+	player.MtuProbeRounds++;
+	for (size_t size : PathMtu::PROBE_SIZES)
+	{
+		if (size <= player.Mtu)
+		{
+			continue;
+		}
+
+		OutgoingPacket outgoingPacket;
+		outgoingPacket.networkPacket = m_network->AcquirePacket();
+		PathMtu::WriteProbe(*outgoingPacket.networkPacket, player.ConnectionSalt, size);
+		outgoingPacket.clientAddr = player.Address;
+		m_outgoingPackets.push_back(std::move(outgoingPacket));
+	}
+	return 0;
+}
+
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::ProbePathMtu()
+{
+	for (Player& player : m_players)
+	{
+		if (player.ConnectionState == NetworkConnectionState::CONNECTED &&
+			player.MtuProbeRounds < PathMtu::MAX_PROBE_ROUNDS &&
+			player.Mtu < NetworkPacket::MAX_DATAGRAM_SIZE)
+		{
+			SendMtuProbes(player);
+		}
+	}
+
+	// Not part of a received batch, so nothing else flushes them
+	return FlushOutgoingPackets();
+}
+
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::FlushOutgoingPackets()
+{
+	if (m_outgoingPackets.empty())
+	{
+		return 0;
+	}
+
+	for (OutgoingPacket& outgoingPacket : m_outgoingPackets)
+	{
+		Codec::Seal(*outgoingPacket.networkPacket);
+	}
+
+	int result = m_network->SendBatch(m_outgoingPackets);
+	if (result != 0)
+	{
+		auto failed = std::count_if(m_outgoingPackets.begin(), m_outgoingPackets.end(),
+			[](const OutgoingPacket& op) { return op.result != 0; });
+		m_logger->Log(LogLevel::WARNING, "FlushOutgoingPackets: Failed to send packets", { KV(failed) });
+	}
+
+	m_outgoingPackets.clear();
+	return result;
+}
+
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::LogNetworkCounters()
+{
+	NetworkCounters counters = m_network->GetCounters();
+
+	// Kernel drops mean the receive buffer overflowed since the previous sample
+	uint64_t newKernelDrops = counters.kernelDrops - m_lastKernelDrops;
+	m_lastKernelDrops = counters.kernelDrops;
+
+	m_logger->Log(
+		newKernelDrops > 0 ? LogLevel::WARNING : LogLevel::DEBUG,
+		"Network counters",
+		{ KV(m_shardId), KV(newKernelDrops), KV(counters.kernelDrops), KV(counters.packetsReceived), KV(counters.packetsSent), KV(counters.sendFailures),
+		  KV(counters.receiveQueueBytes), KV(counters.sendQueueBytes), KV(counters.receiveBufferSize), KV(counters.sendBufferSize) }
+	);
+	return newKernelDrops > 0 ? 1 : 0;
+}
+
+template <typename Transport, typename Codec>
+int BasicServer<Transport, Codec>::QuitGame()
 {
 	m_logger->Log(LogLevel::INFO, "Server is stopping. Notifying clients.");
     for (Player& player : m_players)
@@ -428,12 +787,23 @@ int Server::QuitGame()
         // Send disconnect packets to server
         for (size_t i = 0; i < 10; i++)
         {
-            NetworkPacket sendNetworkPacket;
-            sendNetworkPacket.WriteInt8(static_cast<int8_t>(NetworkPacketType::DISCONNECT));
-            sendNetworkPacket.WriteInt64(player.ConnectionSalt);
-            m_network->Send(sendNetworkPacket, player.Address);
+            OutgoingPacket outgoingPacket;
+            outgoingPacket.networkPacket = m_network->AcquirePacket();
+            PacketSchemas::Disconnect::Write(*outgoingPacket.networkPacket, player.ConnectionSalt);
+            outgoingPacket.clientAddr = player.Address;
+            m_outgoingPackets.push_back(std::move(outgoingPacket));
         }
     }
 
-	return 0;
-}
\ No newline at end of file
+	return FlushOutgoingPackets();
+}
+
+// Any NetworkBase through virtual calls, and the transports main picks without decorators, with either codec
+template class BasicServer<NetworkBase>;
+template class BasicServer<Network>;
+template class BasicServer<UringNetwork>;
+template class BasicServer<UnixNetwork>;
+template class BasicServer<NetworkBase, Crc32cCodec>;
+template class BasicServer<Network, Crc32cCodec>;
+template class BasicServer<UringNetwork, Crc32cCodec>;
+template class BasicServer<UnixNetwork, Crc32cCodec>;
@@ -1,35 +1,106 @@
 #pragma once
 #include <cstdint>
 #include <unordered_map>
-#include <csignal>
+#include <atomic>
 #include "Player.h"
 #include "Logger.h"
 #include "NetworkBase.h"
+#include "ServerWorld.h"
+#include "PacketCodec.h"
+#include "PacketSchemas.h"
+#include "ReceivedMessage.h"
 
-class Server
+// Game server of one shard. Transport is the network the server talks to
+// and Codec validates the received packets and seals the sent ones. With a
+// final transport class every network call is resolved at compile time,
+// with NetworkBase the calls go through the virtual interface so that
+// decorators and test stubs fit in. Server.cpp instantiates the transports
+// that are used.
+template <typename Transport, typename Codec = Crc32Codec>
+class BasicServer
 {
 private:
-	static constexpr int8_t MAX_PLAYERS = 8;
+	static constexpr int HOUSEKEEPING_TIMER = 1;
+
+	using PacketHandler = int (BasicServer::*)(const ReceivedMessage& message, sockaddr_in& clientAddr);
+
+	// Handler by packet type, nullptr for the types the server ignores
+	static constexpr std::array<PacketHandler, 256> MakePacketHandlers();
 
 	std::shared_ptr<Logger> m_logger;
-	std::shared_ptr<NetworkBase> m_network;
+	std::shared_ptr<Transport> m_network;
+	std::shared_ptr<ServerWorld> m_world;
+	int m_shardId = 0;
+	uint64_t m_lastKernelDrops = 0;
+	uint8_t m_features = SUPPORTED_FEATURES;
 
 	std::vector<Player> m_players;
+	// Index in m_players by the low byte of the connection id, which is the player id, -1 for none
+	std::array<int16_t, 256> m_playerIndex;
+	// High byte of the connection ids given out, so that a player id given out again gets another connection id
+	uint8_t m_connectionGeneration = 0;
+	std::vector<ReceivedPacket> m_receivedPackets;
+	std::vector<OutgoingPacket> m_outgoingPackets;
+	std::vector<int> m_expiredTimers;
+	// Players of the other shards, read once for every received batch
+	std::vector<PlayerState> m_otherPlayerStates;
+	// Player states of the snapshot being sent, reused across replies
+	std::vector<PlayerState> m_snapshotPlayerStates;
 
 public:
-	Server(std::shared_ptr<Logger> logger, std::shared_ptr<NetworkBase> network);
-	~Server();
+	static constexpr int8_t MAX_PLAYERS = 64;
+	static constexpr uint8_t SUPPORTED_FEATURES = PacketSchemas::ENTROPY_CODED_SNAPSHOTS;
+
+	BasicServer(std::shared_ptr<Logger> logger, std::shared_ptr<Transport> network);
+	BasicServer(std::shared_ptr<Logger> logger, std::shared_ptr<Transport> network, std::shared_ptr<ServerWorld> world, int shardId);
+	~BasicServer();
 
 	int Initialize(int port);
 
-	int ExecuteGame(volatile std::sig_atomic_t& running);
+	// Features accepted from the clients connecting after, SUPPORTED_FEATURES by default
+	void SetFeatures(uint8_t features);
+
+	int ExecuteGame(std::atomic<bool>& running);
+
+	// Receives, dispatches and answers one batch of datagrams without waiting.
+	// Returns -1 when no data is available, 0 on success and 1 on failure.
+	int ProcessBatch();
 
 	int QuitGame();
 
-	int HandleConnectionRequest(std::unique_ptr<NetworkPacket> networkPacket, sockaddr_in& clientAddr);
-	int HandleChallengeResponse(std::unique_ptr<NetworkPacket> networkPacket, sockaddr_in& clientAddr);
-    int HandleClockSync(std::unique_ptr<NetworkPacket> networkPacket, sockaddr_in& clientAddr);
-    int HandleGameState(std::unique_ptr<NetworkPacket> networkPacket, sockaddr_in& clientAddr);
-    int HandleDisconnect(std::unique_ptr<NetworkPacket> networkPacket, sockaddr_in& clientAddr);
+	// Connected player with the connection id at the address, nullptr when none
+	Player* FindPlayer(uint16_t connectionId, const sockaddr_in& clientAddr);
+	// Whether a player in any connection state is at the address
+	bool HasPlayer(const sockaddr_in& clientAddr) const;
+	// Rebuilds m_playerIndex after players were added or removed
+	void IndexPlayers();
+
+	// Validates a received datagram and dispatches each of its messages
+	int HandlePacket(PacketHandle networkPacket, sockaddr_in& clientAddr);
+	int HandleMessage(const ReceivedMessage& message, sockaddr_in& clientAddr);
+	// Seals the packet with Codec and sends it right away instead of with the batch
+	int SendPacket(NetworkPacket& networkPacket, sockaddr_in& clientAddr);
+	// Appends the message to the datagram queued last for the address while it stays within maxSize, see MessageBundle
+	void QueueOutgoing(PacketHandle networkPacket, const sockaddr_in& clientAddr, size_t maxSize);
+	// Queues the snapshot in m_snapshotPlayerStates as fragments of the path MTU of the player, see SnapshotReassembly.
+	// Returns the number of player states sent.
+	size_t QueueSnapshotFragments(const Player& player, uint32_t ackBits, uint16_t baselineSequenceNumberSmall,
+		const std::vector<PlayerState>& baseline, bool entropyCoded);
+	int FlushOutgoingPackets();
+	int LogNetworkCounters();
+
+	// Queues probes of the sizes above the path MTU of the player, see PathMtu
+	int SendMtuProbes(Player& player);
+	// Probes again for the connected players whose path MTU is not settled yet
+	int ProbePathMtu();
+
+	int HandleConnectionRequest(const ReceivedMessage& message, sockaddr_in& clientAddr);
+	int HandleChallengeResponse(const ReceivedMessage& message, sockaddr_in& clientAddr);
+    int HandleClockSync(const ReceivedMessage& message, sockaddr_in& clientAddr);
+    int HandleGameState(const ReceivedMessage& message, sockaddr_in& clientAddr);
+    int HandleDisconnect(const ReceivedMessage& message, sockaddr_in& clientAddr);
+    int HandleMtuProbeAck(const ReceivedMessage& message, sockaddr_in& clientAddr);
 };
 
+// Server on any NetworkBase
+using Server = BasicServer<NetworkBase>;
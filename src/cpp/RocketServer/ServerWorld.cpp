@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include "ServerWorld.h"
+
+ServerWorld::ServerWorld(int shards, int maxPlayers)
+	: m_stateCapacity(maxPlayers), m_playerIDs(maxPlayers + 1, false)
+{
+	for (int i = 0; i < shards; i++)
+	{
+		m_shards.push_back(std::make_unique<Shard>());
+		m_shards.back()->words = std::make_unique<std::atomic<uint64_t>[]>(m_stateCapacity * WORDS_PER_STATE);
+	}
+
+	// Player id 0 is reserved for "no player"
+	m_playerIDs[0] = true;
+}
+
+int ServerWorld::ShardCount() const
+{
+	return static_cast<int>(m_shards.size());
+}
+
+int ServerWorld::AcquirePlayerID()
+{
+	std::lock_guard<std::mutex> lock(m_playerIDMutex);
+	for (size_t i = 1; i < m_playerIDs.size(); i++)
+	{
+		if (!m_playerIDs[i])
+		{
+			m_playerIDs[i] = true;
+			return static_cast<int>(i);
+		}
+	}
+	return 0;
+}
+
+void ServerWorld::ReleasePlayerID(int playerID)
+{
+	std::lock_guard<std::mutex> lock(m_playerIDMutex);
+	if (playerID > 0 && playerID < static_cast<int>(m_playerIDs.size()))
+	{
+		m_playerIDs[playerID] = false;
+	}
+}
+
+void ServerWorld::Publish(int shardId, const std::vector<Player>& players)
+{
+	Shard& shard = *m_shards[shardId];
+	size_t count = std::min(players.size(), m_stateCapacity);
+
+	uint64_t sequence = shard.sequence.load(std::memory_order_relaxed);
+	shard.sequence.store(sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t buffer[WORDS_PER_STATE]{};
+		std::memcpy(buffer, static_cast<const PlayerState*>(&players[i]), sizeof(PlayerState));
+		for (size_t word = 0; word < WORDS_PER_STATE; word++)
+		{
+			shard.words[i * WORDS_PER_STATE + word].store(buffer[word], std::memory_order_relaxed);
+		}
+	}
+	shard.count.store(count, std::memory_order_relaxed);
+
+	shard.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void ServerWorld::CollectPlayerStates(int shardId, std::vector<PlayerState>& playerStates)
+{
+	size_t offset = playerStates.size();
+	for (int i = 0; i < static_cast<int>(m_shards.size()); i++)
+	{
+		if (i == shardId)
+		{
+			continue;
+		}
+
+		Shard& shard = *m_shards[i];
+		while (true)
+		{
+			uint64_t sequence = shard.sequence.load(std::memory_order_acquire);
+			if ((sequence & 1) != 0)
+			{
+				// Being written, which takes no longer than copying the states
+				std::this_thread::yield();
+				continue;
+			}
+
+			size_t count = shard.count.load(std::memory_order_relaxed);
+			playerStates.resize(offset + count);
+			for (size_t state = 0; state < count; state++)
+			{
+				uint64_t buffer[WORDS_PER_STATE];
+				for (size_t word = 0; word < WORDS_PER_STATE; word++)
+				{
+					buffer[word] = shard.words[state * WORDS_PER_STATE + word].load(std::memory_order_relaxed);
+				}
+				std::memcpy(&playerStates[offset + state], buffer, sizeof(PlayerState));
+			}
+
+			// Torn by a publish meanwhile, read again
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (shard.sequence.load(std::memory_order_relaxed) == sequence)
+			{
+				break;
+			}
+		}
+		offset = playerStates.size();
+	}
+}
+
+void ServerWorld::AddReceivedBatch(int shardId)
+{
+	m_shards[shardId]->receivedBatches.fetch_add(1, std::memory_order_relaxed);
+}
+
+uint64_t ServerWorld::ReceivedBatches()
+{
+	uint64_t receivedBatches = 0;
+	for (const auto& shard : m_shards)
+	{
+		receivedBatches += shard->receivedBatches.load(std::memory_order_relaxed);
+	}
+	return receivedBatches;
+}
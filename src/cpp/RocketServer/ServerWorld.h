@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <type_traits>
+#include "Player.h"
+#include "PlayerState.h"
+
+// Shared state between server shards. Every shard owns its own players and
+// publishes their states here so that other shards can include them into
+// their game state replies without touching each other's player tables.
+// The states of a shard are guarded by a sequence lock, so that readers never
+// take a lock. They copy the states and retry when the owning shard published
+// again meanwhile, which it only does once per received batch.
+class ServerWorld
+{
+private:
+	static_assert(std::is_trivially_copyable_v<PlayerState>, "Player states are copied as words");
+	static constexpr size_t WORDS_PER_STATE = (sizeof(PlayerState) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+
+	struct alignas(64) Shard
+	{
+		// Odd while the owning shard writes its states
+		std::atomic<uint64_t> sequence{};
+		std::atomic<size_t> count{};
+		// Up to maxPlayers states, word by word so that a read racing a write is well defined
+		std::unique_ptr<std::atomic<uint64_t>[]> words;
+		std::atomic<uint64_t> receivedBatches{};
+	};
+
+	std::vector<std::unique_ptr<Shard>> m_shards;
+	size_t m_stateCapacity;
+
+	std::mutex m_playerIDMutex;
+	std::vector<bool> m_playerIDs;
+
+public:
+	ServerWorld(int shards, int maxPlayers);
+
+	int ShardCount() const;
+
+	// Returns a free player id or 0 if the world is full
+	int AcquirePlayerID();
+	void ReleasePlayerID(int playerID);
+
+	// Only called by the shard itself
+	void Publish(int shardId, const std::vector<Player>& players);
+	// Appends the latest published states of all other shards
+	void CollectPlayerStates(int shardId, std::vector<PlayerState>& playerStates);
+
+	void AddReceivedBatch(int shardId);
+	uint64_t ReceivedBatches();
+};
@@ -0,0 +1,55 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "PlayerState.h"
+
+// Player states of the most recent snapshots sent or received on a
+// connection, by small sequence number. Delta encoded snapshots refer to one
+// of them as baseline, and acks cover the last 33 sequence numbers, so older
+// snapshots can no longer become a baseline and their slots are reused.
+class SnapshotHistory
+{
+public:
+    static constexpr size_t CAPACITY = 33;
+
+private:
+    struct Entry
+    {
+        bool valid = false;
+        uint16_t seqNum = 0;
+        std::vector<PlayerState> playerStates;
+    };
+
+    Entry m_entries[CAPACITY];
+
+public:
+    // Replaces the oldest snapshot, returns its emptied player states to fill
+    std::vector<PlayerState>& Add(uint16_t seqNum)
+    {
+        Entry& entry = m_entries[seqNum % CAPACITY];
+        entry.valid = true;
+        entry.seqNum = seqNum;
+        entry.playerStates.clear();
+        return entry.playerStates;
+    }
+
+    // Player states of the snapshot, nullptr when it is no longer kept
+    const std::vector<PlayerState>* Find(uint16_t seqNum) const
+    {
+        const Entry& entry = m_entries[seqNum % CAPACITY];
+        if (!entry.valid || entry.seqNum != seqNum)
+        {
+            return nullptr;
+        }
+        return &entry.playerStates;
+    }
+
+    void Clear()
+    {
+        for (Entry& entry : m_entries)
+        {
+            entry.valid = false;
+            entry.playerStates.clear();
+        }
+    }
+};
@@ -0,0 +1,223 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include "RangeCoder.h"
+
+// Contexts and initial probabilities of the entropy coded snapshots. The
+// symbols are those of the delta encoded snapshot, see GamePacket: the player
+// id, as the difference to the previous one in the snapshot, the mask of the
+// changed fields and every changed field as the difference to its baseline
+// value. A difference is coded as its bit length, modelled per field, then
+// the two bits below the leading one, modelled per field and length, and
+// the remaining bits direct.
+//
+// Probabilities start from TRAINED_PROBABILITIES, counted over captured
+// snapshots by "RocketBenchmark model", and adapt within one snapshot only
+// so that every datagram decodes on its own.
+class SnapshotModel
+{
+public:
+    static constexpr int FIELD_COUNT = 7;
+    static constexpr int LENGTH_BITS = 4;
+    static constexpr int MAX_FIELD_BITS = (1 << LENGTH_BITS) - 1;
+    static constexpr int MANTISSA_BITS = 2;
+
+    // Offsets of the bit trees of every symbol
+    static constexpr size_t PLAYER_ID = 0;
+    static constexpr size_t CHANGED_MASK = PLAYER_ID + (1 << 8);
+    static constexpr size_t LENGTH = CHANGED_MASK + (1 << FIELD_COUNT);
+    static constexpr size_t MANTISSA = LENGTH + FIELD_COUNT * (1 << LENGTH_BITS);
+    static constexpr size_t CONTEXT_COUNT = MANTISSA + FIELD_COUNT * (1 << LENGTH_BITS) * (1 << MANTISSA_BITS);
+
+    using Probabilities = std::array<uint16_t, CONTEXT_COUNT>;
+
+    // Generated by "RocketBenchmark model <capture file> <output file>"
+    static constexpr Probabilities TRAINED_PROBABILITIES = {
+        1024, 1824, 2017, 31, 2017, 1024, 1024, 31, 2017, 1024, 1024, 1024, 1024, 1024, 1024, 31,
+        2012, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 31,
+        1902, 2017, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 878,
+        1733, 1024, 2017, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 683, 1024,
+        31, 1792, 1024, 1024, 2017, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 31, 1024, 1024, 1024,
+        1024, 1979, 2017, 2017, 2017, 1024, 2017, 1024, 2017, 1024, 1024, 1024, 2017, 1024, 1024, 1024,
+        2017, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 2017, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        2017, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        2017, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        2017, 35, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        2017, 31, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 31, 1024, 31, 1024, 1024, 1024, 2017, 1024, 1024, 1024, 1024, 1024, 1024, 2017, 1024,
+        1024, 31, 1024, 31, 1024, 1024, 1024, 2017, 1024, 1024, 1024, 1024, 1024, 1024, 31, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 2017, 1032, 1024, 31, 2017, 1024, 1024, 1024, 34, 2017, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 31, 1024, 2017, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 2017, 31, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 2017, 1024, 1024, 1024, 31, 1024, 31,
+        1024, 2017, 2017, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+        1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024, 1024,
+    };
+
+private:
+    Probabilities m_probabilities = TRAINED_PROBABILITIES;
+
+    static inline int BitLength(uint32_t value)
+    {
+        int length = 0;
+        while (value != 0)
+        {
+            length++;
+            value >>= 1;
+        }
+        return length;
+    }
+
+    // Signed difference of two values of a field wrapping around at bits, small differences become small numbers
+    static inline uint32_t ZigZag(uint32_t value, uint32_t baselineValue, int bits)
+    {
+        uint32_t mask = (1u << bits) - 1;
+        int32_t difference = static_cast<int32_t>((value - baselineValue) & mask);
+        if (difference >= (1 << (bits - 1)))
+        {
+            difference -= 1 << bits;
+        }
+        return difference >= 0 ? static_cast<uint32_t>(difference) << 1 : (static_cast<uint32_t>(-difference) << 1) - 1;
+    }
+
+    static inline uint32_t UnZigZag(uint32_t zigzag, uint32_t baselineValue, int bits)
+    {
+        uint32_t difference = (zigzag >> 1) ^ (0 - (zigzag & 1));
+        return (baselineValue + difference) & ((1u << bits) - 1);
+    }
+
+    template <typename Encoder>
+    inline void EncodeTree(Encoder& encoder, size_t context, uint32_t value, int bits)
+    {
+        uint32_t node = 1;
+        for (int i = bits - 1; i >= 0; i--)
+        {
+            uint32_t bit = (value >> i) & 1;
+            encoder.EncodeBit(m_probabilities[context + node], bit);
+            node = (node << 1) | bit;
+        }
+    }
+
+    template <typename Decoder>
+    inline uint32_t DecodeTree(Decoder& decoder, size_t context, int bits)
+    {
+        uint32_t node = 1;
+        for (int i = 0; i < bits; i++)
+        {
+            node = (node << 1) | decoder.DecodeBit(m_probabilities[context + node]);
+        }
+        return node - (1u << bits);
+    }
+
+public:
+    // Current probabilities, those of a context are at its offset
+    const Probabilities& Contexts() const
+    {
+        return m_probabilities;
+    }
+
+    template <typename Encoder>
+    inline void EncodePlayerId(Encoder& encoder, uint8_t playerID, uint8_t previousPlayerID)
+    {
+        EncodeTree(encoder, PLAYER_ID, static_cast<uint8_t>(playerID - previousPlayerID), 8);
+    }
+
+    template <typename Decoder>
+    inline uint8_t DecodePlayerId(Decoder& decoder, uint8_t previousPlayerID)
+    {
+        return static_cast<uint8_t>(previousPlayerID + DecodeTree(decoder, PLAYER_ID, 8));
+    }
+
+    template <typename Encoder>
+    inline void EncodeChangedMask(Encoder& encoder, uint32_t changedMask)
+    {
+        EncodeTree(encoder, CHANGED_MASK, changedMask, FIELD_COUNT);
+    }
+
+    template <typename Decoder>
+    inline uint32_t DecodeChangedMask(Decoder& decoder)
+    {
+        return DecodeTree(decoder, CHANGED_MASK, FIELD_COUNT);
+    }
+
+    template <typename Encoder>
+    inline void EncodeField(Encoder& encoder, int field, int bits, uint32_t value, uint32_t baselineValue)
+    {
+        uint32_t zigzag = ZigZag(value, baselineValue, bits);
+        int length = BitLength(zigzag);
+        EncodeTree(encoder, LENGTH + field * (1 << LENGTH_BITS), length, LENGTH_BITS);
+        if (length > 1)
+        {
+            int lowBits = length - 1;
+            int mantissaBits = lowBits < MANTISSA_BITS ? lowBits : MANTISSA_BITS;
+            int directBits = lowBits - mantissaBits;
+            size_t context = MANTISSA + (field * (1 << LENGTH_BITS) + length) * (1 << MANTISSA_BITS);
+            EncodeTree(encoder, context, (zigzag >> directBits) & ((1u << mantissaBits) - 1), mantissaBits);
+            if (directBits > 0)
+            {
+                encoder.EncodeDirectBits(zigzag & ((1u << directBits) - 1), directBits);
+            }
+        }
+    }
+
+    template <typename Decoder>
+    inline uint32_t DecodeField(Decoder& decoder, int field, int bits, uint32_t baselineValue)
+    {
+        int length = static_cast<int>(DecodeTree(decoder, LENGTH + field * (1 << LENGTH_BITS), LENGTH_BITS));
+        uint32_t zigzag = length > 0 ? 1 : 0;
+        if (length > 1)
+        {
+            int lowBits = length - 1;
+            int mantissaBits = lowBits < MANTISSA_BITS ? lowBits : MANTISSA_BITS;
+            int directBits = lowBits - mantissaBits;
+            size_t context = MANTISSA + (field * (1 << LENGTH_BITS) + length) * (1 << MANTISSA_BITS);
+            zigzag = (zigzag << mantissaBits) | DecodeTree(decoder, context, mantissaBits);
+            if (directBits > 0)
+            {
+                zigzag = (zigzag << directBits) | decoder.DecodeDirectBits(directBits);
+            }
+        }
+        return UnZigZag(zigzag, baselineValue, bits);
+    }
+};
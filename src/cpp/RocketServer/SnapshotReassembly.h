@@ -0,0 +1,169 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <vector>
+#include <span>
+#include <chrono>
+#include "PacketSchemas.h"
+
+// Snapshots larger than the path MTU are sent as GAME_STATE_FRAGMENT
+// messages. Each fragment carries the game state fields and its own
+// serialized run of player states, so a fragment never straddles a player
+// state. A snapshot is only used, and acknowledged, once all of its fragments
+// arrived, because the sender keeps it whole as the baseline of later ones.
+//
+// Fragments are copied into a slab allocated once, SLOT_COUNT snapshots at a
+// time. A snapshot still missing fragments after TIMEOUT is evicted, and when
+// every slot is taken the oldest one makes room for a new snapshot.
+class SnapshotReassembly
+{
+public:
+    // Enough for a full snapshot of every player id at the minimum path MTU
+    static constexpr size_t MAX_FRAGMENTS = 8;
+    static constexpr size_t SLOT_COUNT = 4;
+    static constexpr std::chrono::milliseconds TIMEOUT{ 250 };
+
+    using FragmentView = PacketView<PacketSchemas::GameStateFragment>;
+
+private:
+    static_assert(MAX_FRAGMENTS <= 32, "Received fragments fit the mask");
+
+    static constexpr size_t FRAGMENT_CAPACITY = PacketSchemas::GameStateFragment::MAX_SIZE - PacketSchemas::GameStateFragment::HEADER_SIZE;
+
+    struct Slot
+    {
+        bool used = false;
+        uint16_t seqNum = 0;
+        size_t fragmentCount = 0;
+        uint32_t receivedMask = 0;
+        std::chrono::steady_clock::time_point started{};
+        PacketSchemas::GameState::Values fields{};
+        std::array<std::span<const uint8_t>, MAX_FRAGMENTS> fragments{};
+    };
+
+    std::vector<uint8_t> m_slab;
+    std::array<Slot, SLOT_COUNT> m_slots{};
+    size_t m_completed = 0;
+    uint64_t m_evicted = 0;
+
+    Slot& FindSlot(uint16_t seqNum, std::chrono::steady_clock::time_point receiveTime)
+    {
+        Slot* free = nullptr;
+        Slot* oldest = &m_slots[0];
+        for (Slot& slot : m_slots)
+        {
+            if (slot.used && receiveTime - slot.started > TIMEOUT)
+            {
+                slot.used = false;
+                m_evicted++;
+            }
+
+            if (slot.used && slot.seqNum == seqNum)
+            {
+                return slot;
+            }
+            if (!slot.used && free == nullptr)
+            {
+                free = &slot;
+            }
+            if (slot.started < oldest->started)
+            {
+                oldest = &slot;
+            }
+        }
+
+        if (free == nullptr)
+        {
+            free = oldest;
+            m_evicted++;
+        }
+
+        // Taken by Add once the fragment turns out valid
+        free->used = false;
+        free->seqNum = seqNum;
+        free->receivedMask = 0;
+        free->started = receiveTime;
+        return *free;
+    }
+
+public:
+    SnapshotReassembly() : m_slab(SLOT_COUNT * MAX_FRAGMENTS * FRAGMENT_CAPACITY)
+    {
+    }
+
+    // Stores a received fragment. Returns 0 when it completes its snapshot,
+    // -1 while fragments are still missing and 1 for an invalid fragment.
+    int Add(const FragmentView& fragment, std::chrono::steady_clock::time_point receiveTime)
+    {
+        auto [connectionId, seqNum, ackDistance, missingAckBits, baselineDistance, fragmentIndex, fragmentCount] = fragment.Fields();
+        if (!fragment.Valid() || fragmentCount == 0 || fragmentCount > MAX_FRAGMENTS || fragmentIndex >= fragmentCount)
+        {
+            return 1;
+        }
+
+        Slot& slot = FindSlot(seqNum, receiveTime);
+        if (!slot.used)
+        {
+            slot.used = true;
+            slot.fragmentCount = fragmentCount;
+            slot.fields = PacketSchemas::GameState::Values{ connectionId, seqNum, ackDistance, missingAckBits, baselineDistance };
+        }
+
+        if (slot.fragmentCount != fragmentCount)
+        {
+            return 1;
+        }
+
+        // Duplicated on the way
+        uint32_t fragmentBit = 1u << fragmentIndex;
+        if ((slot.receivedMask & fragmentBit) != 0)
+        {
+            return -1;
+        }
+
+        std::span<const uint8_t> bytes = fragment.Trailing();
+        size_t slotIndex = &slot - m_slots.data();
+        uint8_t* destination = m_slab.data() + (slotIndex * MAX_FRAGMENTS + fragmentIndex) * FRAGMENT_CAPACITY;
+        std::memcpy(destination, bytes.data(), bytes.size());
+        slot.fragments[fragmentIndex] = std::span<const uint8_t>(destination, bytes.size());
+        slot.receivedMask |= fragmentBit;
+
+        if (slot.receivedMask != (1u << slot.fragmentCount) - 1)
+        {
+            return -1;
+        }
+
+        // Kept until the next Add reuses the slot
+        slot.used = false;
+        m_completed = slotIndex;
+        return 0;
+    }
+
+    // Game state fields of the snapshot the last Add completed
+    const PacketSchemas::GameState::Values& Fields() const
+    {
+        return m_slots[m_completed].fields;
+    }
+
+    // Fragments of the snapshot the last Add completed, in order, valid until the next Add
+    std::span<const std::span<const uint8_t>> Fragments() const
+    {
+        const Slot& slot = m_slots[m_completed];
+        return std::span<const std::span<const uint8_t>>(slot.fragments.data(), slot.fragmentCount);
+    }
+
+    // Snapshots given up on before all of their fragments arrived
+    uint64_t Evicted() const
+    {
+        return m_evicted;
+    }
+
+    void Clear()
+    {
+        for (Slot& slot : m_slots)
+        {
+            slot.used = false;
+        }
+    }
+};
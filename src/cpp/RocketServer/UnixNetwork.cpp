@@ -0,0 +1,580 @@
+#include <cstdint>
+#include <algorithm>
+#include "UnixNetwork.h"
+#include "NetworkUtilities.h"
+
+#ifdef _WIN32
+// Windows implements AF_UNIX for stream sockets only
+UnixNetwork::UnixNetwork(std::shared_ptr<Logger> logger, const std::string& path) : m_logger(logger), m_path(path)
+{
+}
+
+UnixNetwork::~UnixNetwork()
+{
+}
+
+size_t UnixNetwork::QueueLength()
+{
+	return 0;
+}
+
+int UnixNetwork::Initialize(std::string server, int port, sockaddr_in& addr)
+{
+	m_logger->Log(LogLevel::EXCEPTION, "Initialize: Unix domain datagram sockets are not supported on this platform");
+	return 1;
+}
+
+int UnixNetwork::Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
+{
+	return 1;
+}
+
+int UnixNetwork::SendBatch(std::vector<OutgoingPacket>& outgoingPackets)
+{
+	return 1;
+}
+
+PacketHandle UnixNetwork::Receive(sockaddr_in& clientAddr, int& result)
+{
+	result = 1;
+	return nullptr;
+}
+
+int UnixNetwork::ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets)
+{
+	return 1;
+}
+
+int UnixNetwork::StartTimer(int timerId, std::chrono::nanoseconds interval)
+{
+	return 1;
+}
+
+int UnixNetwork::WaitForEvents(std::vector<int>& expiredTimers)
+{
+	return 1;
+}
+
+void UnixNetwork::ReleasePeer(const sockaddr_in& clientAddr)
+{
+}
+#else
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <fstream>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/timerfd.h>
+
+static std::string GetErrorMessage(int errorCode)
+{
+	std::string message(std::strerror(errorCode));
+	std::ranges::replace(message, '"', '\'');
+	return message;
+}
+
+UnixNetwork::UnixNetwork(std::shared_ptr<Logger> logger, const std::string& path) : m_logger(logger), m_path(path)
+{
+	// Point every message of the receive ring to its own address, the
+	// buffers are pooled packets attached before every recvmmsg call
+	for (size_t i = 0; i < MAX_BATCH_SIZE; i++)
+	{
+		m_receiveMessages[i].msg_hdr.msg_iov = &m_receiveIovecs[i];
+		m_receiveMessages[i].msg_hdr.msg_iovlen = 1;
+		m_receiveMessages[i].msg_hdr.msg_name = &m_receiveAddresses[i];
+	}
+}
+
+UnixNetwork::~UnixNetwork()
+{
+	for (UnixTimer& timer : m_timers)
+	{
+		close(timer.fd);
+	}
+	if (m_epoll != -1)
+	{
+		close(m_epoll);
+	}
+	if (m_socket != -1)
+	{
+		close(m_socket);
+	}
+
+	// Abstract names vanish with the socket, paths in the file system do not
+	if (m_bound && m_path[0] != '@')
+	{
+		unlink(m_path.c_str());
+	}
+}
+
+size_t UnixNetwork::QueueLength()
+{
+	std::ifstream file("/proc/sys/net/unix/max_dgram_qlen");
+	size_t queueLength = 0;
+	file >> queueLength;
+	return queueLength;
+}
+
+bool UnixNetwork::ToSocketAddress(const std::string& path, sockaddr_un& address, socklen_t& length)
+{
+	address = {};
+	address.sun_family = AF_UNIX;
+	if (path.empty() || path.size() >= sizeof(address.sun_path))
+	{
+		return false;
+	}
+
+	std::memcpy(address.sun_path, path.data(), path.size());
+	if (path[0] == '@')
+	{
+		// Abstract names start with a null byte and are not null terminated
+		address.sun_path[0] = '\0';
+		length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size());
+	}
+	else
+	{
+		length = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+	}
+	return true;
+}
+
+std::string_view UnixNetwork::PeerName(const sockaddr_un& address, socklen_t length)
+{
+	return std::string_view(address.sun_path, length - offsetof(sockaddr_un, sun_path));
+}
+
+bool UnixNetwork::MapPeer(const sockaddr_un& address, socklen_t length, sockaddr_in& addr)
+{
+	if (length <= offsetof(sockaddr_un, sun_path))
+	{
+		// Unbound sockets have no name to reply to
+		return false;
+	}
+
+	// Looked up by a view of the received path, so known peers cost no allocation
+	auto peerIndex = m_peerIndices.find(PeerName(address, length));
+	uint32_t index = 0;
+	if (peerIndex != m_peerIndices.end())
+	{
+		index = peerIndex->second;
+	}
+	else
+	{
+		if (m_freePeers.empty())
+		{
+			index = static_cast<uint32_t>(m_peers.size());
+			m_peers.emplace_back();
+		}
+		else
+		{
+			index = m_freePeers.back();
+			m_freePeers.pop_back();
+		}
+
+		UnixPeer& peer = m_peers[index];
+		peer.address = address;
+		peer.length = length;
+		m_peerIndices.emplace(PeerName(peer.address, peer.length), index);
+	}
+
+	addr = {};
+	addr.sin_family = AF_UNIX;
+	addr.sin_addr.s_addr = htonl(index);
+	return true;
+}
+
+const UnixNetwork::UnixPeer* UnixNetwork::FindPeer(const sockaddr_in& addr) const
+{
+	uint32_t index = ntohl(addr.sin_addr.s_addr);
+	if (addr.sin_family != AF_UNIX || index >= m_peers.size() || m_peers[index].length == 0)
+	{
+		return nullptr;
+	}
+	return &m_peers[index];
+}
+
+void UnixNetwork::RecyclePeers()
+{
+	// Servers send what they queued for a batch before receiving the next one, so no packet is left for the released peers
+	m_freePeers.insert(m_freePeers.end(), m_releasedPeers.begin(), m_releasedPeers.end());
+	m_releasedPeers.clear();
+}
+
+void UnixNetwork::ReleasePeer(const sockaddr_in& clientAddr)
+{
+	uint32_t index = ntohl(clientAddr.sin_addr.s_addr);
+	if (FindPeer(clientAddr) == nullptr)
+	{
+		return;
+	}
+
+	UnixPeer& peer = m_peers[index];
+	m_peerIndices.erase(PeerName(peer.address, peer.length));
+	peer.length = 0;
+	m_releasedPeers.push_back(index);
+}
+
+int UnixNetwork::Initialize(std::string server, [[maybe_unused]] int port, sockaddr_in& addr)
+{
+	m_socket = socket(AF_UNIX, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+	if (m_socket == -1)
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(LogLevel::EXCEPTION, "Initialize: Socket creation failed", { KV(errorCode), KVS(errorMsg) });
+		return 1;
+	}
+
+	sockaddr_un address{};
+	socklen_t length = 0;
+	if (server.empty())
+	{
+		// Server
+		if (!ToSocketAddress(m_path, address, length))
+		{
+			m_logger->Log(LogLevel::EXCEPTION, "Initialize: Invalid socket path", { KVS(m_path) });
+			return 1;
+		}
+
+		// A socket left behind by a server which did not exit cleanly would fail the bind
+		struct stat status{};
+		if (m_path[0] != '@' && stat(m_path.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+		{
+			unlink(m_path.c_str());
+		}
+
+		m_logger->Log(LogLevel::INFO, "Initialize: Binding on path", { KVS(m_path) });
+		if (bind(m_socket, reinterpret_cast<sockaddr*>(&address), length) == -1)
+		{
+			auto errorCode = errno;
+			std::string errorMsg = GetErrorMessage(errorCode);
+			m_logger->Log(LogLevel::EXCEPTION, "Initialize: Failed to bind socket on path", { KVS(m_path), KV(errorCode), KVS(errorMsg) });
+			return 1;
+		}
+		m_bound = true;
+
+		size_t queueLength = QueueLength();
+		if (queueLength != 0 && queueLength < MAX_BATCH_SIZE)
+		{
+			m_logger->Log(LogLevel::WARNING, "Initialize: Raise net.unix.max_dgram_qlen to serve more clients", { KV(queueLength) });
+		}
+
+		addr = {};
+		addr.sin_family = AF_UNIX;
+	}
+	else
+	{
+		// Client
+		if (!ToSocketAddress(server, address, length))
+		{
+			m_logger->Log(LogLevel::EXCEPTION, "Initialize: Invalid socket path", { KVS(server) });
+			return 1;
+		}
+
+		// Binding only the family makes the kernel pick a unique abstract name to reply to
+		sockaddr_un autobind{};
+		autobind.sun_family = AF_UNIX;
+		if (bind(m_socket, reinterpret_cast<sockaddr*>(&autobind), sizeof(sa_family_t)) == -1)
+		{
+			auto errorCode = errno;
+			std::string errorMsg = GetErrorMessage(errorCode);
+			m_logger->Log(LogLevel::EXCEPTION, "Initialize: Failed to autobind socket", { KV(errorCode), KVS(errorMsg) });
+			return 1;
+		}
+
+		MapPeer(address, length, addr);
+	}
+
+	// Kernel stamps every datagram when it is queued so latency math does not include scheduling delay
+	int timestamps = 1;
+	if (setsockopt(m_socket, SOL_SOCKET, SO_TIMESTAMPNS, &timestamps, sizeof(timestamps)) == -1)
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(LogLevel::WARNING, "Initialize: Failed to enable receive timestamps", { KV(errorCode), KVS(errorMsg) });
+	}
+
+	// Wait for datagrams and timers with epoll instead of spinning on the socket
+	m_epoll = epoll_create1(EPOLL_CLOEXEC);
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.fd = m_socket;
+	if (m_epoll == -1 || epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_socket, &event) == -1)
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(LogLevel::EXCEPTION, "Initialize: Failed to set up epoll", { KV(errorCode), KVS(errorMsg) });
+		return 1;
+	}
+	return 0;
+}
+
+PacketHandle UnixNetwork::Receive(sockaddr_in& clientAddr, int& result)
+{
+	RecyclePeers();
+
+	PacketHandle networkPacket = AcquirePacket();
+	std::span<uint8_t> buffer = networkPacket->Buffer();
+
+	sockaddr_un address{};
+	iovec iov{ buffer.data(), buffer.size() };
+	alignas(cmsghdr) uint8_t control[CONTROL_SIZE]{};
+	msghdr message{};
+	message.msg_name = &address;
+	message.msg_namelen = sizeof(address);
+	message.msg_iov = &iov;
+	message.msg_iovlen = 1;
+	message.msg_control = control;
+	message.msg_controllen = sizeof(control);
+
+	while (true)
+	{
+		ssize_t n = recvmsg(m_socket, &message, 0);
+		if (n == -1)
+		{
+			auto errorCode = errno;
+			if (errorCode == EAGAIN)
+			{
+				// No data received
+				result = -1;
+				return nullptr;
+			}
+
+			std::string errorMsg = GetErrorMessage(errorCode);
+			m_logger->Log(LogLevel::EXCEPTION, "Receive: Failed", { KV(errorCode), KVS(errorMsg) });
+			result = 1;
+			return nullptr;
+		}
+
+		if (!MapPeer(address, message.msg_namelen, clientAddr))
+		{
+			m_logger->Log(LogLevel::WARNING, "Receive: Dropped datagram of unbound socket");
+			message.msg_namelen = sizeof(address);
+			message.msg_controllen = sizeof(control);
+			continue;
+		}
+
+		networkPacket->Resize(static_cast<size_t>(n));
+		networkPacket->SetReceiveTime(NetworkUtilities::GetReceiveTime(message));
+		m_counters.packetsReceived++;
+		result = 0;
+		return networkPacket;
+	}
+}
+
+int UnixNetwork::ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets)
+{
+	RecyclePeers();
+
+	for (size_t i = 0; i < MAX_BATCH_SIZE; i++)
+	{
+		// Slots consumed by the previous call get a fresh packet from the pool
+		if (!m_receiveSlots[i])
+		{
+			m_receiveSlots[i] = AcquirePacket();
+			std::span<uint8_t> buffer = m_receiveSlots[i]->Buffer();
+			m_receiveIovecs[i].iov_base = buffer.data();
+			m_receiveIovecs[i].iov_len = buffer.size();
+		}
+
+		// Kernel overwrites the address and control lengths on every call
+		m_receiveMessages[i].msg_hdr.msg_namelen = sizeof(sockaddr_un);
+		m_receiveMessages[i].msg_hdr.msg_control = m_receiveControl[i];
+		m_receiveMessages[i].msg_hdr.msg_controllen = sizeof(m_receiveControl[i]);
+		m_receiveMessages[i].msg_len = 0;
+	}
+
+	int n = recvmmsg(m_socket, m_receiveMessages, MAX_BATCH_SIZE, 0, nullptr);
+	if (n == -1)
+	{
+		auto errorCode = errno;
+		if (errorCode == EAGAIN)
+		{
+			// No data received
+			return -1;
+		}
+
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(LogLevel::EXCEPTION, "ReceiveBatch: Failed", { KV(errorCode), KVS(errorMsg) });
+		return 1;
+	}
+
+	int received = 0;
+	for (int i = 0; i < n; i++)
+	{
+		msghdr& message = m_receiveMessages[i].msg_hdr;
+		ReceivedPacket receivedPacket;
+		if (!MapPeer(m_receiveAddresses[i], message.msg_namelen, receivedPacket.clientAddr))
+		{
+			m_logger->Log(LogLevel::WARNING, "ReceiveBatch: Dropped datagram of unbound socket");
+			continue;
+		}
+
+		// Hand the slot over without copying, the datagram is already in it
+		receivedPacket.networkPacket = std::move(m_receiveSlots[i]);
+		receivedPacket.networkPacket->Resize(m_receiveMessages[i].msg_len);
+		receivedPacket.networkPacket->SetReceiveTime(NetworkUtilities::GetReceiveTime(message));
+		m_counters.packetsReceived++;
+		receivedPackets.push_back(std::move(receivedPacket));
+		received++;
+	}
+	return received == 0 ? -1 : 0;
+}
+
+int UnixNetwork::StartTimer(int timerId, std::chrono::nanoseconds interval)
+{
+	UnixTimer timer;
+	timer.timerId = timerId;
+	timer.fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timer.fd == -1)
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(LogLevel::EXCEPTION, "StartTimer: Failed to create timer", { KV(timerId), KV(errorCode), KVS(errorMsg) });
+		return 1;
+	}
+
+	auto seconds = std::chrono::duration_cast<std::chrono::seconds>(interval);
+	itimerspec spec{};
+	spec.it_interval.tv_sec = seconds.count();
+	spec.it_interval.tv_nsec = (interval - seconds).count();
+	spec.it_value = spec.it_interval;
+
+	epoll_event event{};
+	event.events = EPOLLIN;
+	event.data.fd = timer.fd;
+	if (timerfd_settime(timer.fd, 0, &spec, nullptr) == -1 ||
+		epoll_ctl(m_epoll, EPOLL_CTL_ADD, timer.fd, &event) == -1)
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(LogLevel::EXCEPTION, "StartTimer: Failed to arm timer", { KV(timerId), KV(errorCode), KVS(errorMsg) });
+		close(timer.fd);
+		return 1;
+	}
+
+	m_timers.push_back(timer);
+	return 0;
+}
+
+int UnixNetwork::WaitForEvents(std::vector<int>& expiredTimers)
+{
+	int n = epoll_wait(m_epoll, m_events, MAX_EVENTS, -1);
+	if (n == -1)
+	{
+		auto errorCode = errno;
+		if (errorCode == EINTR)
+		{
+			// Interrupted by a signal, let the caller check if it is still running
+			return -1;
+		}
+
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(LogLevel::EXCEPTION, "WaitForEvents: Failed", { KV(errorCode), KVS(errorMsg) });
+		return 1;
+	}
+
+	bool readable = false;
+	for (int i = 0; i < n; i++)
+	{
+		if (m_events[i].data.fd == m_socket)
+		{
+			readable = true;
+			continue;
+		}
+
+		for (UnixTimer& timer : m_timers)
+		{
+			if (timer.fd == m_events[i].data.fd)
+			{
+				uint64_t expirations = 0;
+				if (read(timer.fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+				{
+					expiredTimers.push_back(timer.timerId);
+				}
+				break;
+			}
+		}
+	}
+	return readable ? 0 : -1;
+}
+
+int UnixNetwork::Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
+{
+	const UnixPeer* peer = FindPeer(clientAddr);
+	if (peer == nullptr)
+	{
+		std::string address = NetworkUtilities::AddressToString(clientAddr);
+		m_logger->Log(LogLevel::EXCEPTION, "Send: Unknown peer", { KVS(address) });
+		m_counters.sendFailures++;
+		return 1;
+	}
+
+	auto size = networkPacket.Size();
+	if (sendto(m_socket, networkPacket.Data(), size, 0, reinterpret_cast<const sockaddr*>(&peer->address), peer->length) != static_cast<ssize_t>(size))
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(LogLevel::EXCEPTION, "Send: Failed", { KV(errorCode), KVS(errorMsg) });
+		m_counters.sendFailures++;
+		return 1;
+	}
+	m_counters.packetsSent++;
+	return 0;
+}
+
+int UnixNetwork::SendBatch(std::vector<OutgoingPacket>& outgoingPackets)
+{
+	int failures = 0;
+	size_t offset = 0;
+	while (offset < outgoingPackets.size())
+	{
+		size_t count = std::min(outgoingPackets.size() - offset, MAX_BATCH_SIZE);
+		size_t messages = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			OutgoingPacket& outgoingPacket = outgoingPackets[offset + i];
+			const UnixPeer* peer = FindPeer(outgoingPacket.clientAddr);
+			if (peer == nullptr)
+			{
+				// Sent up to here, the next call fails the packet
+				break;
+			}
+
+			outgoingPacket.result = 0;
+			std::span<uint8_t> bytes = outgoingPacket.networkPacket->Bytes();
+			m_sendIovecs[i].iov_base = bytes.data();
+			m_sendIovecs[i].iov_len = bytes.size();
+			msghdr& message = m_sendMessages[i].msg_hdr;
+			message.msg_iov = &m_sendIovecs[i];
+			message.msg_iovlen = 1;
+			message.msg_name = const_cast<sockaddr_un*>(&peer->address);
+			message.msg_namelen = peer->length;
+			m_sendMessages[i].msg_len = 0;
+			messages++;
+		}
+
+		int n = messages == 0 ? -1 : sendmmsg(m_socket, m_sendMessages, messages, 0);
+		if (n == -1)
+		{
+			// sendmmsg stops at the first failing message so report it and skip past it
+			auto errorCode = messages == 0 ? EDESTADDRREQ : errno;
+			OutgoingPacket& failedPacket = outgoingPackets[offset];
+			std::string errorMsg = GetErrorMessage(errorCode);
+			std::string address = NetworkUtilities::AddressToString(failedPacket.clientAddr);
+			m_logger->Log(LogLevel::EXCEPTION, "SendBatch: Failed", { KV(errorCode), KVS(errorMsg), KVS(address) });
+			failedPacket.result = 1;
+			failures++;
+			offset++;
+			continue;
+		}
+		offset += n;
+	}
+
+	m_counters.packetsSent += outgoingPackets.size() - failures;
+	m_counters.sendFailures += failures;
+	return failures == 0 ? 0 : 1;
+}
+#endif
@@ -0,0 +1,110 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <vector>
+#include <deque>
+#include <string_view>
+#include <unordered_map>
+#include "NetworkBase.h"
+#include "Logger.h"
+
+#ifdef _WIN32
+#else
+#include <sys/un.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#endif
+
+// Unix domain datagram transport for clients on the same host as the server,
+// such as load bots and relay sidecars, whose datagrams then skip the UDP/IP
+// stack. The server binds the socket path given to the constructor, a leading
+// '@' puts it in the abstract namespace. Clients pass that path to Initialize
+// and are autobound to an abstract address so that replies reach them.
+//
+// Peers are identified by the path they are bound to. Every path is mapped to
+// a sockaddr_in of family AF_UNIX with the peer index as address, so that the
+// same peer always has the same address and Player::Address and
+// NetworkUtilities::IsSameAddress work as with UDP, without colliding with
+// the addresses of UDP peers. The server releases the peers whose player is
+// gone and the ones whose datagrams it rejected, so that the table only holds
+// the players and the strangers of the current batch. A released index is
+// handed to a new peer from the next receive on, packets still queued for
+// the old peer fail instead of reaching the new one.
+//
+// The kernel queues at most net.unix.max_dgram_qlen datagrams on the
+// receiving socket, 10 by default, and sending to a full queue fails with
+// EAGAIN. Raise it when more clients than that share the server.
+class UnixNetwork final : public NetworkBase
+{
+private:
+	static constexpr int MAX_EVENTS = 16;
+
+	struct UnixTimer
+	{
+		int timerId{};
+		int fd = -1;
+	};
+
+	std::shared_ptr<Logger> m_logger;
+	std::string m_path;
+	bool m_bound = false;
+	int m_socket = -1;
+	std::vector<UnixTimer> m_timers;
+
+#ifndef _WIN32
+	static constexpr size_t CONTROL_SIZE = CMSG_SPACE(sizeof(timespec));
+
+	struct UnixPeer
+	{
+		sockaddr_un address{};
+		socklen_t length = 0;
+	};
+
+	int m_epoll = -1;
+	epoll_event m_events[MAX_EVENTS]{};
+
+	// Peers by mapped index and mapped index by bound path. The keys view the
+	// paths of the peers, which a deque does not move when it grows. Released
+	// indices wait in m_releasedPeers until the next receive.
+	std::deque<UnixPeer> m_peers;
+	std::unordered_map<std::string_view, uint32_t> m_peerIndices;
+	std::vector<uint32_t> m_releasedPeers;
+	std::vector<uint32_t> m_freePeers;
+
+	// Pooled packets and addresses filled in place by recvmmsg
+	PacketHandle m_receiveSlots[MAX_BATCH_SIZE];
+	sockaddr_un m_receiveAddresses[MAX_BATCH_SIZE]{};
+	iovec m_receiveIovecs[MAX_BATCH_SIZE]{};
+	mmsghdr m_receiveMessages[MAX_BATCH_SIZE]{};
+	alignas(cmsghdr) uint8_t m_receiveControl[MAX_BATCH_SIZE][CONTROL_SIZE]{};
+
+	// Scatter list handed to sendmmsg
+	iovec m_sendIovecs[MAX_BATCH_SIZE]{};
+	mmsghdr m_sendMessages[MAX_BATCH_SIZE]{};
+
+	static bool ToSocketAddress(const std::string& path, sockaddr_un& address, socklen_t& length);
+	static std::string_view PeerName(const sockaddr_un& address, socklen_t length);
+	bool MapPeer(const sockaddr_un& address, socklen_t length, sockaddr_in& addr);
+	const UnixPeer* FindPeer(const sockaddr_in& addr) const;
+	// Makes the indices released since the last receive available to new peers
+	void RecyclePeers();
+#endif
+
+public:
+	// Path the server binds, clients pass the path of the server to Initialize instead
+	UnixNetwork(std::shared_ptr<Logger> logger, const std::string& path = "");
+	~UnixNetwork();
+
+	// Datagrams the kernel queues per socket, 0 when unknown
+	static size_t QueueLength();
+
+	// Port is ignored, the server binds its path when server is empty
+	int Initialize(std::string server, int port, sockaddr_in& addr) override;
+	int Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr) override;
+	int SendBatch(std::vector<OutgoingPacket>& outgoingPackets) override;
+	PacketHandle Receive(sockaddr_in& clientAddr, int& result) override;
+	int ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets) override;
+	int StartTimer(int timerId, std::chrono::nanoseconds interval) override;
+	int WaitForEvents(std::vector<int>& expiredTimers) override;
+	void ReleasePeer(const sockaddr_in& clientAddr) override;
+};
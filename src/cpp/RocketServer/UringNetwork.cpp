@@ -0,0 +1,824 @@
+#include <cstdint>
+#include <algorithm>
+#include "UringNetwork.h"
+#include "NetworkUtilities.h"
+
+#ifdef _WIN32
+UringNetwork::UringNetwork(std::shared_ptr<Logger> logger, bool reusePort) : m_logger(logger), m_reusePort(reusePort)
+{
+}
+
+UringNetwork::~UringNetwork()
+{
+}
+
+bool UringNetwork::IsSupported()
+{
+	// io_uring is Linux only
+	return false;
+}
+
+int UringNetwork::Initialize(std::string server, int port, sockaddr_in& addr)
+{
+	m_logger->Log(LogLevel::EXCEPTION, "Initialize: io_uring is not supported on this platform");
+	return 1;
+}
+
+int UringNetwork::Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
+{
+	return 1;
+}
+
+int UringNetwork::SendBatch(std::vector<OutgoingPacket>& outgoingPackets)
+{
+	return 1;
+}
+
+PacketHandle UringNetwork::Receive(sockaddr_in& clientAddr, int& result)
+{
+	result = 1;
+	return nullptr;
+}
+
+int UringNetwork::ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets)
+{
+	return 1;
+}
+
+int UringNetwork::StartTimer(int timerId, std::chrono::nanoseconds interval)
+{
+	return 1;
+}
+
+int UringNetwork::WaitForEvents(std::vector<int>& expiredTimers)
+{
+	return 1;
+}
+#else
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/timerfd.h>
+
+static inline int IoUringSetup(unsigned entries, io_uring_params* params)
+{
+	return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static inline int IoUringEnter(int ringFd, unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+	return static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+static inline int IoUringRegister(int ringFd, unsigned opcode, void* arg, unsigned args)
+{
+	return static_cast<int>(syscall(__NR_io_uring_register, ringFd, opcode, arg, args));
+}
+
+static inline unsigned LoadAcquire(unsigned* p)
+{
+	return std::atomic_ref<unsigned>(*p).load(std::memory_order_acquire);
+}
+
+static inline void StoreRelease(unsigned* p, unsigned value)
+{
+	std::atomic_ref<unsigned>(*p).store(value, std::memory_order_release);
+}
+
+static inline uint64_t MakeUserData(uint64_t tag, uint64_t index)
+{
+	return (tag << 32) | index;
+}
+
+static std::string GetErrorMessage(int errorCode)
+{
+	std::string message(std::strerror(errorCode));
+	std::ranges::replace(message, '"', '\'');
+	return message;
+}
+
+UringNetwork::UringNetwork(std::shared_ptr<Logger> logger, bool reusePort) : m_logger(logger), m_reusePort(reusePort)
+{
+}
+
+UringNetwork::~UringNetwork()
+{
+	for (UringTimer& timer : m_timers)
+	{
+		close(timer.fd);
+	}
+	if (m_ringFd != -1)
+	{
+		close(m_ringFd);
+	}
+	if (m_bufferRing != nullptr)
+	{
+		munmap(m_bufferRing, m_bufferRingSize);
+	}
+	if (m_sqes != nullptr)
+	{
+		munmap(m_sqes, m_sqesSize);
+	}
+	if (m_cqRing != nullptr && m_cqRing != m_sqRing)
+	{
+		munmap(m_cqRing, m_cqRingSize);
+	}
+	if (m_sqRing != nullptr)
+	{
+		munmap(m_sqRing, m_sqRingSize);
+	}
+	if (m_socket != -1)
+	{
+		close(m_socket);
+	}
+}
+
+bool UringNetwork::IsSupported()
+{
+	io_uring_params params{};
+	int ringFd = IoUringSetup(2, &params);
+	if (ringFd < 0)
+	{
+		return false;
+	}
+
+	// Provided buffer rings are required by multishot recvmsg
+	size_t size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+	void* ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	bool supported = false;
+	if (ring != MAP_FAILED)
+	{
+		io_uring_buf_reg reg{};
+		reg.ring_addr = reinterpret_cast<uint64_t>(ring);
+		reg.ring_entries = 1;
+		reg.bgid = BUFFER_GROUP_ID;
+		supported = IoUringRegister(ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) == 0;
+		munmap(ring, size);
+	}
+
+	close(ringFd);
+	return supported;
+}
+
+int UringNetwork::Initialize(std::string server, int port, sockaddr_in& addr)
+{
+	m_socket = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, IPPROTO_UDP);
+	if (m_socket == -1)
+	{
+		auto errorCode = errno;
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"Initialize: Socket creation failed",
+			{ KV(errorCode) }
+		);
+		return 1;
+	}
+
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+
+	if (server.empty())
+	{
+		// Server
+		addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+		if (m_reusePort)
+		{
+			int reusePort = 1;
+			if (setsockopt(m_socket, SOL_SOCKET, SO_REUSEPORT, &reusePort, sizeof(reusePort)) == -1)
+			{
+				auto errorCode = errno;
+				std::string errorMsg = GetErrorMessage(errorCode);
+				m_logger->Log(
+					LogLevel::EXCEPTION,
+					"Initialize: Failed to set SO_REUSEPORT",
+					{ KV(errorCode), KVS(errorMsg) }
+				);
+				return 1;
+			}
+		}
+
+		// Datagrams above the path MTU are dropped instead of fragmented, see Network::Initialize
+		int mtuDiscover = IP_PMTUDISC_PROBE;
+		if (setsockopt(m_socket, IPPROTO_IP, IP_MTU_DISCOVER, &mtuDiscover, sizeof(mtuDiscover)) == -1)
+		{
+			auto errorCode = errno;
+			std::string errorMsg = GetErrorMessage(errorCode);
+			m_logger->Log(
+				LogLevel::WARNING,
+				"Initialize: Failed to set don't fragment",
+				{ KV(errorCode), KVS(errorMsg) }
+			);
+		}
+
+		m_logger->Log(LogLevel::INFO, "Initialize: Binding on port", { KV(port) });
+		if (bind(m_socket, (sockaddr*)&addr, sizeof(addr)) < 0)
+		{
+			m_logger->Log(LogLevel::EXCEPTION, "Initialize: Failed to bind socket on port", { KV(port) });
+			return 1;
+		}
+
+		m_logger->Log(LogLevel::INFO, "Initialize: Successfully bound on port", { KV(port) });
+	}
+	else
+	{
+		// Client
+		if (inet_pton(AF_INET, server.c_str(), &addr.sin_addr) != 1)
+		{
+			m_logger->Log(LogLevel::EXCEPTION, "Initialize: Failed to convert address", { KVS(server) });
+			return 1;
+		}
+	}
+
+	// Kernel stamps every datagram when it is queued so latency math does not include scheduling delay
+	int timestamps = 1;
+	if (setsockopt(m_socket, SOL_SOCKET, SO_TIMESTAMPNS, &timestamps, sizeof(timestamps)) == -1)
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::WARNING,
+			"Initialize: Failed to enable receive timestamps",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+	}
+
+	// Kernel reports datagrams dropped on a full receive buffer with every receive
+	int dropCounter = 1;
+	if (setsockopt(m_socket, SOL_SOCKET, SO_RXQ_OVFL, &dropCounter, sizeof(dropCounter)) == -1)
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::WARNING,
+			"Initialize: Failed to enable drop counter",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+	}
+
+	if (SetupRing() != 0 || SetupBufferRing() != 0)
+	{
+		return 1;
+	}
+
+	m_freeSendSlots.reserve(SEND_SLOTS);
+	for (uint16_t slot = SEND_SLOTS; slot > 0; slot--)
+	{
+		m_freeSendSlots.push_back(slot - 1);
+	}
+
+	// Source address and timestamp are written into the buffer in front of the payload
+	m_receiveMessage.msg_namelen = sizeof(sockaddr_in);
+	m_receiveMessage.msg_controllen = CONTROL_SIZE;
+	ArmReceive();
+	if (Submit(0) != 0)
+	{
+		return 1;
+	}
+
+	m_logger->Log(LogLevel::INFO, "Initialize: io_uring transport ready", { KV(m_sqEntries) });
+	return 0;
+}
+
+int UringNetwork::SetupRing()
+{
+	io_uring_params params{};
+	m_ringFd = IoUringSetup(RING_ENTRIES, &params);
+	if (m_ringFd < 0)
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"SetupRing: io_uring_setup failed",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+		m_ringFd = -1;
+		return 1;
+	}
+
+	m_sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+	m_cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+	if (singleMmap)
+	{
+		m_sqRingSize = std::max(m_sqRingSize, m_cqRingSize);
+		m_cqRingSize = m_sqRingSize;
+	}
+
+	m_sqRing = mmap(nullptr, m_sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQ_RING);
+	if (m_sqRing == MAP_FAILED)
+	{
+		m_sqRing = nullptr;
+		m_logger->Log(LogLevel::EXCEPTION, "SetupRing: Failed to map submission queue");
+		return 1;
+	}
+
+	if (singleMmap)
+	{
+		m_cqRing = m_sqRing;
+	}
+	else
+	{
+		m_cqRing = mmap(nullptr, m_cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_CQ_RING);
+		if (m_cqRing == MAP_FAILED)
+		{
+			m_cqRing = nullptr;
+			m_logger->Log(LogLevel::EXCEPTION, "SetupRing: Failed to map completion queue");
+			return 1;
+		}
+	}
+
+	m_sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+	void* sqes = mmap(nullptr, m_sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, m_ringFd, IORING_OFF_SQES);
+	if (sqes == MAP_FAILED)
+	{
+		m_logger->Log(LogLevel::EXCEPTION, "SetupRing: Failed to map submission entries");
+		return 1;
+	}
+	m_sqes = static_cast<io_uring_sqe*>(sqes);
+
+	uint8_t* sqRing = static_cast<uint8_t*>(m_sqRing);
+	m_sqHead = reinterpret_cast<unsigned*>(sqRing + params.sq_off.head);
+	m_sqTail = reinterpret_cast<unsigned*>(sqRing + params.sq_off.tail);
+	m_sqMask = *reinterpret_cast<unsigned*>(sqRing + params.sq_off.ring_mask);
+	m_sqEntries = params.sq_entries;
+	m_sqArray = reinterpret_cast<unsigned*>(sqRing + params.sq_off.array);
+	m_sqLocalTail = *m_sqTail;
+
+	uint8_t* cqRing = static_cast<uint8_t*>(m_cqRing);
+	m_cqHead = reinterpret_cast<unsigned*>(cqRing + params.cq_off.head);
+	m_cqTail = reinterpret_cast<unsigned*>(cqRing + params.cq_off.tail);
+	m_cqMask = *reinterpret_cast<unsigned*>(cqRing + params.cq_off.ring_mask);
+	m_cqes = reinterpret_cast<io_uring_cqe*>(cqRing + params.cq_off.cqes);
+
+	return 0;
+}
+
+int UringNetwork::SetupBufferRing()
+{
+	m_bufferRingSize = BUFFER_COUNT * sizeof(io_uring_buf);
+	void* ring = mmap(nullptr, m_bufferRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (ring == MAP_FAILED)
+	{
+		m_logger->Log(LogLevel::EXCEPTION, "SetupBufferRing: Failed to allocate buffer ring");
+		return 1;
+	}
+	m_bufferRing = static_cast<io_uring_buf*>(ring);
+
+	io_uring_buf_reg reg{};
+	reg.ring_addr = reinterpret_cast<uint64_t>(m_bufferRing);
+	reg.ring_entries = BUFFER_COUNT;
+	reg.bgid = BUFFER_GROUP_ID;
+	if (IoUringRegister(m_ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0)
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"SetupBufferRing: Failed to register buffer ring",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+		return 1;
+	}
+
+	// Hand all buffers to the kernel
+	m_buffers.resize(BUFFER_COUNT * BUFFER_SIZE);
+	for (uint16_t bufferId = 0; bufferId < BUFFER_COUNT; bufferId++)
+	{
+		RecycleBuffer(bufferId);
+	}
+	return 0;
+}
+
+void UringNetwork::RecycleBuffer(uint16_t bufferId)
+{
+	io_uring_buf& buffer = m_bufferRing[m_bufferRingTail & (BUFFER_COUNT - 1)];
+	buffer.addr = reinterpret_cast<uint64_t>(m_buffers.data() + bufferId * BUFFER_SIZE);
+	buffer.len = BUFFER_SIZE;
+	buffer.bid = bufferId;
+	m_bufferRingTail++;
+	// The ring tail overlays the reserved field of the first entry
+	std::atomic_ref<uint16_t>(m_bufferRing[0].resv).store(m_bufferRingTail, std::memory_order_release);
+}
+
+io_uring_sqe* UringNetwork::GetSqe()
+{
+	if (m_sqLocalTail - LoadAcquire(m_sqHead) >= m_sqEntries)
+	{
+		// Submission queue is full so hand the pending entries to the kernel first
+		Submit(0);
+	}
+
+	unsigned index = m_sqLocalTail & m_sqMask;
+	io_uring_sqe* sqe = &m_sqes[index];
+	std::memset(sqe, 0, sizeof(io_uring_sqe));
+	m_sqArray[index] = index;
+	m_sqLocalTail++;
+	m_pendingSubmissions++;
+	return sqe;
+}
+
+int UringNetwork::Submit(unsigned minComplete)
+{
+	StoreRelease(m_sqTail, m_sqLocalTail);
+
+	unsigned flags = minComplete > 0 ? IORING_ENTER_GETEVENTS : 0;
+	if (m_pendingSubmissions == 0 && minComplete == 0)
+	{
+		return 0;
+	}
+
+	int submitted = IoUringEnter(m_ringFd, m_pendingSubmissions, minComplete, flags);
+	if (submitted < 0)
+	{
+		auto errorCode = errno;
+		if (errorCode == EINTR)
+		{
+			// Interrupted by a signal, let the caller check if it is still running
+			return 0;
+		}
+
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"Submit: io_uring_enter failed",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+		return 1;
+	}
+
+	m_pendingSubmissions -= std::min(m_pendingSubmissions, static_cast<unsigned>(submitted));
+	return 0;
+}
+
+void UringNetwork::ArmReceive()
+{
+	io_uring_sqe* sqe = GetSqe();
+	sqe->opcode = IORING_OP_RECVMSG;
+	sqe->fd = m_socket;
+	sqe->addr = reinterpret_cast<uint64_t>(&m_receiveMessage);
+	sqe->len = 1;
+	sqe->ioprio = IORING_RECV_MULTISHOT;
+	sqe->flags = IOSQE_BUFFER_SELECT;
+	sqe->buf_group = BUFFER_GROUP_ID;
+	sqe->user_data = MakeUserData(TAG_RECEIVE, 0);
+}
+
+void UringNetwork::ArmTimer(size_t index)
+{
+	io_uring_sqe* sqe = GetSqe();
+	sqe->opcode = IORING_OP_POLL_ADD;
+	sqe->fd = m_timers[index].fd;
+	sqe->poll32_events = POLLIN;
+	sqe->len = IORING_POLL_ADD_MULTI;
+	sqe->user_data = MakeUserData(TAG_TIMER, index);
+}
+
+void UringNetwork::ReapCompletions()
+{
+	unsigned head = *m_cqHead;
+	unsigned tail = LoadAcquire(m_cqTail);
+	while (head != tail)
+	{
+		HandleCompletion(m_cqes[head & m_cqMask]);
+		head++;
+	}
+	StoreRelease(m_cqHead, head);
+}
+
+void UringNetwork::HandleCompletion(const io_uring_cqe& cqe)
+{
+	uint64_t tag = cqe.user_data >> 32;
+	uint32_t index = static_cast<uint32_t>(cqe.user_data);
+	bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+
+	if (tag == TAG_SEND)
+	{
+		CompleteSend(static_cast<uint16_t>(index), cqe.res);
+		return;
+	}
+
+	if (tag == TAG_TIMER)
+	{
+		if (cqe.res >= 0)
+		{
+			uint64_t expirations = 0;
+			if (read(m_timers[index].fd, &expirations, sizeof(expirations)) == sizeof(expirations))
+			{
+				m_pendingTimers.push_back(m_timers[index].timerId);
+			}
+		}
+		if (!more)
+		{
+			ArmTimer(index);
+		}
+		return;
+	}
+
+	if (cqe.res < 0)
+	{
+		auto errorCode = -cqe.res;
+		if (errorCode == ENOBUFS)
+		{
+			m_logger->Log(LogLevel::WARNING, "HandleCompletion: Out of receive buffers");
+		}
+		else
+		{
+			std::string errorMsg = GetErrorMessage(errorCode);
+			m_logger->Log(
+				LogLevel::EXCEPTION,
+				"HandleCompletion: Receive failed",
+				{ KV(errorCode), KVS(errorMsg) }
+			);
+		}
+	}
+	else if (cqe.flags & IORING_CQE_F_BUFFER)
+	{
+		uint16_t bufferId = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+		if (m_heldHead != m_heldTail || m_pendingTail - m_pendingHead == BUFFER_COUNT)
+		{
+			// No room in the pending ring, the datagram waits in its buffer behind the others
+			m_heldBufferIds[m_heldTail & (BUFFER_COUNT - 1)] = bufferId;
+			m_heldTail++;
+		}
+		else
+		{
+			QueuePacket(bufferId);
+		}
+	}
+
+	if (!more)
+	{
+		if (m_heldTail - m_heldHead == BUFFER_COUNT)
+		{
+			// Out of buffers, the receive is armed again once a pending packet is taken
+			m_receiveStalled = true;
+		}
+		else
+		{
+			// Multishot receive was terminated for another reason
+			ArmReceive();
+		}
+	}
+}
+
+void UringNetwork::QueuePacket(uint16_t bufferId)
+{
+	uint8_t* buffer = m_buffers.data() + bufferId * BUFFER_SIZE;
+
+	io_uring_recvmsg_out out{};
+	std::memcpy(&out, buffer, sizeof(out));
+	uint8_t* name = buffer + sizeof(io_uring_recvmsg_out);
+	uint8_t* control = name + m_receiveMessage.msg_namelen;
+	uint8_t* payload = control + m_receiveMessage.msg_controllen;
+	size_t size = std::min<size_t>(out.payloadlen, RECEIVE_BUFFER_SIZE);
+
+	if (size == 0)
+	{
+		m_logger->Log(LogLevel::WARNING, "QueuePacket: No data received");
+		RecycleBuffer(bufferId);
+		return;
+	}
+
+	ReceivedPacket& receivedPacket = m_pendingPackets[m_pendingTail & (BUFFER_COUNT - 1)];
+	receivedPacket.networkPacket = AcquirePacket();
+	receivedPacket.networkPacket->Resize(size);
+	std::memcpy(receivedPacket.networkPacket->Data(), payload, size);
+	std::memcpy(&receivedPacket.clientAddr, name, sizeof(sockaddr_in));
+
+	msghdr message{};
+	message.msg_control = control;
+	message.msg_controllen = out.controllen;
+	receivedPacket.networkPacket->SetReceiveTime(NetworkUtilities::GetReceiveTime(message));
+	NetworkUtilities::GetDropCount(message, m_counters.kernelDrops);
+	m_pendingTail++;
+	m_counters.packetsReceived++;
+
+	// Copied out, so the kernel can receive into the buffer again
+	RecycleBuffer(bufferId);
+}
+
+void UringNetwork::TakePendingPacket(ReceivedPacket& receivedPacket)
+{
+	receivedPacket = std::move(m_pendingPackets[m_pendingHead & (BUFFER_COUNT - 1)]);
+	m_pendingHead++;
+
+	// Datagrams held in their buffers move up in the order they were received
+	while (m_heldHead != m_heldTail && m_pendingTail - m_pendingHead < BUFFER_COUNT)
+	{
+		uint16_t bufferId = m_heldBufferIds[m_heldHead & (BUFFER_COUNT - 1)];
+		m_heldHead++;
+		QueuePacket(bufferId);
+	}
+
+	if (m_receiveStalled)
+	{
+		m_receiveStalled = false;
+		ArmReceive();
+	}
+}
+
+void UringNetwork::CompleteSend(uint16_t slot, int result)
+{
+	SendSlot& sendSlot = m_sendSlots[slot];
+	if (result < 0)
+	{
+		auto errorCode = -result;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		std::string address = NetworkUtilities::AddressToString(sendSlot.clientAddr);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"CompleteSend: Failed",
+			{ KV(errorCode), KVS(errorMsg), KVS(address) }
+		);
+		m_counters.sendFailures++;
+	}
+	else if (static_cast<size_t>(result) != sendSlot.networkPacket->Size())
+	{
+		auto size = sendSlot.networkPacket->Size();
+		auto sent = result;
+		std::string address = NetworkUtilities::AddressToString(sendSlot.clientAddr);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"CompleteSend: Partial send",
+			{ KV(size), KV(sent), KVS(address) }
+		);
+		m_counters.sendFailures++;
+	}
+	else
+	{
+		m_counters.packetsSent++;
+	}
+
+	sendSlot.networkPacket.reset();
+	m_freeSendSlots.push_back(slot);
+}
+
+PacketHandle UringNetwork::Receive(sockaddr_in& clientAddr, int& result)
+{
+	ReapCompletions();
+	if (m_pendingHead == m_pendingTail)
+	{
+		Submit(0);
+		result = -1;
+		return nullptr;
+	}
+
+	ReceivedPacket receivedPacket;
+	TakePendingPacket(receivedPacket);
+	Submit(0);
+	clientAddr = receivedPacket.clientAddr;
+	result = 0;
+	return std::move(receivedPacket.networkPacket);
+}
+
+int UringNetwork::ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets)
+{
+	ReapCompletions();
+	if (m_pendingHead == m_pendingTail)
+	{
+		// Re-arm requests queued while reaping still need to reach the kernel
+		Submit(0);
+		return -1;
+	}
+
+	for (size_t i = 0; i < MAX_BATCH_SIZE && m_pendingHead != m_pendingTail; i++)
+	{
+		TakePendingPacket(receivedPackets.emplace_back());
+	}
+
+	// A receive armed again after running out of buffers
+	Submit(0);
+	return 0;
+}
+
+int UringNetwork::Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr)
+{
+	auto size = networkPacket.Size();
+	if (sendto(m_socket, networkPacket.Data(), size, 0, (sockaddr*)&clientAddr, sizeof(clientAddr)) != static_cast<ssize_t>(size))
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"Send: Failed",
+			{ KV(errorCode), KVS(errorMsg) }
+		);
+		m_counters.sendFailures++;
+		return 1;
+	}
+	m_counters.packetsSent++;
+	return 0;
+}
+
+int UringNetwork::SendBatch(std::vector<OutgoingPacket>& outgoingPackets)
+{
+	for (OutgoingPacket& outgoingPacket : outgoingPackets)
+	{
+		while (m_freeSendSlots.empty())
+		{
+			// Every slot is in flight so wait for the oldest sends to complete
+			if (Submit(1) != 0)
+			{
+				return 1;
+			}
+			ReapCompletions();
+		}
+
+		outgoingPacket.result = 0;
+
+		uint16_t slot = m_freeSendSlots.back();
+		m_freeSendSlots.pop_back();
+		SendSlot& sendSlot = m_sendSlots[slot];
+		// Sent straight from the pooled buffer of the caller
+		sendSlot.networkPacket = std::move(outgoingPacket.networkPacket);
+		sendSlot.clientAddr = outgoingPacket.clientAddr;
+
+		std::span<uint8_t> bytes = sendSlot.networkPacket->Bytes();
+		sendSlot.iov.iov_base = bytes.data();
+		sendSlot.iov.iov_len = bytes.size();
+		sendSlot.message = {};
+		sendSlot.message.msg_name = &sendSlot.clientAddr;
+		sendSlot.message.msg_namelen = sizeof(sockaddr_in);
+		sendSlot.message.msg_iov = &sendSlot.iov;
+		sendSlot.message.msg_iovlen = 1;
+
+		io_uring_sqe* sqe = GetSqe();
+		sqe->opcode = IORING_OP_SENDMSG;
+		sqe->fd = m_socket;
+		sqe->addr = reinterpret_cast<uint64_t>(&sendSlot.message);
+		sqe->len = 1;
+		sqe->user_data = MakeUserData(TAG_SEND, slot);
+	}
+
+	// One syscall submits the whole batch, failed sends are counted when their completions are reaped
+	return Submit(0);
+}
+
+int UringNetwork::StartTimer(int timerId, std::chrono::nanoseconds interval)
+{
+	UringTimer timer;
+	timer.timerId = timerId;
+	timer.fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+	if (timer.fd == -1)
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"StartTimer: Failed to create timer",
+			{ KV(timerId), KV(errorCode), KVS(errorMsg) }
+		);
+		return 1;
+	}
+
+	auto seconds = std::chrono::duration_cast<std::chrono::seconds>(interval);
+	itimerspec spec{};
+	spec.it_interval.tv_sec = seconds.count();
+	spec.it_interval.tv_nsec = (interval - seconds).count();
+	spec.it_value = spec.it_interval;
+	if (timerfd_settime(timer.fd, 0, &spec, nullptr) == -1)
+	{
+		auto errorCode = errno;
+		std::string errorMsg = GetErrorMessage(errorCode);
+		m_logger->Log(
+			LogLevel::EXCEPTION,
+			"StartTimer: Failed to arm timer",
+			{ KV(timerId), KV(errorCode), KVS(errorMsg) }
+		);
+		close(timer.fd);
+		return 1;
+	}
+
+	m_timers.push_back(timer);
+	ArmTimer(m_timers.size() - 1);
+	return Submit(0);
+}
+
+int UringNetwork::WaitForEvents(std::vector<int>& expiredTimers)
+{
+	ReapCompletions();
+	if (m_pendingHead == m_pendingTail && m_pendingTimers.empty())
+	{
+		// Block in the kernel until any completion arrives
+		if (Submit(1) != 0)
+		{
+			return 1;
+		}
+		ReapCompletions();
+	}
+	else if (m_pendingSubmissions > 0)
+	{
+		Submit(0);
+	}
+
+	expiredTimers.insert(expiredTimers.end(), m_pendingTimers.begin(), m_pendingTimers.end());
+	m_pendingTimers.clear();
+	return m_pendingHead == m_pendingTail ? -1 : 0;
+}
+#endif
@@ -0,0 +1,140 @@
+#pragma once
+#include <string>
+#include <iostream>
+#include <memory>
+#include <array>
+#include "NetworkBase.h"
+#include "Logger.h"
+
+#ifdef _WIN32
+#else
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#endif
+
+// Linux io_uring transport. Datagrams are received by a single multishot
+// recvmsg into a registered buffer ring so that receive completions arrive
+// without a syscall per packet. Datagrams are copied into a fixed ring of
+// pooled packets and their buffers go straight back to the kernel. When the
+// ring is full they wait in their buffers, and once every buffer is taken
+// the kernel stops receiving instead of overrunning the ring. SendBatch
+// submits all sends with one syscall without waiting for them, their
+// completions are reaped by the next wait.
+class UringNetwork final : public NetworkBase
+{
+public:
+	// Receive buffers handed to the kernel, also the capacity of the pending ring
+	static constexpr unsigned BUFFER_COUNT = 256; // Must be a power of two
+
+private:
+	static constexpr unsigned RING_ENTRIES = 256;
+	static constexpr uint16_t BUFFER_GROUP_ID = 1;
+	static constexpr int RECEIVE_BUFFER_SIZE = NetworkPacket::MAX_DATAGRAM_SIZE;
+
+	static constexpr uint64_t TAG_RECEIVE = 1;
+	static constexpr uint64_t TAG_SEND = 2;
+	static constexpr uint64_t TAG_TIMER = 3;
+
+	struct UringTimer
+	{
+		int timerId{};
+		int fd = -1;
+	};
+
+	std::shared_ptr<Logger> m_logger;
+	bool m_reusePort = false;
+	int m_socket = -1;
+
+	std::vector<UringTimer> m_timers;
+	std::vector<int> m_pendingTimers;
+
+	// Received packets not taken yet
+	std::array<ReceivedPacket, BUFFER_COUNT> m_pendingPackets;
+	unsigned m_pendingHead = 0;
+	unsigned m_pendingTail = 0;
+
+	// Buffers of the datagrams received while the pending ring was full
+	std::array<uint16_t, BUFFER_COUNT> m_heldBufferIds{};
+	unsigned m_heldHead = 0;
+	unsigned m_heldTail = 0;
+
+#ifndef _WIN32
+	// Every receive buffer holds the recvmsg header, the source address, the
+	// receive timestamp control message and the payload
+	static constexpr size_t CONTROL_SIZE = CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(uint32_t));
+	static constexpr size_t BUFFER_SIZE = sizeof(io_uring_recvmsg_out) + sizeof(sockaddr_in) + CONTROL_SIZE + RECEIVE_BUFFER_SIZE;
+
+	int m_ringFd = -1;
+
+	void* m_sqRing = nullptr;
+	size_t m_sqRingSize = 0;
+	unsigned* m_sqHead = nullptr;
+	unsigned* m_sqTail = nullptr;
+	unsigned m_sqMask = 0;
+	unsigned m_sqEntries = 0;
+	unsigned* m_sqArray = nullptr;
+	io_uring_sqe* m_sqes = nullptr;
+	size_t m_sqesSize = 0;
+	unsigned m_sqLocalTail = 0;
+	unsigned m_pendingSubmissions = 0;
+
+	void* m_cqRing = nullptr;
+	size_t m_cqRingSize = 0;
+	unsigned* m_cqHead = nullptr;
+	unsigned* m_cqTail = nullptr;
+	unsigned m_cqMask = 0;
+	io_uring_cqe* m_cqes = nullptr;
+
+	// io_uring_buf_ring is not used directly because its flexible array member
+	// is not at offset zero when the kernel header is compiled as C++
+	io_uring_buf* m_bufferRing = nullptr;
+	size_t m_bufferRingSize = 0;
+	uint16_t m_bufferRingTail = 0;
+	std::vector<uint8_t> m_buffers;
+
+	msghdr m_receiveMessage{};
+
+	bool m_receiveStalled = false;
+
+	// Sends in flight take the packet of the caller and return it to its pool
+	// once their completion is reaped
+	struct SendSlot
+	{
+		PacketHandle networkPacket;
+		sockaddr_in clientAddr{};
+		msghdr message{};
+		iovec iov{};
+	};
+	static constexpr unsigned SEND_SLOTS = RING_ENTRIES;
+	std::array<SendSlot, SEND_SLOTS> m_sendSlots;
+	std::vector<uint16_t> m_freeSendSlots;
+
+	int SetupRing();
+	int SetupBufferRing();
+	io_uring_sqe* GetSqe();
+	int Submit(unsigned minComplete);
+	void ReapCompletions();
+	void HandleCompletion(const io_uring_cqe& cqe);
+	void RecycleBuffer(uint16_t bufferId);
+	void QueuePacket(uint16_t bufferId);
+	void TakePendingPacket(ReceivedPacket& receivedPacket);
+	void CompleteSend(uint16_t slot, int result);
+	void ArmReceive();
+	void ArmTimer(size_t index);
+#endif
+
+public:
+	UringNetwork(std::shared_ptr<Logger> logger, bool reusePort = false);
+	~UringNetwork();
+
+	// Checks that the kernel supports io_uring with provided buffer rings
+	static bool IsSupported();
+
+	int Initialize(std::string server, int port, sockaddr_in& addr) override;
+	int Send(NetworkPacket& networkPacket, sockaddr_in& clientAddr) override;
+	int SendBatch(std::vector<OutgoingPacket>& outgoingPackets) override;
+	PacketHandle Receive(sockaddr_in& clientAddr, int& result) override;
+	int ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets) override;
+	int StartTimer(int timerId, std::chrono::nanoseconds interval) override;
+	int WaitForEvents(std::vector<int>& expiredTimers) override;
+};
@@ -7,20 +7,30 @@
 #include <cstring>
 #include <string>
 #include <csignal>
+#include <atomic>
 #include <cstdlib>
 #include <algorithm>
 #include "NetworkPacket.h"
 #include "Logger.h"
 #include "Network.h"
+#include "UringNetwork.h"
+#include "UnixNetwork.h"
+#include "ImpairedNetwork.h"
+#include "CaptureNetwork.h"
 #include "NetworkPacketType.h"
 #include "Player.h"
 #include "Server.h"
+#include "ServerWorld.h"
 
 // Global variables for cleanup
 std::shared_ptr<Logger> g_logger;
-std::unique_ptr<Server> g_server;
 
-volatile std::sig_atomic_t g_running = 1;
+// Read by every shard thread and cleared from the signal handler, which is safe because it is lock-free
+std::atomic<bool> g_running{ true };
+static_assert(std::atomic<bool>::is_always_lock_free, "Signal handler clears g_running");
+
+// Features the servers accept from their clients
+uint8_t g_features = Server::SUPPORTED_FEATURES;
 
 // Signal handler for Ctrl+C
 static void SignalHandler(int signal)
@@ -28,8 +38,109 @@ static void SignalHandler(int signal)
 	if (signal == SIGINT || signal == SIGTERM)
 	{
 		g_logger->Log(LogLevel::INFO, "Server shutdown requested", { KV(signal) });
-		g_running = 0;
+		g_running = false;
+	}
+}
+
+// Creates the transport selected by NETWORK_BACKEND, falling back to the socket backend
+static std::shared_ptr<NetworkBase> CreateNetwork(const std::string& backend, const NetworkOptions& options)
+{
+	if (backend == "io_uring")
+	{
+		if (UringNetwork::IsSupported())
+		{
+			return std::make_shared<UringNetwork>(g_logger, options.reusePort);
+		}
+
+		g_logger->Log(LogLevel::WARNING, "io_uring is not available, using socket backend");
+	}
+
+	return std::make_shared<Network>(g_logger, options);
+}
+
+// Runs one server per shard on the transports created by createNetwork until
+// stopped. Without decorators the transport type is known at compile time,
+// see BasicServer. With a socket path one more shard serves the clients on
+// this host over a Unix domain socket in the same world.
+template <typename Transport, typename Codec, typename CreateTransport>
+static int RunServers(int udpPort, int shards, const std::string& unixSocketPath, CreateTransport createNetwork)
+{
+	// Every shard has its own SO_REUSEPORT socket, player table and thread
+	std::vector<std::unique_ptr<BasicServer<Transport, Codec>>> servers;
+	int worldShards = unixSocketPath.empty() ? shards : shards + 1;
+	auto world = std::make_shared<ServerWorld>(worldShards, Server::MAX_PLAYERS);
+	for (int shardId = 0; shardId < shards; shardId++)
+	{
+		servers.push_back(std::make_unique<BasicServer<Transport, Codec>>(g_logger, createNetwork(shardId), world, shardId));
+		servers.back()->SetFeatures(g_features);
+
+		if (servers.back()->Initialize(udpPort) != 0)
+		{
+			g_logger->Log(LogLevel::WARNING, "Failed to initialize network", { KV(shardId) });
+			return 1;
+		}
+	}
+
+	std::unique_ptr<BasicServer<UnixNetwork, Codec>> localServer;
+	if (!unixSocketPath.empty())
+	{
+		localServer = std::make_unique<BasicServer<UnixNetwork, Codec>>(g_logger, std::make_shared<UnixNetwork>(g_logger, unixSocketPath), world, shards);
+		localServer->SetFeatures(g_features);
+		if (localServer->Initialize(udpPort) != 0)
+		{
+			g_logger->Log(LogLevel::WARNING, "Failed to initialize Unix domain socket", { KVS(unixSocketPath) });
+			return 1;
+		}
+	}
+
+	std::vector<std::thread> shardThreads;
+	for (int shardId = 1; shardId < shards; shardId++)
+	{
+		shardThreads.emplace_back([&servers, shardId]() {
+			if (servers[shardId]->ExecuteGame(g_running) != 0)
+			{
+				g_logger->Log(LogLevel::EXCEPTION, "Server shard stopped unexpectedly", { KV(shardId) });
+			}
+		});
+	}
+	if (localServer)
+	{
+		shardThreads.emplace_back([&localServer]() {
+			if (localServer->ExecuteGame(g_running) != 0)
+			{
+				g_logger->Log(LogLevel::EXCEPTION, "Unix domain socket shard stopped unexpectedly");
+			}
+		});
+	}
+
+	int result = servers[0]->ExecuteGame(g_running);
+	if (result != 0)
+	{
+		g_logger->Log(LogLevel::EXCEPTION, "Server stopped unexpectedly");
+	}
+
+	// Other shards notice the shutdown latest on their next housekeeping timer
+	g_running = false;
+	for (std::thread& shardThread : shardThreads)
+	{
+		shardThread.join();
+	}
+
+	if (result != 0)
+	{
+		return 1;
 	}
+
+	for (auto& server : servers)
+	{
+		server->QuitGame();
+	}
+	if (localServer)
+	{
+		localServer->QuitGame();
+	}
+
+	return 0;
 }
 
 int main()
@@ -50,24 +161,125 @@ int main()
 		udpPort = std::atoi(envPort);
 	}
 
-	g_logger->Log(LogLevel::INFO, "Listening in UDP Port: {udpPort}", { KV(udpPort) });
+	int shards = 1;
+	const char* envShards = std::getenv("SERVER_SHARDS");
+	if (envShards)
+	{
+		shards = std::max(1, std::atoi(envShards));
+	}
 
-	std::unique_ptr<Network> network = std::make_unique<Network>(g_logger);
-	g_server = std::make_unique<Server>(g_logger, std::move(network));
+	std::string backend = "socket";
+	const char* envBackend = std::getenv("NETWORK_BACKEND");
+	if (envBackend)
+	{
+		backend = envBackend;
+	}
 
-	if (g_server->Initialize(udpPort) != 0)
+	// GRO and GSO are negotiated with the kernel and only used by the socket backend
+	NetworkOptions options;
+	options.reusePort = shards > 1;
+	const char* envOffload = std::getenv("UDP_OFFLOAD");
+	if (envOffload)
 	{
-		g_logger->Log(LogLevel::WARNING, "Failed to initialize network");
-		return 1;
+		options.udpGro = std::atoi(envOffload) != 0;
+		options.udpGso = options.udpGro;
 	}
 
-	if (g_server->ExecuteGame(g_running) != 0)
+	// Socket buffer sizes in bytes, tune with the drop and queue counters logged by the server
+	const char* envReceiveBuffer = std::getenv("UDP_RECEIVE_BUFFER");
+	if (envReceiveBuffer)
 	{
-		g_logger->Log(LogLevel::EXCEPTION, "Server stopped unexpectedly");
-		return 1;
+		options.receiveBufferSize = std::atoi(envReceiveBuffer);
+	}
+	const char* envSendBuffer = std::getenv("UDP_SEND_BUFFER");
+	if (envSendBuffer)
+	{
+		options.sendBufferSize = std::atoi(envSendBuffer);
 	}
 
-	g_server->QuitGame();
+	// Entropy coded snapshots are smaller but cost CPU time on both ends, 0 sends plain delta encoded ones
+	const char* envEntropyCoding = std::getenv("SNAPSHOT_ENTROPY_CODING");
+	if (envEntropyCoding && std::atoi(envEntropyCoding) == 0)
+	{
+		g_features &= ~PacketSchemas::ENTROPY_CODED_SNAPSHOTS;
+	}
+
+	// crc32c checks packets with the Castagnoli polynomial, computed in hardware with SSE4.2.
+	// Only clients started with it as well can connect, see Crc32cCodec.
+	const char* envChecksum = std::getenv("PACKET_CHECKSUM");
+	bool crc32c = envChecksum && std::strcmp(envChecksum, "crc32c") == 0;
+	std::string checksumKernel = crc32c ? CRC32C::kernel() : CRC32::kernel();
+	g_logger->Log(LogLevel::INFO, "Packet checksum", { KVS(checksumKernel) });
+
+	// Simulated latency, jitter, loss, duplication, reordering and bandwidth cap
+	ImpairmentOptions impairment;
+	impairment.LoadFromEnvironment();
+
+	// Records all traffic for replaying it with RocketBenchmark replay
+	std::string capturePath;
+	const char* envCapture = std::getenv("CAPTURE_FILE");
+	if (envCapture)
+	{
+		capturePath = envCapture;
+	}
+
+	// Clients on this host can connect over a Unix domain socket at this path, '@' for the abstract namespace
+	std::string unixSocketPath;
+	const char* envUnixSocket = std::getenv("UNIX_SOCKET");
+	if (envUnixSocket)
+	{
+		unixSocketPath = envUnixSocket;
+	}
+
+	g_logger->Log(LogLevel::INFO, "Listening in UDP Port: {udpPort}", { KV(udpPort), KV(shards), KVS(backend) });
+
+	auto runServers = [&](auto codec) {
+		using Codec = decltype(codec);
+		if (impairment.IsEnabled() || !capturePath.empty())
+		{
+			// Decorators wrap whichever transport was selected
+			return RunServers<NetworkBase, Codec>(udpPort, shards, unixSocketPath, [&](int shardId) {
+				std::shared_ptr<NetworkBase> network = CreateNetwork(backend, options);
+				if (impairment.IsEnabled())
+				{
+					// Every shard draws from its own sequence
+					ImpairmentOptions shardImpairment = impairment;
+					shardImpairment.seed += shardId;
+					network = std::make_shared<ImpairedNetwork>(g_logger, network, shardImpairment);
+				}
+				if (!capturePath.empty())
+				{
+					// One capture file per shard
+					std::string shardCapturePath = shards > 1 ? capturePath + "." + std::to_string(shardId) : capturePath;
+					network = std::make_shared<CaptureNetwork>(g_logger, network, shardCapturePath, Codec::ID);
+				}
+				return network;
+			});
+		}
+		else if (backend == "io_uring" && UringNetwork::IsSupported())
+		{
+			return RunServers<UringNetwork, Codec>(udpPort, shards, unixSocketPath, [&](int) {
+				return std::make_shared<UringNetwork>(g_logger, options.reusePort);
+			});
+		}
+		else
+		{
+			if (backend == "io_uring")
+			{
+				g_logger->Log(LogLevel::WARNING, "io_uring is not available, using socket backend");
+			}
+
+			return RunServers<Network, Codec>(udpPort, shards, unixSocketPath, [&](int) {
+				return std::make_shared<Network>(g_logger, options);
+			});
+		}
+	};
+
+	int result = crc32c ? runServers(Crc32cCodec{}) : runServers(Crc32Codec{});
+	if (result != 0)
+	{
+		return 1;
+	}
 
 #if _DEBUG
 	g_logger->Log(LogLevel::DEBUG, "Press any key to exit...");
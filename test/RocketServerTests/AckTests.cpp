@@ -153,9 +153,10 @@ namespace RocketServerTests
 
             // Set ackBits so that bits for 99, 97, 95 are set
             uint32_t ackBits = (1u << 31) | (1u << 29) | (1u << 27);
+            auto receiveTicks = steady_clock::now();
 
             // Act
-            NetworkUtilities::VerifyAck(data, ack, ackBits);
+            NetworkUtilities::VerifyAck(data, ack, ackBits, receiveTicks);
 
             // Assert
             auto sequence = { 100, 99, 97, 95 };
@@ -166,6 +167,7 @@ namespace RocketServerTests
                 if (std::find(sequence.begin(), sequence.end(), pi.seqNum) != sequence.end())
                 {
                     Assert::IsTrue(pi.acknowledged, L"These seqnums should be acknowledged");
+                    Assert::IsTrue(pi.receiveTicks == receiveTicks, L"Acknowledged packets should use the receive time of the ack");
                 }
                 else
                 {
@@ -0,0 +1,72 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <random>
+#include "CRC32.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(CRC32Tests)
+    {
+    private:
+        // Bit at a time reference of the reflected CRC of a polynomial
+        static uint32_t ReferenceCRC(uint32_t polynomial, const uint8_t* data, size_t length)
+        {
+            uint32_t crc = 0xFFFFFFFFU;
+            for (size_t i = 0; i < length; i++)
+            {
+                crc ^= data[i];
+                for (int bit = 0; bit < 8; bit++)
+                {
+                    crc = (crc & 1) ? (crc >> 1) ^ polynomial : crc >> 1;
+                }
+            }
+            return crc ^ 0xFFFFFFFFU;
+        }
+
+    public:
+        TEST_METHOD(Check_Value_Test)
+        {
+            // Arrange
+            const char* check = "123456789";
+            const uint8_t* data = reinterpret_cast<const uint8_t*>(check);
+
+            // Act
+            uint32_t crc32 = CRC32::calculate(data, 9);
+            uint32_t crc32c = CRC32C::calculate(data, 9);
+
+            // Assert
+            Assert::AreEqual(0xCBF43926U, crc32, L"CRC32 check value should match");
+            Assert::AreEqual(0xE3069283U, crc32c, L"CRC32C check value should match");
+        }
+
+        TEST_METHOD(Kernel_Matches_Reference_Test)
+        {
+            // Arrange
+            std::mt19937 random(1);
+            std::vector<uint8_t> data(1600);
+            for (uint8_t& byte : data)
+            {
+                byte = static_cast<uint8_t>(random());
+            }
+
+            // Act and Assert, every length up to a full datagram at every alignment, in one and in two updates
+            for (size_t offset = 0; offset < 8; offset++)
+            {
+                for (size_t length = 0; length <= 1472; length++)
+                {
+                    const uint8_t* bytes = data.data() + offset;
+                    CRC32 split;
+                    split.update(bytes, length / 3);
+                    split.update(bytes + length / 3, length - length / 3);
+
+                    uint32_t expected = ReferenceCRC(0xEDB88320U, bytes, length);
+                    Assert::AreEqual(expected, CRC32::calculate(bytes, length), L"CRC32 kernel should match the reference");
+                    Assert::AreEqual(expected, split.value(), L"CRC32 should continue across updates");
+                    Assert::AreEqual(ReferenceCRC(0x82F63B78U, bytes, length), CRC32C::calculate(bytes, length), L"CRC32C kernel should match the reference");
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,166 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <filesystem>
+#include "Logger.h"
+#include "LoopbackNetwork.h"
+#include "CaptureNetwork.h"
+#include "ReplayNetwork.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(CaptureReplayTests)
+    {
+    private:
+        std::string CapturePath(const std::string& name)
+        {
+            return (std::filesystem::temp_directory_path() / name).string();
+        }
+
+        PacketHandle Challenge(NetworkBase& network, uint64_t clientSalt, uint64_t serverSalt)
+        {
+            PacketHandle packet = network.AcquirePacket();
+            packet->WriteInt8(static_cast<int8_t>(NetworkPacketType::CHALLENGE));
+            packet->WriteUInt64(clientSalt);
+            packet->WriteUInt64(serverSalt);
+            return packet;
+        }
+
+    public:
+        TEST_METHOD(Replay_Returns_Captured_Datagrams_Test)
+        {
+            // Arrange
+            std::string path = CapturePath("RocketServerTests_roundtrip.rcap");
+            auto hub = std::make_shared<LoopbackHub>();
+            LoopbackNetwork client(std::make_shared<::Logger>(), hub);
+            sockaddr_in clientServerAddr{};
+            client.Initialize("127.0.0.1", 3501, clientServerAddr);
+
+            std::vector<ReceivedPacket> capturedPackets;
+            {
+                CaptureNetwork server(std::make_shared<::Logger>(), std::make_shared<LoopbackNetwork>(std::make_shared<::Logger>(), hub), path);
+                sockaddr_in serverAddr{};
+                server.Initialize("", 3501, serverAddr);
+
+                PacketHandle sendPacket = client.AcquirePacket();
+                sendPacket->WriteInt8(static_cast<int8_t>(NetworkPacketType::CONNECTION_REQUEST));
+                sendPacket->WriteInt64(1234);
+                client.Send(*sendPacket, clientServerAddr);
+                server.ReceiveBatch(capturedPackets);
+            }
+
+            std::atomic<bool> running{ true };
+            ReplayNetwork replay(std::make_shared<::Logger>(), path, 0, running);
+            sockaddr_in replayAddr{};
+
+            // Act
+            int initializeResult = replay.Initialize("", 3501, replayAddr);
+            std::vector<ReceivedPacket> replayedPackets;
+            int receiveResult = replay.ReceiveBatch(replayedPackets);
+            std::vector<int> expiredTimers;
+            replay.WaitForEvents(expiredTimers);
+
+            // Assert
+            Assert::AreEqual(0, initializeResult, L"Initialize should succeed");
+            Assert::AreEqual(0, receiveResult, L"Receive should succeed");
+            Assert::AreEqual(static_cast<size_t>(1), replayedPackets.size(), L"The captured datagram should be replayed");
+            Assert::IsTrue(capturedPackets[0].networkPacket->ToBytes() == replayedPackets[0].networkPacket->ToBytes(), L"Bytes should match the capture");
+            Assert::IsTrue(replayedPackets[0].clientAddr.sin_port == client.LocalAddress().sin_port, L"Source should be the captured client port");
+            Assert::IsFalse(running, L"Exhausted capture should stop the server");
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(Replay_Translates_Connection_Salt_Test)
+        {
+            // Arrange
+            std::string path = CapturePath("RocketServerTests_salt.rcap");
+            auto hub = std::make_shared<LoopbackHub>();
+            LoopbackNetwork client(std::make_shared<::Logger>(), hub);
+            sockaddr_in clientServerAddr{};
+            client.Initialize("127.0.0.1", 3501, clientServerAddr);
+            {
+                CaptureNetwork server(std::make_shared<::Logger>(), std::make_shared<LoopbackNetwork>(std::make_shared<::Logger>(), hub), path);
+                sockaddr_in serverAddr{};
+                server.Initialize("", 3501, serverAddr);
+
+                sockaddr_in clientAddr = client.LocalAddress();
+                server.Send(*Challenge(server, 1, 2), clientAddr);
+                PacketHandle clock = client.AcquirePacket();
+                clock->WriteInt8(static_cast<int8_t>(NetworkPacketType::CLOCK));
+                clock->WriteUInt64(1 ^ 2);
+                clock->CalculateCRC();
+                client.Send(*clock, clientServerAddr);
+                std::vector<ReceivedPacket> capturedPackets;
+                server.ReceiveBatch(capturedPackets);
+            }
+
+            std::atomic<bool> running{ true };
+            ReplayNetwork replay(std::make_shared<::Logger>(), path, 0, running);
+            sockaddr_in replayAddr{};
+            replay.Initialize("", 3501, replayAddr);
+            sockaddr_in clientAddr = client.LocalAddress();
+
+            // Act
+            replay.Send(*Challenge(replay, 1, 6), clientAddr);
+            std::vector<ReceivedPacket> replayedPackets;
+            replay.ReceiveBatch(replayedPackets);
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(1), replayedPackets.size(), L"The clock should be replayed");
+            NetworkPacket& replayed = *replayedPackets[0].networkPacket;
+            Assert::AreEqual(0, replayed.ReadAndValidateCRC(), L"CRC should be recalculated");
+            Assert::IsTrue(replayed.ReadNetworkPacketType() == NetworkPacketType::CLOCK, L"Type should be kept");
+            Assert::AreEqual(static_cast<uint64_t>(1 ^ 6), replayed.ReadUInt64(), L"Salt should be the one of the replay");
+            std::filesystem::remove(path);
+        }
+
+        TEST_METHOD(Replay_Keeps_Codec_Of_Capture_Test)
+        {
+            // Arrange
+            std::string path = CapturePath("RocketServerTests_crc32c.rcap");
+            auto hub = std::make_shared<LoopbackHub>();
+            LoopbackNetwork client(std::make_shared<::Logger>(), hub);
+            sockaddr_in clientServerAddr{};
+            client.Initialize("127.0.0.1", 3501, clientServerAddr);
+            {
+                CaptureNetwork server(std::make_shared<::Logger>(), std::make_shared<LoopbackNetwork>(std::make_shared<::Logger>(), hub), path, CodecId::CRC32C);
+                sockaddr_in serverAddr{};
+                server.Initialize("", 3501, serverAddr);
+
+                sockaddr_in clientAddr = client.LocalAddress();
+                server.Send(*Challenge(server, 1, 2), clientAddr);
+                PacketHandle clock = client.AcquirePacket();
+                clock->WriteInt8(static_cast<int8_t>(NetworkPacketType::CLOCK));
+                clock->WriteUInt64(1 ^ 2);
+                Crc32cCodec::Seal(*clock);
+                client.Send(*clock, clientServerAddr);
+                std::vector<ReceivedPacket> capturedPackets;
+                server.ReceiveBatch(capturedPackets);
+            }
+
+            std::atomic<bool> running{ true };
+            ReplayNetwork replay(std::make_shared<::Logger>(), path, 0, running);
+            sockaddr_in replayAddr{};
+            replay.Initialize("", 3501, replayAddr);
+            sockaddr_in clientAddr = client.LocalAddress();
+
+            // Act
+            CodecId codec = CodecId::CRC32;
+            int readResult = ReplayNetwork::ReadCodec(path, codec);
+            replay.Send(*Challenge(replay, 1, 6), clientAddr);
+            std::vector<ReceivedPacket> replayedPackets;
+            replay.ReceiveBatch(replayedPackets);
+
+            // Assert
+            Assert::AreEqual(0, readResult, L"ReadCodec should succeed");
+            Assert::IsTrue(codec == CodecId::CRC32C, L"Codec should be the one of the capture");
+            Assert::AreEqual(static_cast<size_t>(1), replayedPackets.size(), L"The clock should be replayed");
+            NetworkPacket& replayed = *replayedPackets[0].networkPacket;
+            Assert::AreEqual(0, Crc32cCodec::Validate(replayed), L"CRC32C should be recalculated");
+            Assert::IsTrue(replayed.ReadNetworkPacketType() == NetworkPacketType::CLOCK, L"Type should be kept");
+            Assert::AreEqual(static_cast<uint64_t>(1 ^ 6), replayed.ReadUInt64(), L"Salt should be the one of the replay");
+            std::filesystem::remove(path);
+        }
+    };
+}
@@ -0,0 +1,222 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <cmath>
+#include "GamePacket.h"
+#include "PhysicsEngine.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(GamePacketTests)
+    {
+    private:
+        PlayerState MovingPlayer()
+        {
+            PlayerState playerState{};
+            playerState.playerID = 7;
+            playerState.pos.x.floatValue = 960.3f;
+            playerState.pos.y.floatValue = 12.9f;
+            playerState.vel.x.floatValue = -250.7f;
+            playerState.vel.y.floatValue = 499.9f;
+            playerState.rotation.floatValue = 4.5f;
+            playerState.health.floatValue = 80.0f;
+            playerState.keyboard.up = 1;
+            playerState.keyboard.space = 1;
+            return playerState;
+        }
+
+    public:
+        TEST_METHOD(Player_State_Round_Trip_Test)
+        {
+            // Arrange
+            PlayerState expected = MovingPlayer();
+            GamePacket gamePacket;
+            size_t headerSize = gamePacket.Size();
+
+            // Act
+            gamePacket.SerializePlayerState(expected);
+            size_t size = gamePacket.Size() - headerSize;
+            PlayerState actual = GamePacket::DeserializePlayerState(gamePacket.Bytes().subspan(CRC32::CRC_SIZE));
+
+            // Assert
+            Assert::AreEqual(GamePacket::PLAYER_STATE_SIZE, size, L"Size should match PLAYER_STATE_SIZE");
+            Assert::IsTrue(size <= 11, L"State should be about a third of the 30 bytes of full width fields");
+            Assert::AreEqual(static_cast<int>(expected.playerID), static_cast<int>(actual.playerID), L"Player id should be kept");
+            Assert::AreEqual(expected.pos.x.floatValue, actual.pos.x.floatValue, 0.1f, L"Position x should be within precision");
+            Assert::AreEqual(expected.pos.y.floatValue, actual.pos.y.floatValue, 0.1f, L"Position y should be within precision");
+            Assert::AreEqual(expected.vel.x.floatValue, actual.vel.x.floatValue, 0.1f, L"Velocity x should be within precision");
+            Assert::AreEqual(expected.vel.y.floatValue, actual.vel.y.floatValue, 0.1f, L"Velocity y should be within precision");
+            Assert::AreEqual(expected.rotation.floatValue, actual.rotation.floatValue, 0.01f, L"Rotation should be within precision");
+            Assert::AreEqual(expected.health.floatValue, actual.health.floatValue, 1.0f, L"Health should be within precision");
+            Assert::IsTrue(expected.keyboard == actual.keyboard, L"Keyboard should be kept");
+        }
+
+        TEST_METHOD(Quantized_State_Matches_Deserialized_Test)
+        {
+            // Arrange
+            PlayerState expected = MovingPlayer();
+            GamePacket::QuantizePlayerState(expected);
+            GamePacket gamePacket;
+
+            // Act
+            gamePacket.SerializePlayerState(expected);
+            PlayerState actual = GamePacket::DeserializePlayerState(gamePacket.Bytes().subspan(CRC32::CRC_SIZE));
+
+            // Assert
+            Assert::AreEqual(expected.pos.x.intValue, actual.pos.x.intValue, L"Position x should be bit exact");
+            Assert::AreEqual(expected.pos.y.intValue, actual.pos.y.intValue, L"Position y should be bit exact");
+            Assert::AreEqual(expected.vel.x.intValue, actual.vel.x.intValue, L"Velocity x should be bit exact");
+            Assert::AreEqual(expected.vel.y.intValue, actual.vel.y.intValue, L"Velocity y should be bit exact");
+            Assert::AreEqual(expected.speed.intValue, actual.speed.intValue, L"Speed should be bit exact");
+            Assert::AreEqual(expected.rotation.intValue, actual.rotation.intValue, L"Rotation should be bit exact");
+            Assert::AreEqual(expected.health.intValue, actual.health.intValue, L"Health should be bit exact");
+        }
+
+        TEST_METHOD(Quantization_Clamps_And_Wraps_Test)
+        {
+            // Arrange
+            PlayerState playerState{};
+            playerState.pos.x.floatValue = -5.0f;
+            playerState.pos.y.floatValue = PhysicsEngine::WORLD_HEIGHT + 5.0f;
+            playerState.vel.x.floatValue = 0.0f;
+            playerState.vel.y.floatValue = 2.0f * PhysicsEngine::MAX_SPEED;
+            playerState.rotation.floatValue = PhysicsEngine::FULL_ROTATION + 1.0f;
+
+            // Act
+            GamePacket::QuantizePlayerState(playerState);
+
+            // Assert
+            Assert::AreEqual(0.0f, playerState.pos.x.floatValue, L"Position should be clamped to the world");
+            Assert::AreEqual(PhysicsEngine::WORLD_HEIGHT, playerState.pos.y.floatValue, L"Position should be clamped to the world");
+            Assert::AreEqual(0.0f, playerState.vel.x.floatValue, L"Zero velocity should stay exactly zero");
+            Assert::AreEqual(PhysicsEngine::MAX_SPEED, playerState.vel.y.floatValue, L"Velocity should be clamped to the maximum speed");
+            Assert::AreEqual(1.0f, playerState.rotation.floatValue, 0.01f, L"Rotation should wrap around");
+        }
+
+        TEST_METHOD(Unchanged_State_Delta_Test)
+        {
+            // Arrange
+            PlayerState playerState = MovingPlayer();
+            GamePacket::QuantizePlayerState(playerState);
+            std::vector<PlayerState> baseline{ playerState };
+            GamePacket gamePacket;
+            size_t headerSize = gamePacket.Size();
+
+            // Act
+            size_t count = gamePacket.SerializeSnapshot(std::vector<PlayerState>{ playerState }, baseline, NetworkPacket::MAX_DATAGRAM_SIZE);
+            size_t size = gamePacket.Size() - headerSize;
+            std::vector<PlayerState> actual = GamePacket::DeserializeSnapshot(gamePacket.Bytes().subspan(CRC32::CRC_SIZE), baseline);
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(1), count, L"State should be written");
+            Assert::AreEqual(static_cast<size_t>(3), size, L"Unchanged state should only carry the count, player id and an empty mask");
+            Assert::AreEqual(static_cast<size_t>(1), actual.size(), L"State should be read");
+            Assert::AreEqual(playerState.pos.x.intValue, actual[0].pos.x.intValue, L"Position should be taken from the baseline");
+            Assert::AreEqual(playerState.rotation.intValue, actual[0].rotation.intValue, L"Rotation should be taken from the baseline");
+            Assert::IsTrue(playerState.keyboard == actual[0].keyboard, L"Keyboard should be taken from the baseline");
+        }
+
+        TEST_METHOD(Snapshot_Delta_Round_Trip_Test)
+        {
+            // Arrange
+            PlayerState moved = MovingPlayer();
+            GamePacket::QuantizePlayerState(moved);
+            std::vector<PlayerState> baseline{ moved };
+            moved.pos.x.floatValue += 100.0f;
+            moved.keyboard.up = 0;
+            GamePacket::QuantizePlayerState(moved);
+            PlayerState joined = MovingPlayer();
+            joined.playerID = 9;
+            GamePacket::QuantizePlayerState(joined);
+            std::vector<PlayerState> expected{ moved, joined };
+            GamePacket gamePacket;
+
+            // Act
+            size_t count = gamePacket.SerializeSnapshot(expected, baseline, NetworkPacket::MAX_DATAGRAM_SIZE);
+            std::vector<PlayerState> actual = GamePacket::DeserializeSnapshot(gamePacket.Bytes().subspan(CRC32::CRC_SIZE), baseline);
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(2), count, L"Both states should be written");
+            Assert::AreEqual(static_cast<size_t>(2), actual.size(), L"Both states should be read");
+            for (size_t i = 0; i < expected.size(); i++)
+            {
+                Assert::AreEqual(static_cast<int>(expected[i].playerID), static_cast<int>(actual[i].playerID), L"Player id should be kept");
+                Assert::AreEqual(expected[i].pos.x.intValue, actual[i].pos.x.intValue, L"Position x should be bit exact");
+                Assert::AreEqual(expected[i].pos.y.intValue, actual[i].pos.y.intValue, L"Position y should be bit exact");
+                Assert::AreEqual(expected[i].vel.y.intValue, actual[i].vel.y.intValue, L"Velocity y should be bit exact");
+                Assert::AreEqual(expected[i].health.intValue, actual[i].health.intValue, L"Health should be bit exact");
+                Assert::IsTrue(expected[i].keyboard == actual[i].keyboard, L"Keyboard should be kept");
+            }
+        }
+
+        TEST_METHOD(Entropy_Coded_Snapshot_Round_Trip_Test)
+        {
+            // Arrange
+            std::vector<PlayerState> baseline;
+            std::vector<PlayerState> expected;
+            for (uint8_t playerID = 1; playerID <= 8; playerID++)
+            {
+                PlayerState playerState = MovingPlayer();
+                playerState.playerID = playerID;
+                playerState.pos.x.floatValue += 30.0f * playerID;
+                GamePacket::QuantizePlayerState(playerState);
+                baseline.push_back(playerState);
+
+                // Moved a frame further
+                playerState.pos.x.floatValue += playerState.vel.x.floatValue / 60.0f;
+                playerState.pos.y.floatValue += playerState.vel.y.floatValue / 60.0f;
+                GamePacket::QuantizePlayerState(playerState);
+                expected.push_back(playerState);
+            }
+            GamePacket plainPacket;
+            GamePacket codedPacket;
+
+            // Act
+            plainPacket.SerializeSnapshot(expected, baseline, NetworkPacket::MAX_DATAGRAM_SIZE);
+            size_t count = codedPacket.SerializeSnapshot(expected, baseline, NetworkPacket::MAX_DATAGRAM_SIZE, true);
+            std::vector<PlayerState> actual = GamePacket::DeserializeSnapshot(codedPacket.Bytes().subspan(CRC32::CRC_SIZE), baseline, true);
+
+            // Assert
+            Assert::AreEqual(expected.size(), count, L"All states should be written");
+            Assert::AreEqual(expected.size(), actual.size(), L"All states should be read");
+            for (size_t i = 0; i < expected.size(); i++)
+            {
+                Assert::AreEqual(static_cast<int>(expected[i].playerID), static_cast<int>(actual[i].playerID), L"Player id should be kept");
+                Assert::AreEqual(expected[i].pos.x.intValue, actual[i].pos.x.intValue, L"Position x should be bit exact");
+                Assert::AreEqual(expected[i].pos.y.intValue, actual[i].pos.y.intValue, L"Position y should be bit exact");
+                Assert::AreEqual(expected[i].rotation.intValue, actual[i].rotation.intValue, L"Rotation should be taken from the baseline");
+                Assert::IsTrue(expected[i].keyboard == actual[i].keyboard, L"Keyboard should be kept");
+            }
+            Assert::IsTrue(codedPacket.Size() < plainPacket.Size(), L"Small position changes should code smaller than plain bits");
+        }
+
+        TEST_METHOD(Entropy_Coded_Snapshot_Max_Size_Test)
+        {
+            // Arrange
+            std::vector<PlayerState> expected;
+            for (uint8_t playerID = 1; playerID <= 200; playerID++)
+            {
+                PlayerState playerState = MovingPlayer();
+                playerState.playerID = playerID;
+                playerState.pos.x.floatValue = 7.0f * playerID;
+                playerState.vel.y.floatValue = -2.0f * playerID;
+                GamePacket::QuantizePlayerState(playerState);
+                expected.push_back(playerState);
+            }
+            size_t maxSize = 300;
+            GamePacket gamePacket;
+
+            // Act
+            size_t count = gamePacket.SerializeSnapshot(expected, {}, maxSize, true);
+            std::vector<PlayerState> actual = GamePacket::DeserializeSnapshot(gamePacket.Bytes().subspan(CRC32::CRC_SIZE), {}, true);
+
+            // Assert
+            Assert::IsTrue(count > 0 && count < expected.size(), L"Only some states should fit");
+            Assert::IsTrue(gamePacket.Size() <= maxSize, L"Snapshot should fit into the maximum size");
+            Assert::AreEqual(count, actual.size(), L"Written states should be read");
+            Assert::AreEqual(expected[count - 1].pos.x.intValue, actual[count - 1].pos.x.intValue, L"Last state should be complete");
+            Assert::AreEqual(expected[count - 1].vel.y.intValue, actual[count - 1].vel.y.intValue, L"Last state should be complete");
+        }
+    };
+}
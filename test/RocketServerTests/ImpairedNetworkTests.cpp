@@ -0,0 +1,103 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "Logger.h"
+#include "LoopbackNetwork.h"
+#include "ImpairedNetwork.h"
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(ImpairedNetworkTests)
+    {
+    private:
+        // Sends count packets from an impaired client to a plain loopback server
+        size_t SendThroughImpairment(const ImpairmentOptions& options, int count, std::chrono::milliseconds wait)
+        {
+            auto logger = std::make_shared<::Logger>();
+            auto hub = std::make_shared<LoopbackHub>();
+            LoopbackNetwork server(logger, hub);
+            ImpairedNetwork client(logger, std::make_shared<LoopbackNetwork>(logger, hub), options);
+            sockaddr_in serverAddr{};
+            sockaddr_in clientServerAddr{};
+            server.Initialize("", 3501, serverAddr);
+            client.Initialize("127.0.0.1", 3501, clientServerAddr);
+
+            PacketHandle sendPacket = client.AcquirePacket();
+            sendPacket->WriteInt8(static_cast<int8_t>(NetworkPacketType::GAME_STATE));
+            for (int i = 0; i < count; i++)
+            {
+                client.Send(*sendPacket, clientServerAddr);
+            }
+
+            std::this_thread::sleep_for(wait);
+
+            // Delayed packets are released by the next call on the impaired network
+            std::vector<ReceivedPacket> receivedPackets;
+            client.ReceiveBatch(receivedPackets);
+            while (server.ReceiveBatch(receivedPackets) == 0)
+            {
+            }
+            return receivedPackets.size();
+        }
+
+    public:
+        TEST_METHOD(Loss_Drops_All_Packets_Test)
+        {
+            // Arrange
+            ImpairmentOptions options;
+            options.lossRate = 1.0;
+
+            // Act
+            size_t received = SendThroughImpairment(options, 10, std::chrono::milliseconds(0));
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(0), received, L"All packets should be lost");
+        }
+
+        TEST_METHOD(Duplication_Doubles_Packets_Test)
+        {
+            // Arrange
+            ImpairmentOptions options;
+            options.duplicateRate = 1.0;
+
+            // Act
+            size_t received = SendThroughImpairment(options, 10, std::chrono::milliseconds(0));
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(20), received, L"Every packet should arrive twice");
+        }
+
+        TEST_METHOD(Latency_Delays_Packets_Test)
+        {
+            // Arrange
+            ImpairmentOptions options;
+            options.latencyMs = 20;
+
+            // Act
+            size_t early = SendThroughImpairment(options, 10, std::chrono::milliseconds(0));
+            size_t late = SendThroughImpairment(options, 10, std::chrono::milliseconds(40));
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(0), early, L"Packets should not arrive before the latency");
+            Assert::AreEqual(static_cast<size_t>(10), late, L"Packets should arrive after the latency");
+        }
+
+        TEST_METHOD(Same_Seed_Same_Loss_Test)
+        {
+            // Arrange
+            ImpairmentOptions options;
+            options.lossRate = 0.5;
+            options.seed = 42;
+
+            // Act
+            size_t first = SendThroughImpairment(options, 100, std::chrono::milliseconds(0));
+            size_t second = SendThroughImpairment(options, 100, std::chrono::milliseconds(0));
+
+            // Assert
+            Assert::AreEqual(first, second, L"Same seed should lose the same packets");
+            Assert::IsTrue(first > 0 && first < 100, L"Some but not all packets should be lost");
+        }
+    };
+}
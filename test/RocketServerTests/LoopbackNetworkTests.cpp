@@ -0,0 +1,85 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "Logger.h"
+#include "LoopbackNetwork.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(LoopbackNetworkTests)
+    {
+    private:
+    public:
+        TEST_METHOD(Send_Delivers_To_Bound_Port_Test)
+        {
+            // Arrange
+            auto hub = std::make_shared<LoopbackHub>();
+            LoopbackNetwork server(std::make_shared<::Logger>(), hub);
+            LoopbackNetwork client(std::make_shared<::Logger>(), hub);
+            sockaddr_in serverAddr{};
+            sockaddr_in clientServerAddr{};
+            server.Initialize("", 3501, serverAddr);
+            client.Initialize("127.0.0.1", 3501, clientServerAddr);
+
+            PacketHandle sendPacket = client.AcquirePacket();
+            sendPacket->WriteInt8(static_cast<int8_t>(NetworkPacketType::GAME_STATE));
+            sendPacket->WriteInt64(1234);
+            sendPacket->CalculateCRC();
+
+            // Act
+            int sendResult = client.Send(*sendPacket, clientServerAddr);
+            std::vector<ReceivedPacket> receivedPackets;
+            int receiveResult = server.ReceiveBatch(receivedPackets);
+
+            // Assert
+            Assert::AreEqual(0, sendResult, L"Send should succeed");
+            Assert::AreEqual(0, receiveResult, L"Receive should succeed");
+            Assert::AreEqual(static_cast<size_t>(1), receivedPackets.size(), L"One packet should be received");
+            Assert::AreEqual(0, receivedPackets[0].networkPacket->ReadAndValidateCRC(), L"Bytes should arrive as sent");
+            Assert::IsTrue(receivedPackets[0].clientAddr.sin_port == client.LocalAddress().sin_port, L"Source should be the client port");
+        }
+
+        TEST_METHOD(Full_Queue_Counts_Drops_Test)
+        {
+            // Arrange
+            auto hub = std::make_shared<LoopbackHub>();
+            LoopbackNetwork server(std::make_shared<::Logger>(), hub, 2);
+            LoopbackNetwork client(std::make_shared<::Logger>(), hub);
+            sockaddr_in serverAddr{};
+            sockaddr_in clientServerAddr{};
+            server.Initialize("", 3501, serverAddr);
+            client.Initialize("127.0.0.1", 3501, clientServerAddr);
+            PacketHandle sendPacket = client.AcquirePacket();
+
+            // Act
+            for (int i = 0; i < 5; i++)
+            {
+                client.Send(*sendPacket, clientServerAddr);
+            }
+            std::vector<ReceivedPacket> receivedPackets;
+            server.ReceiveBatch(receivedPackets);
+            NetworkCounters counters = server.GetCounters();
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(2), receivedPackets.size(), L"Only queued packets should be received");
+            Assert::AreEqual(static_cast<uint64_t>(3), counters.kernelDrops, L"Overflowing packets should be counted as drops");
+        }
+
+        TEST_METHOD(Send_To_Unbound_Port_Fails_Test)
+        {
+            // Arrange
+            auto hub = std::make_shared<LoopbackHub>();
+            LoopbackNetwork client(std::make_shared<::Logger>(), hub);
+            sockaddr_in serverAddr{};
+            client.Initialize("127.0.0.1", 3501, serverAddr);
+            PacketHandle sendPacket = client.AcquirePacket();
+
+            // Act
+            int sendResult = client.Send(*sendPacket, serverAddr);
+
+            // Assert
+            Assert::AreEqual(1, sendResult, L"Send without a bound destination should fail");
+        }
+    };
+}
@@ -0,0 +1,96 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "MessageBundle.h"
+#include "PathMtu.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(MessageBundleTests)
+    {
+    public:
+        TEST_METHOD(Round_Trip_Test)
+        {
+            // Arrange
+            NetworkPacket bundle;
+            PacketSchemas::Clock::Write(bundle, 42, -5);
+            NetworkPacket ackPacket;
+            PathMtu::WriteProbeAck(ackPacket, 42, 1200);
+            NetworkPacket responsePacket;
+            PacketSchemas::ClockResponse::Write(responsePacket, 7);
+            size_t expectedSize = bundle.Size() + ackPacket.Size() + responsePacket.Size() - 2 * CRC32::CRC_SIZE +
+                sizeof(NetworkPacketType) + 3 * MessageBundle::LENGTH_SIZE;
+            std::vector<NetworkPacketType> types;
+
+            // Act
+            bool ackAppended = MessageBundle::Append(bundle, ackPacket, PathMtu::MIN_DATAGRAM_SIZE);
+            bool responseAppended = MessageBundle::Append(bundle, responsePacket, PathMtu::MIN_DATAGRAM_SIZE);
+            int result = MessageBundle::ForEach(bundle.Message(), [&](std::span<const uint8_t> message) {
+                types.push_back(static_cast<NetworkPacketType>(message[0]));
+                if (types.size() == 2)
+                {
+                    auto [connectionSalt, size] = PacketView<PacketSchemas::MtuProbeAck>(message).Fields();
+                    Assert::AreEqual(static_cast<uint16_t>(1200), size, L"Bundled message should be read in place");
+                }
+                return 0;
+            });
+
+            // Assert
+            Assert::IsTrue(ackAppended && responseAppended, L"Messages should be appended");
+            Assert::AreEqual(0, result, L"Bundle should be valid");
+            Assert::AreEqual(expectedSize, bundle.Size(), L"Bundle should be the type and the messages with their lengths");
+            Assert::IsTrue(PacketSchemas::ValidSize(NetworkPacketType::BUNDLE, bundle.Size()), L"Bundle size should be valid");
+            Assert::IsTrue(types == std::vector<NetworkPacketType>{ NetworkPacketType::CLOCK, NetworkPacketType::MTU_PROBE_ACK, NetworkPacketType::CLOCK_RESPONSE },
+                L"Messages should be handled in order");
+        }
+
+        TEST_METHOD(Append_Rejected_Test)
+        {
+            // Arrange
+            NetworkPacket bundle;
+            PacketSchemas::Clock::Write(bundle, 42, -5);
+            std::vector<uint8_t> expected = bundle.ToBytes();
+            NetworkPacket responsePacket;
+            PacketSchemas::ClockResponse::Write(responsePacket, 7);
+            NetworkPacket probePacket;
+            PathMtu::WriteProbe(probePacket, 42, 1000);
+
+            // Act
+            bool overBudget = MessageBundle::Append(bundle, responsePacket, bundle.Size() + responsePacket.Size());
+            bool probe = MessageBundle::Append(bundle, probePacket, NetworkPacket::MAX_DATAGRAM_SIZE);
+
+            // Assert
+            Assert::IsFalse(overBudget, L"Bundle larger than the budget should be rejected");
+            Assert::IsFalse(probe, L"Probe should not be bundled");
+            Assert::IsTrue(expected == bundle.ToBytes(), L"Rejected append should leave the datagram unchanged");
+        }
+
+        TEST_METHOD(Malformed_Bundle_Test)
+        {
+            // Arrange
+            NetworkPacket truncated;
+            PacketSchemas::Clock::Write(truncated, 42, -5);
+            NetworkPacket responsePacket;
+            PacketSchemas::ClockResponse::Write(responsePacket, 7);
+            MessageBundle::Append(truncated, responsePacket, PathMtu::MIN_DATAGRAM_SIZE);
+            truncated.Resize(truncated.Size() - 1);
+
+            // Handshake message inside a bundle
+            NetworkPacket handshake;
+            PacketSchemas::Clock::Write(handshake, 42, -5);
+            MessageBundle::Append(handshake, responsePacket, PathMtu::MIN_DATAGRAM_SIZE);
+            handshake.Data()[CRC32::CRC_SIZE + sizeof(NetworkPacketType) + MessageBundle::LENGTH_SIZE] = static_cast<uint8_t>(NetworkPacketType::CONNECTION_REQUEST);
+            size_t handled = 0;
+
+            // Act
+            int truncatedResult = MessageBundle::ForEach(truncated.Message(), [&](std::span<const uint8_t>) { handled++; return 0; });
+            int handshakeResult = MessageBundle::ForEach(handshake.Message(), [&](std::span<const uint8_t>) { handled++; return 0; });
+
+            // Assert
+            Assert::AreEqual(1, truncatedResult, L"Length past the end should be rejected");
+            Assert::AreEqual(1, handshakeResult, L"Handshake message should not be bundled");
+            Assert::AreEqual(static_cast<size_t>(0), handled, L"No message of a malformed bundle should be handled");
+        }
+    };
+}
@@ -1,6 +1,7 @@
 #include "pch.h"
 #include "CppUnitTest.h"
 #include "NetworkPacket.h"
+#include "PacketCodec.h"
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -37,5 +38,64 @@ namespace RocketServerTests
             // Assert
             Assert::AreEqual(expected, actual, L"Validation should have succeeded");
         }
+
+        TEST_METHOD(Crc32c_Codec_Test)
+        {
+            // Arrange
+            NetworkPacket networkPacket;
+            networkPacket.WriteInt8(static_cast<int8_t>(NetworkPacketType::CLOCK));
+            networkPacket.WriteUInt64(42);
+
+            // Act
+            Crc32cCodec::Seal(networkPacket);
+            networkPacket.Resize(networkPacket.Size());
+            int sameCodec = Crc32cCodec::Validate(networkPacket);
+            networkPacket.Resize(networkPacket.Size());
+            int otherCodec = Crc32Codec::Validate(networkPacket);
+
+            // Assert
+            Assert::AreEqual(0, sameCodec, L"Packet sealed with Crc32cCodec should validate with it");
+            Assert::AreEqual(1, otherCodec, L"Packet sealed with Crc32cCodec should fail validation with Crc32Codec");
+        }
+
+        TEST_METHOD(Read_Past_End_Test)
+        {
+            // Arrange
+            NetworkPacket networkPacket;
+            networkPacket.WriteInt16(0x1234);
+            networkPacket.Resize(networkPacket.Size());
+            networkPacket.ReadInt32();
+
+            // Act
+            int16_t value = networkPacket.ReadInt16();
+            bool overrunBefore = networkPacket.Overrun();
+            uint64_t pastEnd = networkPacket.ReadUInt64();
+
+            // Assert
+            Assert::AreEqual(static_cast<int16_t>(0x1234), value, L"Value should be read");
+            Assert::IsFalse(overrunBefore, L"Reading the written bytes should not overrun");
+            Assert::AreEqual(static_cast<uint64_t>(0), pastEnd, L"Read past the end should return zero");
+            Assert::IsTrue(networkPacket.Overrun(), L"Read past the end should mark the packet overrun");
+        }
+
+        TEST_METHOD(Write_Past_Capacity_Test)
+        {
+            // Arrange
+            NetworkPacket networkPacket;
+            while (networkPacket.Size() < NetworkPacket::MAX_DATAGRAM_SIZE)
+            {
+                networkPacket.WriteInt8(1);
+            }
+
+            // Act
+            networkPacket.WriteInt32(2);
+
+            // Assert
+            Assert::AreEqual(NetworkPacket::MAX_DATAGRAM_SIZE, networkPacket.Size(), L"Write past the capacity should be dropped");
+            Assert::AreEqual(NetworkPacket::MAX_DATAGRAM_SIZE, networkPacket.Bytes().size(), L"Bytes should span the written size");
+            Assert::IsTrue(networkPacket.Overrun(), L"Write past the capacity should mark the packet overrun");
+            networkPacket.Clear();
+            Assert::IsFalse(networkPacket.Overrun(), L"Clear should reset the overrun");
+        }
     };
 }
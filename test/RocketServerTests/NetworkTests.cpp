@@ -0,0 +1,269 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "Logger.h"
+#include "Network.h"
+#include "NetworkUtilities.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#include <sys/syscall.h>
+
+// Makes the kernel reject the first UDP_SEGMENT message with EIO, as it does
+// for devices which cannot checksum the segments
+static bool g_failSegmentedSends = false;
+
+extern "C" int sendmmsg(int fd, mmsghdr* messages, unsigned int count, int flags)
+{
+    if (g_failSegmentedSends)
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (messages[i].msg_hdr.msg_controllen == 0)
+            {
+                continue;
+            }
+            if (i == 0)
+            {
+                errno = EIO;
+                return -1;
+            }
+            count = i;
+        }
+    }
+    return static_cast<int>(syscall(SYS_sendmmsg, fd, messages, count, flags));
+}
+#endif
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(NetworkTests)
+    {
+    private:
+        static constexpr int TIMER = 1;
+
+        NetworkOptions OffloadOptions()
+        {
+            NetworkOptions options;
+            options.udpGro = true;
+            options.udpGso = true;
+            return options;
+        }
+
+        OutgoingPacket Numbered(NetworkBase& network, const sockaddr_in& addr, int32_t number, size_t size)
+        {
+            OutgoingPacket outgoingPacket;
+            outgoingPacket.networkPacket = network.AcquirePacket();
+            outgoingPacket.networkPacket->WriteInt32(number);
+            // Like Client.cpp the size includes the CRC
+            while (outgoingPacket.networkPacket->Size() < size)
+            {
+                outgoingPacket.networkPacket->WriteInt8(0);
+            }
+            outgoingPacket.networkPacket->CalculateCRC();
+            outgoingPacket.clientAddr = addr;
+            return outgoingPacket;
+        }
+
+        // Takes the datagrams until count arrived or the timer expired too often
+        std::vector<ReceivedPacket> ReceiveAll(Network& network, size_t count)
+        {
+            std::vector<int> expiredTimers;
+            std::vector<ReceivedPacket> receivedPackets;
+            for (int wakeups = 0; receivedPackets.size() < count && wakeups < 20; wakeups++)
+            {
+                expiredTimers.clear();
+                if (network.WaitForEvents(expiredTimers) == 0)
+                {
+                    network.ReceiveBatch(receivedPackets);
+                }
+            }
+            return receivedPackets;
+        }
+
+        void AssertNumbered(const std::vector<ReceivedPacket>& receivedPackets, const std::vector<int32_t>& numbers, const std::vector<size_t>& sizes)
+        {
+            Assert::AreEqual(numbers.size(), receivedPackets.size(), L"Every datagram should arrive once");
+            for (size_t i = 0; i < numbers.size(); i++)
+            {
+                NetworkPacket& networkPacket = *receivedPackets[i].networkPacket;
+                Assert::AreEqual(sizes[i], networkPacket.Size(), L"Datagram should keep its size");
+                Assert::AreEqual(0, networkPacket.ReadAndValidateCRC(), L"Datagram should be intact");
+                Assert::AreEqual(numbers[i], networkPacket.ReadInt32(), L"Datagrams should arrive in order");
+            }
+        }
+
+    public:
+        TEST_METHOD(Segment_Count_Keeps_Short_Last_Segment_Test)
+        {
+            // Act
+            size_t whole = NetworkUtilities::SegmentCount(300, 100, false);
+            size_t shortLast = NetworkUtilities::SegmentCount(250, 100, false);
+            size_t single = NetworkUtilities::SegmentCount(40, 40, false);
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(3), whole, L"Equal segments should all be counted");
+            Assert::AreEqual(static_cast<size_t>(3), shortLast, L"Short last segment should be counted");
+            Assert::AreEqual(static_cast<size_t>(1), single, L"Buffer without coalescing should be one datagram");
+        }
+
+        TEST_METHOD(Segment_Count_Drops_Truncated_Last_Segment_Test)
+        {
+            // Act
+            size_t cut = NetworkUtilities::SegmentCount(250, 100, true);
+            size_t boundary = NetworkUtilities::SegmentCount(300, 100, true);
+            size_t empty = NetworkUtilities::SegmentCount(0, 100, false);
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(2), cut, L"Cut off last segment should be dropped");
+            Assert::AreEqual(static_cast<size_t>(3), boundary, L"Segments before the cut should be kept");
+            Assert::AreEqual(static_cast<size_t>(0), empty, L"Empty buffer should hold no datagram");
+        }
+
+#ifndef _WIN32
+        TEST_METHOD(Segment_Size_Without_Gro_Control_Message_Test)
+        {
+            // Arrange
+            alignas(cmsghdr) uint8_t control[CMSG_SPACE(sizeof(int))]{};
+            msghdr withoutGro{};
+            msghdr withGro{};
+            withGro.msg_control = control;
+            withGro.msg_controllen = sizeof(control);
+            cmsghdr* cmsg = CMSG_FIRSTHDR(&withGro);
+            cmsg->cmsg_level = SOL_UDP;
+            cmsg->cmsg_type = UDP_GRO;
+            cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+            int groSize = 100;
+            std::memcpy(CMSG_DATA(cmsg), &groSize, sizeof(groSize));
+
+            // Act
+            size_t single = NetworkUtilities::GetSegmentSize(withoutGro, 250);
+            size_t coalesced = NetworkUtilities::GetSegmentSize(withGro, 250);
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(250), single, L"Buffer without the control message should be one datagram");
+            Assert::AreEqual(static_cast<size_t>(100), coalesced, L"Segment size should be read from the control message");
+        }
+#endif
+
+        TEST_METHOD(Send_Batch_Segments_Short_Last_Packet_Test)
+        {
+            // Arrange
+            Network server(std::make_shared<::Logger>(), OffloadOptions());
+            Network client(std::make_shared<::Logger>(), OffloadOptions());
+            sockaddr_in serverAddr{};
+            sockaddr_in clientServerAddr{};
+            server.Initialize("", 47320, serverAddr);
+            client.Initialize("127.0.0.1", 47320, clientServerAddr);
+            server.StartTimer(TIMER, std::chrono::milliseconds(50));
+
+            std::vector<int32_t> numbers{ 0, 1, 2, 3 };
+            std::vector<size_t> sizes{ 100, 100, 100, 40 };
+            std::vector<OutgoingPacket> outgoingPackets;
+            for (size_t i = 0; i < numbers.size(); i++)
+            {
+                outgoingPackets.push_back(Numbered(client, clientServerAddr, numbers[i], sizes[i]));
+            }
+
+            // Act
+            int sendResult = client.SendBatch(outgoingPackets);
+            std::vector<ReceivedPacket> receivedPackets = ReceiveAll(server, numbers.size());
+
+            // Assert
+            Assert::AreEqual(0, sendResult, L"SendBatch should succeed");
+            AssertNumbered(receivedPackets, numbers, sizes);
+        }
+
+        TEST_METHOD(Send_Batch_Splits_Segments_By_Destination_Test)
+        {
+            // Arrange
+            Network first(std::make_shared<::Logger>(), OffloadOptions());
+            Network second(std::make_shared<::Logger>(), OffloadOptions());
+            Network client(std::make_shared<::Logger>(), OffloadOptions());
+            sockaddr_in firstAddr{};
+            sockaddr_in secondAddr{};
+            sockaddr_in clientFirstAddr{};
+            first.Initialize("", 47321, firstAddr);
+            second.Initialize("", 47322, secondAddr);
+            client.Initialize("127.0.0.1", 47321, clientFirstAddr);
+            sockaddr_in clientSecondAddr = clientFirstAddr;
+            clientSecondAddr.sin_port = htons(47322);
+            first.StartTimer(TIMER, std::chrono::milliseconds(50));
+            second.StartTimer(TIMER, std::chrono::milliseconds(50));
+
+            // Runs to one destination are interrupted by the other one
+            std::vector<OutgoingPacket> outgoingPackets;
+            outgoingPackets.push_back(Numbered(client, clientFirstAddr, 0, 100));
+            outgoingPackets.push_back(Numbered(client, clientFirstAddr, 1, 100));
+            outgoingPackets.push_back(Numbered(client, clientSecondAddr, 0, 100));
+            outgoingPackets.push_back(Numbered(client, clientSecondAddr, 1, 100));
+            outgoingPackets.push_back(Numbered(client, clientFirstAddr, 2, 100));
+            outgoingPackets.push_back(Numbered(client, clientFirstAddr, 3, 60));
+
+            // Act
+            int sendResult = client.SendBatch(outgoingPackets);
+            std::vector<ReceivedPacket> firstPackets = ReceiveAll(first, 4);
+            std::vector<ReceivedPacket> secondPackets = ReceiveAll(second, 2);
+
+            // Assert
+            Assert::AreEqual(0, sendResult, L"SendBatch should succeed");
+            AssertNumbered(firstPackets, { 0, 1, 2, 3 }, { 100, 100, 100, 60 });
+            AssertNumbered(secondPackets, { 0, 1 }, { 100, 100 });
+        }
+
+        TEST_METHOD(Send_Batch_Falls_Back_When_Segmentation_Fails_Test)
+        {
+            // Arrange
+            Network first(std::make_shared<::Logger>(), OffloadOptions());
+            Network second(std::make_shared<::Logger>(), OffloadOptions());
+            Network client(std::make_shared<::Logger>(), OffloadOptions());
+            sockaddr_in firstAddr{};
+            sockaddr_in secondAddr{};
+            sockaddr_in clientFirstAddr{};
+            first.Initialize("", 47323, firstAddr);
+            second.Initialize("", 47324, secondAddr);
+            client.Initialize("127.0.0.1", 47323, clientFirstAddr);
+            sockaddr_in clientSecondAddr = clientFirstAddr;
+            clientSecondAddr.sin_port = htons(47324);
+            first.StartTimer(TIMER, std::chrono::milliseconds(50));
+            second.StartTimer(TIMER, std::chrono::milliseconds(50));
+
+            // GSO is Linux only
+            if (!client.IsGsoEnabled())
+            {
+                return;
+            }
+
+            // The plain message goes out before the segmented one fails
+            std::vector<OutgoingPacket> outgoingPackets;
+            outgoingPackets.push_back(Numbered(client, clientSecondAddr, 0, 100));
+            for (int32_t i = 0; i < 4; i++)
+            {
+                outgoingPackets.push_back(Numbered(client, clientFirstAddr, i, 100));
+            }
+
+            // Act
+#ifndef _WIN32
+            g_failSegmentedSends = true;
+#endif
+            int sendResult = client.SendBatch(outgoingPackets);
+#ifndef _WIN32
+            g_failSegmentedSends = false;
+#endif
+            std::vector<ReceivedPacket> firstPackets = ReceiveAll(first, 4);
+            std::vector<ReceivedPacket> secondPackets = ReceiveAll(second, 1);
+
+            // Assert
+            Assert::AreEqual(0, sendResult, L"SendBatch should succeed without GSO");
+            Assert::IsFalse(client.IsGsoEnabled(), L"GSO should be disabled after EIO");
+            for (const OutgoingPacket& outgoingPacket : outgoingPackets)
+            {
+                Assert::AreEqual(0, outgoingPacket.result, L"Every packet should be marked as sent");
+            }
+            Assert::AreEqual(static_cast<uint64_t>(5), client.GetCounters().packetsSent, L"Every packet should be counted once");
+            AssertNumbered(firstPackets, { 0, 1, 2, 3 }, { 100, 100, 100, 100 });
+            AssertNumbered(secondPackets, { 0 }, { 100 });
+        }
+    };
+}
@@ -0,0 +1,65 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "PacketPool.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(PacketPoolTests)
+    {
+    private:
+    public:
+        TEST_METHOD(Acquire_Recycles_Packet_Test)
+        {
+            // Arrange
+            PacketPool pool(2);
+            NetworkPacket* first = nullptr;
+            {
+                PacketHandle networkPacket = pool.Acquire();
+                first = networkPacket.get();
+            }
+
+            // Act
+            PacketHandle networkPacket = pool.Acquire();
+
+            // Assert
+            Assert::IsTrue(first == networkPacket.get(), L"Released packet should be handed out again");
+            Assert::AreEqual(static_cast<size_t>(1), pool.Available(), L"One packet should remain in the pool");
+        }
+
+        TEST_METHOD(Release_Clears_Packet_Test)
+        {
+            // Arrange
+            PacketPool pool(1);
+            {
+                PacketHandle networkPacket = pool.Acquire();
+                networkPacket->WriteInt8(static_cast<int8_t>(NetworkPacketType::GAME_STATE));
+                networkPacket->WriteInt64(1234);
+            }
+
+            // Act
+            PacketHandle networkPacket = pool.Acquire();
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(CRC32::CRC_SIZE), networkPacket->Size(), L"Recycled packet should only hold the CRC placeholder");
+        }
+
+        TEST_METHOD(Empty_Pool_Allocates_Test)
+        {
+            // Arrange
+            PacketPool pool(1);
+            PacketHandle first = pool.Acquire();
+
+            // Act
+            PacketHandle second = pool.Acquire();
+            bool allocated = second != nullptr;
+            first.reset();
+            second.reset();
+
+            // Assert
+            Assert::IsTrue(allocated, L"Empty pool should allocate a new packet");
+            Assert::AreEqual(static_cast<size_t>(1), pool.Available(), L"Pool should not grow over its capacity");
+        }
+    };
+}
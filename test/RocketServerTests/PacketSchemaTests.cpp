@@ -0,0 +1,157 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "PacketSchemas.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(PacketSchemaTests)
+    {
+    public:
+        TEST_METHOD(Fields_Round_Trip_Test)
+        {
+            // Arrange
+            NetworkPacket networkPacket;
+
+            // Act
+            PacketSchemas::GameState::Write(networkPacket, 0x1122, 65534, 65532, 0x80000001, 65533);
+            networkPacket.WriteInt8(1);
+            PacketView<PacketSchemas::GameState> gameState(networkPacket.Message());
+            auto [connectionId, seqNum, ackDistance, missingAckBits, baselineDistance] = gameState.Fields();
+
+            // Assert
+            Assert::IsTrue(gameState.Valid(), L"Game state with a snapshot count should be valid");
+            Assert::AreEqual(PacketSchemas::GameState::MAX_HEADER_SIZE + 1, networkPacket.Size(), L"Large values should take the longest fields");
+            Assert::AreEqual(static_cast<uint16_t>(0x1122), connectionId, L"Connection id should be kept");
+            Assert::AreEqual(static_cast<uint16_t>(65534), seqNum, L"Sequence number should be kept");
+            Assert::AreEqual(static_cast<uint16_t>(65532), ackDistance, L"Ack distance should be kept");
+            Assert::AreEqual(static_cast<uint32_t>(0x80000001), missingAckBits, L"Ack bits should be kept");
+            Assert::AreEqual(static_cast<uint16_t>(65533), baselineDistance, L"Baseline distance should be kept");
+            Assert::AreEqual(static_cast<size_t>(1), gameState.Trailing().size(), L"Snapshot should follow the fields");
+        }
+
+        TEST_METHOD(Compact_Header_Test)
+        {
+            // Arrange
+            NetworkPacket networkPacket;
+            uint16_t seqNum = 2;
+            uint16_t ack = 65535;
+            uint32_t ackBits = 0xFFFFFFFF;
+
+            // Act
+            PacketSchemas::InputFrame::Write(networkPacket, 0x1122, seqNum, PacketSchemas::SequenceDistance(seqNum, ack), PacketSchemas::MissingAckBits(ackBits));
+            std::span<uint8_t> playerState = networkPacket.Append(GamePacket::PLAYER_STATE_SIZE);
+            std::memset(playerState.data(), 0, playerState.size());
+            PacketView<PacketSchemas::InputFrame> inputFrame(networkPacket.Message());
+            auto [connectionId, actualSeqNum, ackDistance, missingAckBits] = inputFrame.Fields();
+
+            // Assert
+            Assert::IsTrue(inputFrame.Valid(), L"Input frame should be valid");
+            Assert::AreEqual(PacketSchemas::InputFrame::HEADER_SIZE + GamePacket::PLAYER_STATE_SIZE, networkPacket.Size(), L"Ack across the wrap and no loss should take a byte each");
+            Assert::AreEqual(ack, PacketSchemas::SequenceBefore(actualSeqNum, ackDistance), L"Ack should be restored");
+            Assert::AreEqual(ackBits, PacketSchemas::MissingAckBits(missingAckBits), L"Ack bits should be restored");
+            Assert::AreEqual(static_cast<size_t>(GamePacket::PLAYER_STATE_SIZE), inputFrame.Trailing().size(), L"Player state should follow the fields");
+        }
+
+        TEST_METHOD(Malformed_Variable_Length_Field_Test)
+        {
+            // Arrange
+            size_t ackDistanceOffset = CRC32::CRC_SIZE + sizeof(NetworkPacketType) + 2 * sizeof(uint16_t);
+
+            // Ack bits running into the player state
+            NetworkPacket unterminated;
+            PacketSchemas::InputFrame::Write(unterminated, 1, 1, 0, 0);
+            std::span<uint8_t> playerState = unterminated.Append(GamePacket::PLAYER_STATE_SIZE);
+            std::memset(playerState.data(), 0x80, playerState.size());
+            unterminated.Data()[ackDistanceOffset + 1] = 0x80;
+
+            // Ack distance of more than 16 bits
+            NetworkPacket overlong;
+            PacketSchemas::InputFrame::Write(overlong, 1, 1, 0, 0);
+            playerState = overlong.Append(GamePacket::PLAYER_STATE_SIZE);
+            std::memset(playerState.data(), 0, playerState.size());
+            overlong.Data()[ackDistanceOffset] = 0xFF;
+            overlong.Data()[ackDistanceOffset + 1] = 0xFF;
+            overlong.Data()[ackDistanceOffset + 2] = 0x04;
+
+            // Act
+            PacketView<PacketSchemas::InputFrame> unterminatedView(unterminated.Message());
+            PacketView<PacketSchemas::InputFrame> overlongView(overlong.Message());
+
+            // Assert
+            Assert::IsFalse(unterminatedView.Valid(), L"Field without its last byte should be invalid");
+            Assert::IsFalse(overlongView.Valid(), L"Field past the range of its type should be invalid");
+        }
+
+        TEST_METHOD(Invalid_View_Test)
+        {
+            // Arrange
+            NetworkPacket clockPacket;
+            PacketSchemas::Clock::Write(clockPacket, 42, -5);
+            NetworkPacket truncatedPacket;
+            PacketSchemas::Clock::Write(truncatedPacket, 42, -5);
+            truncatedPacket.Resize(truncatedPacket.Size() - 1);
+
+            // Act
+            PacketView<PacketSchemas::ClockResponse> otherType(clockPacket.Message());
+            PacketView<PacketSchemas::Clock> truncated(truncatedPacket.Message());
+            auto [connectionSalt, clientTime] = truncated.Fields();
+
+            // Assert
+            Assert::IsTrue(PacketView<PacketSchemas::Clock>(clockPacket.Message()).Valid(), L"Matching type and size should be valid");
+            Assert::IsFalse(otherType.Valid(), L"Other type should be invalid");
+            Assert::IsFalse(truncated.Valid(), L"Truncated packet should be invalid");
+            Assert::AreEqual(static_cast<uint64_t>(0), connectionSalt, L"Fields of an invalid view should be zero");
+            Assert::IsTrue(truncated.Trailing().empty(), L"Invalid view should have no trailing bytes");
+        }
+
+        TEST_METHOD(Fields_Match_Hand_Written_Layout_Test)
+        {
+            // Arrange
+            NetworkPacket expected;
+            expected.WriteInt8(static_cast<int8_t>(NetworkPacketType::CLOCK));
+            expected.WriteUInt64(42);
+            expected.WriteInt64(-5);
+            NetworkPacket actual;
+
+            // Act
+            PacketSchemas::Clock::Write(actual, 42, -5);
+
+            // Assert
+            Assert::IsTrue(expected.ToBytes() == actual.ToBytes(), L"Fields should be big-endian in order");
+        }
+
+        TEST_METHOD(Padded_Size_Test)
+        {
+            // Arrange
+            NetworkPacket networkPacket;
+
+            // Act
+            PacketSchemas::ConnectionRequest::Write(networkPacket, 1, 0);
+
+            // Assert
+            Assert::AreEqual(PacketSchemas::CONNECTION_PACKET_SIZE, networkPacket.Size(), L"Request should be padded");
+            Assert::IsTrue(PacketSchemas::ValidSize(NetworkPacketType::CONNECTION_REQUEST, PacketSchemas::CONNECTION_PACKET_SIZE), L"Padded size should be valid");
+            Assert::IsFalse(PacketSchemas::ValidSize(NetworkPacketType::CONNECTION_REQUEST, PacketSchemas::CONNECTION_PACKET_SIZE - 1), L"Shorter request should be invalid");
+        }
+
+        TEST_METHOD(Size_Limits_Test)
+        {
+            // Arrange
+            size_t inputFrameSize = PacketSchemas::InputFrame::HEADER_SIZE + GamePacket::PLAYER_STATE_SIZE;
+
+            // Act
+            bool inputFrameValid = PacketSchemas::ValidSize(NetworkPacketType::INPUT_FRAME, inputFrameSize);
+            bool longInputFrameValid = PacketSchemas::ValidSize(NetworkPacketType::INPUT_FRAME, PacketSchemas::InputFrame::MAX_SIZE + 1);
+            bool emptyGameStateValid = PacketSchemas::ValidSize(NetworkPacketType::GAME_STATE, PacketSchemas::GameState::HEADER_SIZE);
+            bool pauseValid = PacketSchemas::ValidSize(NetworkPacketType::PAUSE, CRC32::CRC_SIZE + 1);
+
+            // Assert
+            Assert::IsTrue(inputFrameValid, L"Input frame with one player state should be valid");
+            Assert::IsFalse(longInputFrameValid, L"Input frame with trailing bytes should be invalid");
+            Assert::IsFalse(emptyGameStateValid, L"Game state without the snapshot count should be invalid");
+            Assert::IsFalse(pauseValid, L"Types without a layout should be invalid");
+        }
+    };
+}
@@ -0,0 +1,87 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include <random>
+#include "RangeCoder.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(RangeCoderTests)
+    {
+    public:
+        TEST_METHOD(Round_Trip_Test)
+        {
+            // Arrange
+            std::mt19937 random(1);
+            std::vector<uint32_t> bits(4000);
+            std::vector<uint32_t> directValues(200);
+            for (uint32_t& bit : bits)
+            {
+                // Mostly zeros, so that the probabilities become skewed and carries propagate
+                bit = random() % 16 == 0 ? 1 : 0;
+            }
+            for (uint32_t& value : directValues)
+            {
+                value = random() & 0x3FF;
+            }
+            NetworkPacket networkPacket;
+            size_t headerSize = networkPacket.Size();
+
+            // Act
+            RangeEncoder encoder(networkPacket);
+            std::vector<uint16_t> encoderProbabilities(8, RangeCoder::PROBABILITY_HALF);
+            for (size_t i = 0; i < bits.size(); i++)
+            {
+                encoder.EncodeBit(encoderProbabilities[i % 8], bits[i]);
+                if (i % 20 == 0)
+                {
+                    encoder.EncodeDirectBits(directValues[i / 20], 10);
+                }
+            }
+            encoder.Flush();
+
+            RangeDecoder decoder(networkPacket.Bytes().subspan(headerSize));
+            std::vector<uint16_t> decoderProbabilities(8, RangeCoder::PROBABILITY_HALF);
+            size_t mismatches = 0;
+            for (size_t i = 0; i < bits.size(); i++)
+            {
+                mismatches += decoder.DecodeBit(decoderProbabilities[i % 8]) != bits[i] ? 1 : 0;
+                if (i % 20 == 0)
+                {
+                    mismatches += decoder.DecodeDirectBits(10) != directValues[i / 20] ? 1 : 0;
+                }
+            }
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(0), mismatches, L"Every bit should be decoded");
+            Assert::IsTrue(networkPacket.Size() - headerSize < (bits.size() / 2 + directValues.size() * 10) / 8, L"Skewed bits should take well below one bit each");
+        }
+
+        TEST_METHOD(Restore_Checkpoint_Test)
+        {
+            // Arrange
+            NetworkPacket expected;
+            NetworkPacket actual;
+            uint16_t actualProbability = RangeCoder::PROBABILITY_HALF;
+
+            // Act
+            RangeEncoder expectedEncoder(expected);
+            expectedEncoder.EncodeDirectBits(0x12345, 20);
+            expectedEncoder.Flush();
+
+            RangeEncoder actualEncoder(actual);
+            actualEncoder.EncodeDirectBits(0x12345, 20);
+            RangeEncoder::Checkpoint checkpoint = actualEncoder.Save();
+            for (int i = 0; i < 100; i++)
+            {
+                actualEncoder.EncodeBit(actualProbability, 1);
+            }
+            actualEncoder.Restore(checkpoint);
+            actualEncoder.Flush();
+
+            // Assert
+            Assert::IsTrue(expected.ToBytes() == actual.ToBytes(), L"Bits coded after the checkpoint should be undone");
+        }
+    };
+}
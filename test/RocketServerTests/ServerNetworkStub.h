@@ -21,6 +21,21 @@ public:
 	std::vector<std::vector<uint8_t>> ReceiveDataReturnValues;
 	std::vector<sockaddr_in> ReceiveAddressReturnValues;
 
+	// Number of scripted packets returned by each ReceiveBatch call
+	std::vector<size_t> ReceiveBatchSizes;
+	size_t ReceiveBatchCalls = 0;
+	size_t SendBatchCalls = 0;
+
+	// Timer ids reported as expired by each WaitForEvents call
+	std::vector<std::vector<int>> ExpiredTimerReturnValues;
+	std::vector<int> StartedTimers;
+
+	// Addresses passed to ReleasePeer
+	std::vector<sockaddr_in> ReleasedPeers;
+
+	// Counters reported by each GetCounters call
+	std::vector<NetworkCounters> CountersReturnValues;
+
 	std::function<int(NetworkPacket&, sockaddr_in&)> SendCaptureCallback;
 
 	int Initialize(std::string server, int port, sockaddr_in& addr) override
@@ -38,6 +53,11 @@ public:
 	{
 		SendData.push_back(networkPacket.ToBytes());
 
+		if (SendCaptureCallback)
+		{
+			SendCaptureCallback(networkPacket, clientAddr);
+		}
+
 		if (SendReturnValues.empty())
 		{
 			return 0;
@@ -47,7 +67,7 @@ public:
 		return returnValue;
 	}
 
-	std::unique_ptr<NetworkPacket> Receive(sockaddr_in& clientAddr, int& result) override
+	PacketHandle Receive(sockaddr_in& clientAddr, int& result) override
 	{
 		if (ReceiveReturnValues.empty())
 		{
@@ -67,6 +87,85 @@ public:
 		ReceiveDataReturnValues.erase(ReceiveDataReturnValues.begin());
 
 		auto packet = std::make_unique<NetworkPacket>(data);
+		packet->SetReceiveTime(std::chrono::steady_clock::now());
 		return packet;
 	}
+
+	int ReceiveBatch(std::vector<ReceivedPacket>& receivedPackets) override
+	{
+		ReceiveBatchCalls++;
+		if (ReceiveDataReturnValues.empty())
+		{
+			return -1;
+		}
+
+		size_t batchSize = MAX_BATCH_SIZE;
+		if (!ReceiveBatchSizes.empty())
+		{
+			batchSize = ReceiveBatchSizes.front();
+			ReceiveBatchSizes.erase(ReceiveBatchSizes.begin());
+		}
+
+		for (size_t i = 0; i < batchSize && !ReceiveDataReturnValues.empty(); i++)
+		{
+			ReceivedPacket receivedPacket;
+			receivedPacket.networkPacket = std::make_unique<NetworkPacket>(ReceiveDataReturnValues.front());
+			receivedPacket.networkPacket->SetReceiveTime(std::chrono::steady_clock::now());
+			ReceiveDataReturnValues.erase(ReceiveDataReturnValues.begin());
+
+			if (!ReceiveAddressReturnValues.empty())
+			{
+				receivedPacket.clientAddr = ReceiveAddressReturnValues.front();
+				ReceiveAddressReturnValues.erase(ReceiveAddressReturnValues.begin());
+			}
+			receivedPackets.push_back(std::move(receivedPacket));
+		}
+		return 0;
+	}
+
+	int SendBatch(std::vector<OutgoingPacket>& outgoingPackets) override
+	{
+		SendBatchCalls++;
+		int failures = 0;
+		for (OutgoingPacket& outgoingPacket : outgoingPackets)
+		{
+			outgoingPacket.result = Send(*outgoingPacket.networkPacket, outgoingPacket.clientAddr);
+			if (outgoingPacket.result != 0)
+			{
+				failures++;
+			}
+		}
+		return failures == 0 ? 0 : 1;
+	}
+
+	int StartTimer(int timerId, std::chrono::nanoseconds interval) override
+	{
+		StartedTimers.push_back(timerId);
+		return 0;
+	}
+
+	int WaitForEvents(std::vector<int>& expiredTimers) override
+	{
+		if (!ExpiredTimerReturnValues.empty())
+		{
+			expiredTimers = ExpiredTimerReturnValues.front();
+			ExpiredTimerReturnValues.erase(ExpiredTimerReturnValues.begin());
+		}
+		return ReceiveDataReturnValues.empty() ? -1 : 0;
+	}
+
+	void ReleasePeer(const sockaddr_in& clientAddr) override
+	{
+		ReleasedPeers.push_back(clientAddr);
+	}
+
+	NetworkCounters GetCounters() override
+	{
+		if (!CountersReturnValues.empty())
+		{
+			m_counters = CountersReturnValues.front();
+			CountersReturnValues.erase(CountersReturnValues.begin());
+		}
+		return m_counters;
+	}
 };
@@ -5,6 +5,11 @@
 #include "ServerNetworkStub.h"
 #include "NetworkPacketType.h"
 #include "Utils.h"
+#include "GamePacket.h"
+#include "PathMtu.h"
+#include "PacketSchemas.h"
+#include "MessageBundle.h"
+#include "SnapshotReassembly.h"
 #include <thread>
 #include <future>
 
@@ -22,6 +27,7 @@ namespace Microsoft {
 				case NetworkPacketType::CONNECTION_ACCEPTED: return L"CONNECTION_ACCEPTED";
 				case NetworkPacketType::CONNECTION_DENIED: return L"CONNECTION_DENIED";
 				case NetworkPacketType::CHALLENGE: return L"CHALLENGE";
+				case NetworkPacketType::MTU_PROBE: return L"MTU_PROBE";
 				default: return L"Unknown NetworkPacketType";
 				}
 			}
@@ -41,8 +47,8 @@ namespace RocketServerTests
 			networkPacket->WriteInt8(static_cast<int8_t>(networkPacketType));
 			networkPacket->WriteInt64(salt); // Client salt
 
-			// Pad the rest of the packet with zeros
-			for (size_t i = 0; i < 1000 - sizeof(int8_t) - sizeof(int64_t); i++)
+			// Pad the rest of the packet with zeros, like Client.cpp the size includes the CRC
+			while (networkPacket->Size() < PacketSchemas::CONNECTION_PACKET_SIZE)
 			{
 				networkPacket->WriteInt8(0x00);
 			}
@@ -50,6 +56,89 @@ namespace RocketServerTests
 			return std::move(networkPacket);
 		}
 
+		// Helper to complete the handshake, returns the connection salt
+		uint64_t Connect(Server& server, NetworkStub& network, sockaddr_in& clientAddr, uint8_t requestedFeatures = 0)
+		{
+			std::unique_ptr<NetworkPacket> requestPacket = std::make_unique<NetworkPacket>();
+			PacketSchemas::ConnectionRequest::Write(*requestPacket, 0x1234567890ABCDEF, requestedFeatures);
+			requestPacket->CalculateCRC();
+			server.HandlePacket(std::move(requestPacket), clientAddr);
+
+			NetworkPacket challengePacket(network.SendData.back());
+			challengePacket.ReadAndValidateCRC();
+			challengePacket.ReadNetworkPacketType();
+			uint64_t connectionSalt = challengePacket.ReadUInt64() ^ challengePacket.ReadUInt64();
+
+			std::unique_ptr<NetworkPacket> responsePacket = CreateConnectionPacket(NetworkPacketType::CHALLENGE_RESPONSE, connectionSalt);
+			responsePacket->CalculateCRC();
+			server.HandlePacket(std::move(responsePacket), clientAddr);
+			return connectionSalt;
+		}
+
+		// Helper to find the features the server accepted in its reply to the handshake
+		uint8_t AcceptedFeatures(NetworkStub& network)
+		{
+			for (const std::vector<uint8_t>& data : network.SendData)
+			{
+				NetworkPacket networkPacket(data);
+				PacketView<PacketSchemas::ConnectionAccepted> connectionAccepted(networkPacket.Message());
+				if (connectionAccepted.Valid())
+				{
+					return std::get<1>(connectionAccepted.Fields());
+				}
+			}
+			return 0xFF;
+		}
+
+		// Helper to find the connection id the server assigned in its reply to the handshake
+		uint16_t AcceptedConnectionId(NetworkStub& network)
+		{
+			for (const std::vector<uint8_t>& data : network.SendData)
+			{
+				NetworkPacket networkPacket(data);
+				PacketView<PacketSchemas::ConnectionAccepted> connectionAccepted(networkPacket.Message());
+				if (connectionAccepted.Valid())
+				{
+					return std::get<2>(connectionAccepted.Fields());
+				}
+			}
+			return 0;
+		}
+
+		// Helper to create players which all differ from a default state
+		std::vector<Player> MovingPlayers(size_t count)
+		{
+			std::vector<Player> players(count);
+			for (size_t i = 0; i < count; i++)
+			{
+				players[i].playerID = static_cast<uint8_t>(100 + i);
+				players[i].pos.x.floatValue = 10.0f * i + 1.0f;
+				players[i].pos.y.floatValue = 5.0f * i + 1.0f;
+				players[i].vel.x.floatValue = 1.0f * i + 1.0f;
+				players[i].vel.y.floatValue = -1.0f * i - 1.0f;
+				players[i].rotation.floatValue = 0.01f * i + 0.01f;
+				players[i].health.floatValue = 100.0f;
+				players[i].keyboard.up = 1;
+			}
+			return players;
+		}
+
+		// Helper to send a game state acknowledging ack, returns the reply
+		NetworkPacket SendGameState(Server& server, NetworkStub& network, sockaddr_in& clientAddr, uint16_t connectionId, uint16_t seqNum, uint16_t ack)
+		{
+			auto gamePacket = std::make_unique<GamePacket>();
+			PacketSchemas::InputFrame::Write(*gamePacket, connectionId, seqNum, PacketSchemas::SequenceDistance(seqNum, ack), PacketSchemas::MissingAckBits(0));
+			gamePacket->SerializePlayerState(PlayerState{});
+			gamePacket->CalculateCRC();
+			network.SendData.clear();
+
+			// Received as a batch, which reads the players of the other shards
+			network.ReceiveDataReturnValues.push_back(gamePacket->ToBytes());
+			network.ReceiveAddressReturnValues.push_back(clientAddr);
+			server.ProcessBatch();
+			return NetworkPacket(network.SendData.back());
+		}
+
 	public:
 		TEST_METHOD(Initialization_Succeed_Test)
 		{
@@ -85,13 +174,14 @@ namespace RocketServerTests
 			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
 			const int64_t CLIENT_SALT = 0x1234567890ABCDEF;
 			std::unique_ptr<NetworkPacket> connectionRequestPacket = CreateConnectionPacket(NetworkPacketType::CONNECTION_REQUEST, CLIENT_SALT);
+			connectionRequestPacket->CalculateCRC();
 			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
 			sockaddr_in clientAddr{};
 			int expected = 0; // Expected return value for successful handling
 			size_t sendExpected = 1; // Expected send count
 
 			// Act
-			int actual = server->HandleConnectionRequest(std::move(connectionRequestPacket), clientAddr);
+			int actual = server->HandlePacket(std::move(connectionRequestPacket), clientAddr);
 
 			// Assert
 			Assert::AreEqual(expected, actual, L"Connection");
@@ -104,5 +194,429 @@ namespace RocketServerTests
 			NetworkPacketType packetType = sendPacket.ReadNetworkPacketType();
 			Assert::AreEqual(NetworkPacketType::CHALLENGE, packetType, L"Packet type should be CHALLENGE");
 		}
+
+		TEST_METHOD(Receive_Batch_Dispatch_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
+			std::atomic<bool> running{ true };
+			size_t sendExpected = 3; // One challenge per connection request
+			size_t batchCallsExpected = 1;
+
+			for (uint16_t port = 1; port <= sendExpected; port++)
+			{
+				std::unique_ptr<NetworkPacket> connectionRequestPacket = CreateConnectionPacket(NetworkPacketType::CONNECTION_REQUEST, port);
+				connectionRequestPacket->CalculateCRC();
+				network->ReceiveDataReturnValues.push_back(connectionRequestPacket->ToBytes());
+
+				sockaddr_in clientAddr{};
+				clientAddr.sin_family = AF_INET;
+				clientAddr.sin_port = htons(port);
+				network->ReceiveAddressReturnValues.push_back(clientAddr);
+			}
+
+			network->SendCaptureCallback = [&](NetworkPacket&, sockaddr_in&) {
+				if (network->SendData.size() == sendExpected)
+				{
+					running = false;
+				}
+				return 0;
+			};
+
+			// Act
+			server->ExecuteGame(running);
+
+			// Assert
+			size_t sendActual = network->SendData.size();
+			Assert::AreEqual(sendExpected, sendActual, L"Server should answer every packet of the batch");
+			Assert::AreEqual(batchCallsExpected, network->ReceiveBatchCalls, L"All packets should be drained by a single batch");
+		}
+
+		TEST_METHOD(Quit_Game_Send_Batch_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
+			const int64_t CLIENT_SALT = 0x1234567890ABCDEF;
+			sockaddr_in clientAddr{};
+			std::unique_ptr<NetworkPacket> connectionRequestPacket = CreateConnectionPacket(NetworkPacketType::CONNECTION_REQUEST, CLIENT_SALT);
+			connectionRequestPacket->CalculateCRC();
+			server->HandlePacket(std::move(connectionRequestPacket), clientAddr);
+			network->SendData.clear();
+			size_t sendExpected = 10; // Disconnect is repeated to survive packet loss
+			size_t batchCallsExpected = 1;
+
+			// Act
+			server->QuitGame();
+
+			// Assert
+			Assert::AreEqual(sendExpected, network->SendData.size(), L"Server should send all disconnect packets");
+			Assert::AreEqual(batchCallsExpected, network->SendBatchCalls, L"Disconnect packets should be sent in a single batch");
+
+			NetworkPacket sendPacket(network->SendData[0]);
+			sendPacket.ReadAndValidateCRC();
+			NetworkPacketType packetType = sendPacket.ReadNetworkPacketType();
+			Assert::AreEqual(NetworkPacketType::DISCONNECT, packetType, L"Packet type should be DISCONNECT");
+		}
+
+		TEST_METHOD(Idle_Timeout_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
+			std::atomic<bool> running{ true };
+			size_t startedTimersExpected = 1;
+
+			// Housekeeping timer expires 21 times without any data
+			for (int i = 0; i < 21; i++)
+			{
+				network->ExpiredTimerReturnValues.push_back({ 1 });
+			}
+
+			// Act
+			int actual = server->ExecuteGame(running);
+
+			// Assert
+			Assert::AreEqual(0, actual, L"Server should exit cleanly");
+			Assert::IsFalse(running, L"Server should stop after being idle");
+			Assert::AreEqual(startedTimersExpected, network->StartedTimers.size(), L"Server should start housekeeping timer");
+			Assert::AreEqual(static_cast<size_t>(0), network->ReceiveBatchCalls, L"Timer wakeups should not receive");
+		}
+
+		TEST_METHOD(Kernel_Drops_Reported_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
+			NetworkCounters counters;
+			counters.kernelDrops = 5;
+			network->CountersReturnValues = { counters, counters };
+
+			// Act
+			int first = server->LogNetworkCounters();
+			int second = server->LogNetworkCounters();
+
+			// Assert
+			Assert::AreEqual(1, first, L"New kernel drops should be reported");
+			Assert::AreEqual(0, second, L"Drops already reported should not be reported again");
+		}
+
+		TEST_METHOD(Mtu_Probes_After_Connection_Accepted_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
+			sockaddr_in clientAddr{};
+			Connect(*server, *network, clientAddr);
+			network->SendData.clear();
+
+			// Act
+			server->FlushOutgoingPackets();
+
+			// Assert
+			Assert::AreEqual(std::size(PathMtu::PROBE_SIZES), network->SendData.size(), L"Every probe size should be sent");
+			for (size_t i = 0; i < network->SendData.size(); i++)
+			{
+				NetworkPacket probePacket(network->SendData[i]);
+				probePacket.ReadAndValidateCRC();
+				Assert::AreEqual(NetworkPacketType::MTU_PROBE, probePacket.ReadNetworkPacketType(), L"Packet type should be MTU_PROBE");
+				uint64_t connectionSalt = 0;
+				Assert::AreEqual(PathMtu::PROBE_SIZES[i], PathMtu::ReadProbe(probePacket.Message(), connectionSalt), L"Probe should be padded to its size");
+			}
+		}
+
+		TEST_METHOD(Snapshot_Fits_Acknowledged_Mtu_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto world = std::make_shared<ServerWorld>(2, 64);
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network, world, 0);
+			sockaddr_in clientAddr{};
+			uint64_t connectionSalt = Connect(*server, *network, clientAddr);
+			uint16_t connectionId = AcceptedConnectionId(*network);
+
+			// Players of the other shard are more than the minimum datagram size carries
+			world->Publish(1, MovingPlayers(60));
+
+			auto ackPacket = std::make_unique<NetworkPacket>();
+			PathMtu::WriteProbeAck(*ackPacket, connectionSalt, NetworkPacket::MAX_DATAGRAM_SIZE);
+			ackPacket->CalculateCRC();
+
+			// Act
+			size_t sizeBeforeAck = SendGameState(*server, *network, clientAddr, connectionId, 1, 0).Size();
+			server->HandlePacket(std::move(ackPacket), clientAddr);
+			size_t sizeAfterAck = SendGameState(*server, *network, clientAddr, connectionId, 2, 0).Size();
+
+			// Assert
+			Assert::IsTrue(sizeBeforeAck <= PathMtu::MIN_DATAGRAM_SIZE, L"Snapshot should fit the minimum datagram size before probing");
+			Assert::IsTrue(sizeAfterAck > PathMtu::MIN_DATAGRAM_SIZE, L"Snapshot should use the acknowledged size");
+			Assert::IsTrue(sizeAfterAck <= NetworkPacket::MAX_DATAGRAM_SIZE, L"Snapshot should fit the acknowledged size");
+		}
+
+		TEST_METHOD(Snapshot_Delta_Against_Acknowledged_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto world = std::make_shared<ServerWorld>(2, 64);
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network, world, 0);
+			sockaddr_in clientAddr{};
+			Connect(*server, *network, clientAddr);
+			uint16_t connectionId = AcceptedConnectionId(*network);
+			world->Publish(1, MovingPlayers(20));
+
+			// Act
+			NetworkPacket fullPacket = SendGameState(*server, *network, clientAddr, connectionId, 1, 0);
+			NetworkPacket deltaPacket = SendGameState(*server, *network, clientAddr, connectionId, 2, 1);
+
+			// Assert
+			auto [fullId, fullSeqNum, fullAckDistance, fullMissingAckBits, fullBaselineDistance] = PacketView<PacketSchemas::GameState>(fullPacket.Message()).Fields();
+			Assert::AreEqual(static_cast<uint16_t>(0), fullBaselineDistance, L"Snapshot without an acknowledged one should be full");
+
+			auto [deltaId, deltaSeqNum, deltaAckDistance, deltaMissingAckBits, deltaBaselineDistance] = PacketView<PacketSchemas::GameState>(deltaPacket.Message()).Fields();
+			Assert::AreEqual(fullSeqNum, PacketSchemas::SequenceBefore(deltaSeqNum, deltaBaselineDistance), L"Acknowledged snapshot should be the baseline");
+			Assert::IsTrue(deltaPacket.Size() < fullPacket.Size() / 2, L"Unchanged players should shrink the snapshot");
+		}
+
+		TEST_METHOD(Snapshot_Fragmented_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto world = std::make_shared<ServerWorld>(2, 64);
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network, world, 0);
+			sockaddr_in clientAddr{};
+			Connect(*server, *network, clientAddr);
+			uint16_t connectionId = AcceptedConnectionId(*network);
+			world->Publish(1, MovingPlayers(60));
+			SnapshotReassembly reassembly;
+			size_t fragmentCount = 0;
+			int result = -1;
+
+			// Act
+			SendGameState(*server, *network, clientAddr, connectionId, 1, 0);
+			for (const std::vector<uint8_t>& data : network->SendData)
+			{
+				// Probes are sent along
+				NetworkPacket networkPacket(data);
+				MessageBundle::ForEach(networkPacket.Message(), [&](std::span<const uint8_t> message) {
+					if (static_cast<NetworkPacketType>(message[0]) == NetworkPacketType::GAME_STATE_FRAGMENT)
+					{
+						Assert::IsTrue(data.size() <= PathMtu::MIN_DATAGRAM_SIZE, L"Fragment should fit the path MTU");
+						result = reassembly.Add(SnapshotReassembly::FragmentView(message), std::chrono::steady_clock::now());
+						fragmentCount++;
+					}
+					return 0;
+				});
+			}
+
+			// Assert
+			Assert::IsTrue(fragmentCount > 1, L"Snapshot should be sent in fragments");
+			Assert::AreEqual(0, result, L"Fragments should complete the snapshot");
+			std::vector<PlayerState> playerStates = GamePacket::DeserializeSnapshotFragments(reassembly.Fragments(), {});
+			Assert::AreEqual(static_cast<size_t>(61), playerStates.size(), L"Snapshot should hold every player");
+		}
+
+		TEST_METHOD(Invalid_Packet_Size_Rejected_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
+			sockaddr_in clientAddr{};
+			Connect(*server, *network, clientAddr);
+			uint16_t connectionId = AcceptedConnectionId(*network);
+			server->FlushOutgoingPackets();
+			network->SendData.clear();
+
+			// Input frame without the player state
+			auto inputPacket = std::make_unique<GamePacket>();
+			PacketSchemas::InputFrame::Write(*inputPacket, connectionId, 1, 1, 0);
+			inputPacket->CalculateCRC();
+
+			// Act
+			int actual = server->HandlePacket(std::move(inputPacket), clientAddr);
+			server->FlushOutgoingPackets();
+
+			// Assert
+			Assert::AreEqual(1, actual, L"Packet shorter than its layout should be rejected");
+			Assert::IsTrue(network->SendData.empty(), L"No snapshot should be sent");
+		}
+
+		TEST_METHOD(Connection_Id_Bound_To_Address_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
+			sockaddr_in clientAddr{};
+			Connect(*server, *network, clientAddr);
+			uint16_t connectionId = AcceptedConnectionId(*network);
+			sockaddr_in otherAddr{};
+			otherAddr.sin_port = htons(4000);
+
+			auto inputPacket = std::make_unique<GamePacket>();
+			PacketSchemas::InputFrame::Write(*inputPacket, connectionId, 1, 1, 0);
+			inputPacket->SerializePlayerState(PlayerState{});
+			inputPacket->CalculateCRC();
+			auto otherIdPacket = std::make_unique<GamePacket>();
+			PacketSchemas::InputFrame::Write(*otherIdPacket, connectionId ^ 0x100, 1, 1, 0);
+			otherIdPacket->SerializePlayerState(PlayerState{});
+			otherIdPacket->CalculateCRC();
+			auto otherAddrPacket = std::make_unique<GamePacket>();
+			PacketSchemas::InputFrame::Write(*otherAddrPacket, connectionId, 1, 1, 0);
+			otherAddrPacket->SerializePlayerState(PlayerState{});
+			otherAddrPacket->CalculateCRC();
+
+			// Act
+			int otherId = server->HandlePacket(std::move(otherIdPacket), clientAddr);
+			int otherAddress = server->HandlePacket(std::move(otherAddrPacket), otherAddr);
+			int actual = server->HandlePacket(std::move(inputPacket), clientAddr);
+
+			// Assert
+			Assert::AreEqual(1, otherId, L"Connection id of another generation should be rejected");
+			Assert::AreEqual(1, otherAddress, L"Connection id from another address should be rejected");
+			Assert::AreEqual(0, actual, L"Connection id should find the player");
+		}
+
+		TEST_METHOD(Disconnect_Releases_Peer_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
+			sockaddr_in clientAddr{};
+			clientAddr.sin_port = htons(4000);
+			uint64_t connectionSalt = Connect(*server, *network, clientAddr);
+
+			auto otherSaltPacket = std::make_unique<NetworkPacket>();
+			PacketSchemas::Disconnect::Write(*otherSaltPacket, connectionSalt ^ 1);
+			otherSaltPacket->CalculateCRC();
+			auto disconnectPacket = std::make_unique<NetworkPacket>();
+			PacketSchemas::Disconnect::Write(*disconnectPacket, connectionSalt);
+			disconnectPacket->CalculateCRC();
+
+			// Act
+			server->HandlePacket(std::move(otherSaltPacket), clientAddr);
+			size_t releasedBeforeDisconnect = network->ReleasedPeers.size();
+			server->HandlePacket(std::move(disconnectPacket), clientAddr);
+
+			// Assert
+			Assert::AreEqual(size_t(0), releasedBeforeDisconnect, L"Peer of a connected player should be kept");
+			Assert::AreEqual(size_t(1), network->ReleasedPeers.size(), L"Peer should be released when its player disconnects");
+			Assert::AreEqual(clientAddr.sin_port, network->ReleasedPeers[0].sin_port, L"Address of the player should be released");
+		}
+
+		TEST_METHOD(Rejected_Datagram_Of_Stranger_Releases_Peer_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
+			sockaddr_in playerAddr{};
+			playerAddr.sin_port = htons(4000);
+			uint64_t connectionSalt = Connect(*server, *network, playerAddr);
+			sockaddr_in corruptAddr{};
+			corruptAddr.sin_port = htons(5000);
+			sockaddr_in clockAddr{};
+			clockAddr.sin_port = htons(6000);
+			sockaddr_in requestAddr{};
+			requestAddr.sin_port = htons(7000);
+
+			NetworkPacket corruptPacket;
+			PacketSchemas::Clock::Write(corruptPacket, connectionSalt, 1000);
+			NetworkPacket clockPacket;
+			PacketSchemas::Clock::Write(clockPacket, connectionSalt, 1000);
+			clockPacket.CalculateCRC();
+			NetworkPacket requestPacket;
+			PacketSchemas::ConnectionRequest::Write(requestPacket, 0x1234, 0);
+			requestPacket.CalculateCRC();
+
+			network->ReceiveDataReturnValues = { corruptPacket.ToBytes(), corruptPacket.ToBytes(), clockPacket.ToBytes(), requestPacket.ToBytes() };
+			network->ReceiveAddressReturnValues = { playerAddr, corruptAddr, clockAddr, requestAddr };
+
+			// Act
+			server->ProcessBatch();
+
+			// Assert
+			Assert::AreEqual(size_t(2), network->ReleasedPeers.size(), L"Only the strangers with rejected datagrams should be released");
+			Assert::AreEqual(corruptAddr.sin_port, network->ReleasedPeers[0].sin_port, L"Stranger with a corrupt datagram should be released");
+			Assert::AreEqual(clockAddr.sin_port, network->ReleasedPeers[1].sin_port, L"Stranger without a player should be released");
+		}
+
+		TEST_METHOD(Bundled_Messages_Bundled_Replies_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
+			sockaddr_in clientAddr{};
+			uint64_t connectionSalt = Connect(*server, *network, clientAddr);
+			uint16_t connectionId = AcceptedConnectionId(*network);
+			server->FlushOutgoingPackets();
+			network->SendData.clear();
+
+			auto bundlePacket = std::make_unique<NetworkPacket>();
+			PacketSchemas::Clock::Write(*bundlePacket, connectionSalt, 1000);
+			GamePacket inputPacket;
+			PacketSchemas::InputFrame::Write(inputPacket, connectionId, 1, 1, 0);
+			inputPacket.SerializePlayerState(PlayerState{});
+			MessageBundle::Append(*bundlePacket, inputPacket, PathMtu::MIN_DATAGRAM_SIZE);
+			bundlePacket->CalculateCRC();
+			std::vector<NetworkPacketType> replyTypes;
+
+			// Act
+			int actual = server->HandlePacket(std::move(bundlePacket), clientAddr);
+			server->FlushOutgoingPackets();
+
+			// Assert
+			Assert::AreEqual(0, actual, L"Every message of the bundle should be handled");
+			Assert::AreEqual(static_cast<size_t>(1), network->SendData.size(), L"Replies should share one datagram");
+			NetworkPacket replyPacket(network->SendData[0]);
+			MessageBundle::ForEach(replyPacket.Message(), [&](std::span<const uint8_t> message) {
+				replyTypes.push_back(static_cast<NetworkPacketType>(message[0]));
+				return 0;
+			});
+			Assert::IsTrue(replyTypes == std::vector<NetworkPacketType>{ NetworkPacketType::CLOCK_RESPONSE, NetworkPacketType::GAME_STATE },
+				L"Clock response and snapshot should be bundled in order");
+		}
+
+		TEST_METHOD(Entropy_Coded_Snapshot_Negotiated_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto world = std::make_shared<ServerWorld>(2, 64);
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network, world, 0);
+			sockaddr_in clientAddr{};
+			std::vector<Player> players = MovingPlayers(20);
+			world->Publish(1, players);
+
+			// Act
+			Connect(*server, *network, clientAddr, PacketSchemas::ENTROPY_CODED_SNAPSHOTS);
+			uint8_t acceptedFeatures = AcceptedFeatures(*network);
+			uint16_t connectionId = AcceptedConnectionId(*network);
+			NetworkPacket gameStatePacket = SendGameState(*server, *network, clientAddr, connectionId, 1, 0);
+			PacketView<PacketSchemas::GameState> gameState(gameStatePacket.Message());
+			std::vector<PlayerState> playerStates = GamePacket::DeserializeSnapshot(gameState.Trailing(), {}, true);
+
+			// Assert
+			Assert::AreEqual(PacketSchemas::ENTROPY_CODED_SNAPSHOTS, acceptedFeatures, L"Requested feature should be accepted");
+			Assert::AreEqual(players.size() + 1, playerStates.size(), L"Own and other players should be decoded");
+			PlayerState expected = players.back();
+			GamePacket::QuantizePlayerState(expected);
+			Assert::AreEqual(static_cast<int>(expected.playerID), static_cast<int>(playerStates.back().playerID), L"Last player should be decoded");
+			Assert::AreEqual(expected.pos.x.intValue, playerStates.back().pos.x.intValue, L"Position should be decoded");
+			Assert::AreEqual(expected.vel.y.intValue, playerStates.back().vel.y.intValue, L"Velocity should be decoded");
+		}
+
+		TEST_METHOD(Entropy_Coding_Disabled_Test)
+		{
+			// Arrange
+			std::shared_ptr<NetworkStub> network = std::make_shared<NetworkStub>();
+			auto server = std::make_unique<Server>(std::make_shared<::Logger>(), network);
+			sockaddr_in clientAddr{};
+			server->SetFeatures(0);
+
+			// Act
+			Connect(*server, *network, clientAddr, PacketSchemas::ENTROPY_CODED_SNAPSHOTS);
+			uint8_t acceptedFeatures = AcceptedFeatures(*network);
+
+			// Assert
+			Assert::AreEqual(static_cast<uint8_t>(0), acceptedFeatures, L"Disabled feature should not be accepted");
+		}
 	};
 }
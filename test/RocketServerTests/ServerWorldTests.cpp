@@ -0,0 +1,99 @@
+#include "pch.h"
+#include <vector>
+#include "CppUnitTest.h"
+#include "ServerWorld.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(ServerWorldTests)
+    {
+    private:
+    public:
+        TEST_METHOD(Acquire_Player_ID_Unique_Test)
+        {
+            // Arrange
+            ServerWorld world(2, 3);
+
+            // Act
+            int first = world.AcquirePlayerID();
+            int second = world.AcquirePlayerID();
+            int third = world.AcquirePlayerID();
+            int full = world.AcquirePlayerID();
+
+            // Assert
+            Assert::AreEqual(1, first, L"First player should get id 1");
+            Assert::AreEqual(2, second, L"Second player should get id 2");
+            Assert::AreEqual(3, third, L"Third player should get id 3");
+            Assert::AreEqual(0, full, L"Full world should not hand out ids");
+        }
+
+        TEST_METHOD(Release_Player_ID_Reused_Test)
+        {
+            // Arrange
+            ServerWorld world(1, 2);
+            world.AcquirePlayerID();
+            world.AcquirePlayerID();
+
+            // Act
+            world.ReleasePlayerID(1);
+            int actual = world.AcquirePlayerID();
+
+            // Assert
+            Assert::AreEqual(1, actual, L"Released id should be handed out again");
+        }
+
+        TEST_METHOD(Collect_Other_Shards_Test)
+        {
+            // Arrange
+            ServerWorld world(3, 8);
+            std::vector<Player> shard0(1);
+            shard0[0].playerID = 1;
+            std::vector<Player> shard1(2);
+            shard1[0].playerID = 2;
+            shard1[1].playerID = 3;
+            world.Publish(0, shard0);
+            world.Publish(1, shard1);
+            std::vector<PlayerState> playerStates;
+            size_t expected = 1;
+
+            // Act
+            world.CollectPlayerStates(1, playerStates);
+
+            // Assert
+            Assert::AreEqual(expected, playerStates.size(), L"Only players of other shards should be collected");
+            Assert::AreEqual(static_cast<uint8_t>(1), playerStates[0].playerID, L"Player of shard 0 should be collected");
+        }
+
+        TEST_METHOD(Publish_Replaces_States_Test)
+        {
+            // Arrange
+            ServerWorld world(2, 8);
+            std::vector<Player> players(3);
+            for (size_t i = 0; i < players.size(); i++)
+            {
+                players[i].playerID = static_cast<uint8_t>(i + 1);
+            }
+            std::vector<PlayerState> first;
+            std::vector<PlayerState> second;
+            std::vector<PlayerState> third;
+
+            // Act, every publish with fewer players than the one before
+            world.Publish(0, players);
+            world.CollectPlayerStates(1, first);
+            players.pop_back();
+            world.Publish(0, players);
+            world.CollectPlayerStates(1, second);
+            players.pop_back();
+            world.Publish(0, players);
+            world.CollectPlayerStates(1, third);
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(3), first.size(), L"First publish should be collected");
+            Assert::AreEqual(static_cast<size_t>(2), second.size(), L"Second publish should replace the first");
+            Assert::AreEqual(static_cast<size_t>(1), third.size(), L"Only the states of the latest publish should be collected");
+            Assert::AreEqual(static_cast<uint8_t>(1), third[0].playerID, L"Latest player should be collected");
+        }
+    };
+}
@@ -0,0 +1,95 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "SnapshotReassembly.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(SnapshotReassemblyTests)
+    {
+    private:
+        // Helper to create a fragment whose snapshot bytes are all its index
+        NetworkPacket CreateFragment(uint16_t seqNum, uint8_t fragmentIndex, uint8_t fragmentCount)
+        {
+            NetworkPacket networkPacket;
+            PacketSchemas::GameStateFragment::Write(networkPacket, 42, seqNum, 0, 0, 0, fragmentIndex, fragmentCount);
+            for (int i = 0; i < 10; i++)
+            {
+                networkPacket.WriteInt8(static_cast<int8_t>(fragmentIndex));
+            }
+            return networkPacket;
+        }
+
+    public:
+        TEST_METHOD(Out_Of_Order_Fragments_Test)
+        {
+            // Arrange
+            SnapshotReassembly reassembly;
+            auto now = std::chrono::steady_clock::now();
+            NetworkPacket first = CreateFragment(7, 0, 3);
+            NetworkPacket second = CreateFragment(7, 1, 3);
+            NetworkPacket third = CreateFragment(7, 2, 3);
+
+            // Act
+            int thirdResult = reassembly.Add(SnapshotReassembly::FragmentView(third.Message()), now);
+            int firstResult = reassembly.Add(SnapshotReassembly::FragmentView(first.Message()), now);
+            int duplicateResult = reassembly.Add(SnapshotReassembly::FragmentView(first.Message()), now);
+            int secondResult = reassembly.Add(SnapshotReassembly::FragmentView(second.Message()), now);
+
+            // Assert
+            Assert::AreEqual(-1, thirdResult, L"Snapshot should miss fragments");
+            Assert::AreEqual(-1, firstResult, L"Snapshot should miss fragments");
+            Assert::AreEqual(-1, duplicateResult, L"Duplicate fragment should be ignored");
+            Assert::AreEqual(0, secondResult, L"Last fragment should complete the snapshot");
+            Assert::AreEqual(static_cast<uint16_t>(7), std::get<1>(reassembly.Fields()), L"Sequence number should be kept");
+            Assert::AreEqual(static_cast<size_t>(3), reassembly.Fragments().size(), L"Every fragment should be kept");
+            for (size_t i = 0; i < reassembly.Fragments().size(); i++)
+            {
+                Assert::AreEqual(static_cast<uint8_t>(i), reassembly.Fragments()[i][0], L"Fragments should be in order");
+            }
+        }
+
+        TEST_METHOD(Invalid_Fragment_Rejected_Test)
+        {
+            // Arrange
+            SnapshotReassembly reassembly;
+            auto now = std::chrono::steady_clock::now();
+            NetworkPacket outOfRange = CreateFragment(7, 3, 3);
+            NetworkPacket tooMany = CreateFragment(7, 0, SnapshotReassembly::MAX_FRAGMENTS + 1);
+            NetworkPacket first = CreateFragment(7, 0, 2);
+            NetworkPacket otherCount = CreateFragment(7, 1, 3);
+
+            // Act
+            int outOfRangeResult = reassembly.Add(SnapshotReassembly::FragmentView(outOfRange.Message()), now);
+            int tooManyResult = reassembly.Add(SnapshotReassembly::FragmentView(tooMany.Message()), now);
+            reassembly.Add(SnapshotReassembly::FragmentView(first.Message()), now);
+            int otherCountResult = reassembly.Add(SnapshotReassembly::FragmentView(otherCount.Message()), now);
+
+            // Assert
+            Assert::AreEqual(1, outOfRangeResult, L"Index past the count should be rejected");
+            Assert::AreEqual(1, tooManyResult, L"Count past the maximum should be rejected");
+            Assert::AreEqual(1, otherCountResult, L"Count differing from the first fragment should be rejected");
+        }
+
+        TEST_METHOD(Timed_Out_Snapshot_Evicted_Test)
+        {
+            // Arrange
+            SnapshotReassembly reassembly;
+            auto now = std::chrono::steady_clock::now();
+            NetworkPacket first = CreateFragment(7, 0, 2);
+            NetworkPacket second = CreateFragment(7, 1, 2);
+            NetworkPacket other = CreateFragment(8, 0, 2);
+
+            // Act
+            reassembly.Add(SnapshotReassembly::FragmentView(first.Message()), now);
+            now += SnapshotReassembly::TIMEOUT + std::chrono::milliseconds(1);
+            reassembly.Add(SnapshotReassembly::FragmentView(other.Message()), now);
+            int lateResult = reassembly.Add(SnapshotReassembly::FragmentView(second.Message()), now);
+
+            // Assert
+            Assert::AreEqual(-1, lateResult, L"Fragment of an evicted snapshot should start it over");
+            Assert::AreEqual(static_cast<uint64_t>(1), reassembly.Evicted(), L"Timed out snapshot should be evicted");
+        }
+    };
+}
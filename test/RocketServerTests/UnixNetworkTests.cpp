@@ -0,0 +1,179 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "Logger.h"
+#include "UnixNetwork.h"
+#include "NetworkUtilities.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(UnixNetworkTests)
+    {
+    private:
+        static constexpr int TIMER = 1;
+
+        PacketHandle Numbered(NetworkBase& network, int32_t number)
+        {
+            PacketHandle packet = network.AcquirePacket();
+            packet->WriteInt32(number);
+            packet->CalculateCRC();
+            return packet;
+        }
+
+        // Takes the datagram of the client, sent when the server is not waiting for anything else
+        bool ReceiveFrom(UnixNetwork& server, UnixNetwork& client, sockaddr_in& clientServerAddr, sockaddr_in& clientAddr)
+        {
+            client.Send(*Numbered(client, 0), clientServerAddr);
+
+            std::vector<int> expiredTimers;
+            std::vector<ReceivedPacket> receivedPackets;
+            for (int wakeups = 0; receivedPackets.empty() && wakeups < 20; wakeups++)
+            {
+                expiredTimers.clear();
+                if (server.WaitForEvents(expiredTimers) == 0)
+                {
+                    server.ReceiveBatch(receivedPackets);
+                }
+            }
+
+            if (receivedPackets.size() != 1)
+            {
+                return false;
+            }
+            clientAddr = receivedPackets[0].clientAddr;
+            return true;
+        }
+
+        uint32_t PeerIndex(const sockaddr_in& addr)
+        {
+            return ntohl(addr.sin_addr.s_addr);
+        }
+
+    public:
+        TEST_METHOD(Peers_Keep_Their_Mapped_Address_Test)
+        {
+            // Arrange
+            UnixNetwork server(std::make_shared<::Logger>(), "@RocketServerTests_unix_map");
+            UnixNetwork first(std::make_shared<::Logger>());
+            UnixNetwork second(std::make_shared<::Logger>());
+            sockaddr_in serverAddr{};
+            sockaddr_in firstServerAddr{};
+            sockaddr_in secondServerAddr{};
+
+            // Windows implements AF_UNIX for stream sockets only
+            if (server.Initialize("", 0, serverAddr) != 0)
+            {
+                return;
+            }
+            first.Initialize("@RocketServerTests_unix_map", 0, firstServerAddr);
+            second.Initialize("@RocketServerTests_unix_map", 0, secondServerAddr);
+            server.StartTimer(TIMER, std::chrono::milliseconds(50));
+
+            // Act
+            sockaddr_in firstAddr{};
+            sockaddr_in secondAddr{};
+            sockaddr_in firstAgainAddr{};
+            bool received =
+                ReceiveFrom(server, first, firstServerAddr, firstAddr) &&
+                ReceiveFrom(server, second, secondServerAddr, secondAddr) &&
+                ReceiveFrom(server, first, firstServerAddr, firstAgainAddr);
+
+            // Assert
+            Assert::IsTrue(received, L"Every datagram should arrive");
+            Assert::AreEqual(static_cast<int>(AF_UNIX), static_cast<int>(firstAddr.sin_family), L"Peers should not collide with UDP addresses");
+            Assert::IsTrue(NetworkUtilities::IsSameAddress(firstAddr, firstAgainAddr), L"Peer should keep its address");
+            Assert::IsFalse(NetworkUtilities::IsSameAddress(firstAddr, secondAddr), L"Peers should have their own address");
+        }
+
+        TEST_METHOD(Released_Index_Is_Reused_From_Next_Receive_Test)
+        {
+            // Arrange
+            UnixNetwork server(std::make_shared<::Logger>(), "@RocketServerTests_unix_release");
+            UnixNetwork first(std::make_shared<::Logger>());
+            UnixNetwork second(std::make_shared<::Logger>());
+            sockaddr_in serverAddr{};
+            sockaddr_in firstServerAddr{};
+            sockaddr_in secondServerAddr{};
+
+            // Windows implements AF_UNIX for stream sockets only
+            if (server.Initialize("", 0, serverAddr) != 0)
+            {
+                return;
+            }
+            first.Initialize("@RocketServerTests_unix_release", 0, firstServerAddr);
+            second.Initialize("@RocketServerTests_unix_release", 0, secondServerAddr);
+            server.StartTimer(TIMER, std::chrono::milliseconds(50));
+
+            sockaddr_in firstAddr{};
+            ReceiveFrom(server, first, firstServerAddr, firstAddr);
+
+            // Act
+            server.ReleasePeer(firstAddr);
+            std::vector<OutgoingPacket> outgoingPackets;
+            OutgoingPacket outgoingPacket;
+            outgoingPacket.networkPacket = Numbered(server, 1);
+            outgoingPacket.clientAddr = firstAddr;
+            outgoingPackets.push_back(std::move(outgoingPacket));
+            int sendResult = server.SendBatch(outgoingPackets);
+            sockaddr_in secondAddr{};
+            sockaddr_in firstAgainAddr{};
+            bool received =
+                ReceiveFrom(server, second, secondServerAddr, secondAddr) &&
+                ReceiveFrom(server, first, firstServerAddr, firstAgainAddr);
+
+            // Assert
+            Assert::AreEqual(1, sendResult, L"Packet queued for the released peer should fail");
+            Assert::AreEqual(1, outgoingPackets[0].result, L"Packet queued for the released peer should be marked as failed");
+            Assert::IsTrue(received, L"Every datagram should arrive");
+            Assert::AreEqual(PeerIndex(firstAddr), PeerIndex(secondAddr), L"New peer should get the released index");
+            Assert::AreNotEqual(PeerIndex(firstAddr), PeerIndex(firstAgainAddr), L"Released peer should be mapped again");
+        }
+
+        TEST_METHOD(Release_Keeps_Other_Peers_Of_Batch_Test)
+        {
+            // Arrange
+            UnixNetwork server(std::make_shared<::Logger>(), "@RocketServerTests_unix_defer");
+            UnixNetwork first(std::make_shared<::Logger>());
+            UnixNetwork second(std::make_shared<::Logger>());
+            UnixNetwork third(std::make_shared<::Logger>());
+            sockaddr_in serverAddr{};
+            sockaddr_in firstServerAddr{};
+            sockaddr_in secondServerAddr{};
+            sockaddr_in thirdServerAddr{};
+
+            // Windows implements AF_UNIX for stream sockets only
+            if (server.Initialize("", 0, serverAddr) != 0)
+            {
+                return;
+            }
+            first.Initialize("@RocketServerTests_unix_defer", 0, firstServerAddr);
+            second.Initialize("@RocketServerTests_unix_defer", 0, secondServerAddr);
+            third.Initialize("@RocketServerTests_unix_defer", 0, thirdServerAddr);
+            server.StartTimer(TIMER, std::chrono::milliseconds(50));
+
+            // Both datagrams wait in the socket and arrive in one batch
+            first.Send(*Numbered(first, 0), firstServerAddr);
+            second.Send(*Numbered(second, 0), secondServerAddr);
+            std::vector<int> expiredTimers;
+            std::vector<ReceivedPacket> receivedPackets;
+            server.WaitForEvents(expiredTimers);
+            server.ReceiveBatch(receivedPackets);
+
+            // Act
+            server.ReleasePeer(receivedPackets[0].clientAddr);
+            int sendResult = server.Send(*Numbered(server, 1), receivedPackets[0].clientAddr);
+            int sendSecondResult = server.Send(*Numbered(server, 1), receivedPackets[1].clientAddr);
+            // Nothing is sent in between, like on a server without players
+            sockaddr_in thirdAddr{};
+            bool received = ReceiveFrom(server, third, thirdServerAddr, thirdAddr);
+
+            // Assert
+            Assert::AreEqual(static_cast<size_t>(2), receivedPackets.size(), L"Both datagrams should arrive in one batch");
+            Assert::AreEqual(1, sendResult, L"Released peer should not be sent to before its index is reused");
+            Assert::AreEqual(0, sendSecondResult, L"Other peers of the batch should keep their address");
+            Assert::IsTrue(received, L"Every datagram should arrive");
+            Assert::AreEqual(PeerIndex(receivedPackets[0].clientAddr), PeerIndex(thirdAddr), L"Index should be reused once the next receive started");
+        }
+    };
+}
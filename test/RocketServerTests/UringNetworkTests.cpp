@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "CppUnitTest.h"
+#include "Logger.h"
+#include "UringNetwork.h"
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace RocketServerTests
+{
+    TEST_CLASS(UringNetworkTests)
+    {
+    private:
+        static constexpr int TIMER = 1;
+
+        PacketHandle Numbered(NetworkBase& network, int32_t number)
+        {
+            PacketHandle packet = network.AcquirePacket();
+            packet->WriteInt32(number);
+            packet->CalculateCRC();
+            return packet;
+        }
+
+        // Takes the packets until count arrived or the timer expired too often, returns how many arrived in order
+        size_t ReceiveInOrder(UringNetwork& network, size_t count)
+        {
+            size_t inOrder = 0;
+            std::vector<int> expiredTimers;
+            std::vector<ReceivedPacket> receivedPackets;
+            for (int wakeups = 0; inOrder < count && wakeups < 100; wakeups++)
+            {
+                expiredTimers.clear();
+                if (network.WaitForEvents(expiredTimers) != 0)
+                {
+                    continue;
+                }
+
+                receivedPackets.clear();
+                network.ReceiveBatch(receivedPackets);
+                for (ReceivedPacket& receivedPacket : receivedPackets)
+                {
+                    if (receivedPacket.networkPacket->ReadAndValidateCRC() != 0 ||
+                        receivedPacket.networkPacket->ReadInt32() != static_cast<int32_t>(inOrder))
+                    {
+                        return inOrder;
+                    }
+                    inOrder++;
+                }
+            }
+            return inOrder;
+        }
+
+    public:
+        TEST_METHOD(Pending_Ring_Wraps_And_Receive_Rearms_Test)
+        {
+            // io_uring is Linux only
+            if (!UringNetwork::IsSupported())
+            {
+                return;
+            }
+
+            // Arrange
+            UringNetwork server(std::make_shared<::Logger>());
+            UringNetwork client(std::make_shared<::Logger>());
+            sockaddr_in serverAddr{};
+            sockaddr_in clientServerAddr{};
+            server.Initialize("", 47310, serverAddr);
+            client.Initialize("127.0.0.1", 47310, clientServerAddr);
+            server.StartTimer(TIMER, std::chrono::milliseconds(50));
+
+            // Fills the pending ring, then every buffer, the rest waits in the socket
+            size_t expected = 2 * UringNetwork::BUFFER_COUNT + 100;
+            std::vector<int> expiredTimers;
+            for (size_t i = 0; i < expected; i++)
+            {
+                client.Send(*Numbered(client, static_cast<int32_t>(i)), clientServerAddr);
+                if ((i + 1) % 50 == 0)
+                {
+                    // Reaps the completions without taking the packets
+                    server.WaitForEvents(expiredTimers);
+                }
+            }
+
+            // Act
+            size_t actual = ReceiveInOrder(server, expected);
+
+            // Assert
+            Assert::AreEqual(expected, actual, L"Every datagram should be taken in order");
+            Assert::AreEqual(static_cast<uint64_t>(expected), server.GetCounters().packetsReceived, L"Every datagram should be received once");
+        }
+
+        TEST_METHOD(Send_Batch_Larger_Than_Send_Slots_Test)
+        {
+            // io_uring is Linux only
+            if (!UringNetwork::IsSupported())
+            {
+                return;
+            }
+
+            // Arrange
+            UringNetwork server(std::make_shared<::Logger>());
+            UringNetwork client(std::make_shared<::Logger>());
+            sockaddr_in serverAddr{};
+            sockaddr_in clientServerAddr{};
+            server.Initialize("", 47311, serverAddr);
+            client.Initialize("127.0.0.1", 47311, clientServerAddr);
+            server.StartTimer(TIMER, std::chrono::milliseconds(50));
+
+            size_t expected = 300;
+            std::vector<OutgoingPacket> outgoingPackets;
+            for (size_t i = 0; i < expected; i++)
+            {
+                OutgoingPacket outgoingPacket;
+                outgoingPacket.networkPacket = Numbered(client, static_cast<int32_t>(i));
+                outgoingPacket.clientAddr = clientServerAddr;
+                outgoingPackets.push_back(std::move(outgoingPacket));
+            }
+
+            // Act
+            int sendResult = client.SendBatch(outgoingPackets);
+            outgoingPackets.clear();
+            size_t actual = ReceiveInOrder(server, expected);
+
+            // Assert
+            Assert::AreEqual(0, sendResult, L"SendBatch should succeed");
+            Assert::AreEqual(expected, actual, L"Every datagram should arrive in order");
+        }
+    };
+}